@@ -0,0 +1,35 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Host micro-benchmarks for the core. Each bench_*.cpp provides one entry
+// point listed in bench_main.cpp; run `core_bench [name...]` on a quiet
+// machine and compare the rows of one table, not numbers across hosts.
+
+// Best of `reps` runs of fn, in nanoseconds
+template <class F>
+double benchBestNs(int reps, F&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < reps; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+// One table row: total time and the cost per unit of work
+inline void benchReport(const char* name, double ns, uint64_t units, const char* unit) {
+    std::printf("  %-34s %9.3f ms  %8.3f ns/%s\n", name, ns / 1e6, ns / static_cast<double>(units), unit);
+}
+
+// Results fold into this so the optimizer cannot drop the measured work
+extern volatile uint64_t g_benchSink;
+
+void benchRunPolicy();
+void benchFpu();
+void benchVifUnpack();
+void benchIpu();
+void benchFastmem();
@@ -0,0 +1,121 @@
+// Guest loads and stores through the page tables against the fastmem
+// window: first the host accessors alone, then an LW/SW loop compiled by
+// the recompiler, whose loads read the window directly when it is on
+#include "bench.h"
+#include "ee_jit.h"
+#include "mem_map.h"
+#include <cstring>
+
+static constexpr uint32_t DATA = 0x80100000;
+static constexpr uint32_t SPAN = 1u << 19;                // bytes walked per pass; RAM is 2 MB
+static constexpr uint32_t PASSES = 8;
+static constexpr uint64_t ACCESSES = uint64_t(SPAN / 4) * PASSES;
+
+// Each word of the span holds the address of the next one, so every access
+// depends on the last and the host loops can't be vectorized
+static void fillChain(Mem& mem) {
+    for (uint32_t a = DATA; a < DATA + SPAN; a += 4) memWrite32(mem, a, a + 4 < DATA + SPAN ? a + 4 : DATA);
+}
+
+static void measureAccessors(Mem& mem) {
+    fillChain(mem);
+    const double tableLoad = benchBestNs(5, [&] {
+        uint32_t a = DATA;
+        for (uint64_t i = 0; i < ACCESSES; ++i) a = memRead32(mem, a);
+        g_benchSink = g_benchSink + a;
+    });
+    benchReport("load chain, page table", tableLoad, ACCESSES, "access");
+    const double tableStore = benchBestNs(5, [&] {
+        uint32_t a = DATA;
+        for (uint64_t i = 0; i < ACCESSES; ++i) {
+            const uint32_t next = memRead32(mem, a);
+            memWrite32(mem, a, next);
+            a = next;
+        }
+        g_benchSink = g_benchSink + a;
+    });
+    benchReport("load+store chain, page table", tableStore, ACCESSES, "access");
+
+    uint8_t* const window = mem.fastmem;
+    const double fastLoad = benchBestNs(5, [&] {
+        uint32_t a = DATA;
+        for (uint64_t i = 0; i < ACCESSES; ++i) std::memcpy(&a, window + a, 4);
+        g_benchSink = g_benchSink + a;
+    });
+    benchReport("load chain, fastmem window", fastLoad, ACCESSES, "access");
+    const double fastStore = benchBestNs(5, [&] {
+        uint32_t a = DATA;
+        for (uint64_t i = 0; i < ACCESSES; ++i) {
+            uint32_t next;
+            std::memcpy(&next, window + a, 4);
+            std::memcpy(window + a, &next, 4);
+            a = next;
+        }
+        g_benchSink = g_benchSink + a;
+    });
+    benchReport("load+store chain, fastmem window", fastStore, ACCESSES, "access");
+}
+
+// Four LWs and one SW per iteration, walking the span from DATA
+static constexpr uint32_t LOOP_PC = 0x80030000;
+static constexpr uint32_t ITERATIONS = SPAN / 32;          // per pass
+static constexpr int32_t  INSNS = ITERATIONS * 10;
+static const uint32_t kLoop[] = {
+    0x8C230000, // LW    r3, 0(r1)
+    0x8C240004, // LW    r4, 4(r1)
+    0x8C250008, // LW    r5, 8(r1)
+    0x8C26000C, // LW    r6, 12(r1)
+    0x00E33821, // ADDU  r7, r7, r3
+    0xAC270010, // SW    r7, 16(r1)
+    0x24210020, // ADDIU r1, r1, 32
+    0x2442FFFF, // ADDIU r2, r2, -1
+    0x1440FFF7, // BNE   r2, r0, LOOP_PC
+    0x00000000, // NOP
+};
+
+static void measureCompiled(const char* name, EEJit& jit, Mem& mem) {
+    EERegs ee;
+    const double ns = benchBestNs(5, [&] {
+        for (uint32_t p = 0; p < PASSES; ++p) {
+            eeInit(ee, LOOP_PC);
+            ee.GPR[1].UD[0] = DATA;
+            ee.GPR[2].UD[0] = ITERATIONS;
+            // The budget runs out exactly at the loop exit
+            int32_t left = INSNS;
+            while (left > 0) {
+                uint32_t executed = 0;
+                if (eeJitRun(jit, ee, mem, left, executed) != ExecResult::Ok) break;
+                left -= static_cast<int32_t>(executed);
+            }
+        }
+    });
+    if (ee.pc != LOOP_PC + sizeof(kLoop)) std::printf("  %s: stopped at %08X\n", name, ee.pc);
+    g_benchSink = g_benchSink + ee.GPR[7].UD[0];
+    benchReport(name, ns, uint64_t(ITERATIONS) * PASSES * 5, "access");
+}
+
+void benchFastmem() {
+    static Mem mem;
+    if (!memInit(mem)) return;
+    for (uint32_t i = 0; i < sizeof(kLoop) / 4; ++i) memWrite32(mem, LOOP_PC + i * 4, kLoop[i]);
+    if (!memFastmemEnable(mem)) {
+        std::printf("  fastmem unavailable on this host\n");
+        return;
+    }
+    measureAccessors(mem);
+
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+    EEJit jit;
+    if (!eeJitInit(jit, mem, cache)) {
+        std::printf("  no recompiler on this host\n");
+        return;
+    }
+    measureCompiled("compiled LW/SW, fastmem loads", jit, mem);
+    if (jit.patchedLoads) std::printf("  %llu of %llu fast loads fell back to handlers\n",
+                                      static_cast<unsigned long long>(jit.patchedLoads),
+                                      static_cast<unsigned long long>(jit.fastLoads));
+    memFastmemDisable(mem);
+    measureCompiled("compiled LW/SW, page table", jit, mem);
+    eeJitShutdown(jit, mem);
+}
@@ -0,0 +1,58 @@
+// COP1 fast (host IEEE) against accurate (PS2 clamping, round to zero) on
+// an ADD.S/MUL.S/MADD.S loop, the block pinned to each mode in turn
+#include "bench.h"
+#include "ee_block.h"
+#include "mem_map.h"
+#include <cstring>
+
+static constexpr uint32_t LOOP_PC = 0x80020000;
+static constexpr uint32_t EXIT_PC = LOOP_PC + 0x24;
+static constexpr uint32_t ITERATIONS = 1u << 20;
+static constexpr uint64_t FPU_OPS = uint64_t(ITERATIONS) * 7;
+
+// Settles near f1 = 0.55, so neither mode sees denormals or infinities
+static const uint32_t kLoop[] = {
+    0x460208C0, // ADD.S  f3, f1, f2
+    0x46011902, // MUL.S  f4, f3, f1
+    0x46022018, // ADDA.S f4, f2
+    0x4604195C, // MADD.S f5, f3, f4
+    0x46062842, // MUL.S  f1, f5, f6
+    0x46060882, // MUL.S  f2, f1, f6
+    0x2442FFFF, // ADDIU  r2, r2, -1
+    0x1440FFF8, // BNE    r2, r0, LOOP_PC
+    0x46070840, // ADD.S  f1, f1, f7
+};
+
+static void setFloat(EERegs& ee, int reg, float v) {
+    std::memcpy(&ee.FPR[reg], &v, 4);
+}
+
+static void measure(const char* name, EEFpuMode mode, Mem& mem, EEBlockCache& cache) {
+    eeBlockSetFpuMode(cache, LOOP_PC, mode, true);
+    EERegs ee;
+    const double ns = benchBestNs(5, [&] {
+        eeInit(ee, LOOP_PC);
+        ee.GPR[2].UD[0] = ITERATIONS;
+        setFloat(ee, 1, 1.0f);
+        setFloat(ee, 2, 0.5f);
+        setFloat(ee, 6, 0.1f);
+        setFloat(ee, 7, 0.5f);
+        while (ee.pc != EXIT_PC) {
+            uint32_t executed = 0;
+            eeRunBlock(ee, mem, cache, executed);
+        }
+    });
+    g_benchSink = g_benchSink + ee.FPR[1];
+    benchReport(name, ns, FPU_OPS, "fpu op");
+}
+
+void benchFpu() {
+    static Mem mem;
+    if (!memInit(mem)) return;
+    for (uint32_t i = 0; i < sizeof(kLoop) / 4; ++i) memWrite32(mem, LOOP_PC + i * 4, kLoop[i]);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+
+    measure("fast", EEFpuMode::Fast, mem, cache);
+    measure("accurate", EEFpuMode::Accurate, mem, cache);
+}
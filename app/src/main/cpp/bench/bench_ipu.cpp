@@ -0,0 +1,80 @@
+// IPU throughput per macroblock: BDEC (VLC, dequantise, IDCT of six
+// blocks) and CSC to RGB32/RGB16, fed and drained through the FIFO calls
+// the DMA channels use
+#include "bench.h"
+#include "ipu.h"
+#include <cstring>
+#include <vector>
+
+static constexpr uint32_t MACROBLOCKS = 1024;     // per run
+static constexpr int AC_PER_BLOCK = 10;
+
+struct BitWriter {
+    std::vector<uint8_t> bytes;
+    uint32_t bits = 0;
+    void put(uint32_t code, int len) {
+        for (int i = len - 1; i >= 0; --i, ++bits) {
+            if (!(bits & 7)) bytes.push_back(0);
+            bytes.back() |= ((code >> i) & 1) << (7 - (bits & 7));
+        }
+    }
+};
+
+// Intra MPEG-2 macroblocks: DC size 0, then AC_PER_BLOCK run-0 level +-1
+// codes ('11s', table B-14) and EOB ('10'), so every block takes the IDCT
+static std::vector<uint32_t> bdecStream() {
+    BitWriter w;
+    for (uint32_t m = 0; m < MACROBLOCKS; ++m) {
+        for (int n = 0; n < 6; ++n) {
+            if (n < 4) w.put(0x4, 3);           // luma DC size 0: '100'
+            else       w.put(0x0, 2);           // chroma DC size 0: '00'
+            for (int i = 0; i < AC_PER_BLOCK; ++i) w.put(0x6 | ((i + n) & 1), 3);
+            w.put(0x2, 2);                      // EOB
+        }
+    }
+    w.bytes.resize((w.bytes.size() + 16 + 15) & ~size_t(15), 0);
+    std::vector<uint32_t> q(w.bytes.size() / 4);
+    std::memcpy(q.data(), w.bytes.data(), w.bytes.size());
+    return q;
+}
+
+// Raw 8-bit macroblocks (256 Y, 64 Cb, 64 Cr) with varied samples
+static std::vector<uint32_t> cscStream() {
+    std::vector<uint32_t> q(MACROBLOCKS * 96);
+    uint32_t seed = 7;
+    for (uint32_t& v : q) v = seed = seed * 1664525u + 1013904223u;
+    return q;
+}
+
+// Runs one command per macroblock and drains the output after each
+static void measure(const char* name, const std::vector<uint32_t>& input, uint32_t firstCmd, uint32_t cmd) {
+    IPU ipu;
+    std::vector<uint32_t> out(256 * 4);
+    uint64_t drained = 0;
+    const double ns = benchBestNs(5, [&] {
+        ipuInit(ipu);
+        ipuPushInput(ipu, input.data(), static_cast<uint32_t>(input.size() / 4));
+        drained = 0;
+        for (uint32_t m = 0; m < MACROBLOCKS; ++m) {
+            ipuWriteReg(ipu, 0x00, m ? cmd : firstCmd);
+            while (const uint32_t n = ipuPopOutput(ipu, out.data(), 256)) drained += n;
+        }
+    });
+    if (ipu.macroblocks + ipu.cscMacroblocks != MACROBLOCKS || (ipu.ctrl & IPU_CTRL_ECD)) {
+        std::printf("  %s: only %llu macroblocks decoded\n", name,
+                    static_cast<unsigned long long>(ipu.macroblocks + ipu.cscMacroblocks));
+    }
+    g_benchSink = g_benchSink + drained + out[0];
+    benchReport(name, ns, MACROBLOCKS, "mb");
+}
+
+void benchIpu() {
+    // BDEC: intra, QSC 1; the first command also resets the DC predictors
+    const uint32_t bdec = uint32_t(IPU_BDEC) << 28 | 1u << 27 | 1u << 16;
+    measure("BDEC intra (VLC + dequant + IDCT)", bdecStream(), bdec | 1u << 26, bdec);
+
+    const std::vector<uint32_t> raw = cscStream();
+    const uint32_t csc = uint32_t(IPU_CSC) << 28 | 1;
+    measure("CSC to RGB32", raw, csc, csc);
+    measure("CSC to RGB16, dithered", raw, csc | 3u << 26, csc | 3u << 26);
+}
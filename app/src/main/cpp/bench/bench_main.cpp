@@ -0,0 +1,29 @@
+#include "bench.h"
+#include <cstring>
+
+volatile uint64_t g_benchSink = 0;
+
+struct BenchEntry {
+    const char* name;
+    void (*run)();
+};
+
+static const BenchEntry kBenches[] = {
+    {"run_policy", benchRunPolicy},
+    {"fpu",        benchFpu},
+    {"vif_unpack", benchVifUnpack},
+    {"ipu",        benchIpu},
+    {"fastmem",    benchFastmem},
+};
+
+// No arguments runs everything; otherwise only the named benches
+int main(int argc, char** argv) {
+    for (const BenchEntry& b : kBenches) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected |= std::strcmp(argv[i], b.name) == 0;
+        if (!selected) continue;
+        std::printf("%s\n", b.name);
+        b.run();
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+// The all-off RunPolicy against a block loop written without any hooks,
+// with the hooked policies for scale
+#include "bench.h"
+#include "ee_run.h"
+#include "mem_map.h"
+
+static constexpr uint32_t LOOP_PC = 0x80010000;
+static constexpr uint32_t EXIT_PC = LOOP_PC + 0x20;
+static constexpr uint32_t ITERATIONS = 1u << 20;
+static constexpr uint64_t INSNS = uint64_t(ITERATIONS) * 8;
+
+// r2 counts down; the body is plain ALU work ending in BNE with a filled slot
+static const uint32_t kLoop[] = {
+    0x24210001, // ADDIU r1, r1, 1
+    0x00611821, // ADDU  r3, r3, r1
+    0x00832026, // XOR   r4, r4, r3
+    0x00042840, // SLL   r5, r4, 1
+    0x00C53025, // OR    r6, r6, r5
+    0x2442FFFF, // ADDIU r2, r2, -1
+    0x1440FFF9, // BNE   r2, r0, LOOP_PC
+    0x00E63821, // ADDU  r7, r7, r6
+};
+
+// eeExecBlockT with the hook points taken out by hand: same hit count,
+// exception checks and delay slot handling, nothing else
+static ExecResult execHandWritten(EERegs& ee, Mem& mem, EEBlock& b, uint32_t& executed) {
+    uint32_t n = 0;
+    b.hits++;
+    ee.branchTaken = false;
+    const int32_t body = b.branchIdx < 0 ? static_cast<int32_t>(b.ops.size()) : b.branchIdx + 1;
+    for (int32_t i = 0; i < body; ++i) {
+        const EEBlockOp& op = b.ops[i];
+        ee.pc = b.startPc + (static_cast<uint32_t>(i) << 2);
+        if (op.fn(ee, mem, op.d) == ExecResult::Exception) {
+            executed = n;
+            return ExecResult::Exception;
+        }
+        ++n;
+    }
+    const bool taken = ee.branchTaken;
+    const uint32_t target = ee.branchTarget;
+    ee.branchTaken = false;
+    if (b.flow == EEFlow::Branch || (b.flow == EEFlow::BranchLikely && taken)) {
+        const EEBlockOp& op = b.ops[body];
+        ee.pc = b.startPc + (static_cast<uint32_t>(body) << 2);
+        ee.delaySlot = true;
+        const ExecResult r = op.fn(ee, mem, op.d);
+        ee.delaySlot = false;
+        ee.branchTaken = false;
+        if (r == ExecResult::Exception) {
+            executed = n;
+            return r;
+        }
+        ++n;
+    }
+    ee.pc = taken ? target : b.endPc;
+    ee.nextPc = ee.pc + 4;
+    executed = n;
+    return ExecResult::Ok;
+}
+
+static uint64_t runHandWritten(EERegs& ee, Mem& mem, EEBlockCache& c) {
+    uint64_t executed = 0;
+    while (ee.pc != EXIT_PC) {
+        uint32_t n = 0;
+        execHandWritten(ee, mem, *eeBlockLookup(c, ee, mem), n);
+        executed += n;
+    }
+    return executed;
+}
+
+template <class P>
+static uint64_t runPolicy(EERegs& ee, Mem& mem, EEBlockCache& c, EERunHooks* hooks) {
+    uint64_t executed = 0;
+    while (ee.pc != EXIT_PC) {
+        uint32_t n = 0;
+        eeExecBlockT<P>(ee, mem, *eeBlockLookup(c, ee, mem), hooks, n);
+        executed += n;
+    }
+    return executed;
+}
+
+static void countCycles(void* user, uint32_t cycles) {
+    *static_cast<uint64_t*>(user) += cycles;
+}
+
+template <class Run>
+static void measure(const char* name, EERegs& ee, Run&& run) {
+    uint64_t executed = 0;
+    // The rows differ by a few percent at most, so take the best of more runs
+    const double ns = benchBestNs(15, [&] {
+        eeInit(ee, LOOP_PC);
+        ee.GPR[2].UD[0] = ITERATIONS;
+        executed = run();
+    });
+    g_benchSink = g_benchSink + ee.GPR[7].UD[0] + executed;
+    if (executed != INSNS) std::printf("  %s: ran %llu instructions, expected %llu\n", name,
+                                       static_cast<unsigned long long>(executed), static_cast<unsigned long long>(INSNS));
+    benchReport(name, ns, INSNS, "insn");
+}
+
+void benchRunPolicy() {
+    static Mem mem;
+    if (!memInit(mem)) return;
+    for (uint32_t i = 0; i < sizeof(kLoop) / 4; ++i) memWrite32(mem, LOOP_PC + i * 4, kLoop[i]);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+    EERegs ee;
+    EERunHooks hooks;
+    uint64_t cycles = 0;
+    hooks.onCycles = countCycles;
+    hooks.onCyclesUser = &cycles;
+
+    measure("hand-written, no hooks", ee, [&] { return runHandWritten(ee, mem, cache); });
+    measure("RunPolicy<false,false,false>", ee, [&] { return runPolicy<EERunFast>(ee, mem, cache, nullptr); });
+    measure("RunPolicy<true,false,false>", ee, [&] { return runPolicy<RunPolicy<true, false, false>>(ee, mem, cache, &hooks); });
+    measure("RunPolicy<true,true,true>", ee, [&] { return runPolicy<RunPolicy<true, true, true>>(ee, mem, cache, &hooks); });
+    g_benchSink = g_benchSink + cycles + hooks.traced;
+}
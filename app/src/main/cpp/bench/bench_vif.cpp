@@ -0,0 +1,56 @@
+// VIF UNPACK per format: 256-element UNPACKs into VU0 data memory fed
+// through vifTransfer, counted in quadwords written
+#include "bench.h"
+#include "vif.h"
+#include <vector>
+
+static constexpr uint32_t UNPACKS = 256;          // per run
+static constexpr uint32_t STCYCL_1_1 = 0x01000101;
+
+static const char* const kFormat[16] = {
+    "S-32", "S-16", "S-8", nullptr, "V2-32", "V2-16", "V2-8", nullptr,
+    "V3-32", "V3-16", "V3-8", nullptr, "V4-32", "V4-16", "V4-8", "V4-5",
+};
+static constexpr uint32_t kBits[16] = {32, 16, 8, 0, 64, 32, 16, 0, 96, 48, 24, 0, 128, 64, 32, 16};
+
+// STCYCL, then UNPACKS full-memory UNPACKs of format vnvl, NOP-padded to a
+// quadword; masked adds STMASK/STMOD so the write stage merges ROW and COL
+static std::vector<uint32_t> unpackStream(uint32_t vnvl, bool masked) {
+    std::vector<uint32_t> s{STCYCL_1_1};
+    if (masked) {
+        s.insert(s.end(), {0x20000000, 0x90909090});    // STMASK: x/y data, z row, w col
+        s.push_back(0x05000001);                        // STMOD offset
+    }
+    const uint32_t words = (256 * kBits[vnvl] + 31) / 32;
+    uint32_t seed = 1;
+    for (uint32_t u = 0; u < UNPACKS; ++u) {
+        s.push_back((0x60u | (masked ? 0x10u : 0u) | vnvl) << 24);   // num 0 = 256, addr 0
+        for (uint32_t w = 0; w < words; ++w) s.push_back(seed = seed * 1664525u + 1013904223u);
+    }
+    while (s.size() % 4) s.push_back(0);
+    return s;
+}
+
+static void measure(const char* name, VIF& vif, const std::vector<uint32_t>& stream) {
+    const uint32_t qwc = static_cast<uint32_t>(stream.size() / 4);
+    uint32_t accepted = 0;
+    const double ns = benchBestNs(5, [&] {
+        vifReset(vif);
+        accepted = vifTransfer(vif, stream.data(), qwc);
+    });
+    if (accepted != qwc) std::printf("  %s: VIF stalled after %u of %u quadwords\n", name, accepted, qwc);
+    g_benchSink = g_benchSink + vif.vu->data[255].UL[0];
+    benchReport(name, ns, uint64_t(UNPACKS) * 256, "qword");
+}
+
+void benchVifUnpack() {
+    VU vu0;
+    vuInit(vu0, 0);
+    VIF vif0;
+    vifInit(vif0, 0, &vu0, nullptr, nullptr);
+
+    for (uint32_t vnvl = 0; vnvl < 16; ++vnvl) {
+        if (kFormat[vnvl]) measure(kFormat[vnvl], vif0, unpackStream(vnvl, false));
+    }
+    measure("V4-8 masked, offset mode", vif0, unpackStream(14, true));
+}
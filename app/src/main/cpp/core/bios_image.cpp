@@ -0,0 +1,56 @@
+#include "bios_image.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Takes ownership of fd
+static BiosImage* biosImageMap(int fd) {
+    struct stat st;
+    if (fd < 0) return nullptr;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || static_cast<uint64_t>(st.st_size) > BIOS_MAX_SIZE) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    // Fetches walk the ROM front to back during boot
+    madvise(p, size, MADV_WILLNEED);
+
+    BiosImage* img = new BiosImage;
+    img->data = static_cast<const uint8_t*>(p);
+    img->size = size;
+    img->fd = fd;
+    img->map = p;
+    return img;
+}
+
+BiosImage* biosImageOpen(const char* path) {
+    if (!path) return nullptr;
+    return biosImageMap(open(path, O_RDONLY | O_CLOEXEC));
+}
+
+BiosImage* biosImageOpenFd(int fd) {
+    if (fd < 0) return nullptr;
+    return biosImageMap(fcntl(fd, F_DUPFD_CLOEXEC, 0));
+}
+
+BiosImage* biosImageCopy(const uint8_t* data, size_t size) {
+    if (!data || size == 0 || size > BIOS_MAX_SIZE) return nullptr;
+    BiosImage* img = new BiosImage;
+    img->copy.assign(data, data + size);
+    img->data = img->copy.data();
+    img->size = size;
+    return img;
+}
+
+void biosImageFree(BiosImage* img) {
+    if (!img) return;
+    if (img->map) munmap(img->map, img->size);
+    if (img->fd >= 0) close(img->fd);
+    delete img;
+}
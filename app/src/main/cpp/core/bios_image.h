@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A BIOS image as handed to the core. It is never modified once built, so
+// the emulator reads it without locking; replacing the BIOS means building
+// a new image and publishing that instead.
+//
+// Images opened from a file map it read-only (no copy) and keep a
+// descriptor so fastmem can map the same pages. Images built from a byte
+// buffer hold their own copy.
+// The ROM window at 0x1FC00000; everything past it belongs to other devices
+static constexpr size_t BIOS_MAX_SIZE = 4 * 1024 * 1024;
+
+struct BiosImage {
+    const uint8_t* data = nullptr;
+    size_t         size = 0;
+    uint64_t       hash = 0;    // eeTcacheHash of the bytes, set by the loader
+
+    int            fd = -1;     // file holding the bytes at offset 0, or -1
+    void*          map = nullptr;
+    std::vector<uint8_t> copy;
+};
+
+// nullptr when the file can't be opened, is empty, is larger than
+// BIOS_MAX_SIZE or can't be mapped; biosImageCopy rejects the same sizes.
+// biosImageOpenFd duplicates fd; the caller still owns (and closes) its own.
+BiosImage* biosImageOpen(const char* path);
+BiosImage* biosImageOpenFd(int fd);
+BiosImage* biosImageCopy(const uint8_t* data, size_t size);
+void       biosImageFree(BiosImage* img);
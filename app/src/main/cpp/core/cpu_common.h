@@ -2,5 +2,7 @@
 
 enum class ExecResult {
     Ok,
-    Exception
+    Exception,
+    Breakpoint, // stopped before a breakpoint address (see ee_run.h)
+    Idle        // spinning in an idle loop at pc; nothing changes until an event
 };
\ No newline at end of file
@@ -1,89 +1,468 @@
 #include "dma_stub.h"
 #include "mem_map.h"
-#include "gs_stub.h"
+#include "gif_fifo.h"
+#include "vif.h"
+#include "ipu.h"
+#include "scheduler.h"
 #include <cstdint>
+#include <algorithm>
 #include <cstring>
 
-// Simple helpers for register mapping (addresses illustrative)
-static inline bool isGifChannelActive(const DMAChannel& ch) {
-    // CHCR STR bit (bit 8) indicates start/active
-    return (ch.chcr & 0x100u) != 0;
+// D_CTRL, D_STAT, D_PCR, D_ENABLEW bits
+static constexpr uint32_t CTRL_DMAE   = 1u << 0;
+static constexpr uint32_t STAT_SIS    = 1u << 13;
+static constexpr uint32_t STAT_BEIS   = 1u << 15;
+static constexpr uint32_t PCR_PCE     = 1u << 31;
+static constexpr uint32_t ENABLE_CPND = 1u << 16;
+
+// Tag IDs. Source chain uses all eight; destination chain only CNTS, CNT
+// and END.
+enum : uint32_t { TAG_REFE, TAG_CNT, TAG_NEXT, TAG_REF, TAG_REFS, TAG_CALL, TAG_RET, TAG_END };
+static constexpr uint32_t TAG_CNTS = 0;
+
+// Bus time in EE cycles: a quadword per BUSCLK, and a tag fetch
+static constexpr uint32_t DMA_QWC_CYCLES = 2;
+static constexpr uint32_t DMA_TAG_CYCLES = 2;
+// Quadwords a channel moves before the bus is arbitrated again
+static constexpr uint32_t DMA_BURST_QWC = 256;
+// How soon a channel held up by its device tries again
+static constexpr uint32_t DMA_RETRY_CYCLES = 2048;
+
+// MOD: 0 normal, 1 chain, 2 interleave; 3 is undefined and runs as chain
+static inline uint32_t dmaMode(const DMAChannel& ch)       { return (ch.chcr & DMA_CHCR_MOD) >> 2; }
+static inline bool     dmaChain(const DMAChannel& ch)      { return dmaMode(ch) & 1; }
+static inline bool     dmaInterleave(const DMAChannel& ch) { return dmaMode(ch) == 2; }
+
+// Channels writing memory: fromIPU, SIF0, fromSPR, and VIF1 with DIR clear
+static inline bool dmaToMemory(const DMAChannel& ch, uint32_t i) {
+    return i == DMA_FROM_IPU || i == DMA_SIF0 || i == DMA_FROM_SPR || (i == DMA_VIF1 && !(ch.chcr & DMA_CHCR_DIR));
+}
+
+// D_CTRL STS/STD: the channel whose writes set D_STADR, and the one held
+// behind it
+static inline uint32_t dmaStallSource(const DMAC& d) {
+    static constexpr uint32_t src[4] = {DMA_CHANNEL_COUNT, DMA_SIF0, DMA_FROM_SPR, DMA_FROM_IPU};
+    return src[(d.ctrl >> 4) & 3];
+}
+
+static inline uint32_t dmaStallDrain(const DMAC& d) {
+    static constexpr uint32_t drain[4] = {DMA_CHANNEL_COUNT, DMA_VIF1, DMA_GIF, DMA_SIF1};
+    return drain[(d.ctrl >> 6) & 3];
+}
+
+// D_SQWC TQWC; 0 transfers without skipping
+static inline uint32_t dmaTqwc(const DMAC& d) {
+    const uint32_t tqwc = (d.sqwc >> 16) & 0xFF;
+    return tqwc ? tqwc : UINT32_MAX;
 }
 
-void dmaInit(DMAC& dmac) {
-    std::memset(&dmac, 0, sizeof(DMAC));
-    // Default priorities, masks, etc. can be set here if needed
-    // For now, keep it minimal.
+// Host memory at a DMA address (bit 31 picks the scratchpad) and how many
+// quadwords follow before that memory ends
+static uint8_t* dmaMemory(Mem& mem, uint32_t addr, uint32_t& room) {
+    if (addr & 0x80000000u) {
+        const uint32_t off = addr & (MEM_SCRATCH_SIZE - 1) & ~15u;
+        room = (MEM_SCRATCH_SIZE - off) / 16;
+        return mem.scratch.data() + off;
+    }
+    const size_t off = addr & (mem.ram.size() - 1) & ~size_t(15);
+    room = static_cast<uint32_t>((mem.ram.size() - off) / 16);
+    return mem.ram.data() + off;
 }
 
-// Returns number of GIF pushes (QWC processed)
-uint32_t dmaStep(DMAC& dmac, Mem& mem, GS& gs) {
-    uint32_t gifPushes = 0;
+// Memory to the channel's device in contiguous runs; returns the quadwords
+// it took
+static uint32_t dmaSend(DMAC& d, uint32_t i, uint32_t addr, uint32_t qwc) {
+    const DMAPort& port = d.ports[i];
+    uint32_t total = 0;
+    while (qwc) {
+        uint32_t room;
+        const uint8_t* p = dmaMemory(*d.mem, addr, room);
+        const uint32_t n = std::min(qwc, room);
+        const uint32_t done = port.push ? port.push(port.dev, reinterpret_cast<const uint32_t*>(p), n) : n;
+        total += done;
+        if (done < n) break;
+        addr += n * 16;
+        qwc -= n;
+    }
+    return total;
+}
+
+// Device to memory; RAM written this way drops any code cached there
+static uint32_t dmaReceive(DMAC& d, uint32_t i, uint32_t addr, uint32_t qwc) {
+    const DMAPort& port = d.ports[i];
+    if (!port.pull) return 0;
+    uint32_t total = 0;
+    while (qwc) {
+        uint32_t room;
+        uint8_t* p = dmaMemory(*d.mem, addr, room);
+        const uint32_t n = std::min(qwc, room);
+        const uint32_t done = port.pull(port.dev, reinterpret_cast<uint32_t*>(p), n);
+        if (!(addr & 0x80000000u)) memRamWritten(*d.mem, static_cast<uint32_t>(p - d.mem->ram.data()), done * 16);
+        total += done;
+        if (done < n) break;
+        addr += n * 16;
+        qwc -= n;
+    }
+    return total;
+}
 
-    // GIF channel is channel 2
-    DMAChannel& ch2 = dmac.channels[2];
+// toSPR / fromSPR: the scratchpad end, walked by SADR
+static uint32_t dmaSprPush(void* dev, const uint32_t* data, uint32_t qwc) {
+    DMAC& d = *static_cast<DMAC*>(dev);
+    uint32_t& sadr = d.channels[DMA_TO_SPR].sadr;
+    for (uint32_t left = qwc; left;) {
+        const uint32_t off = sadr & (MEM_SCRATCH_SIZE - 1) & ~15u;
+        const uint32_t n = std::min(left, (MEM_SCRATCH_SIZE - off) / 16);
+        std::memcpy(d.mem->scratch.data() + off, data, n * 16);
+        data += n * 4;
+        sadr = (off + n * 16) & (MEM_SCRATCH_SIZE - 1);
+        left -= n;
+    }
+    return qwc;
+}
 
-    if (isGifChannelActive(ch2)) {
-        // Source pointer in RAM (wrap to RAM size)
-        const size_t ramMask = mem.ram.size() - 1;
-        const uint8_t* base  = mem.ram.data();
-        const size_t   madr  = static_cast<size_t>(ch2.madr) & ramMask;
+static uint32_t dmaSprPull(void* dev, uint32_t* data, uint32_t qwc) {
+    DMAC& d = *static_cast<DMAC*>(dev);
+    uint32_t& sadr = d.channels[DMA_FROM_SPR].sadr;
+    for (uint32_t left = qwc; left;) {
+        const uint32_t off = sadr & (MEM_SCRATCH_SIZE - 1) & ~15u;
+        const uint32_t n = std::min(left, (MEM_SCRATCH_SIZE - off) / 16);
+        std::memcpy(data, d.mem->scratch.data() + off, n * 16);
+        data += n * 4;
+        sadr = (off + n * 16) & (MEM_SCRATCH_SIZE - 1);
+        left -= n;
+    }
+    return qwc;
+}
 
-        const uint32_t* src = reinterpret_cast<const uint32_t*>(base + madr);
-        int qwc = static_cast<int>(ch2.qwc);
+// QWC, PCE and the IRQ stop from a tag; its upper half goes to CHCR.TAG.
+// Returns the ID.
+static uint32_t dmaTakeTag(DMAC& d, DMAChannel& ch, uint64_t tag) {
+    ch.qwc  = static_cast<uint32_t>(tag) & 0xFFFF;
+    ch.chcr = (ch.chcr & 0xFFFF) | (static_cast<uint32_t>(tag) & 0xFFFF0000u);
+    const uint32_t pce = (tag >> 26) & 3;
+    if (pce == 2) d.pcr &= ~PCR_PCE;
+    if (pce == 3) d.pcr |= PCR_PCE;
+    ch.tagEnd  = ((tag >> 31) & 1) && (ch.chcr & DMA_CHCR_TIE);
+    ch.tagRefs = false;
+    return (tag >> 28) & 7;
+}
 
-        if (src && qwc > 0) {
-            // Feed packet into GS
-            gsProcessGifPacket(gs, src, qwc);
-            gifPushes += static_cast<uint32_t>(qwc);
+// ADDR plus the SPR bit, which lands on bit 31
+static inline uint32_t dmaTagAddr(uint64_t tag) {
+    return static_cast<uint32_t>(tag >> 32) & 0xFFFFFFF0u;
+}
 
-            // Advance DMA state: each QWC = 16 bytes (128 bits)
-            ch2.madr += static_cast<uint32_t>(qwc * 16);
-            ch2.qwc   = 0;
-            ch2.chcr &= ~0x100u; // clear STR (stop)
+// Source chain: follow the tag at TADR. False while the device won't take
+// the copy TTE sends ahead of the data.
+static bool dmaSourceTag(DMAC& d, uint32_t i) {
+    DMAChannel& ch = d.channels[i];
+    uint32_t room;
+    const uint32_t* p = reinterpret_cast<const uint32_t*>(dmaMemory(*d.mem, ch.tadr, room));
+    if (ch.chcr & DMA_CHCR_TTE) {
+        // The device sees the upper half; the DMAtag half goes as zeros
+        alignas(16) const uint32_t q[4] = {0, 0, p[2], p[3]};
+        const DMAPort& port = d.ports[i];
+        if (port.push && port.push(port.dev, q, 1) == 0) return false;
+    }
+    uint64_t tag;
+    std::memcpy(&tag, p, sizeof(tag));
+    const uint32_t id   = dmaTakeTag(d, ch, tag);
+    const uint32_t addr = dmaTagAddr(tag);
+    uint32_t asp = (ch.chcr & DMA_CHCR_ASP) >> 4;
+    switch (id) {
+    case TAG_REFE:
+        ch.madr = addr;
+        ch.tadr += 16;
+        ch.tagEnd = true;
+        break;
+    case TAG_CNT:
+        ch.madr = ch.tadr + 16;
+        ch.tadr = ch.madr + ch.qwc * 16;
+        break;
+    case TAG_NEXT:
+        ch.madr = ch.tadr + 16;
+        ch.tadr = addr;
+        break;
+    case TAG_REFS:
+        ch.tagRefs = true;
+        [[fallthrough]];
+    case TAG_REF:
+        ch.madr = addr;
+        ch.tadr += 16;
+        break;
+    case TAG_CALL:
+        ch.madr = ch.tadr + 16;
+        if (asp >= 2) {
+            // Two levels deep already
+            d.stat |= STAT_BEIS;
+            ch.tagEnd = true;
+            break;
+        }
+        (asp ? ch.asr1 : ch.asr0) = ch.madr + ch.qwc * 16;
+        asp++;
+        ch.tadr = addr;
+        break;
+    case TAG_RET:
+        ch.madr = ch.tadr + 16;
+        if (asp) {
+            asp--;
+            ch.tadr = asp ? ch.asr1 : ch.asr0;
+        } else {
+            ch.tagEnd = true;
         }
+        break;
+    default: // TAG_END
+        ch.madr = ch.tadr + 16;
+        ch.tagEnd = true;
+        break;
     }
+    ch.chcr = (ch.chcr & ~DMA_CHCR_ASP) | (asp << 4);
+    return true;
+}
+
+// Destination chain: the tag is the first quadword the device sends
+static bool dmaDestTag(DMAC& d, uint32_t i) {
+    DMAChannel& ch = d.channels[i];
+    const DMAPort& port = d.ports[i];
+    alignas(16) uint32_t q[4];
+    if (!port.pull || port.pull(port.dev, q, 1) == 0) return false;
+    const uint64_t tag = q[0] | (uint64_t(q[1]) << 32);
+    const uint32_t id = dmaTakeTag(d, ch, tag);
+    ch.madr = dmaTagAddr(tag);
+    if (id == TAG_END) {
+        ch.tagEnd = true;
+    } else if (id != TAG_CNTS && id != TAG_CNT) {
+        d.stat |= STAT_BEIS;
+        ch.qwc = 0;
+        ch.tagEnd = true;
+    }
+    return true;
+}
+
+// One burst of at most budget quadwords on channel i. Returns the EE cycles
+// it holds the bus, 0 when the channel can't move right now.
+static uint32_t dmaService(DMAC& d, uint32_t i, uint32_t budget) {
+    DMAChannel& ch = d.channels[i];
+    const bool toMem = dmaToMemory(ch, i);
+    uint32_t cycles = 0;
+    while (budget) {
+        if (ch.qwc == 0) {
+            if (!dmaChain(ch) || ch.tagEnd) {
+                // Done once this burst has left the bus
+                d.ending |= 1u << i;
+                return std::max(cycles, 1u);
+            }
+            if (!(toMem ? dmaDestTag(d, i) : dmaSourceTag(d, i))) break;
+            cycles += DMA_TAG_CYCLES;
+            continue;
+        }
+
+        uint32_t n = std::min(ch.qwc, budget);
+        if (dmaInterleave(ch)) n = std::min(n, ch.ilvLeft);
+        // The drain channel stays behind what the stall source has written
+        if (i == dmaStallDrain(d) && (!dmaChain(ch) || ch.tagRefs)) {
+            const uint32_t avail = d.stadr > ch.madr ? (d.stadr - ch.madr) / 16 : 0;
+            if (!avail) {
+                d.stat |= STAT_SIS;
+                break;
+            }
+            n = std::min(n, avail);
+        }
 
-    // You can add other channels here (VIF0/1, SIF, etc.) as needed.
+        const uint32_t done = toMem ? dmaReceive(d, i, ch.madr, n) : dmaSend(d, i, ch.madr, n);
+        ch.madr += done * 16;
+        ch.qwc  -= done;
+        budget  -= done;
+        cycles  += done * DMA_QWC_CYCLES;
+        d.moved += done;
+        if (toMem && i == dmaStallSource(d)) d.stadr = ch.madr;
+        if (dmaInterleave(ch) && done) {
+            ch.ilvLeft -= done;
+            if (!ch.ilvLeft) {
+                ch.madr += (d.sqwc & 0xFF) * 16;
+                ch.ilvLeft = dmaTqwc(d);
+            }
+        }
+        if (done < n) break;
+    }
+    return cycles;
+}
 
-    return gifPushes;
+static inline bool dmaReady(const DMAC& d, uint32_t i) {
+    if (!(d.channels[i].chcr & DMA_CHCR_STR) || ((d.ending >> i) & 1)) return false;
+    // With priority control on, only channels enabled in CDE get the bus
+    return !(d.pcr & PCR_PCE) || ((d.pcr >> (16 + i)) & 1);
 }
 
-// Minimal register read (map a few core regs; expand as needed)
-uint32_t dmaReadReg(const DMAC& dmac, uint32_t addr) {
-    // Example mapping (addresses illustrative; align with your mem_map)
-    // D_CTRL: 0x1000E000, D_STAT: 0x1000E010, D_PCR: 0x1000E020, D_SQWC: 0x1000E030
-    switch (addr) {
-        case 0x1000E000: return dmac.ctrl;
-        case 0x1000E010: return dmac.stat;
-        case 0x1000E020: return dmac.pcr;
-        case 0x1000E030: return dmac.sqwc;
-        default:
-            // Channel CHCR/MADR/TADR/QWC reads could be added here
-            return 0;
+// Retire the channels whose last burst is over, then give the bus to the
+// first channel in priority order that can move
+static void dmaEvent(void* dev, uint64_t when) {
+    DMAC& d = *static_cast<DMAC*>(dev);
+    d.polling = false;
+    for (uint32_t i = 0; d.ending; ++i) {
+        if (!((d.ending >> i) & 1)) continue;
+        d.channels[i].chcr &= ~DMA_CHCR_STR;
+        d.stat |= 1u << i;
+        d.ending &= ~(1u << i);
+    }
+    if (!(d.ctrl & CTRL_DMAE) || (d.enable & ENABLE_CPND)) return;
+
+    bool blocked = false;
+    for (uint32_t i = 0; i < DMA_CHANNEL_COUNT; ++i) {
+        if (!dmaReady(d, i)) continue;
+        if (const uint32_t cycles = dmaService(d, i, DMA_BURST_QWC)) {
+            d.bursts++;
+            schedAt(*d.sched, SCHED_DMA, when + cycles);
+            return;
+        }
+        const DMAPort& port = d.ports[i];
+        blocked |= dmaToMemory(d.channels[i], i) ? port.pull != nullptr : port.push != nullptr;
+    }
+    // Only a device can let these go; register writes kick the rest
+    if (blocked) {
+        d.polling = true;
+        schedAt(*d.sched, SCHED_DMA, when + DMA_RETRY_CYCLES);
     }
 }
 
-// Minimal register write (update core regs; expand as needed)
-void dmaWriteReg(DMAC& dmac, Mem& mem, uint32_t addr, uint32_t val) {
-    (void)mem; // currently unused in this stub
+// Arbitrate at the end of the current slice, unless a burst holds the bus
+static void dmaKick(DMAC& d) {
+    if (!schedPending(*d.sched, SCHED_DMA) || d.polling) {
+        d.polling = false;
+        schedAt(*d.sched, SCHED_DMA, d.sched->now);
+    }
+}
 
-    switch (addr) {
-        case 0x1000E000: // D_CTRL
-            dmac.ctrl = val;
-            break;
-        case 0x1000E010: // D_STAT
-            dmac.stat = val;
-            break;
-        case 0x1000E020: // D_PCR
-            dmac.pcr = val;
-            break;
-        case 0x1000E030: // D_SQWC
-            dmac.sqwc = val;
-            break;
-        default:
-            // Channel register writes (e.g., CHCR/MADR/TADR/QWC) should be handled
-            // via your mem_map MMIO handlers that update dmac.channels[n].
-            break;
+void dmaInit(DMAC& dmac, Mem& mem, Scheduler& sched) {
+    dmac = DMAC{};
+    dmac.enable = 0x1201; // D_ENABLER reset value
+    dmac.mem = &mem;
+    dmac.sched = &sched;
+    dmac.ports[DMA_TO_SPR]   = DMAPort{dmaSprPush, nullptr, &dmac};
+    dmac.ports[DMA_FROM_SPR] = DMAPort{nullptr, dmaSprPull, &dmac};
+    schedSetHandler(sched, SCHED_DMA, dmaEvent, &dmac);
+    schedCancel(sched, SCHED_DMA);
+}
+
+void dmaAttach(DMAC& dmac, DMAChannelId channel, const DMAPort& port) {
+    dmac.ports[channel] = port;
+}
+
+// Takes the whole burst; a full GS ring holds up the EE rather than the bus
+static uint32_t dmaGifPush(void* dev, const uint32_t* data, uint32_t qwc) {
+    gifFifoPush(*static_cast<GIFFifo*>(dev), data, qwc);
+    return qwc;
+}
+
+// The VIF may stall part way; commands it already queued go first
+static uint32_t dmaVifPush(void* dev, const uint32_t* data, uint32_t qwc) {
+    VIF& vif = *static_cast<VIF*>(dev);
+    return vifUpdate(vif) ? vifTransfer(vif, data, qwc) : 0;
+}
+
+static uint32_t dmaIpuPush(void* dev, const uint32_t* data, uint32_t qwc) {
+    return ipuPushInput(*static_cast<IPU*>(dev), data, qwc);
+}
+
+static uint32_t dmaIpuPull(void* dev, uint32_t* data, uint32_t qwc) {
+    return ipuPopOutput(*static_cast<IPU*>(dev), data, qwc);
+}
+
+DMAPort dmaGifPort(GIFFifo& gif) { return DMAPort{dmaGifPush, nullptr, &gif}; }
+DMAPort dmaVifPort(VIF& vif)   { return DMAPort{dmaVifPush, nullptr, &vif}; }
+DMAPort dmaIpuInPort(IPU& ipu) { return DMAPort{dmaIpuPush, nullptr, &ipu}; }
+DMAPort dmaIpuOutPort(IPU& ipu) { return DMAPort{nullptr, dmaIpuPull, &ipu}; }
+
+static inline uint32_t dmaChannelAt(uint32_t addr) {
+    uint32_t i = 0;
+    while (i + 1 < DMA_CHANNEL_COUNT && DMA_CHANNEL_BASE[i] != (addr & ~0xFFu)) ++i;
+    return i;
+}
+
+static uint64_t dmaReadChcr(void* dev, uint32_t addr, uint32_t) {
+    return static_cast<DMAC*>(dev)->channels[dmaChannelAt(addr)].chcr;
+}
+
+// Setting STR starts the channel; in chain mode it may pick up part way
+// through a tag, whose ID (in CHCR.TAG) says whether it is the last
+static void dmaWriteChcr(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    DMAC& d = *static_cast<DMAC*>(dev);
+    const uint32_t i = dmaChannelAt(addr);
+    DMAChannel& ch = d.channels[i];
+    const uint32_t v = static_cast<uint32_t>(value);
+    const bool start = (v & DMA_CHCR_STR) && !(ch.chcr & DMA_CHCR_STR);
+    ch.chcr = v;
+    if (!start) return;
+
+    const uint32_t id = (v >> 28) & 7;
+    const bool toMem = dmaToMemory(ch, i);
+    ch.tagEnd  = ch.qwc && (id == TAG_END || (!toMem && id == TAG_REFE) ||
+                            (((v >> 31) & 1) && (v & DMA_CHCR_TIE)));
+    ch.tagRefs = !toMem && id == TAG_REFS;
+    ch.ilvLeft = dmaTqwc(d);
+    d.ending &= ~(1u << i);
+    dmaKick(d);
+}
+
+// D_CTRL, D_PCR, D_STADR and D_ENABLEW can let a waiting channel go
+template <uint32_t DMAC::*Reg>
+static uint64_t dmaReadReg(void* dev, uint32_t, uint32_t) {
+    return static_cast<DMAC*>(dev)->*Reg;
+}
+
+template <uint32_t DMAC::*Reg>
+static void dmaWriteKick(void* dev, uint32_t, uint64_t value, uint32_t) {
+    DMAC& d = *static_cast<DMAC*>(dev);
+    d.*Reg = static_cast<uint32_t>(value);
+    dmaKick(d);
+}
+
+template <uint32_t DMAC::*Reg>
+static MemMmioSlot dmaKickReg(DMAC& dmac) {
+    return MemMmioSlot{dmaReadReg<Reg>, dmaWriteKick<Reg>, nullptr, nullptr, &dmac};
+}
+
+// D_STAT: writing 1 clears an interrupt status bit and flips a mask bit
+static void dmaWriteStat(void* stat, uint32_t, uint64_t value, uint32_t) {
+    uint32_t& reg = *static_cast<uint32_t*>(stat);
+    const uint32_t v = static_cast<uint32_t>(value);
+    reg = (reg & ~(v & 0xE3FFu)) ^ (v & 0x63FF0000u);
+}
+
+void dmaMapMmio(DMAC& dmac, Mem& mem) {
+    for (size_t i = 0; i < dmac.channels.size(); ++i) {
+        DMAChannel& ch = dmac.channels[i];
+        const uint32_t base = DMA_CHANNEL_BASE[i];
+        memMapMmio(mem, base + 0x00, 16, MemMmioSlot{dmaReadChcr, dmaWriteChcr, nullptr, nullptr, &dmac});
+        memMapMmio(mem, base + 0x10, 16, memMmioReg(&ch.madr));
+        memMapMmio(mem, base + 0x20, 16, memMmioReg(&ch.qwc));
+        memMapMmio(mem, base + 0x30, 16, memMmioReg(&ch.tadr));
+        memMapMmio(mem, base + 0x40, 16, memMmioReg(&ch.asr0));
+        memMapMmio(mem, base + 0x50, 16, memMmioReg(&ch.asr1));
+        memMapMmio(mem, base + 0x80, 16, memMmioReg(&ch.sadr));
     }
-}
\ No newline at end of file
+
+    MemMmioSlot stat = memMmioReg(&dmac.stat);
+    stat.write = dmaWriteStat;
+    memMapMmio(mem, 0x1000E000, 16, dmaKickReg<&DMAC::ctrl>(dmac));
+    memMapMmio(mem, 0x1000E010, 16, stat);
+    memMapMmio(mem, 0x1000E020, 16, dmaKickReg<&DMAC::pcr>(dmac));
+    memMapMmio(mem, 0x1000E030, 16, memMmioReg(&dmac.sqwc));
+    memMapMmio(mem, 0x1000E040, 16, memMmioReg(&dmac.rbsr));
+    memMapMmio(mem, 0x1000E050, 16, memMmioReg(&dmac.rbor));
+    memMapMmio(mem, 0x1000E060, 16, dmaKickReg<&DMAC::stadr>(dmac));
+
+    // D_ENABLER reads what D_ENABLEW wrote
+    MemMmioSlot enabler = memMmioReg(&dmac.enable);
+    MemMmioSlot enablew = dmaKickReg<&DMAC::enable>(dmac);
+    enabler.write = nullptr;
+    enablew.read  = nullptr;
+    memMapMmio(mem, 0x1000F520, 16, enabler);
+    memMapMmio(mem, 0x1000F590, 16, enablew);
+
+    // Transfers only move on DMA events, so guests may poll all of these
+    for (uint32_t base : DMA_CHANNEL_BASE) memMmioEventDriven(mem, base, 0x90);
+    memMmioEventDriven(mem, 0x1000E000, 0x70);
+    memMmioEventDriven(mem, 0x1000F520, 16);
+}
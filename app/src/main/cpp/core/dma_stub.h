@@ -2,14 +2,51 @@
 #include <cstdint>
 #include <array>
 
-struct Mem; // forward declaration
-struct GS;  // forward declaration
+struct Mem;     // forward declaration
+struct GIFFifo; // forward declaration
+struct VIF;     // forward declaration
+struct IPU;     // forward declaration
+struct Scheduler;
+
+// Channel numbers, in priority order
+enum DMAChannelId : uint32_t {
+    DMA_VIF0, DMA_VIF1, DMA_GIF, DMA_FROM_IPU, DMA_TO_IPU,
+    DMA_SIF0, DMA_SIF1, DMA_SIF2, DMA_FROM_SPR, DMA_TO_SPR,
+    DMA_CHANNEL_COUNT
+};
+
+// CHCR bits
+static constexpr uint32_t DMA_CHCR_DIR = 1u << 0;   // from memory (VIF1)
+static constexpr uint32_t DMA_CHCR_MOD = 3u << 2;   // normal, chain, interleave
+static constexpr uint32_t DMA_CHCR_ASP = 3u << 4;   // CALL stack depth
+static constexpr uint32_t DMA_CHCR_TTE = 1u << 6;   // send tags along
+static constexpr uint32_t DMA_CHCR_TIE = 1u << 7;   // stop on a tag's IRQ bit
+static constexpr uint32_t DMA_CHCR_STR = 1u << 8;
+
+// A channel's peripheral end. Channels reading memory push to it, the rest
+// pull from it; both return the quadwords taken or produced, fewer when
+// the device stalls. A channel without a port drops what it sends and
+// waits forever for what it receives.
+struct DMAPort {
+    uint32_t (*push)(void* dev, const uint32_t* data, uint32_t qwc) = nullptr;
+    uint32_t (*pull)(void* dev, uint32_t* data, uint32_t qwc) = nullptr;
+    void* dev = nullptr;
+};
 
 struct DMAChannel {
     uint32_t madr = 0; // Memory Address
     uint32_t tadr = 0; // Tag Address
     uint32_t qwc  = 0; // Quadword Count
     uint32_t chcr = 0; // Control Register
+    uint32_t asr0 = 0; // Tag Address Stack (CALL/RET)
+    uint32_t asr1 = 0;
+    uint32_t sadr = 0; // Scratchpad Address
+
+    // Transfer state: the current tag is the last one, it was REFS (stall
+    // controlled), and quadwords left in the interleave block
+    bool     tagEnd = false;
+    bool     tagRefs = false;
+    uint32_t ilvLeft = 0;
 };
 
 struct DMAC {
@@ -18,10 +55,48 @@ struct DMAC {
     uint32_t stat = 0;   // D_STAT
     uint32_t pcr  = 0;   // D_PCR (Priority Control)
     uint32_t sqwc = 0;   // D_SQWC (Skip Quadword Count)
+    uint32_t rbsr = 0;   // D_RBSR (Ring Buffer Size)
+    uint32_t rbor = 0;   // D_RBOR (Ring Buffer Offset)
+    uint32_t stadr = 0;  // D_STADR (Stall Address)
+    uint32_t enable = 0; // D_ENABLER/D_ENABLEW
+
+    std::array<DMAPort, 10> ports{};
+    uint32_t ending = 0;     // channels whose last burst is still on the bus
+    bool     polling = false; // the pending event is a retry for blocked devices
+    uint64_t moved = 0;      // quadwords transferred
+    uint64_t bursts = 0;
+    Mem*       mem = nullptr;
+    Scheduler* sched = nullptr;
+};
+
+// Register block of each channel (VIF0, VIF1, GIF, fromIPU, toIPU, SIF0,
+// SIF1, SIF2, fromSPR, toSPR)
+static constexpr uint32_t DMA_CHANNEL_BASE[10] = {
+    0x10008000, 0x10009000, 0x1000A000, 0x1000B000, 0x1000B400,
+    0x1000C000, 0x1000C400, 0x1000C800, 0x1000D000, 0x1000D400,
 };
 
-// Function declarations
-void     dmaInit(DMAC& dmac);
-uint32_t dmaStep(DMAC& dmac, Mem& mem, GS& gs);  // returns number of GIF pushes
-uint32_t dmaReadReg(const DMAC& dmac, uint32_t addr);
-void     dmaWriteReg(DMAC& dmac, Mem& mem, uint32_t addr, uint32_t val);
\ No newline at end of file
+// Resets the registers and registers the DMA event. Transfers run as
+// scheduler bursts from the cycle STR is set; the scratchpad channels are
+// built in, the rest move data once a port is attached.
+void     dmaInit(DMAC& dmac, Mem& mem, Scheduler& sched);
+void     dmaAttach(DMAC& dmac, DMAChannelId channel, const DMAPort& port);
+DMAPort  dmaGifPort(GIFFifo& gif);
+DMAPort  dmaVifPort(VIF& vif);
+DMAPort  dmaIpuInPort(IPU& ipu);    // toIPU
+DMAPort  dmaIpuOutPort(IPU& ipu);   // fromIPU
+
+// D_STAT has an unmasked channel, stall or MFIFO interrupt, or a bus
+// error (EE INT1)
+inline bool dmaInterrupt(const DMAC& dmac) {
+    return ((dmac.stat & (dmac.stat >> 16)) & 0x63FFu) != 0 || (dmac.stat & 0x8000u) != 0;
+}
+
+// COP0 condition 0 (BC0F/BC0T): every channel D_PCR.CPC selects has its
+// D_STAT channel bit set
+inline bool dmaCpcond0(const DMAC& dmac) {
+    return ((~dmac.pcr & 0x3FFu) | (dmac.stat & 0x3FFu)) == 0x3FFu;
+}
+
+// Channel registers plus D_CTRL..D_STADR at 0x1000E000 and D_ENABLER/W
+void     dmaMapMmio(DMAC& dmac, Mem& mem);
@@ -0,0 +1,258 @@
+#include "ee_block.h"
+#include "ee_run.h"
+#include "ee_tlb.h"
+#include <algorithm>
+#include <utility>
+
+void eeBlockCacheInit(EEBlockCache& c) {
+    c.blocks.clear();
+    c.pageBlocks.clear();
+    c.fpuModes.clear();
+    c.built = 0;
+    c.invalidated = 0;
+}
+
+void eeBlockCacheFlush(EEBlockCache& c, Mem& mem) {
+    c.blocks.clear();
+    c.pageBlocks.clear();
+    std::fill(mem.codePages.begin(), mem.codePages.end(), 0);
+    mem.dirtyCodePages.clear();
+}
+
+void eeBlockInvalidatePage(EEBlockCache& c, uint32_t page) {
+    auto it = c.pageBlocks.find(page);
+    if (it == c.pageBlocks.end()) return;
+
+    for (uint32_t pc : it->second) {
+        c.invalidated += c.blocks.erase(pc);
+    }
+    c.pageBlocks.erase(it);
+}
+
+// Registers an op reads and writes, if it may appear in an idle loop: plain
+// ALU ops, loads and non-linking branches. Anything that stores, links,
+// raises or touches other state disqualifies the loop.
+static bool eeIdleOpRegs(const DecodedOp& d, uint32_t& reads, uint32_t& writes) {
+    const uint32_t rs = 1u << d.rs, rt = 1u << d.rt;
+    switch (d.op) {
+        case 0x00:
+            switch (d.func) {
+                case 0x00: case 0x02: case 0x03:                         // SLL, SRL, SRA
+                    reads = rt; writes = 1u << d.rd; return true;
+                case 0x04: case 0x06: case 0x07:                         // SLLV, SRLV, SRAV
+                case 0x21: case 0x23: case 0x24: case 0x25:              // ADDU, SUBU, AND, OR
+                case 0x26: case 0x27: case 0x2A: case 0x2B:              // XOR, NOR, SLT, SLTU
+                    reads = rs | rt; writes = 1u << d.rd; return true;
+                default:
+                    return false;
+            }
+        case 0x01:                                                       // BLTZ(L), BGEZ(L)
+            if (d.rt > 0x03) return false;
+            reads = rs; writes = 0; return true;
+        case 0x04: case 0x05: case 0x14: case 0x15:                      // BEQ, BNE (+L)
+            reads = rs | rt; writes = 0; return true;
+        case 0x06: case 0x07: case 0x16: case 0x17:                      // BLEZ, BGTZ (+L)
+            reads = rs; writes = 0; return true;
+        case 0x09: case 0x0A: case 0x0B: case 0x0C: case 0x0D: case 0x0E: // ADDIU..XORI
+        case 0x20: case 0x21: case 0x23: case 0x24: case 0x25: case 0x27: // loads
+            reads = rs; writes = rt; return true;
+        case 0x0F:                                                       // LUI
+            reads = 0; writes = rt; return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool eeIsLoad(const DecodedOp& d) {
+    return d.op >= 0x20 && d.op <= 0x27;
+}
+
+// An idle loop branches back to its own start, and every register it
+// writes is written before it is read in the same iteration. Each pass then
+// computes the same thing from the same memory, so spinning again changes
+// nothing until memory or time does (e.g. polling a status register). Its
+// loads are recorded for eeBlockSpun, which needs their base registers to
+// still hold the addresses at the end of a pass.
+static bool eeBlockIsIdle(EEBlock& b) {
+    b.idleLoads.clear();
+    if (b.branchIdx < 0 || b.ops.size() > EE_IDLE_MAX_OPS) return false;
+    if (b.flow != EEFlow::Branch && b.flow != EEFlow::BranchLikely) return false;
+
+    const DecodedOp& br = b.ops[b.branchIdx].d;
+    const uint32_t brPc = b.startPc + (static_cast<uint32_t>(b.branchIdx) << 2);
+    if (br.op == 0x00 || br.op == 0x02 || br.op == 0x03) return false; // jumps
+    if (brPc + 4 + (static_cast<uint32_t>(static_cast<int32_t>(br.imm)) << 2) != b.startPc) return false;
+
+    uint32_t reads[EE_IDLE_MAX_OPS], writes[EE_IDLE_MAX_OPS];
+    uint32_t written = 0;
+    for (size_t i = 0; i < b.ops.size(); ++i) {
+        if (!eeIdleOpRegs(b.ops[i].d, reads[i], writes[i])) return false;
+        written |= writes[i];
+    }
+    written &= ~1u; // r0
+
+    uint32_t defined = 0;
+    for (size_t i = 0; i < b.ops.size(); ++i) {
+        if (reads[i] & written & ~defined) return false; // carried from the last pass
+        defined |= writes[i];
+    }
+
+    for (size_t i = 0; i < b.ops.size(); ++i) {
+        const DecodedOp& d = b.ops[i].d;
+        if (!eeIsLoad(d)) continue;
+        for (size_t j = i; j < b.ops.size(); ++j) {
+            if (writes[j] & (1u << d.rs) & ~1u) return false; // base changes later in the pass
+        }
+        b.idleLoads.push_back(EEIdleLoad{d.rs, d.imm});
+    }
+    return true;
+}
+
+static void eeBlockAnalyze(EEBlockCache& c, EEBlock& b) {
+    b.idle = eeBlockIsIdle(b);
+    if (b.idle) c.idleLoops++;
+}
+
+// Register the RAM pages a block was decoded from. They are keyed by
+// physical page, the way stores and DMA report them, so code run through
+// KSEG0/KSEG1 or a TLB mapping is dropped like code run from kuseg.
+static void eeBlockTrackPages(EEBlockCache& c, Mem& mem, const EEBlock& b) {
+    const uint32_t lastPage = (b.endPc - 4) >> MEM_PAGE_SHIFT;
+    for (uint32_t vpage = b.startPc >> MEM_PAGE_SHIFT; vpage <= lastPage; ++vpage) {
+        const int64_t page = memMarkCodePage(mem, vpage << MEM_PAGE_SHIFT);
+        if (page >= 0) c.pageBlocks[static_cast<uint32_t>(page)].push_back(b.startPc);
+    }
+}
+
+// Instruction fetch through the TLB, as eeLoad does for data. A page the
+// tables leave unmapped either is untranslated (the fallback value, as
+// before) or needs a TLB exception. Only the block's first instruction (or
+// the delay slot of a branch that is) raises it; anywhere else the block
+// just ends there and the fault is taken when execution reaches it.
+enum class EEFetch { Ok, End, Fault };
+
+static EEFetch eeBlockFetch(EERegs& ee, const Mem& mem, uint32_t addr, bool first, bool delay, uint32_t& raw) {
+    if (memTryRead(mem, addr, raw)) return EEFetch::Ok;
+    if (!first) return EEFetch::End;
+    ee.pc = addr;
+    ee.delaySlot = delay;
+    if (eeTlbMiss(ee, addr, false) != ExecResult::Ok) return EEFetch::Fault;
+    ee.pc = delay ? addr - 4 : addr;
+    ee.delaySlot = false;
+    raw = memRead32(mem, addr);
+    return EEFetch::Ok;
+}
+
+static bool eeBlockBuild(EEBlockCache& c, EERegs& ee, Mem& mem, EEBlock& b, uint32_t pc) {
+    b.startPc = pc;
+    b.fpu = eeBlockFpuMode(c, pc);
+    b.branchIdx = -1;
+    b.flow = EEFlow::None;
+    b.ops.clear();
+    b.ops.reserve(8);
+
+    uint32_t addr = pc;
+    for (uint32_t n = 0; n < EE_BLOCK_MAX_OPS; ++n, addr += 4) {
+        uint32_t raw = 0;
+        const EEFetch f = eeBlockFetch(ee, mem, addr, n == 0, false, raw);
+        if (f == EEFetch::Fault) return false;
+        if (f == EEFetch::End) break;
+        const DecodedOp d = decode(raw);
+
+        const EEFlow flow = eeFlow(d);
+        if (flow != EEFlow::None) {
+            if (flow != EEFlow::Jump) {
+                // Take the delay slot along with the branch, or leave the
+                // branch to a block of its own when the slot can't be fetched
+                uint32_t delayRaw = 0;
+                const EEFetch df = eeBlockFetch(ee, mem, addr + 4, n == 0, true, delayRaw);
+                if (df == EEFetch::Fault) return false;
+                if (df == EEFetch::End) break;
+                b.ops.push_back(EEBlockOp{d, eeLookupHandler(d, b.fpu)});
+                const DecodedOp delay = decode(delayRaw);
+                b.ops.push_back(EEBlockOp{delay, eeLookupHandler(delay, b.fpu)});
+                addr += 8;
+            } else {
+                b.ops.push_back(EEBlockOp{d, eeLookupHandler(d, b.fpu)});
+                addr += 4;
+            }
+            b.branchIdx = static_cast<int32_t>(b.ops.size() - (flow != EEFlow::Jump ? 2 : 1));
+            b.flow = flow;
+            break;
+        }
+        b.ops.push_back(EEBlockOp{d, eeLookupHandler(d, b.fpu)});
+    }
+    b.endPc = addr;
+
+    eeBlockAnalyze(c, b);
+    eeBlockTrackPages(c, mem, b);
+    c.built++;
+    return true;
+}
+
+EEFpuMode eeBlockFpuMode(const EEBlockCache& c, uint32_t pc) {
+    auto it = c.fpuModes.find(pc);
+    return it != c.fpuModes.end() ? it->second : eeGetFpuMode();
+}
+
+void eeBlockSetFpuMode(EEBlockCache& c, uint32_t pc, EEFpuMode mode, bool pinned) {
+    if (pinned) c.fpuModes[pc] = mode;
+    else        c.fpuModes.erase(pc);
+    c.invalidated += c.blocks.erase(pc);
+}
+
+EEBlock* eeBlockInsert(EEBlockCache& c, Mem& mem, EEBlock&& b) {
+    auto it = c.blocks.find(b.startPc);
+    if (it != c.blocks.end()) return &it->second;
+
+    EEBlock& slot = c.blocks[b.startPc];
+    slot = std::move(b);
+    eeBlockAnalyze(c, slot);
+    eeBlockTrackPages(c, mem, slot);
+    return &slot;
+}
+
+EEBlock* eeBlockLookup(EEBlockCache& c, EERegs& ee, Mem& mem) {
+    const uint32_t pc = ee.pc;
+    if (!mem.dirtyCodePages.empty()) {
+        for (uint32_t page : mem.dirtyCodePages) eeBlockInvalidatePage(c, page);
+        mem.dirtyCodePages.clear();
+    }
+
+    auto it = c.blocks.find(pc);
+    if (it != c.blocks.end()) return &it->second;
+
+    EEBlock b;
+    if (!eeBlockBuild(c, ee, mem, b, pc)) return nullptr;
+    EEBlock& slot = c.blocks[pc];
+    slot = std::move(b);
+    return &slot;
+}
+
+ExecResult eeExecBlock(EERegs& ee, Mem& mem, EEBlock& b, uint32_t& executed) {
+    return eeExecBlockT<EERunFast>(ee, mem, b, nullptr, executed);
+}
+
+ExecResult eeRunBlock(EERegs& ee, Mem& mem, EEBlockCache& c, uint32_t& executed) {
+    EEBlock* found = eeBlockLookup(c, ee, mem);
+    if (!found) {
+        executed = 0;
+        return ExecResult::Exception;
+    }
+    EEBlock& b = *found;
+    const ExecResult r = eeExecBlock(ee, mem, b, executed);
+    return r == ExecResult::Ok && eeBlockSpun(b, ee, mem) ? ExecResult::Idle : r;
+}
+
+std::vector<std::pair<uint32_t, uint64_t>> eeBlockOpProfile(const EEBlockCache& c) {
+    std::unordered_map<uint32_t, uint64_t> counts;
+    for (const auto& kv : c.blocks) {
+        const EEBlock& b = kv.second;
+        if (!b.hits) continue;
+        for (const EEBlockOp& op : b.ops) counts[eeOpKey(op.d)] += b.hits;
+    }
+
+    std::vector<std::pair<uint32_t, uint64_t>> out(counts.begin(), counts.end());
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    return out;
+}
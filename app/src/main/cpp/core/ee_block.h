@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "ee_cpu.h"
+
+// Longest straight-line run decoded into one block
+static constexpr uint32_t EE_BLOCK_MAX_OPS = 64;
+
+struct EEBlockOp {
+    DecodedOp   d;
+    EEOpHandler fn;
+};
+
+// A load in an idle loop: base register and offset
+struct EEIdleLoad {
+    uint8_t base;
+    int16_t offset;
+};
+
+// Pre-decoded run of EE code starting at startPc. Ends after the delay slot
+// of the first branch, after an exception return/raise (ERET, SYSCALL,
+// BREAK), or after EE_BLOCK_MAX_OPS instructions.
+struct EEBlock {
+    uint32_t startPc = 0;
+    uint32_t endPc   = 0;   // address following the last op
+    int32_t  branchIdx = -1; // index of the terminating branch, -1 if none
+    EEFlow   flow = EEFlow::None; // eeFlow() of the op at branchIdx
+    bool     idle = false;  // loop that cannot progress until memory or time changes
+    std::vector<EEIdleLoad> idleLoads; // what an idle loop polls, see eeBlockSpun
+    EEFpuMode fpu = EEFpuMode::Fast; // mode the COP1 handlers were picked for
+    std::vector<EEBlockOp> ops;
+    uint64_t hits = 0;
+
+    const void* jitCode = nullptr; // compiled body, see ee_jit.h
+    bool        noJit = false;     // recompiler declined this block
+};
+
+struct EEBlockCache {
+    std::unordered_map<uint32_t, EEBlock> blocks;               // keyed by guest PC
+    std::unordered_map<uint32_t, std::vector<uint32_t>> pageBlocks; // physical RAM page -> block PCs
+    std::unordered_map<uint32_t, EEFpuMode> fpuModes;            // per-block FPU mode overrides
+
+    uint64_t built = 0;
+    uint64_t invalidated = 0;
+    uint64_t idleLoops = 0; // blocks recognized as idle loops
+};
+
+void     eeBlockCacheInit(EEBlockCache& c);
+void     eeBlockCacheFlush(EEBlockCache& c, Mem& mem);
+
+// Drop every block overlapping the given RAM page
+void     eeBlockInvalidatePage(EEBlockCache& c, uint32_t page);
+
+// FPU mode for a block starting at pc: its override, else the global mode
+EEFpuMode eeBlockFpuMode(const EEBlockCache& c, uint32_t pc);
+
+// Pin the block at pc to an FPU mode (pinned=false returns it to the global
+// mode). The block is dropped so the next lookup rebuilds it; compiled code
+// and links to it must be flushed by the caller.
+void     eeBlockSetFpuMode(EEBlockCache& c, uint32_t pc, EEFpuMode mode, bool pinned);
+
+// Find or build the block at ee.pc (invalidates dirty pages first). Code is
+// fetched through the TLB: null when the fetch raised a TLB exception, with
+// ee already at the vector and nothing cached.
+EEBlock* eeBlockLookup(EEBlockCache& c, EERegs& ee, Mem& mem);
+
+// Add an externally built block (e.g. from the translation cache). An
+// existing block at the same PC wins; returns the block now cached.
+EEBlock* eeBlockInsert(EEBlockCache& c, Mem& mem, EEBlock&& b);
+
+// Longest loop body considered for idle-loop detection
+static constexpr uint32_t EE_IDLE_MAX_OPS = 16;
+
+// After running b: did it spin once through an idle loop? Only if every
+// load it made reads memory or an event-driven register (memStableRead);
+// polling anything else (VU1 or GS thread status) has to keep running. The
+// run loops stop with ExecResult::Idle so the caller can skip to its next
+// event.
+inline bool eeBlockSpun(const EEBlock& b, const EERegs& ee, const Mem& mem) {
+    if (!b.idle || ee.pc != b.startPc) return false;
+    for (const EEIdleLoad& l : b.idleLoads) {
+        if (!memStableRead(mem, eeGetReg(ee, l.base) + static_cast<int32_t>(l.offset))) return false;
+    }
+    return true;
+}
+
+// Interpret one whole block; ee.pc must equal b.startPc
+ExecResult eeExecBlock(EERegs& ee, Mem& mem, EEBlock& b, uint32_t& executed);
+
+// Run one whole block starting at ee.pc; executed receives the op count
+ExecResult eeRunBlock(EERegs& ee, Mem& mem, EEBlockCache& c, uint32_t& executed);
+
+// Interpreted executions per opcode table slot (see eeOpKey), estimated from
+// block hit counts, hottest first
+std::vector<std::pair<uint32_t, uint64_t>> eeBlockOpProfile(const EEBlockCache& c);
@@ -0,0 +1,184 @@
+#include "ee_cpu.h"
+#include "ee_optable.h"
+#include "ee_tlb.h"
+#include "vu.h"
+#include "mtvu.h"
+
+// COP2: VU0 in macro mode, plus the EE's view of both VUs' control
+// registers. Macro ops reuse the VU interpreter: upper ops share their low
+// 26 bits with the micro encoding, lower ones map onto the 0x40 group.
+// VCALLMS runs the VU0 microprogram to completion; VU1 is kicked through
+// CMSAR1 and runs alongside the EE, possibly on its own thread (mtvu.h).
+
+static constexpr uint64_t SX32(uint32_t v) { return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))); }
+
+static constexpr uint32_t FBRST_FB0 = 1u << 0;  // force break VU0
+static constexpr uint32_t FBRST_RS0 = 1u << 1;  // reset VU0
+static constexpr uint32_t FBRST_FB1 = 1u << 8;
+static constexpr uint32_t FBRST_RS1 = 1u << 9;
+
+// VU0 must be idle before macro ops and transfers see its registers
+static inline VU& eeVu0(EERegs& ee) {
+    VU& vu = *ee.vu0;
+    if (vu.running) vuFinish(vu);
+    return vu;
+}
+
+static ExecResult opQMFC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    const VUVec& v = eeVu0(ee).VF[d.rd];
+    if (d.rt) for (int i = 0; i < 4; ++i) ee.GPR[d.rt].UL[i] = v.UL[i];
+    return ExecResult::Ok;
+}
+static ExecResult opQMTC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    VUVec& v = eeVu0(ee).VF[d.rd];
+    if (d.rd) for (int i = 0; i < 4; ++i) v.UL[i] = ee.GPR[d.rt].UL[i];
+    return ExecResult::Ok;
+}
+
+static ExecResult opCFC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    uint32_t v = 0;
+    if (d.rd == VU_REG_VPU_STAT) {
+        // Polled while VU1 runs, so it must not wait for anything
+        v = (ee.vu0->running ? 1u : 0u) | (ee.vu1 && mtvuBusy(*ee.vu1) ? 0x100u : 0u);
+    } else if (d.rd != VU_REG_FBRST && d.rd != VU_REG_CMSAR1) {
+        v = vuReadReg(eeVu0(ee), d.rd);
+    }
+    eeSetReg64(ee, d.rt, SX32(v));
+    return ExecResult::Ok;
+}
+
+static ExecResult opCTC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    const uint32_t v = eeGetReg(ee, d.rt);
+    switch (d.rd) {
+        case VU_REG_FBRST:
+            if (v & (FBRST_FB0 | FBRST_RS0)) ee.vu0->running = false;
+            if (v & FBRST_RS0) vuReset(*ee.vu0);
+            if (ee.vu1 && (v & (FBRST_FB1 | FBRST_RS1))) {
+                mtvuSync(*ee.vu1);
+                ee.vu1->vu->running = false;
+                if (v & FBRST_RS1) vuReset(*ee.vu1->vu);
+            }
+            break;
+        case VU_REG_CMSAR1:
+            if (ee.vu1 && !mtvuBusy(*ee.vu1)) mtvuKick(*ee.vu1, (v & 0xFFFF) * 8);
+            break;
+        case VU_REG_VPU_STAT:
+            break;
+        default:
+            vuWriteReg(eeVu0(ee), d.rd, v);
+            break;
+    }
+    return ExecResult::Ok;
+}
+
+// BC2F/BC2T(L) on CPCOND2, which follows VU1's run state; likely forms are
+// handled by the caller
+static ExecResult opBC2(EERegs& ee, Mem&, const DecodedOp& d) {
+    const bool cond = ee.vu1 && mtvuBusy(*ee.vu1);
+    ee.branchTaken = (d.rt & 1) ? cond : !cond;
+    ee.branchTarget = ee.pc + 4 + (static_cast<uint32_t>(static_cast<int32_t>(d.imm)) << 2);
+    return ExecResult::Ok;
+}
+
+// LQC2/SQC2 ignore the low four address bits like LQ/SQ
+ExecResult eeOpLQC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    MemQword q;
+    if (!eeLoad(ee, mem, eeGetReg(ee, d.rs) + static_cast<uint32_t>(static_cast<int32_t>(d.imm)), q)) {
+        return ExecResult::Exception;
+    }
+    if (d.rt) std::memcpy(eeVu0(ee).VF[d.rt].UL, &q, 16);
+    return ExecResult::Ok;
+}
+ExecResult eeOpSQC2(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    MemQword q;
+    std::memcpy(&q, eeVu0(ee).VF[d.rt].UL, 16);
+    const uint32_t addr = eeGetReg(ee, d.rs) + static_cast<uint32_t>(static_cast<int32_t>(d.imm));
+    return eeStore(ee, mem, addr, q) ? ExecResult::Ok : ExecResult::Exception;
+}
+
+// Macro ops
+static inline uint32_t eeVuLower(uint32_t raw) { return 0x80000000u | (raw & 0x01FFFFFFu); }
+
+static ExecResult opVUpper(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    vuExecUpper(eeVu0(ee), d.raw);
+    return ExecResult::Ok;
+}
+static ExecResult opVLower(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    vuExecLower(eeVu0(ee), eeVuLower(d.raw));
+    return ExecResult::Ok;
+}
+// Slots 0x3C-0x3F: (fd << 2 | funct & 3) below 0x30 are upper ops
+static ExecResult opVSpecial(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    if ((((d.raw >> 4) & 0x7C) | (d.raw & 3)) < 0x30) vuExecUpper(eeVu0(ee), d.raw);
+    else                                                vuExecLower(eeVu0(ee), eeVuLower(d.raw));
+    return ExecResult::Ok;
+}
+
+static ExecResult eeCallMs(EERegs& ee, uint32_t addr) {
+    VU& vu = eeVu0(ee);
+    vuStart(vu, addr);
+    vuFinish(vu);
+    return ExecResult::Ok;
+}
+static ExecResult opVCALLMS(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    return eeCallMs(ee, ((d.raw >> 6) & 0x7FFF) * 8);
+}
+static ExecResult opVCALLMSR(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    if (!ee.vu0) return eeOpUnimplemented(ee, mem, d);
+    return eeCallMs(ee, ee.vu0->cmsar * 8);
+}
+
+// -----------------------------------------------------------------------------
+// Tables: COP2 by rs, macro ops (rs >= 0x10) by funct
+// -----------------------------------------------------------------------------
+
+static constexpr EEOpTable<32> eeMakeCop2() {
+    EEOpTableBuilder<32> b;
+    b.op(0x01, opQMFC2, "QMFC2");
+    b.op(0x02, opCFC2, "CFC2");
+    b.op(0x05, opQMTC2, "QMTC2");
+    b.op(0x06, opCTC2, "CTC2");
+    b.op(0x08, opBC2, "BC2");
+    return b.t;
+}
+
+static constexpr EEOpTable<64> eeMakeCop2Macro() {
+    EEOpTableBuilder<64> b;
+    constexpr const char* bc[] = {"VADDbc", "VSUBbc", "VMADDbc", "VMSUBbc", "VMAXbc", "VMINIbc", "VMULbc"};
+    for (size_t i = 0; i < 0x1C; ++i) b.op(i, opVUpper, bc[i / 4]);
+    b.op(0x1C, opVUpper, "VMULq");    b.op(0x1D, opVUpper, "VMAXi");
+    b.op(0x1E, opVUpper, "VMULi");    b.op(0x1F, opVUpper, "VMINIi");
+    b.op(0x20, opVUpper, "VADDq");    b.op(0x21, opVUpper, "VMADDq");
+    b.op(0x22, opVUpper, "VADDi");    b.op(0x23, opVUpper, "VMADDi");
+    b.op(0x24, opVUpper, "VSUBq");    b.op(0x25, opVUpper, "VMSUBq");
+    b.op(0x26, opVUpper, "VSUBi");    b.op(0x27, opVUpper, "VMSUBi");
+    b.op(0x28, opVUpper, "VADD");     b.op(0x29, opVUpper, "VMADD");
+    b.op(0x2A, opVUpper, "VMUL");     b.op(0x2B, opVUpper, "VMAX");
+    b.op(0x2C, opVUpper, "VSUB");     b.op(0x2D, opVUpper, "VMSUB");
+    b.op(0x2E, opVUpper, "VOPMSUB");  b.op(0x2F, opVUpper, "VMINI");
+    b.op(0x30, opVLower, "VIADD");    b.op(0x31, opVLower, "VISUB");
+    b.op(0x32, opVLower, "VIADDI");   b.op(0x34, opVLower, "VIAND");
+    b.op(0x35, opVLower, "VIOR");
+    b.op(0x38, opVCALLMS, "VCALLMS"); b.op(0x39, opVCALLMSR, "VCALLMSR");
+    for (size_t i = 0x3C; i < 0x40; ++i) b.op(i, opVSpecial, "VU0.SPECIAL");
+    return b.t;
+}
+
+static constexpr EEOpTable<32> kCop2      = eeMakeCop2();
+static constexpr EEOpTable<64> kCop2Macro = eeMakeCop2Macro();
+
+const EEOpEntry& eeCop2Entry(const DecodedOp& d, uint32_t& key) {
+    if (d.rs & 0x10) { key = TBL_COP2_MACRO << 8 | d.func; return kCop2Macro[d.func]; }
+    key = TBL_COP2 << 8 | d.rs;
+    return kCop2[d.rs];
+}
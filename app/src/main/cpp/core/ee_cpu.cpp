@@ -1,132 +1,693 @@
 #include "ee_cpu.h"
+#include "ee_optable.h"
+#include "ee_tlb.h"
+#include "dma_stub.h"
+#include "debug_bus.h"
+#include <type_traits>
+#include <atomic>
 #include <cstdio>
 
-// Field extractors
-static inline uint32_t OPC(uint32_t op) { return (op >> 26) & 0x3F; }
-static inline uint32_t RS (uint32_t op) { return (op >> 21) & 0x1F; }
-static inline uint32_t RT (uint32_t op) { return (op >> 16) & 0x1F; }
-static inline uint32_t RD (uint32_t op) { return (op >> 11) & 0x1F; }
-static inline uint32_t SA (uint32_t op) { return (op >> 6)  & 0x1F; }
-static inline uint32_t FUN(uint32_t op) { return  op        & 0x3F; }
-static inline uint32_t IMM(uint32_t op) { return  op        & 0xFFFF; }
-static inline uint32_t TGT(uint32_t op) { return  op        & 0x03FFFFFF; }
-
-static inline int32_t  S16(uint32_t imm) { return static_cast<int16_t>(imm); }
-static inline uint32_t Z16(uint32_t imm) { return imm & 0xFFFFu; }
-
-// Memory helpers
-static inline bool eeLoad32(Mem& mem, uint32_t addr, uint32_t& out) {
-    if ((addr & 3u) != 0) return false;
-    out = memRead32(mem, addr);
-    return true;
+static inline uint64_t Z16(int16_t imm) { return static_cast<uint16_t>(imm); }
+static inline uint64_t S16(int16_t imm) { return static_cast<uint64_t>(static_cast<int64_t>(imm)); }
+static constexpr uint64_t SX32(uint32_t v) { return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))); }
+
+static inline void eeBranch(EERegs& ee, bool taken, uint32_t target) {
+    ee.branchTaken = taken;
+    ee.branchTarget = target;
 }
-static inline bool eeStore32(Mem& mem, uint32_t addr, uint32_t val) {
-    if ((addr & 3u) != 0) return false;
-    memWrite32(mem, addr, val);
-    return true;
+
+static inline uint32_t eeAddr(const EERegs& ee, const DecodedOp& d) {
+    return eeGetReg(ee, d.rs) + static_cast<uint32_t>(S16(d.imm));
+}
+
+static inline uint32_t eeBranchTarget(const EERegs& ee, const DecodedOp& d) {
+    return ee.pc + 4 + (static_cast<uint32_t>(S16(d.imm)) << 2);
+}
+
+static ExecResult eeAddressError(EERegs& ee, uint32_t addr, EEExc code) {
+    ee.cop0[COP0_BADVADDR] = addr;
+    return eeRaiseException(ee, code);
 }
 
-// Execute one instruction
-static ExecResult eeExecOne(EERegs& ee, Mem& mem, uint32_t opcode,
-                            bool& branchTaken, uint32_t& branchTarget) {
+ExecResult eeRaiseException(EERegs& ee, EEExc code, uint32_t vector) {
+    uint32_t& status = ee.cop0[COP0_STATUS];
+    uint32_t& cause  = ee.cop0[COP0_CAUSE];
+
+    cause = (cause & ~0x7Cu) | (static_cast<uint32_t>(code) << 2);
+    if (!(status & STATUS_EXL)) {
+        // EPC points at the branch when the fault is in its delay slot
+        if (ee.delaySlot) { ee.cop0[COP0_EPC] = ee.pc - 4; cause |= 0x80000000u; }
+        else              { ee.cop0[COP0_EPC] = ee.pc;     cause &= ~0x80000000u; }
+        status |= STATUS_EXL;
+    }
+
+    ee.delaySlot = false;
+    ee.branchTaken = false;
+    ee.pc = ((status & STATUS_BEV) ? 0xBFC00200u : 0x80000000u) + vector;
     ee.nextPc = ee.pc + 4;
+    return ExecResult::Exception;
+}
 
-    const uint32_t op  = OPC(opcode);
-    const uint32_t rs  = RS(opcode);
-    const uint32_t rt  = RT(opcode);
-    const uint32_t rd  = RD(opcode);
-    const uint32_t sa  = SA(opcode);
-    const uint32_t fun = FUN(opcode);
-    const uint32_t imm = IMM(opcode);
-    const uint32_t tgt = TGT(opcode);
-
-    const uint32_t vrs = eeGetReg(ee, rs);
-    const uint32_t vrt = eeGetReg(ee, rt);
-
-    branchTaken = false;
-    branchTarget = 0;
-
-    switch (op) {
-        case 0x00: { // SPECIAL
-            switch (fun) {
-                case 0x00: // SLL (NOP if rd=0, rt=0, sa=0)
-                    if (!(rd == 0 && rt == 0 && sa == 0))
-                        eeSetReg(ee, rd, vrt << sa);
-                    break;
-                case 0x02: eeSetReg(ee, rd, vrt >> sa); break; // SRL
-                case 0x03: eeSetReg(ee, rd, static_cast<int32_t>(vrt) >> sa); break; // SRA
-                case 0x08: branchTaken = true; branchTarget = vrs; break; // JR
-                case 0x09: eeSetReg(ee, rd ? rd : 31, ee.pc + 8);
-                    branchTaken = true; branchTarget = vrs; break; // JALR
-                case 0x23: eeSetReg(ee, rd, vrs - vrt); break; // SUBU
-                case 0x24: eeSetReg(ee, rd, vrs & vrt); break; // AND
-                case 0x25: eeSetReg(ee, rd, vrs | vrt); break; // OR
-                case 0x26: eeSetReg(ee, rd, vrs ^ vrt); break; // XOR
-                case 0x27: eeSetReg(ee, rd, ~(vrs | vrt)); break; // NOR
-                case 0x2A: eeSetReg(ee, rd, (int32_t)vrs < (int32_t)vrt); break; // SLT
-                case 0x2B: eeSetReg(ee, rd, vrs < vrt); break; // SLTU
-                default: break;
-            }
-            break;
-        }
-
-        case 0x02: branchTaken = true;
-            branchTarget = (ee.pc & 0xF0000000u) | (tgt << 2); break; // J
-        case 0x03: eeSetReg(ee, 31, ee.pc + 8);
-            branchTaken = true;
-            branchTarget = (ee.pc & 0xF0000000u) | (tgt << 2); break; // JAL
-        case 0x04: if (vrs == vrt) { branchTaken = true;
-                branchTarget = ee.pc + 4 + (S16(imm) << 2); } break; // BEQ
-        case 0x05: if (vrs != vrt) { branchTaken = true;
-                branchTarget = ee.pc + 4 + (S16(imm) << 2); } break; // BNE
-
-        case 0x09: eeSetReg(ee, rt, vrs + static_cast<uint32_t>(S16(imm))); break; // ADDIU
-        case 0x0D: eeSetReg(ee, rt, vrs | Z16(imm)); break; // ORI
-        case 0x0F: eeSetReg(ee, rt, Z16(imm) << 16); break; // LUI
-
-        case 0x23: { // LW
-            uint32_t addr = vrs + static_cast<uint32_t>(S16(imm));
-            uint32_t val  = 0;
-            if (!eeLoad32(mem, addr, val)) return ExecResult::Exception;
-            eeSetReg(ee, rt, val);
-            break;
-        }
-        case 0x2B: { // SW
-            uint32_t addr = vrs + static_cast<uint32_t>(S16(imm));
-            if (!eeStore32(mem, addr, vrt)) return ExecResult::Exception;
-            break;
-        }
+bool eeCheckInterrupts(EERegs& ee, bool int0, bool int1) {
+    uint32_t& cause = ee.cop0[COP0_CAUSE];
+    cause = (cause & ~(CAUSE_IP2 | CAUSE_IP3)) | (int0 ? CAUSE_IP2 : 0) | (int1 ? CAUSE_IP3 : 0);
+
+    const uint32_t status = ee.cop0[COP0_STATUS];
+    if ((status & (STATUS_IE | STATUS_EIE)) != (STATUS_IE | STATUS_EIE)) return false;
+    if (status & (STATUS_EXL | STATUS_ERL)) return false;
+    if (!(cause & status & (CAUSE_IP2 | CAUSE_IP3))) return false;
+    if (ee.branchTaken || ee.delaySlot) return false;
+    eeRaiseException(ee, EEExc::Int, 0x200);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Instruction handlers (shared by eeStep, the block cache and the recompiler)
+// -----------------------------------------------------------------------------
+
+static ExecResult opNop(EERegs&, Mem&, const DecodedOp&) { return ExecResult::Ok; }
+
+// ALU operations on the low doubleword, specialized into one handler per
+// instruction. 32-bit forms sign-extend their result.
+static constexpr uint64_t aluAddu(uint64_t a, uint64_t b) { return SX32(static_cast<uint32_t>(a + b)); }
+static constexpr uint64_t aluSubu(uint64_t a, uint64_t b) { return SX32(static_cast<uint32_t>(a - b)); }
+static constexpr uint64_t aluDaddu(uint64_t a, uint64_t b) { return a + b; }
+static constexpr uint64_t aluDsubu(uint64_t a, uint64_t b) { return a - b; }
+static constexpr uint64_t aluAnd(uint64_t a, uint64_t b) { return a & b; }
+static constexpr uint64_t aluOr (uint64_t a, uint64_t b) { return a | b; }
+static constexpr uint64_t aluXor(uint64_t a, uint64_t b) { return a ^ b; }
+static constexpr uint64_t aluNor(uint64_t a, uint64_t b) { return ~(a | b); }
+static constexpr uint64_t aluSlt(uint64_t a, uint64_t b) { return static_cast<int64_t>(a) < static_cast<int64_t>(b); }
+static constexpr uint64_t aluSltu(uint64_t a, uint64_t b) { return a < b; }
+static constexpr uint64_t aluSll(uint64_t a, uint64_t s) { return SX32(static_cast<uint32_t>(a) << (s & 31)); }
+static constexpr uint64_t aluSrl(uint64_t a, uint64_t s) { return SX32(static_cast<uint32_t>(a) >> (s & 31)); }
+static constexpr uint64_t aluSra(uint64_t a, uint64_t s) { return SX32(static_cast<uint32_t>(static_cast<int32_t>(a) >> (s & 31))); }
+static constexpr uint64_t aluDsll(uint64_t a, uint64_t s) { return a << (s & 63); }
+static constexpr uint64_t aluDsrl(uint64_t a, uint64_t s) { return a >> (s & 63); }
+static constexpr uint64_t aluDsra(uint64_t a, uint64_t s) { return static_cast<uint64_t>(static_cast<int64_t>(a) >> (s & 63)); }
+static constexpr uint64_t aluDsll32(uint64_t a, uint64_t s) { return a << ((s & 31) + 32); }
+static constexpr uint64_t aluDsrl32(uint64_t a, uint64_t s) { return a >> ((s & 31) + 32); }
+static constexpr uint64_t aluDsra32(uint64_t a, uint64_t s) { return static_cast<uint64_t>(static_cast<int64_t>(a) >> ((s & 31) + 32)); }
+
+using EEAluFn = uint64_t (*)(uint64_t, uint64_t);
+
+// rd = rs op rt
+template <EEAluFn F>
+static ExecResult opRType(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg64(ee, d.rd, F(eeGetReg64(ee, d.rs), eeGetReg64(ee, d.rt))); return ExecResult::Ok;
+}
+
+// rt = rs op imm (sign- or zero-extended)
+template <EEAluFn F, bool ZeroExt>
+static ExecResult opIType(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg64(ee, d.rt, F(eeGetReg64(ee, d.rs), ZeroExt ? Z16(d.imm) : S16(d.imm))); return ExecResult::Ok;
+}
+
+// rd = rt shift sa
+template <EEAluFn F>
+static ExecResult opShift(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg64(ee, d.rd, F(eeGetReg64(ee, d.rt), d.sa)); return ExecResult::Ok;
+}
+
+// rd = rt shift rs
+template <EEAluFn F>
+static ExecResult opShiftV(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg64(ee, d.rd, F(eeGetReg64(ee, d.rt), eeGetReg64(ee, d.rs))); return ExecResult::Ok;
+}
+
+// Trapping adds: 32-bit (ADD/ADDI/SUB) and 64-bit (DADD/DADDI/DSUB)
+template <typename T>
+static inline bool addOverflows(T a, T b, T r) { return ((a ^ r) & (b ^ r)) >> (sizeof(T) * 8 - 1); }
+
+template <typename T, bool Sub, bool Imm>
+static ExecResult opAddTrap(EERegs& ee, Mem&, const DecodedOp& d) {
+    const T a = static_cast<T>(eeGetReg64(ee, d.rs));
+    const T b = static_cast<T>(Imm ? S16(d.imm) : eeGetReg64(ee, d.rt));
+    const T r = Sub ? a - b : a + b;
+    if (addOverflows<T>(a, Sub ? ~b : b, r)) return eeRaiseException(ee, EEExc::Overflow);
+    const uint64_t v = sizeof(T) == 4 ? SX32(static_cast<uint32_t>(r)) : static_cast<uint64_t>(r);
+    eeSetReg64(ee, Imm ? d.rt : d.rd, v);
+    return ExecResult::Ok;
+}
+
+static ExecResult opLUI(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg64(ee, d.rt, S16(d.imm) << 16); return ExecResult::Ok;
+}
+
+static ExecResult opMOVZ(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (eeGetReg64(ee, d.rt) == 0) eeSetReg64(ee, d.rd, eeGetReg64(ee, d.rs));
+    return ExecResult::Ok;
+}
+static ExecResult opMOVN(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (eeGetReg64(ee, d.rt) != 0) eeSetReg64(ee, d.rd, eeGetReg64(ee, d.rs));
+    return ExecResult::Ok;
+}
+
+// HI/LO
+static ExecResult opMFHI(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rd, ee.HI.UD[0]); return ExecResult::Ok; }
+static ExecResult opMFLO(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rd, ee.LO.UD[0]); return ExecResult::Ok; }
+static ExecResult opMTHI(EERegs& ee, Mem&, const DecodedOp& d) { ee.HI.UD[0] = eeGetReg64(ee, d.rs); return ExecResult::Ok; }
+static ExecResult opMTLO(EERegs& ee, Mem&, const DecodedOp& d) { ee.LO.UD[0] = eeGetReg64(ee, d.rs); return ExecResult::Ok; }
+
+// The EE's three-operand MULT/MULTU also copy LO into rd
+template <bool Signed>
+static ExecResult opMult(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = eeGetReg(ee, d.rs), b = eeGetReg(ee, d.rt);
+    const uint64_t p = Signed
+        ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(a)) * static_cast<int32_t>(b))
+        : static_cast<uint64_t>(a) * b;
+    ee.LO.UD[0] = SX32(static_cast<uint32_t>(p));
+    ee.HI.UD[0] = SX32(static_cast<uint32_t>(p >> 32));
+    eeSetReg64(ee, d.rd, ee.LO.UD[0]);
+    return ExecResult::Ok;
+}
+
+template <bool Signed>
+static ExecResult opDiv(EERegs& ee, Mem&, const DecodedOp& d) {
+    uint32_t lo, hi;
+    eeDivide<Signed>(eeGetReg(ee, d.rs), eeGetReg(ee, d.rt), lo, hi);
+    ee.LO.UD[0] = SX32(lo);
+    ee.HI.UD[0] = SX32(hi);
+    return ExecResult::Ok;
+}
+
+// Conditions shared by branches and traps (64-bit compares)
+enum class EECond { Eq, Ne, Ltz, Gez, Lez, Gtz, Lt, Ltu, Ge, Geu };
+
+template <EECond C>
+static inline bool eeTest(uint64_t a, uint64_t b) {
+    const int64_t sa = static_cast<int64_t>(a), sb = static_cast<int64_t>(b);
+    switch (C) {
+        case EECond::Eq:  return a == b;
+        case EECond::Ne:  return a != b;
+        case EECond::Ltz: return sa < 0;
+        case EECond::Gez: return sa >= 0;
+        case EECond::Lez: return sa <= 0;
+        case EECond::Gtz: return sa > 0;
+        case EECond::Lt:  return sa < sb;
+        case EECond::Ltu: return a < b;
+        case EECond::Ge:  return sa >= sb;
+        case EECond::Geu: return a >= b;
+    }
+    return false;
+}
+
+// Jumps and branches. Likely variants share the handler; the caller skips
+// their delay slot (see eeFlow).
+static ExecResult opJ(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeBranch(ee, true, (ee.pc & 0xF0000000u) | d.target); return ExecResult::Ok;
+}
+static ExecResult opJAL(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg(ee, 31, ee.pc + 8);
+    eeBranch(ee, true, (ee.pc & 0xF0000000u) | d.target); return ExecResult::Ok;
+}
+static ExecResult opJR(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeBranch(ee, true, eeGetReg(ee, d.rs)); return ExecResult::Ok;
+}
+static ExecResult opJALR(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t target = eeGetReg(ee, d.rs);
+    eeSetReg(ee, d.rd ? d.rd : 31, ee.pc + 8);
+    eeBranch(ee, true, target); return ExecResult::Ok;
+}
+
+template <EECond C, bool Link>
+static ExecResult opBranch(EERegs& ee, Mem&, const DecodedOp& d) {
+    const bool taken = eeTest<C>(eeGetReg64(ee, d.rs), eeGetReg64(ee, d.rt));
+    if (Link) eeSetReg(ee, 31, ee.pc + 8);
+    eeBranch(ee, taken, eeBranchTarget(ee, d));
+    return ExecResult::Ok;
+}
+
+// Traps: register (TGE..TNE) and immediate (TGEI..TNEI) forms
+template <EECond C, bool Imm>
+static ExecResult opTrap(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint64_t b = Imm ? S16(d.imm) : eeGetReg64(ee, d.rt);
+    if (eeTest<C>(eeGetReg64(ee, d.rs), b)) return eeRaiseException(ee, EEExc::Trap);
+    return ExecResult::Ok;
+}
+
+static ExecResult opSYSCALL(EERegs& ee, Mem&, const DecodedOp&) { return eeRaiseException(ee, EEExc::Syscall); }
+static ExecResult opBREAK(EERegs& ee, Mem&, const DecodedOp&)   { return eeRaiseException(ee, EEExc::Break); }
+
+// SA register: stored as a byte count for QFSRV
+static ExecResult opMFSA(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rd, ee.SA); return ExecResult::Ok; }
+static ExecResult opMTSA(EERegs& ee, Mem&, const DecodedOp& d) { ee.SA = eeGetReg(ee, d.rs) & 0xF; return ExecResult::Ok; }
+static ExecResult opMTSAB(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.SA = (eeGetReg(ee, d.rs) ^ static_cast<uint32_t>(d.imm)) & 0xF; return ExecResult::Ok;
+}
+static ExecResult opMTSAH(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.SA = ((eeGetReg(ee, d.rs) ^ static_cast<uint32_t>(d.imm)) & 0x7) << 1; return ExecResult::Ok;
+}
+
+// Loads / stores
+template <typename T, bool Signed>
+static ExecResult opLoad(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d);
+    if (addr & (sizeof(T) - 1)) return eeAddressError(ee, addr, EEExc::AdEL);
+    T v;
+    if (!eeLoad(ee, mem, addr, v)) return ExecResult::Exception;
+    using S = std::make_signed_t<T>;
+    eeSetReg64(ee, d.rt, Signed ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<S>(v))) : v);
+    return ExecResult::Ok;
+}
+
+template <typename T>
+static ExecResult opStore(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d);
+    if (addr & (sizeof(T) - 1)) return eeAddressError(ee, addr, EEExc::AdES);
+    return eeStore(ee, mem, addr, static_cast<T>(eeGetReg64(ee, d.rt))) ? ExecResult::Ok : ExecResult::Exception;
+}
+
+// Quadword access ignores the low four address bits
+static ExecResult opLQ(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    MemQword q;
+    if (!eeLoad(ee, mem, eeAddr(ee, d), q)) return ExecResult::Exception;
+    if (d.rt) { ee.GPR[d.rt].UD[0] = q.lo; ee.GPR[d.rt].UD[1] = q.hi; }
+    return ExecResult::Ok;
+}
+static ExecResult opSQ(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const MemQword q{ee.GPR[d.rt].UD[0], ee.GPR[d.rt].UD[1]};
+    return eeStore(ee, mem, eeAddr(ee, d), q) ? ExecResult::Ok : ExecResult::Exception;
+}
+
+// FPU register loads/stores
+static ExecResult opLWC1(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d);
+    if (addr & 3) return eeAddressError(ee, addr, EEExc::AdEL);
+    return eeLoad(ee, mem, addr, ee.FPR[d.rt]) ? ExecResult::Ok : ExecResult::Exception;
+}
+static ExecResult opSWC1(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d);
+    if (addr & 3) return eeAddressError(ee, addr, EEExc::AdES);
+    return eeStore(ee, mem, addr, ee.FPR[d.rt]) ? ExecResult::Ok : ExecResult::Exception;
+}
 
-        default: break;
+// Unaligned word access (little-endian): merge the bytes of the aligned
+// word that fall on the addressed side
+static ExecResult opLWL(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 3) * 8;
+    uint32_t word;
+    if (!eeLoad(ee, mem, addr & ~3u, word)) return ExecResult::Exception;
+    eeSetReg(ee, d.rt, (eeGetReg(ee, d.rt) & (0x00FFFFFFu >> shift)) | (word << (24 - shift)));
+    return ExecResult::Ok;
+}
+static ExecResult opLWR(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 3) * 8;
+    uint32_t word;
+    if (!eeLoad(ee, mem, addr & ~3u, word)) return ExecResult::Exception;
+    if (shift == 0) {
+        eeSetReg(ee, d.rt, word);
+    } else if (d.rt) {
+        // The upper word is left alone unless the full word was loaded
+        ee.GPR[d.rt].UL[0] = (eeGetReg(ee, d.rt) & (0xFFFFFF00u << (24 - shift))) | (word >> shift);
     }
+    return ExecResult::Ok;
+}
+static ExecResult opSWL(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 3) * 8;
+    uint32_t word;
+    if (!eeLoad(ee, mem, addr & ~3u, word)) return ExecResult::Exception;
+    const uint32_t merged = (word & (0xFFFFFF00u << shift)) | (eeGetReg(ee, d.rt) >> (24 - shift));
+    return eeStore(ee, mem, addr & ~3u, merged) ? ExecResult::Ok : ExecResult::Exception;
+}
+static ExecResult opSWR(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 3) * 8;
+    uint32_t word;
+    if (!eeLoad(ee, mem, addr & ~3u, word)) return ExecResult::Exception;
+    const uint32_t merged = (word & (0x00FFFFFFu >> (24 - shift))) | (eeGetReg(ee, d.rt) << shift);
+    return eeStore(ee, mem, addr & ~3u, merged) ? ExecResult::Ok : ExecResult::Exception;
+}
 
+// Unaligned doubleword access, same scheme on eight bytes
+static ExecResult opLDL(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 7) * 8;
+    uint64_t dword;
+    if (!eeLoad(ee, mem, addr & ~7u, dword)) return ExecResult::Exception;
+    eeSetReg64(ee, d.rt, (eeGetReg64(ee, d.rt) & (0x00FFFFFFFFFFFFFFull >> shift)) | (dword << (56 - shift)));
+    return ExecResult::Ok;
+}
+static ExecResult opLDR(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 7) * 8;
+    uint64_t dword;
+    if (!eeLoad(ee, mem, addr & ~7u, dword)) return ExecResult::Exception;
+    eeSetReg64(ee, d.rt, (eeGetReg64(ee, d.rt) & (0xFFFFFFFFFFFFFF00ull << (56 - shift))) | (dword >> shift));
     return ExecResult::Ok;
 }
+static ExecResult opSDL(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 7) * 8;
+    uint64_t dword;
+    if (!eeLoad(ee, mem, addr & ~7u, dword)) return ExecResult::Exception;
+    const uint64_t merged = (dword & (0xFFFFFFFFFFFFFF00ull << shift)) | (eeGetReg64(ee, d.rt) >> (56 - shift));
+    return eeStore(ee, mem, addr & ~7u, merged) ? ExecResult::Ok : ExecResult::Exception;
+}
+static ExecResult opSDR(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t addr = eeAddr(ee, d), shift = (addr & 7) * 8;
+    uint64_t dword;
+    if (!eeLoad(ee, mem, addr & ~7u, dword)) return ExecResult::Exception;
+    const uint64_t merged = (dword & (0x00FFFFFFFFFFFFFFull >> (56 - shift))) | (eeGetReg64(ee, d.rt) << shift);
+    return eeStore(ee, mem, addr & ~7u, merged) ? ExecResult::Ok : ExecResult::Exception;
+}
+
+// COP0
+static ExecResult opMFC0(EERegs& ee, Mem&, const DecodedOp& d) {
+    eeSetReg(ee, d.rt, ee.cop0[d.rd]); return ExecResult::Ok;
+}
+static ExecResult opMTC0(EERegs& ee, Mem& mem, const DecodedOp& d) {
+    const uint32_t v = eeGetReg(ee, d.rt);
+    switch (d.rd) {
+        case COP0_PRID:    break;
+        case COP0_ENTRYHI: eeTlbSetEntryHi(ee, mem, v); break;
+        case COP0_WIRED:
+            ee.cop0[COP0_WIRED] = v & 63;
+            ee.cop0[COP0_RANDOM] = EE_TLB_ENTRIES - 1;
+            break;
+        default:           ee.cop0[d.rd] = v; break;
+    }
+    return ExecResult::Ok;
+}
+static ExecResult opBC0(EERegs& ee, Mem&, const DecodedOp& d) {
+    const bool cond = !ee.dmac || dmaCpcond0(*ee.dmac);
+    eeBranch(ee, (d.rt & 1) ? cond : !cond, eeBranchTarget(ee, d));
+    return ExecResult::Ok;
+}
+static ExecResult opERET(EERegs& ee, Mem&, const DecodedOp&) {
+    uint32_t& status = ee.cop0[COP0_STATUS];
+    if (status & STATUS_ERL) {
+        status &= ~STATUS_ERL;
+        eeBranch(ee, true, ee.cop0[COP0_ERROREPC]);
+    } else {
+        status &= ~STATUS_EXL;
+        eeBranch(ee, true, ee.cop0[COP0_EPC]);
+    }
+    return ExecResult::Ok;
+}
+static ExecResult opTLBR(EERegs& ee, Mem& mem, const DecodedOp&)  { eeTlbRead(ee, mem, ee.cop0[COP0_INDEX]); return ExecResult::Ok; }
+static ExecResult opTLBWI(EERegs& ee, Mem& mem, const DecodedOp&) { eeTlbWrite(ee, mem, ee.cop0[COP0_INDEX]); return ExecResult::Ok; }
+static ExecResult opTLBWR(EERegs& ee, Mem& mem, const DecodedOp&) { eeTlbWrite(ee, mem, eeTlbRandom(ee)); return ExecResult::Ok; }
+static ExecResult opTLBP(EERegs& ee, Mem&, const DecodedOp&)      { eeTlbProbe(ee); return ExecResult::Ok; }
+static ExecResult opEI(EERegs& ee, Mem&, const DecodedOp&) { ee.cop0[COP0_STATUS] |= STATUS_EIE;  return ExecResult::Ok; }
+static ExecResult opDI(EERegs& ee, Mem&, const DecodedOp&) { ee.cop0[COP0_STATUS] &= ~STATUS_EIE; return ExecResult::Ok; }
+
+// -----------------------------------------------------------------------------
+// Dispatch tables, built at compile time. Every slot has a handler: named
+// instructions without one go to the counted slow path, unassigned encodings
+// raise a reserved-instruction exception. MMI tables live in ee_mmi.cpp.
+// -----------------------------------------------------------------------------
+
+// Bumped by the EE thread, read by the UI thread's debug state
+static std::atomic<uint64_t> g_unimplHits[TBL_COUNT * 64] = {};
+static std::atomic<uint64_t> g_unimplTotal{0};
+
+ExecResult eeOpUnimplemented(EERegs&, Mem&, const DecodedOp& d) {
+    const uint32_t key = eeOpKey(d);
+    const uint32_t slot = (key >> 8) * 64 + (key & 0x3F);
+    if (g_unimplHits[slot].fetch_add(1, std::memory_order_relaxed) == 0) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "EE: unimplemented %s (%08X)", eeOpName(d), d.raw);
+        dbgPush(buf);
+    }
+    g_unimplTotal.fetch_add(1, std::memory_order_relaxed);
+    return ExecResult::Ok;
+}
+
+ExecResult eeOpReserved(EERegs& ee, Mem&, const DecodedOp&) {
+    return eeRaiseException(ee, EEExc::Reserved);
+}
+
+static constexpr EEOpTable<64> eeMakePrimary() {
+    EEOpTableBuilder<64> b;
+    b.name(0x00, "SPECIAL");  b.name(0x01, "REGIMM");
+    b.op(0x02, opJ, "J");     b.op(0x03, opJAL, "JAL");
+    b.op(0x04, opBranch<EECond::Eq,  false>, "BEQ");
+    b.op(0x05, opBranch<EECond::Ne,  false>, "BNE");
+    b.op(0x06, opBranch<EECond::Lez, false>, "BLEZ");
+    b.op(0x07, opBranch<EECond::Gtz, false>, "BGTZ");
+    b.op(0x08, opAddTrap<uint32_t, false, true>, "ADDI");
+    b.op(0x09, opIType<aluAddu, false>, "ADDIU");
+    b.op(0x0A, opIType<aluSlt,  false>, "SLTI");
+    b.op(0x0B, opIType<aluSltu, false>, "SLTIU");
+    b.op(0x0C, opIType<aluAnd,  true>,  "ANDI");
+    b.op(0x0D, opIType<aluOr,   true>,  "ORI");
+    b.op(0x0E, opIType<aluXor,  true>,  "XORI");
+    b.op(0x0F, opLUI, "LUI");
+    b.name(0x10, "COP0");     b.name(0x11, "COP1");     b.name(0x12, "COP2");
+    b.op(0x14, opBranch<EECond::Eq,  false>, "BEQL");
+    b.op(0x15, opBranch<EECond::Ne,  false>, "BNEL");
+    b.op(0x16, opBranch<EECond::Lez, false>, "BLEZL");
+    b.op(0x17, opBranch<EECond::Gtz, false>, "BGTZL");
+    b.op(0x18, opAddTrap<uint64_t, false, true>, "DADDI");
+    b.op(0x19, opIType<aluDaddu, false>, "DADDIU");
+    b.op(0x1A, opLDL, "LDL");
+    b.op(0x1B, opLDR, "LDR");
+    b.name(0x1C, "MMI");
+    b.op(0x1E, opLQ, "LQ");
+    b.op(0x1F, opSQ, "SQ");
+    b.op(0x20, opLoad<uint8_t,  true>,  "LB");
+    b.op(0x21, opLoad<uint16_t, true>,  "LH");
+    b.op(0x22, opLWL, "LWL");
+    b.op(0x23, opLoad<uint32_t, true>,  "LW");
+    b.op(0x24, opLoad<uint8_t,  false>, "LBU");
+    b.op(0x25, opLoad<uint16_t, false>, "LHU");
+    b.op(0x26, opLWR, "LWR");
+    b.op(0x27, opLoad<uint32_t, false>, "LWU");
+    b.op(0x28, opStore<uint8_t>,  "SB");
+    b.op(0x29, opStore<uint16_t>, "SH");
+    b.op(0x2A, opSWL, "SWL");
+    b.op(0x2B, opStore<uint32_t>, "SW");
+    b.op(0x2C, opSDL, "SDL");
+    b.op(0x2D, opSDR, "SDR");
+    b.op(0x2E, opSWR, "SWR");
+    b.op(0x2F, opNop, "CACHE");
+    b.op(0x31, opLWC1, "LWC1");
+    b.op(0x33, opNop, "PREF");
+    b.op(0x36, eeOpLQC2, "LQC2");
+    b.op(0x37, opLoad<uint64_t, false>, "LD");
+    b.op(0x39, opSWC1, "SWC1");
+    b.op(0x3E, eeOpSQC2, "SQC2");
+    b.op(0x3F, opStore<uint64_t>, "SD");
+    return b.t;
+}
+
+static constexpr EEOpTable<64> eeMakeSpecial() {
+    EEOpTableBuilder<64> b;
+    b.op(0x00, opShift<aluSll>, "SLL");
+    b.op(0x02, opShift<aluSrl>, "SRL");
+    b.op(0x03, opShift<aluSra>, "SRA");
+    b.op(0x04, opShiftV<aluSll>, "SLLV");
+    b.op(0x06, opShiftV<aluSrl>, "SRLV");
+    b.op(0x07, opShiftV<aluSra>, "SRAV");
+    b.op(0x08, opJR, "JR");
+    b.op(0x09, opJALR, "JALR");
+    b.op(0x0A, opMOVZ, "MOVZ");
+    b.op(0x0B, opMOVN, "MOVN");
+    b.op(0x0C, opSYSCALL, "SYSCALL");
+    b.op(0x0D, opBREAK, "BREAK");
+    b.op(0x0F, opNop, "SYNC");
+    b.op(0x10, opMFHI, "MFHI");
+    b.op(0x11, opMTHI, "MTHI");
+    b.op(0x12, opMFLO, "MFLO");
+    b.op(0x13, opMTLO, "MTLO");
+    b.op(0x14, opShiftV<aluDsll>, "DSLLV");
+    b.op(0x16, opShiftV<aluDsrl>, "DSRLV");
+    b.op(0x17, opShiftV<aluDsra>, "DSRAV");
+    b.op(0x18, opMult<true>,  "MULT");
+    b.op(0x19, opMult<false>, "MULTU");
+    b.op(0x1A, opDiv<true>,   "DIV");
+    b.op(0x1B, opDiv<false>,  "DIVU");
+    b.op(0x20, opAddTrap<uint32_t, false, false>, "ADD");
+    b.op(0x21, opRType<aluAddu>, "ADDU");
+    b.op(0x22, opAddTrap<uint32_t, true, false>, "SUB");
+    b.op(0x23, opRType<aluSubu>, "SUBU");
+    b.op(0x24, opRType<aluAnd>, "AND");
+    b.op(0x25, opRType<aluOr>,  "OR");
+    b.op(0x26, opRType<aluXor>, "XOR");
+    b.op(0x27, opRType<aluNor>, "NOR");
+    b.op(0x28, opMFSA, "MFSA");
+    b.op(0x29, opMTSA, "MTSA");
+    b.op(0x2A, opRType<aluSlt>,  "SLT");
+    b.op(0x2B, opRType<aluSltu>, "SLTU");
+    b.op(0x2C, opAddTrap<uint64_t, false, false>, "DADD");
+    b.op(0x2D, opRType<aluDaddu>, "DADDU");
+    b.op(0x2E, opAddTrap<uint64_t, true, false>, "DSUB");
+    b.op(0x2F, opRType<aluDsubu>, "DSUBU");
+    b.op(0x30, opTrap<EECond::Ge,  false>, "TGE");
+    b.op(0x31, opTrap<EECond::Geu, false>, "TGEU");
+    b.op(0x32, opTrap<EECond::Lt,  false>, "TLT");
+    b.op(0x33, opTrap<EECond::Ltu, false>, "TLTU");
+    b.op(0x34, opTrap<EECond::Eq,  false>, "TEQ");
+    b.op(0x36, opTrap<EECond::Ne,  false>, "TNE");
+    b.op(0x38, opShift<aluDsll>,   "DSLL");
+    b.op(0x3A, opShift<aluDsrl>,   "DSRL");
+    b.op(0x3B, opShift<aluDsra>,   "DSRA");
+    b.op(0x3C, opShift<aluDsll32>, "DSLL32");
+    b.op(0x3E, opShift<aluDsrl32>, "DSRL32");
+    b.op(0x3F, opShift<aluDsra32>, "DSRA32");
+    return b.t;
+}
+
+static constexpr EEOpTable<32> eeMakeRegimm() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opBranch<EECond::Ltz, false>, "BLTZ");
+    b.op(0x01, opBranch<EECond::Gez, false>, "BGEZ");
+    b.op(0x02, opBranch<EECond::Ltz, false>, "BLTZL");
+    b.op(0x03, opBranch<EECond::Gez, false>, "BGEZL");
+    b.op(0x08, opTrap<EECond::Ge,  true>, "TGEI");
+    b.op(0x09, opTrap<EECond::Geu, true>, "TGEIU");
+    b.op(0x0A, opTrap<EECond::Lt,  true>, "TLTI");
+    b.op(0x0B, opTrap<EECond::Ltu, true>, "TLTIU");
+    b.op(0x0C, opTrap<EECond::Eq,  true>, "TEQI");
+    b.op(0x0E, opTrap<EECond::Ne,  true>, "TNEI");
+    b.op(0x10, opBranch<EECond::Ltz, true>, "BLTZAL");
+    b.op(0x11, opBranch<EECond::Gez, true>, "BGEZAL");
+    b.op(0x12, opBranch<EECond::Ltz, true>, "BLTZALL");
+    b.op(0x13, opBranch<EECond::Gez, true>, "BGEZALL");
+    b.op(0x18, opMTSAB, "MTSAB");
+    b.op(0x19, opMTSAH, "MTSAH");
+    return b.t;
+}
+
+// COP0 by rs
+static constexpr EEOpTable<32> eeMakeCop0() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opMFC0, "MFC0");
+    b.op(0x04, opMTC0, "MTC0");
+    b.op(0x08, opBC0, "BC0");
+    return b.t;
+}
+
+// COP0 rs=0x10 (C0) by funct
+static constexpr EEOpTable<64> eeMakeCop0Co() {
+    EEOpTableBuilder<64> b;
+    b.op(0x01, opTLBR, "TLBR");
+    b.op(0x02, opTLBWI, "TLBWI");
+    b.op(0x06, opTLBWR, "TLBWR");
+    b.op(0x08, opTLBP, "TLBP");
+    b.op(0x18, opERET, "ERET");
+    b.op(0x38, opEI, "EI");
+    b.op(0x39, opDI, "DI");
+    return b.t;
+}
+
+static constexpr EEOpTable<64> kPrimary = eeMakePrimary();
+static constexpr EEOpTable<64> kSpecial = eeMakeSpecial();
+static constexpr EEOpTable<32> kRegimm  = eeMakeRegimm();
+static constexpr EEOpTable<32> kCop0    = eeMakeCop0();
+static constexpr EEOpTable<64> kCop0Co  = eeMakeCop0Co();
+
+static EEFpuMode g_fpuMode = EEFpuMode::Fast;
+
+void eeSetFpuMode(EEFpuMode mode) {
+    g_fpuMode = mode;
+}
+
+EEFpuMode eeGetFpuMode() {
+    return g_fpuMode;
+}
+
+static const EEOpEntry& eeOpEntry(const DecodedOp& d, uint32_t& key, EEFpuMode fpu = g_fpuMode) {
+    switch (d.op) {
+        case 0x00: key = TBL_SPECIAL << 8 | d.func; return kSpecial[d.func];
+        case 0x01: key = TBL_REGIMM << 8 | d.rt;    return kRegimm[d.rt];
+        case 0x10:
+            if (d.rs == 0x10) { key = TBL_COP0_CO << 8 | d.func; return kCop0Co[d.func]; }
+            key = TBL_COP0 << 8 | d.rs; return kCop0[d.rs];
+        case 0x11: return eeFpuEntry(d, key, fpu);
+        case 0x12: return eeCop2Entry(d, key);
+        case 0x1C: return eeMmiEntry(d, key, false);
+        default:   key = TBL_PRIMARY << 8 | d.op;   return kPrimary[d.op];
+    }
+}
+
+EEOpHandler eeLookupHandler(const DecodedOp& d, EEFpuMode fpu) {
+    uint32_t key;
+    return eeOpEntry(d, key, fpu).fn;
+}
+
+EEOpHandler eeLookupHandler(const DecodedOp& d) {
+    return eeLookupHandler(d, g_fpuMode);
+}
+
+uint32_t eeOpKey(const DecodedOp& d) {
+    uint32_t key;
+    eeOpEntry(d, key);
+    return key;
+}
+
+const char* eeOpName(const DecodedOp& d) {
+    uint32_t key;
+    const char* name = eeOpEntry(d, key).name;
+    return name ? name : "RESERVED";
+}
+
+uint64_t eeUnimplementedTotal() {
+    return g_unimplTotal.load(std::memory_order_relaxed);
+}
+
+std::vector<std::pair<uint32_t, uint64_t>> eeUnimplementedOps() {
+    std::vector<std::pair<uint32_t, uint64_t>> out;
+    for (uint32_t i = 0; i < TBL_COUNT * 64; ++i) {
+        const uint64_t hits = g_unimplHits[i].load(std::memory_order_relaxed);
+        if (hits) out.emplace_back((i / 64) << 8 | (i % 64), hits);
+    }
+    return out;
+}
+
+EEFlow eeFlow(const DecodedOp& d) {
+    switch (d.op) {
+        case 0x00:
+            if (d.func == 0x08 || d.func == 0x09) return EEFlow::Branch;      // JR, JALR
+            if (d.func == 0x0C || d.func == 0x0D) return EEFlow::Jump;        // SYSCALL, BREAK
+            return EEFlow::None;
+        case 0x01:                                                            // REGIMM branches
+            if (d.rt & 0x0C) return EEFlow::None;                             // traps, MTSAB/H
+            return (d.rt & 0x02) ? EEFlow::BranchLikely : EEFlow::Branch;
+        case 0x02: case 0x03:                                                 // J, JAL
+        case 0x04: case 0x05: case 0x06: case 0x07:                           // BEQ..BGTZ
+            return EEFlow::Branch;
+        case 0x14: case 0x15: case 0x16: case 0x17:                           // likely variants
+            return EEFlow::BranchLikely;
+        case 0x10:
+            if (d.rs == 0x10 && d.func == 0x18) return EEFlow::Jump;          // ERET
+            [[fallthrough]];
+        case 0x11: case 0x12:                                                 // BCzF/T(L)
+            if (d.rs != 0x08) return EEFlow::None;
+            return (d.rt & 0x02) ? EEFlow::BranchLikely : EEFlow::Branch;
+        default:
+            return EEFlow::None;
+    }
+}
 
 ExecResult eeStep(EERegs& ee, Mem& mem, uint32_t opcode) {
-    bool branchTaken = false;
-    uint32_t branchTarget = 0;
+    const DecodedOp d = decode(opcode);
+    const EEFlow flow = eeFlow(d);
+    ee.nextPc = ee.pc + 4;
+    ee.branchTaken = false;
 
-    ExecResult r = eeExecOne(ee, mem, opcode, branchTaken, branchTarget);
+    ExecResult r = eeLookupHandler(d)(ee, mem, d);
     if (r == ExecResult::Exception) return r;
 
-    if (branchTaken) {
+    const bool taken = ee.branchTaken;
+    const uint32_t branchTarget = ee.branchTarget;
+    ee.branchTaken = false;
+
+    if (flow == EEFlow::Jump) {
+        ee.pc = taken ? branchTarget : ee.pc + 4;
+    } else if (flow == EEFlow::Branch || (flow == EEFlow::BranchLikely && taken)) {
         // Execute delay slot at pc+4
-        uint32_t delayOp = memRead32(mem, ee.pc + 4);
-        uint32_t savedPc = ee.pc;
-        ee.pc = savedPc + 4;
-        bool dummyTaken = false;
-        uint32_t dummyTarget = 0;
-        r = eeExecOne(ee, mem, delayOp, dummyTaken, dummyTarget);
+        const DecodedOp delay = decode(memRead32(mem, ee.pc + 4));
+        ee.pc += 4;
+        ee.delaySlot = true;
+        r = eeLookupHandler(delay)(ee, mem, delay);
+        ee.delaySlot = false;
+        ee.branchTaken = false;
         if (r == ExecResult::Exception) return r;
 
-        // Commit branch target
-        ee.pc = branchTarget;
-        ee.nextPc = branchTarget + 4;
+        ee.pc = taken ? branchTarget : ee.pc + 4;
     } else {
-        ee.pc = ee.pc + 4;
-        ee.nextPc = ee.pc + 4;
+        // Not-taken likely branches skip their delay slot
+        ee.pc += flow == EEFlow::BranchLikely ? 8 : 4;
     }
 
+    ee.nextPc = ee.pc + 4;
     return ExecResult::Ok;
-}
\ No newline at end of file
+}
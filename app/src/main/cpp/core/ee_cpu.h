@@ -1,33 +1,219 @@
 #pragma once
 #include <cstdint>
+#include <vector>
+#include <utility>
 #include "mem_map.h"
 #include "cpu_common.h"
+#include "ee_decode.h"
+
+struct VU;
+struct MTVU;
+struct DMAC;
+
+// COP0 register indices
+enum : uint32_t {
+    COP0_INDEX    = 0,
+    COP0_RANDOM   = 1,
+    COP0_ENTRYLO0 = 2,
+    COP0_ENTRYLO1 = 3,
+    COP0_CONTEXT  = 4,
+    COP0_PAGEMASK = 5,
+    COP0_WIRED    = 6,
+    COP0_BADVADDR = 8,
+    COP0_COUNT    = 9,
+    COP0_ENTRYHI  = 10,
+    COP0_COMPARE  = 11,
+    COP0_STATUS   = 12,
+    COP0_CAUSE    = 13,
+    COP0_EPC      = 14,
+    COP0_PRID     = 15,
+    COP0_CONFIG   = 16,
+    COP0_ERROREPC = 30,
+};
+
+// COP0 Status bits
+static constexpr uint32_t STATUS_IE  = 1u << 0;
+static constexpr uint32_t STATUS_EXL = 1u << 1;
+static constexpr uint32_t STATUS_ERL = 1u << 2;
+static constexpr uint32_t STATUS_IM2 = 1u << 10;   // INT0 (INTC) mask
+static constexpr uint32_t STATUS_IM3 = 1u << 11;   // INT1 (DMAC) mask
+static constexpr uint32_t STATUS_EIE = 1u << 16;   // EI/DI
+static constexpr uint32_t STATUS_BEV = 1u << 22;
+
+// COP0 Cause interrupt lines
+static constexpr uint32_t CAUSE_IP2 = 1u << 10;    // INT0: INTC_STAT & INTC_MASK
+static constexpr uint32_t CAUSE_IP3 = 1u << 11;    // INT1: D_STAT (dmaInterrupt)
+
+// Exception codes (Cause.ExcCode)
+enum class EEExc : uint32_t {
+    Int = 0, Mod = 1, TLBL = 2, TLBS = 3, AdEL = 4, AdES = 5, Syscall = 8, Break = 9, Reserved = 10, Overflow = 12, Trap = 13
+};
+
+// TLB entry as TLBWI/TLBWR wrote it (see ee_tlb.h). Reset entries sit in
+// KSEG0, where nothing is translated.
+static constexpr uint32_t EE_TLB_ENTRIES = 48;
+
+struct EETlbEntry {
+    uint32_t pageMask = 0;
+    uint32_t entryHi  = MEM_KSEG0;
+    uint32_t entryLo0 = 0;
+    uint32_t entryLo1 = 0;
+};
+
+// FCR31 (FPU control/status) bits
+static constexpr uint32_t FCR31_C  = 1u << 23; // condition
+static constexpr uint32_t FCR31_I  = 1u << 17; // invalid (0/0, sqrt of negative)
+static constexpr uint32_t FCR31_D  = 1u << 16; // divide by zero
+static constexpr uint32_t FCR31_O  = 1u << 15; // overflow
+static constexpr uint32_t FCR31_U  = 1u << 14; // underflow
+static constexpr uint32_t FCR31_SI = 1u << 6;  // sticky I/D/O/U
+static constexpr uint32_t FCR31_SD = 1u << 5;
+static constexpr uint32_t FCR31_SO = 1u << 4;
+static constexpr uint32_t FCR31_SU = 1u << 3;
+static constexpr uint32_t FCR31_FIXED = 0x01000001u; // reads as set
+
+// FPU arithmetic: host IEEE floats, or the PS2's clamped round-to-zero format
+enum class EEFpuMode : uint8_t { Fast, Accurate };
+
+// 128-bit EE register. 32-bit operations use the low word and sign-extend
+// into the low doubleword; only MMI and quadword ops touch the upper half.
+union alignas(16) EEGpr {
+    uint64_t UD[2];
+    int64_t  SD[2];
+    uint32_t UL[4];
+    int32_t  SL[4];
+    uint16_t US[8];
+    int16_t  SS[8];
+    uint8_t  UC[16];
+    int8_t   SC[16];
+};
+static_assert(sizeof(EEGpr) == 16, "EEGpr must be one quadword");
 
 // Emotion Engine (EE) register state
 struct EERegs {
-    uint32_t GPR[32] = {0}; // General-purpose registers r0..r31
-    uint32_t HI = 0;        // Multiply/divide high result
-    uint32_t LO = 0;        // Multiply/divide low result
+    EEGpr    GPR[32] = {};  // General-purpose registers r0..r31
+    EEGpr    HI = {};       // Multiply/divide high result; upper half is HI1
+    EEGpr    LO = {};       // Multiply/divide low result; upper half is LO1
+    uint32_t SA = 0;        // QFSRV shift amount, in bytes
     uint32_t pc = 0;        // Program counter
     uint32_t nextPc = 0;    // Next program counter (branch delay slot)
+
+    // Written by branch/jump handlers, consumed by the step/block loop
+    bool     branchTaken  = false;
+    uint32_t branchTarget = 0;
+
+    bool     delaySlot = false; // executing a branch delay slot
+
+    // Run-loop position, for eeSliceCycles. budget is the live instruction
+    // budget of the slice being run (null between slices), already charged
+    // for the whole block that ends at blockEnd.
+    int32_t* budget = nullptr;
+    int32_t  budgetStart = 0;
+    uint32_t blockEnd = 0;
+
+    uint32_t cop0[32] = {0};
+    EETlbEntry tlb[EE_TLB_ENTRIES] = {};
+
+    // COP1: single-precision registers (raw bits), accumulator, FCR31
+    uint32_t FPR[32] = {0};
+    uint32_t ACC = 0;
+    uint32_t FCR31 = FCR31_FIXED;
+
+    // COP2 is VU0; VU1 is reached through its front end (CMSAR1, FBRST,
+    // VPU-STAT, BC2). Attached by the owner and left alone by eeInit.
+    VU*   vu0 = nullptr;
+    MTVU* vu1 = nullptr;
+
+    // DMAC behind CPCOND0 (BC0F/BC0T); without one it reads as true, like
+    // a DMAC fresh out of reset. Attached like the VUs.
+    const DMAC* dmac = nullptr;
 };
 
 // Initialize EE state
 inline void eeInit(EERegs& ee, uint32_t startPc) {
-    for (int i = 0; i < 32; ++i) ee.GPR[i] = 0;
-    ee.HI = ee.LO = 0;
+    for (int i = 0; i < 32; ++i) ee.GPR[i] = EEGpr{};
+    ee.HI = ee.LO = EEGpr{};
+    ee.SA = 0;
     ee.pc = startPc;
     ee.nextPc = startPc + 4;
+    ee.branchTaken = false;
+    ee.branchTarget = 0;
+    ee.delaySlot = false;
+    ee.budget = nullptr;
+    for (int i = 0; i < 32; ++i) ee.cop0[i] = 0;
+    ee.cop0[COP0_STATUS] = STATUS_BEV | STATUS_ERL;
+    ee.cop0[COP0_PRID] = 0x2E20; // EE (R5900) implementation/revision
+    ee.cop0[COP0_RANDOM] = EE_TLB_ENTRIES - 1;
+    for (EETlbEntry& e : ee.tlb) e = EETlbEntry{};
+    for (int i = 0; i < 32; ++i) ee.FPR[i] = 0;
+    ee.ACC = 0;
+    ee.FCR31 = FCR31_FIXED;
 }
 
 // Execute one EE instruction
 ExecResult eeStep(EERegs& ee, Mem& mem, uint32_t opcode);
 
-// Register helpers
+// Handler for one pre-decoded instruction. ee.pc must hold the instruction's
+// address; branches report through ee.branchTaken/branchTarget. A handler
+// returning ExecResult::Exception has already redirected ee.pc to the
+// exception vector.
+using EEOpHandler = ExecResult (*)(EERegs& ee, Mem& mem, const DecodedOp& d);
+
+// Handler for d; COP1 arithmetic comes in the given FPU mode, or the global one
+EEOpHandler eeLookupHandler(const DecodedOp& d, EEFpuMode fpu);
+EEOpHandler eeLookupHandler(const DecodedOp& d);
+
+// Global FPU mode used by eeStep and by blocks without their own. Blocks
+// keep the handlers they were built with; flush them after a change.
+void      eeSetFpuMode(EEFpuMode mode);
+EEFpuMode eeGetFpuMode();
+
+// How an instruction ends a basic block
+enum class EEFlow : uint8_t {
+    None,          // falls through
+    Branch,        // branch/jump with a delay slot
+    BranchLikely,  // delay slot is skipped when not taken
+    Jump,          // redirects without a delay slot (ERET, SYSCALL, BREAK)
+};
+
+EEFlow eeFlow(const DecodedOp& d);
+
+// Enter the exception handler: sets EPC/Cause/Status and ee.pc. TLB refills
+// use vector offset 0 while Status.EXL is clear, everything else 0x180.
+ExecResult eeRaiseException(EERegs& ee, EEExc code, uint32_t vector = 0x180);
+
+// Latch the INT0/INT1 lines into Cause.IP2/IP3 and, when Status lets them
+// through (IE, EIE, IM2/IM3, no EXL/ERL), enter the interrupt handler at
+// vector 0x200. Call between instructions; a pending branch delays it.
+// Returns true when the exception was taken.
+bool       eeCheckInterrupts(EERegs& ee, bool int0, bool int1);
+
+// Opcode table slot of an instruction (table id << 8 | index) and its name
+uint32_t    eeOpKey(const DecodedOp& d);
+const char* eeOpName(const DecodedOp& d);
+
+// Table slots that had no handler when executed, with execution counts
+uint64_t eeUnimplementedTotal();
+std::vector<std::pair<uint32_t, uint64_t>> eeUnimplementedOps();
+
+// Run every MMI instruction through the host SIMD and scalar reference
+// paths on pseudo-random operands; returns the number of differing results
+uint32_t eeMmiVerify(uint32_t iterations, uint64_t seed);
+
+// Register helpers. r0 is never written, so it always reads as zero.
 inline uint32_t eeGetReg(const EERegs& ee, int idx) {
-    return (idx & 31) == 0 ? 0u : ee.GPR[idx & 31];
+    return ee.GPR[idx & 31].UL[0];
 }
 
+inline uint64_t eeGetReg64(const EERegs& ee, int idx) {
+    return ee.GPR[idx & 31].UD[0];
+}
+
+// 32-bit results are sign-extended into the low doubleword
 inline void eeSetReg(EERegs& ee, int idx, uint32_t val) {
-    if ((idx & 31) != 0) ee.GPR[idx & 31] = val;
-}
\ No newline at end of file
+    if ((idx & 31) != 0) ee.GPR[idx & 31].SD[0] = static_cast<int32_t>(val);
+}
+
+inline void eeSetReg64(EERegs& ee, int idx, uint64_t val) {
+    if ((idx & 31) != 0) ee.GPR[idx & 31].UD[0] = val;
+}
@@ -0,0 +1,281 @@
+#include "ee_cpu.h"
+#include "ee_optable.h"
+#include <cmath>
+#include <cstring>
+
+// COP1 (FPU). Fast handlers use host IEEE single precision. Accurate handlers
+// follow the PS2 FPU: no NaN/Inf (exponent 255 is an ordinary exponent),
+// denormals read as zero, results truncate toward zero and clamp to
+// +/-0x7FFFFFFF on overflow, with the O/U/D/I flags in FCR31.
+
+static constexpr uint64_t SX32(uint32_t v) { return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))); }
+
+static inline float    flt(uint32_t v) { float f; std::memcpy(&f, &v, 4); return f; }
+static inline uint32_t bits(float f)   { uint32_t v; std::memcpy(&v, &f, 4); return v; }
+
+static constexpr uint32_t FPU_MAX = 0x7FFFFFFFu;   // largest PS2 magnitude
+static constexpr uint32_t FCR0    = 0x00002E30u;   // implementation/revision
+static constexpr uint32_t FCR31_WRITABLE = 0x0083C078u;
+
+// PS2 single -> double, exactly (the double exponent range covers 255)
+static inline double ps2ToDouble(uint32_t f) {
+    const uint64_t sign = static_cast<uint64_t>(f >> 31) << 63;
+    const uint32_t e = (f >> 23) & 0xFF;
+    uint64_t b = sign;
+    if (e) b |= static_cast<uint64_t>(e - 127 + 1023) << 52 | static_cast<uint64_t>(f & 0x7FFFFF) << 29;
+    double d;
+    std::memcpy(&d, &b, 8);
+    return d;
+}
+
+// Double -> PS2 single, truncating the mantissa and clamping the exponent
+static inline uint32_t ps2FromDouble(double d, uint32_t& fcr31) {
+    uint64_t b;
+    std::memcpy(&b, &d, 8);
+    const uint32_t sign = static_cast<uint32_t>(b >> 63) << 31;
+    const int32_t e = static_cast<int32_t>((b >> 52) & 0x7FF);
+    if (e == 0 && (b << 1) == 0) return sign;
+
+    const int32_t exp = e - 1023 + 127;
+    if (exp <= 0) {
+        fcr31 |= FCR31_U | FCR31_SU;
+        return sign;
+    }
+    if (exp > 255) {
+        fcr31 |= FCR31_O | FCR31_SO;
+        return sign | FPU_MAX;
+    }
+    return sign | static_cast<uint32_t>(exp) << 23 | static_cast<uint32_t>((b >> 29) & 0x7FFFFF);
+}
+
+// Two-operand arithmetic, one specialization per instruction and mode
+struct FpuAdd { static float f(float a, float b) { return a + b; } static double d(double a, double b) { return a + b; } };
+struct FpuSub { static float f(float a, float b) { return a - b; } static double d(double a, double b) { return a - b; } };
+struct FpuMul { static float f(float a, float b) { return a * b; } static double d(double a, double b) { return a * b; } };
+
+template <EEFpuMode M, class Op>
+static inline uint32_t fpuArith(EERegs& ee, uint32_t a, uint32_t b) {
+    if (M == EEFpuMode::Fast) return bits(Op::f(flt(a), flt(b)));
+    ee.FCR31 &= ~(FCR31_O | FCR31_U);
+    return ps2FromDouble(Op::d(ps2ToDouble(a), ps2ToDouble(b)), ee.FCR31);
+}
+
+// fs = d.rd, ft = d.rt, fd = d.sa
+template <EEFpuMode M, class Op>
+static ExecResult opArith(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.FPR[d.sa] = fpuArith<M, Op>(ee, ee.FPR[d.rd], ee.FPR[d.rt]); return ExecResult::Ok;
+}
+
+// ADDA/SUBA/MULA write the accumulator
+template <EEFpuMode M, class Op>
+static ExecResult opArithA(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.ACC = fpuArith<M, Op>(ee, ee.FPR[d.rd], ee.FPR[d.rt]); return ExecResult::Ok;
+}
+
+// MADD/MSUB(A): ACC +/- fs * ft, with the product rounded first (not fused)
+template <EEFpuMode M, class Op, bool ToAcc>
+static ExecResult opMadd(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t p = fpuArith<M, FpuMul>(ee, ee.FPR[d.rd], ee.FPR[d.rt]);
+    const uint32_t r = fpuArith<M, Op>(ee, ee.ACC, p);
+    if (ToAcc) ee.ACC = r;
+    else       ee.FPR[d.sa] = r;
+    return ExecResult::Ok;
+}
+
+template <EEFpuMode M>
+static ExecResult opDiv(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = ee.FPR[d.rd], b = ee.FPR[d.rt];
+    if (M == EEFpuMode::Fast) { ee.FPR[d.sa] = bits(flt(a) / flt(b)); return ExecResult::Ok; }
+
+    ee.FCR31 &= ~(FCR31_I | FCR31_D);
+    if ((b & 0x7F800000u) == 0) {
+        // x/0 sets D, 0/0 sets I; the result is the signed maximum
+        ee.FCR31 |= (a & 0x7F800000u) ? (FCR31_D | FCR31_SD) : (FCR31_I | FCR31_SI);
+        ee.FPR[d.sa] = ((a ^ b) & 0x80000000u) | FPU_MAX;
+        return ExecResult::Ok;
+    }
+    ee.FPR[d.sa] = ps2FromDouble(ps2ToDouble(a) / ps2ToDouble(b), ee.FCR31);
+    return ExecResult::Ok;
+}
+
+// SQRT.S reads ft; negative inputs set I and use the magnitude
+template <EEFpuMode M>
+static ExecResult opSqrt(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t b = ee.FPR[d.rt];
+    if (M == EEFpuMode::Fast) { ee.FPR[d.sa] = bits(std::sqrt(flt(b))); return ExecResult::Ok; }
+
+    ee.FCR31 &= ~(FCR31_I | FCR31_D);
+    if ((b & 0x7F800000u) == 0) { ee.FPR[d.sa] = b & 0x80000000u; return ExecResult::Ok; }
+    if (b & 0x80000000u) ee.FCR31 |= FCR31_I | FCR31_SI;
+    ee.FPR[d.sa] = ps2FromDouble(std::sqrt(ps2ToDouble(b & FPU_MAX)), ee.FCR31);
+    return ExecResult::Ok;
+}
+
+template <EEFpuMode M>
+static ExecResult opRsqrt(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = ee.FPR[d.rd], b = ee.FPR[d.rt];
+    if (M == EEFpuMode::Fast) { ee.FPR[d.sa] = bits(flt(a) / std::sqrt(flt(b))); return ExecResult::Ok; }
+
+    ee.FCR31 &= ~(FCR31_I | FCR31_D);
+    if ((b & 0x7F800000u) == 0) {
+        ee.FCR31 |= FCR31_D | FCR31_SD;
+        ee.FPR[d.sa] = ((a ^ b) & 0x80000000u) | FPU_MAX;
+        return ExecResult::Ok;
+    }
+    if (b & 0x80000000u) ee.FCR31 |= FCR31_I | FCR31_SI;
+    ee.FPR[d.sa] = ps2FromDouble(ps2ToDouble(a) / std::sqrt(ps2ToDouble(b & FPU_MAX)), ee.FCR31);
+    return ExecResult::Ok;
+}
+
+// Sign-bit operations are exact in both modes and clear O/U
+static ExecResult opAbs(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.FPR[d.sa] = ee.FPR[d.rd] & 0x7FFFFFFFu;
+    ee.FCR31 &= ~(FCR31_O | FCR31_U);
+    return ExecResult::Ok;
+}
+static ExecResult opNeg(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.FPR[d.sa] = ee.FPR[d.rd] ^ 0x80000000u;
+    ee.FCR31 &= ~(FCR31_O | FCR31_U);
+    return ExecResult::Ok;
+}
+static ExecResult opMov(EERegs& ee, Mem&, const DecodedOp& d) {
+    ee.FPR[d.sa] = ee.FPR[d.rd]; return ExecResult::Ok;
+}
+
+// PS2 values order like sign-magnitude integers, which also holds for
+// host floats without NaNs
+static inline int32_t fpuOrderKey(uint32_t v) {
+    return (v & 0x80000000u) ? -static_cast<int32_t>(v & FPU_MAX) : static_cast<int32_t>(v);
+}
+
+template <EEFpuMode M, bool Max>
+static ExecResult opMinMax(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = ee.FPR[d.rd], b = ee.FPR[d.rt];
+    bool aWins;
+    if (M == EEFpuMode::Fast) aWins = Max ? flt(a) > flt(b) : flt(a) < flt(b);
+    else                      aWins = Max ? fpuOrderKey(a) > fpuOrderKey(b) : fpuOrderKey(a) < fpuOrderKey(b);
+    ee.FPR[d.sa] = aWins ? a : b;
+    ee.FCR31 &= ~(FCR31_O | FCR31_U);
+    return ExecResult::Ok;
+}
+
+enum class FpuCond { F, Eq, Lt, Le };
+
+template <EEFpuMode M, FpuCond C>
+static ExecResult opCompare(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = ee.FPR[d.rd], b = ee.FPR[d.rt];
+    bool c = false;
+    if (M == EEFpuMode::Fast) {
+        if (C == FpuCond::Eq) c = flt(a) == flt(b);
+        if (C == FpuCond::Lt) c = flt(a) <  flt(b);
+        if (C == FpuCond::Le) c = flt(a) <= flt(b);
+    } else {
+        const double x = ps2ToDouble(a), y = ps2ToDouble(b);
+        if (C == FpuCond::Eq) c = x == y;
+        if (C == FpuCond::Lt) c = x <  y;
+        if (C == FpuCond::Le) c = x <= y;
+    }
+    ee.FCR31 = c ? (ee.FCR31 | FCR31_C) : (ee.FCR31 & ~FCR31_C);
+    return ExecResult::Ok;
+}
+
+// CVT.W.S truncates and saturates in both modes
+static ExecResult opCvtW(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t v = ee.FPR[d.rd];
+    if ((v & 0x7F800000u) >= 0x4F000000u) ee.FPR[d.sa] = (v & 0x80000000u) ? 0x80000000u : 0x7FFFFFFFu;
+    else                                  ee.FPR[d.sa] = static_cast<uint32_t>(static_cast<int32_t>(flt(v)));
+    return ExecResult::Ok;
+}
+
+template <EEFpuMode M>
+static ExecResult opCvtS(EERegs& ee, Mem&, const DecodedOp& d) {
+    const int32_t v = static_cast<int32_t>(ee.FPR[d.rd]);
+    if (M == EEFpuMode::Fast) ee.FPR[d.sa] = bits(static_cast<float>(v));
+    else                      ee.FPR[d.sa] = ps2FromDouble(static_cast<double>(v), ee.FCR31);
+    return ExecResult::Ok;
+}
+
+// Moves and control registers
+static ExecResult opMFC1(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rt, SX32(ee.FPR[d.rd])); return ExecResult::Ok; }
+static ExecResult opMTC1(EERegs& ee, Mem&, const DecodedOp& d) { ee.FPR[d.rd] = eeGetReg(ee, d.rt); return ExecResult::Ok; }
+static ExecResult opCFC1(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t v = d.rd == 0 ? FCR0 : d.rd == 31 ? ee.FCR31 : 0;
+    eeSetReg64(ee, d.rt, SX32(v));
+    return ExecResult::Ok;
+}
+static ExecResult opCTC1(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (d.rd == 31) ee.FCR31 = (eeGetReg(ee, d.rt) & FCR31_WRITABLE) | FCR31_FIXED;
+    return ExecResult::Ok;
+}
+
+// BC1F/BC1T(L) on the C flag; likely forms are handled by the caller
+static ExecResult opBC1(EERegs& ee, Mem&, const DecodedOp& d) {
+    const bool cond = (ee.FCR31 & FCR31_C) != 0;
+    ee.branchTaken = (d.rt & 1) ? cond : !cond;
+    ee.branchTarget = ee.pc + 4 + (static_cast<uint32_t>(static_cast<int32_t>(d.imm)) << 2);
+    return ExecResult::Ok;
+}
+
+// -----------------------------------------------------------------------------
+// Tables: COP1 by rs is shared, the S and W formats exist once per mode
+// -----------------------------------------------------------------------------
+
+static constexpr EEOpTable<32> eeMakeCop1() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opMFC1, "MFC1");
+    b.op(0x02, opCFC1, "CFC1");
+    b.op(0x04, opMTC1, "MTC1");
+    b.op(0x06, opCTC1, "CTC1");
+    b.op(0x08, opBC1, "BC1");
+    b.name(0x10, "FPU.S");    b.name(0x14, "FPU.W");
+    return b.t;
+}
+
+template <EEFpuMode M>
+static constexpr EEOpTable<64> eeMakeCop1S() {
+    EEOpTableBuilder<64> b;
+    b.op(0x00, opArith<M, FpuAdd>, "ADD.S");
+    b.op(0x01, opArith<M, FpuSub>, "SUB.S");
+    b.op(0x02, opArith<M, FpuMul>, "MUL.S");
+    b.op(0x03, opDiv<M>,  "DIV.S");
+    b.op(0x04, opSqrt<M>, "SQRT.S");
+    b.op(0x05, opAbs, "ABS.S");
+    b.op(0x06, opMov, "MOV.S");
+    b.op(0x07, opNeg, "NEG.S");
+    b.op(0x16, opRsqrt<M>, "RSQRT.S");
+    b.op(0x18, opArithA<M, FpuAdd>, "ADDA.S");
+    b.op(0x19, opArithA<M, FpuSub>, "SUBA.S");
+    b.op(0x1A, opArithA<M, FpuMul>, "MULA.S");
+    b.op(0x1C, opMadd<M, FpuAdd, false>, "MADD.S");
+    b.op(0x1D, opMadd<M, FpuSub, false>, "MSUB.S");
+    b.op(0x1E, opMadd<M, FpuAdd, true>,  "MADDA.S");
+    b.op(0x1F, opMadd<M, FpuSub, true>,  "MSUBA.S");
+    b.op(0x24, opCvtW, "CVT.W.S");
+    b.op(0x28, opMinMax<M, true>,  "MAX.S");
+    b.op(0x29, opMinMax<M, false>, "MIN.S");
+    b.op(0x30, opCompare<M, FpuCond::F>,  "C.F.S");
+    b.op(0x32, opCompare<M, FpuCond::Eq>, "C.EQ.S");
+    b.op(0x34, opCompare<M, FpuCond::Lt>, "C.LT.S");
+    b.op(0x36, opCompare<M, FpuCond::Le>, "C.LE.S");
+    return b.t;
+}
+
+template <EEFpuMode M>
+static constexpr EEOpTable<64> eeMakeCop1W() {
+    EEOpTableBuilder<64> b;
+    b.op(0x20, opCvtS<M>, "CVT.S.W");
+    return b.t;
+}
+
+static constexpr EEOpTable<32> kCop1 = eeMakeCop1();
+static constexpr EEOpTable<64> kCop1S[2] = {eeMakeCop1S<EEFpuMode::Fast>(), eeMakeCop1S<EEFpuMode::Accurate>()};
+static constexpr EEOpTable<64> kCop1W[2] = {eeMakeCop1W<EEFpuMode::Fast>(), eeMakeCop1W<EEFpuMode::Accurate>()};
+
+const EEOpEntry& eeFpuEntry(const DecodedOp& d, uint32_t& key, EEFpuMode mode) {
+    const size_t m = mode == EEFpuMode::Accurate ? 1 : 0;
+    switch (d.rs) {
+        case 0x10: key = TBL_COP1_S << 8 | d.func; return kCop1S[m][d.func];
+        case 0x14: key = TBL_COP1_W << 8 | d.func; return kCop1W[m][d.func];
+        default:   key = TBL_COP1 << 8 | d.rs;     return kCop1[d.rs];
+    }
+}
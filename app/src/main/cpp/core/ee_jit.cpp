@@ -0,0 +1,531 @@
+#include "ee_jit.h"
+#include <cstddef>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define EE_JIT_BACKEND 1
+#else
+#define EE_JIT_BACKEND 0
+#endif
+
+using EEJitEnter = uint32_t (*)(EERegs* ee, Mem* mem, int32_t* budget, const void* body, uint8_t* fastmem);
+
+// EERegs field offsets used by compiled code. Native code works on the low
+// doubleword of a GPR as two 32-bit halves.
+static inline uint32_t gprOff(uint32_t r) {
+    return static_cast<uint32_t>(offsetof(EERegs, GPR) + r * sizeof(EEGpr));
+}
+static inline uint32_t gprHiOff(uint32_t r) { return gprOff(r) + 4; }
+static constexpr uint32_t PC_OFF     = offsetof(EERegs, pc);
+static constexpr uint32_t NEXTPC_OFF = offsetof(EERegs, nextPc);
+static constexpr uint32_t TAKEN_OFF  = offsetof(EERegs, branchTaken);
+static constexpr uint32_t TARGET_OFF = offsetof(EERegs, branchTarget);
+static constexpr uint32_t DELAY_OFF  = offsetof(EERegs, delaySlot);
+static constexpr uint32_t BLOCKEND_OFF = offsetof(EERegs, blockEnd);
+
+static inline int32_t S16(int16_t imm) { return imm; }
+
+// -----------------------------------------------------------------------------
+// Code-page write hook: unlink blocks on the page right away, so chained
+// blocks stop jumping into stale code before the cache drains the page.
+// -----------------------------------------------------------------------------
+
+static void eeJitOnCodeWrite(void* user, uint32_t page) {
+    EEJit& jit = *static_cast<EEJit*>(user);
+    auto it = jit.cache->pageBlocks.find(page);
+    if (it == jit.cache->pageBlocks.end()) return;
+
+    for (uint32_t pc : it->second) {
+        auto link = jit.links.find(pc);
+        if (link != jit.links.end()) link->second = nullptr;
+    }
+}
+
+#if EE_JIT_BACKEND
+
+static inline void loadGpr(JitAsm& a, int r, uint32_t gpr) {
+    if (gpr == 0) jitEmitLoadZero(a, r);
+    else          jitEmitLoad(a, r, gprOff(gpr));
+}
+
+static inline void loadGprHi(JitAsm& a, int r, uint32_t gpr) {
+    if (gpr == 0) jitEmitLoadZero(a, r);
+    else          jitEmitLoad(a, r, gprHiOff(gpr));
+}
+
+// 32-bit constant result, sign-extended like eeSetReg
+static inline void storeImmSx(JitAsm& a, uint32_t gpr, uint32_t imm) {
+    jitEmitStoreImm(a, gprOff(gpr), imm);
+    jitEmitStoreImm(a, gprHiOff(gpr), (imm & 0x80000000u) ? 0xFFFFFFFFu : 0);
+}
+
+// ADDU/SUBU produce sign-extended 32-bit results; logic ops run on both halves
+static bool emitRR(JitAsm& a, const DecodedOp& d, JitAlu op) {
+    if (d.rd == 0) return true;
+    loadGpr(a, 0, d.rs);
+    loadGpr(a, 1, d.rt);
+    jitEmitAlu(a, op);
+    if (op == JitAlu::Add || op == JitAlu::Sub) {
+        jitEmitStoreSx(a, 0, gprOff(d.rd));
+        return true;
+    }
+    jitEmitStore(a, 0, gprOff(d.rd));
+    loadGprHi(a, 0, d.rs);
+    loadGprHi(a, 1, d.rt);
+    jitEmitAlu(a, op);
+    jitEmitStore(a, 0, gprHiOff(d.rd));
+    return true;
+}
+
+// BEQ/BNE on the full doubleword: (lo ^ lo) | (hi ^ hi) against zero.
+// branchTarget is free scratch here since native branches exit to constants.
+static bool emitBranchEq(JitAsm& a, const DecodedOp& d, JitCmp cc) {
+    loadGpr(a, 0, d.rs);
+    loadGpr(a, 1, d.rt);
+    jitEmitAlu(a, JitAlu::Xor);
+    jitEmitStore(a, 0, TARGET_OFF);
+    loadGprHi(a, 0, d.rs);
+    loadGprHi(a, 1, d.rt);
+    jitEmitAlu(a, JitAlu::Xor);
+    jitEmitLoad(a, 1, TARGET_OFF);
+    jitEmitAlu(a, JitAlu::Or);
+    jitEmitLoadZero(a, 1);
+    jitEmitCmp(a, cc);
+    jitEmitStoreByte(a, 0, TAKEN_OFF);
+    return true;
+}
+
+static bool emitShift(JitAsm& a, const DecodedOp& d, JitShift op) {
+    if (d.rd == 0) return true;
+    loadGpr(a, 0, d.rt);
+    jitEmitShift(a, op, d.sa);
+    jitEmitStoreSx(a, 0, gprOff(d.rd));
+    return true;
+}
+
+// ANDI clears the upper word; ORI/XORI pass it through from rs
+static bool emitLogicImm(JitAsm& a, const DecodedOp& d, JitAlu op) {
+    if (d.rt == 0) return true;
+    loadGpr(a, 0, d.rs);
+    jitEmitAluImm(a, op, static_cast<uint16_t>(d.imm));
+    jitEmitStore(a, 0, gprOff(d.rt));
+    if (op == JitAlu::And || d.rs == 0) {
+        jitEmitStoreImm(a, gprHiOff(d.rt), 0);
+    } else if (d.rs != d.rt) {
+        jitEmitLoad(a, 0, gprHiOff(d.rs));
+        jitEmitStore(a, 0, gprHiOff(d.rt));
+    }
+    return true;
+}
+
+static inline void storeFlag(JitAsm& a, uint32_t off, bool v) {
+    jitEmitLoadZero(a, 0);
+    if (v) jitEmitAluImm(a, JitAlu::Or, 1);
+    jitEmitStoreByte(a, 0, off);
+}
+
+// Emit host code for one instruction. Returns false when the instruction
+// has no native form and must go through its interpreter handler. With a
+// full JitAsm this only answers the question and writes nothing.
+static bool jitEmitOp(JitAsm& a, const DecodedOp& d, uint32_t pc) {
+    switch (d.op) {
+        case 0x00: { // SPECIAL
+            switch (d.func) {
+                case 0x00: return emitShift(a, d, JitShift::Sll);
+                case 0x02: return emitShift(a, d, JitShift::Srl);
+                case 0x03: return emitShift(a, d, JitShift::Sra);
+                case 0x08: // JR
+                    loadGpr(a, 0, d.rs);
+                    jitEmitStore(a, 0, TARGET_OFF);
+                    return true;
+                case 0x09: // JALR
+                    loadGpr(a, 0, d.rs);
+                    jitEmitStore(a, 0, TARGET_OFF);
+                    storeImmSx(a, d.rd ? d.rd : 31, pc + 8);
+                    return true;
+                case 0x21: return emitRR(a, d, JitAlu::Add);
+                case 0x23: return emitRR(a, d, JitAlu::Sub);
+                case 0x24: return emitRR(a, d, JitAlu::And);
+                case 0x25: return emitRR(a, d, JitAlu::Or);
+                case 0x26: return emitRR(a, d, JitAlu::Xor);
+                case 0x27: return emitRR(a, d, JitAlu::Nor);
+                default:   return false;
+            }
+        }
+        case 0x02: // J, target applied at block exit
+            return true;
+        case 0x03: // JAL
+            storeImmSx(a, 31, pc + 8);
+            return true;
+        case 0x04: return emitBranchEq(a, d, JitCmp::Eq); // BEQ
+        case 0x05: return emitBranchEq(a, d, JitCmp::Ne); // BNE
+        case 0x09: // ADDIU
+            if (d.rt == 0) return true;
+            if (d.rs == 0) { storeImmSx(a, d.rt, static_cast<uint32_t>(S16(d.imm))); return true; }
+            jitEmitLoad(a, 0, gprOff(d.rs));
+            jitEmitAluImm(a, JitAlu::Add, static_cast<uint32_t>(S16(d.imm)));
+            jitEmitStoreSx(a, 0, gprOff(d.rt));
+            return true;
+        case 0x0C: return emitLogicImm(a, d, JitAlu::And); // ANDI
+        case 0x0D: return emitLogicImm(a, d, JitAlu::Or);  // ORI
+        case 0x0E: return emitLogicImm(a, d, JitAlu::Xor); // XORI
+        case 0x0F: // LUI
+            if (d.rt == 0) return true;
+            storeImmSx(a, d.rt, static_cast<uint32_t>(static_cast<uint16_t>(d.imm)) << 16);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Loads compiled as a direct read from the fastmem window
+static bool jitFastLoad(const EEJit& jit, const DecodedOp& d, uint32_t& bytes, bool& sign) {
+    if (!jit.fastmem || d.rt == 0) return false;
+    switch (d.op) {
+        case 0x20: bytes = 1; sign = true;  return true; // LB
+        case 0x21: bytes = 2; sign = true;  return true; // LH
+        case 0x23: bytes = 4; sign = true;  return true; // LW
+        case 0x24: bytes = 1; sign = false; return true; // LBU
+        case 0x25: bytes = 2; sign = false; return true; // LHU
+        case 0x27: bytes = 4; sign = false; return true; // LWU
+        default:   return false;
+    }
+}
+
+// A fastmem load's way out: misaligned addresses branch to `misaligned`,
+// MMIO faults at `access` get patched to jump to the handler call
+struct JitLoadSite {
+    const uint8_t* access;
+    uint8_t*       misaligned;
+    const uint8_t* resume;
+    uint32_t       index;
+    DecodedOp*     data;
+};
+
+static void jitEmitFastLoadOp(JitAsm& a, const DecodedOp& d, std::vector<JitLoadSite>& sites,
+                              uint32_t index, DecodedOp* data, uint32_t bytes, bool sign) {
+    loadGpr(a, 0, d.rs);
+    if (d.imm) jitEmitAluImm(a, JitAlu::Add, static_cast<uint32_t>(S16(d.imm)));
+    uint8_t* misaligned = bytes > 1 ? jitEmitSkipIfMasked(a, bytes - 1) : nullptr;
+    const uint8_t* access = jitEmitFastLoad(a, bytes, sign);
+    if (sign) {
+        jitEmitStoreSx(a, 0, gprOff(d.rt));
+    } else {
+        jitEmitStore(a, 0, gprOff(d.rt));
+        jitEmitStoreImm(a, gprHiOff(d.rt), 0);
+    }
+    sites.push_back(JitLoadSite{access, misaligned, a.p, index, data});
+}
+
+static inline bool jitIsNative(const DecodedOp& d) {
+    JitAsm probe{nullptr, nullptr, true};
+    return jitEmitOp(probe, d, 0);
+}
+
+// Link cell for a block exit. Idle loops always return to eeJitRun, which
+// needs to see them spin.
+static void* const kNoLink = nullptr;
+
+static inline void* const* jitCell(EEJit& jit, const EEBlock& b, uint32_t target) {
+    return b.idle ? &kNoLink : &jit.links[target];
+}
+
+// Emit the block tail: pick the next guest PC and chain or return
+static void jitEmitTail(EEJit& jit, JitAsm& a, const EEBlock& b) {
+    if (b.branchIdx < 0) {
+        jitEmitExit(a, PC_OFF, NEXTPC_OFF, b.endPc, jitCell(jit, b, b.endPc), jit.stubs);
+        return;
+    }
+
+    const DecodedOp& d = b.ops[b.branchIdx].d;
+    const uint32_t pc = b.startPc + (static_cast<uint32_t>(b.branchIdx) << 2);
+
+    if (!jitIsNative(d)) {
+        // Interpreted branch: its handler left taken/target in EERegs
+        uint8_t* notTaken = jitEmitSkipIfByteZero(a, TAKEN_OFF);
+        jitEmitExitDynamic(a, TARGET_OFF, PC_OFF, NEXTPC_OFF, jit.stubs);
+        jitBind(a, notTaken);
+        jitEmitExit(a, PC_OFF, NEXTPC_OFF, b.endPc, jitCell(jit, b, b.endPc), jit.stubs);
+        return;
+    }
+
+    switch (d.op) {
+        case 0x00: // JR, JALR
+            jitEmitExitDynamic(a, TARGET_OFF, PC_OFF, NEXTPC_OFF, jit.stubs);
+            break;
+        case 0x02: case 0x03: { // J, JAL
+            const uint32_t target = (pc & 0xF0000000u) | d.target;
+            jitEmitExit(a, PC_OFF, NEXTPC_OFF, target, jitCell(jit, b, target), jit.stubs);
+            break;
+        }
+        default: { // BEQ, BNE
+            const uint32_t target = pc + 4 + (static_cast<uint32_t>(S16(d.imm)) << 2);
+            uint8_t* notTaken = jitEmitSkipIfByteZero(a, TAKEN_OFF);
+            jitEmitExit(a, PC_OFF, NEXTPC_OFF, target, jitCell(jit, b, target), jit.stubs);
+            jitBind(a, notTaken);
+            jitEmitExit(a, PC_OFF, NEXTPC_OFF, b.endPc, jitCell(jit, b, b.endPc), jit.stubs);
+            break;
+        }
+    }
+}
+
+// Translate one block into the code cache; false if it did not fit
+static bool jitTranslate(EEJit& jit, EEBlock& b) {
+    const uint32_t n = static_cast<uint32_t>(b.ops.size());
+
+    // Operand records for interpreted ops live just ahead of the code
+    size_t at = (jit.codeUsed + 15) & ~size_t(15);
+    DecodedOp* data = reinterpret_cast<DecodedOp*>(jit.code + at);
+    uint32_t calls = 0;
+    for (const EEBlockOp& op : b.ops) if (!jitIsNative(op.d)) ++calls;
+    at += calls * sizeof(DecodedOp);
+    at = (at + 15) & ~size_t(15);
+    if (at >= jit.codeSize) return false;
+
+    JitAsm a{jit.code + at, jit.code + jit.codeSize, false};
+    uint8_t* body = a.p;
+    jitEmitBudget(a, n);
+    jitEmitStoreImm(a, BLOCKEND_OFF, b.endPc); // for eeSliceCycles
+
+    const int32_t slot = b.branchIdx >= 0 && b.flow != EEFlow::Jump ? b.branchIdx + 1 : -1;
+    uint8_t* skipSlot = nullptr;
+    std::vector<JitLoadSite> sites;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        const EEBlockOp& op = b.ops[i];
+        const uint32_t pc = b.startPc + (i << 2);
+        const bool inSlot = static_cast<int32_t>(i) == slot;
+
+        if (static_cast<int32_t>(i) == b.branchIdx && !jitIsNative(op.d)) {
+            // Handlers only write these when they branch
+            storeFlag(a, TAKEN_OFF, false);
+        }
+
+        // Likely branches only run their delay slot when taken
+        if (inSlot && b.flow == EEFlow::BranchLikely) skipSlot = jitEmitSkipIfByteZero(a, TAKEN_OFF);
+
+        if (jitEmitOp(a, op.d, pc)) continue;
+
+        uint32_t bytes = 0;
+        bool sign = false;
+        if (jitFastLoad(jit, op.d, bytes, sign)) {
+            *data = op.d;
+            jitEmitFastLoadOp(a, op.d, sites, i, data++, bytes, sign);
+            continue;
+        }
+
+        *data = op.d;
+        jitEmitStoreImm(a, PC_OFF, pc);
+        if (inSlot) storeFlag(a, DELAY_OFF, true);
+        jitEmitCall(a, reinterpret_cast<const void*>(op.fn), data, n - i, jit.stubs);
+        if (inSlot) storeFlag(a, DELAY_OFF, false);
+        ++data;
+    }
+    jitBind(a, skipSlot);
+
+    jitEmitTail(jit, a, b);
+
+    // Out-of-line handler calls for fastmem loads, resuming after the load
+    std::vector<std::pair<const uint8_t*, const uint8_t*>> faults;
+    for (const JitLoadSite& s : sites) {
+        jitBind(a, s.misaligned);
+        const uint8_t* call = a.p;
+        const bool inSlot = static_cast<int32_t>(s.index) == slot;
+        jitEmitStoreImm(a, PC_OFF, b.startPc + (s.index << 2));
+        if (inSlot) storeFlag(a, DELAY_OFF, true);
+        jitEmitCall(a, reinterpret_cast<const void*>(b.ops[s.index].fn), s.data, n - s.index, jit.stubs);
+        if (inSlot) storeFlag(a, DELAY_OFF, false);
+        jitEmitJump(a, s.resume);
+        faults.emplace_back(s.access, call);
+    }
+    if (a.full) return false;
+
+    for (const auto& f : faults) jit.faultSites[reinterpret_cast<uintptr_t>(f.first)] = f.second;
+    jit.fastLoads += faults.size();
+    jitFlushICache(body, a.p);
+    jit.codeUsed = static_cast<size_t>(a.p - jit.code);
+    b.jitCode = body;
+    jit.links[b.startPc] = body;
+    jit.compiled++;
+    return true;
+}
+
+static void eeJitCompile(EEJit& jit, EEBlock& b) {
+    // A branch in a delay slot is undefined on MIPS; leave such blocks alone
+    if (b.branchIdx >= 0 && static_cast<size_t>(b.branchIdx) + 1 < b.ops.size() &&
+        eeFlow(b.ops[b.branchIdx + 1].d) != EEFlow::None) {
+        b.noJit = true;
+        jit.rejected++;
+        return;
+    }
+
+    if (jitTranslate(jit, b)) return;
+
+    // Cache full: start over and retry once
+    eeJitFlush(jit);
+    if (!jitTranslate(jit, b)) {
+        b.noJit = true;
+        jit.rejected++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Fastmem faults: a compiled load that hits an unmapped (MMIO) page is
+// patched to jump to its handler call, and resumes there. Anything else is
+// passed on to the handler installed before ours.
+// -----------------------------------------------------------------------------
+
+static EEJit* g_faultJit = nullptr;
+static struct sigaction g_prevSegv;
+
+static void eeJitFault(int sig, siginfo_t* info, void* ctx) {
+    uintptr_t* pc = jitFaultPc(ctx);
+    if (EEJit* jit = g_faultJit) {
+        auto it = jit->faultSites.find(*pc);
+        if (it != jit->faultSites.end()) {
+            jitPatchJump(reinterpret_cast<uint8_t*>(*pc), it->second);
+            *pc = reinterpret_cast<uintptr_t>(it->second);
+            jit->patchedLoads++;
+            return;
+        }
+    }
+
+    if (g_prevSegv.sa_flags & SA_SIGINFO) {
+        g_prevSegv.sa_sigaction(sig, info, ctx);
+    } else if (g_prevSegv.sa_handler != SIG_DFL && g_prevSegv.sa_handler != SIG_IGN) {
+        g_prevSegv.sa_handler(sig);
+    } else {
+        signal(sig, SIG_DFL); // returning re-runs the access and takes the default action
+    }
+}
+
+static void eeJitInstallFaultHandler() {
+    static bool installed = false;
+    if (installed) return;
+    struct sigaction sa {};
+    sa.sa_sigaction = eeJitFault;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    installed = sigaction(SIGSEGV, &sa, &g_prevSegv) == 0;
+}
+
+#endif // EE_JIT_BACKEND
+
+bool eeJitInit(EEJit& jit, Mem& mem, EEBlockCache& c) {
+    jit.cache = &c;
+    jit.enabled = false;
+    jit.links.clear();
+    jit.faultSites.clear();
+    jit.fastmem = mem.fastmem;
+    jit.compiled = jit.rejected = jit.flushes = 0;
+    jit.fastLoads = jit.patchedLoads = 0;
+
+#if EE_JIT_BACKEND
+    void* code = mmap(nullptr, EE_JIT_CACHE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) return false;
+
+    jit.code = static_cast<uint8_t*>(code);
+    jit.codeSize = EE_JIT_CACHE_SIZE;
+
+    JitAsm a{jit.code, jit.code + jit.codeSize, false};
+    jitEmitStubs(a, jit.stubs);
+    jitFlushICache(jit.code, a.p);
+    jit.stubsSize = jit.codeUsed = static_cast<size_t>(a.p - jit.code);
+
+    mem.onCodeWrite = eeJitOnCodeWrite;
+    mem.onCodeWriteUser = &jit;
+    eeJitInstallFaultHandler();
+    g_faultJit = &jit;
+    jit.enabled = true;
+    return true;
+#else
+    (void)mem;
+    return false;
+#endif
+}
+
+void eeJitShutdown(EEJit& jit, Mem& mem) {
+    if (jit.cache) {
+        for (auto& kv : jit.cache->blocks) kv.second.jitCode = nullptr;
+    }
+    if (jit.code) munmap(jit.code, jit.codeSize);
+    jit.code = nullptr;
+    jit.codeSize = jit.codeUsed = jit.stubsSize = 0;
+    jit.links.clear();
+    jit.faultSites.clear();
+    jit.enabled = false;
+#if EE_JIT_BACKEND
+    if (g_faultJit == &jit) g_faultJit = nullptr;
+#endif
+
+    if (mem.onCodeWriteUser == &jit) {
+        mem.onCodeWrite = nullptr;
+        mem.onCodeWriteUser = nullptr;
+    }
+}
+
+void eeJitFlush(EEJit& jit) {
+    if (jit.cache) {
+        for (auto& kv : jit.cache->blocks) {
+            kv.second.jitCode = nullptr;
+            kv.second.noJit = false;
+        }
+    }
+    jit.links.clear();
+    jit.faultSites.clear();
+    jit.codeUsed = jit.stubsSize;
+    jit.flushes++;
+}
+
+ExecResult eeJitRun(EEJit& jit, EERegs& ee, Mem& mem, int32_t budget, uint32_t& executed) {
+    executed = 0;
+
+#if EE_JIT_BACKEND
+    // Compiled loads are tied to the window they were built against
+    if (jit.fastmem != mem.fastmem) {
+        eeJitFlush(jit);
+        jit.fastmem = mem.fastmem;
+    }
+#endif
+
+    int32_t left = budget;
+    ee.budget = &left;
+    ee.budgetStart = budget;
+    ExecResult r = ExecResult::Ok;
+    while (left > 0) {
+        EEBlock* b = eeBlockLookup(*jit.cache, ee, mem);
+        if (!b) { r = ExecResult::Exception; break; }
+
+#if EE_JIT_BACKEND
+        if (!b->jitCode && jit.enabled && !b->noJit && b->hits >= EE_JIT_HOT_THRESHOLD) {
+            eeJitCompile(jit, *b);
+        }
+
+        if (b->jitCode) {
+            const EEJitEnter enter = reinterpret_cast<EEJitEnter>(const_cast<uint8_t*>(jit.stubs.enter));
+            const uint32_t status = enter(&ee, &mem, &left, b->jitCode, mem.fastmem);
+            if (status != 0) { r = ExecResult::Exception; break; }
+            if (eeBlockSpun(*b, ee, mem)) { r = ExecResult::Idle; break; }
+            continue;
+        }
+#endif
+
+        // Charge the whole block up front, as compiled code does
+        const int32_t len = static_cast<int32_t>(b->ops.size());
+        ee.blockEnd = b->endPc;
+        left -= len;
+        uint32_t n = 0;
+        r = eeExecBlock(ee, mem, *b, n);
+        left += len - static_cast<int32_t>(n);
+        if (r == ExecResult::Exception) break;
+        r = ExecResult::Ok;
+        if (eeBlockSpun(*b, ee, mem)) { r = ExecResult::Idle; break; }
+    }
+
+    ee.budget = nullptr;
+    executed = static_cast<uint32_t>(budget - left);
+    return r;
+}
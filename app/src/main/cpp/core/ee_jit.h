@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include "ee_block.h"
+#include "ee_jit_emit.h"
+
+// Tiered EE execution: blocks start in the block-cache interpreter and are
+// recompiled to host code (x86-64 / AArch64) once they are hot. Other hosts
+// run interpreter-only through the same entry point.
+
+// Dispatches of a block before it is handed to the recompiler
+static constexpr uint32_t EE_JIT_HOT_THRESHOLD = 32;
+
+// Bounded host code cache; filling it flushes every compiled block
+static constexpr size_t EE_JIT_CACHE_SIZE = 8 * 1024 * 1024;
+
+struct EEJit {
+    bool     enabled = false;
+    uint8_t* code = nullptr;     // RWX code cache
+    size_t   codeSize = 0;
+    size_t   codeUsed = 0;       // includes the shared stubs
+    size_t   stubsSize = 0;
+    JitStubs stubs{};
+
+    EEBlockCache* cache = nullptr;
+
+    // Fastmem window compiled loads read from (null: all loads go through
+    // their handlers), and the access instructions that may fault on MMIO
+    // mapped to the out-of-line handler call to patch in
+    uint8_t* fastmem = nullptr;
+    std::unordered_map<uintptr_t, const uint8_t*> faultSites;
+
+    // Link cells: guest PC -> compiled body, or null when that PC has no
+    // valid compiled block. Exits chain through these without returning.
+    std::unordered_map<uint32_t, void*> links;
+
+    uint64_t compiled = 0;
+    uint64_t rejected = 0;       // blocks left to the interpreter
+    uint64_t flushes = 0;
+    uint64_t fastLoads = 0;      // loads compiled against fastmem
+    uint64_t patchedLoads = 0;   // of those, rerouted after hitting MMIO
+};
+
+// Map the code cache, hook code-page writes and install the fastmem fault
+// handler. Leaves jit.enabled false (interpreter only) when the host has no
+// backend or mapping fails.
+bool eeJitInit(EEJit& jit, Mem& mem, EEBlockCache& c);
+void eeJitShutdown(EEJit& jit, Mem& mem);
+
+// Drop all compiled code (blocks stay cached for the interpreter)
+void eeJitFlush(EEJit& jit);
+
+// Run blocks from ee.pc until at least `budget` instructions have executed,
+// compiling hot blocks along the way; executed receives the count.
+ExecResult eeJitRun(EEJit& jit, EERegs& ee, Mem& mem, int32_t budget, uint32_t& executed);
@@ -0,0 +1,265 @@
+// AArch64 (AAPCS64) backend for the EE recompiler.
+// x19 = EERegs*, x20 = Mem*, x21 = int32_t* budget, x22 = fastmem base;
+// w0/w1 are r0/r1, x16/x17 are used for addresses and call targets.
+#if defined(__aarch64__)
+#include "ee_jit_emit.h"
+#include <cstring>
+#include <ucontext.h>
+
+static inline bool jitRoom(JitAsm& a, size_t n) {
+    if (a.full || a.p + n > a.end) { a.full = true; return false; }
+    return true;
+}
+
+static inline void put32(JitAsm& a, uint32_t insn) { std::memcpy(a.p, &insn, 4); a.p += 4; }
+
+// Every emitter below writes at most this many bytes
+static constexpr size_t MAX_SEQ = 96;
+
+static constexpr uint32_t X19 = 19, X20 = 20, X21 = 21, X22 = 22, X16 = 16;
+
+enum : uint32_t { CC_EQ = 0x0, CC_NE = 0x1, CC_HS = 0x2, CC_GE = 0xA, CC_GT = 0xC };
+
+static inline uint32_t ldrW(uint32_t rt, uint32_t rn, uint32_t off)  { return 0xB9400000u | ((off >> 2) << 10) | (rn << 5) | rt; }
+static inline uint32_t strW(uint32_t rt, uint32_t rn, uint32_t off)  { return 0xB9000000u | ((off >> 2) << 10) | (rn << 5) | rt; }
+static inline uint32_t strB(uint32_t rt, uint32_t rn, uint32_t off)  { return 0x39000000u | (off << 10) | (rn << 5) | rt; }
+static inline uint32_t ldrB(uint32_t rt, uint32_t rn, uint32_t off)  { return 0x39400000u | (off << 10) | (rn << 5) | rt; }
+static inline uint32_t ldrX(uint32_t rt, uint32_t rn, uint32_t off)  { return 0xF9400000u | ((off >> 3) << 10) | (rn << 5) | rt; }
+static inline uint32_t strX(uint32_t rt, uint32_t rn, uint32_t off)  { return 0xF9000000u | ((off >> 3) << 10) | (rn << 5) | rt; }
+static inline uint32_t movX(uint32_t rd, uint32_t rm)                { return 0xAA0003E0u | (rm << 16) | rd; }
+static inline uint32_t movzW(uint32_t rd, uint32_t imm, uint32_t hw) { return 0x52800000u | (hw << 21) | ((imm & 0xFFFF) << 5) | rd; }
+static inline uint32_t movkW(uint32_t rd, uint32_t imm, uint32_t hw) { return 0x72800000u | (hw << 21) | ((imm & 0xFFFF) << 5) | rd; }
+static inline uint32_t movzX(uint32_t rd, uint32_t imm, uint32_t hw) { return 0xD2800000u | (hw << 21) | ((imm & 0xFFFF) << 5) | rd; }
+static inline uint32_t movkX(uint32_t rd, uint32_t imm, uint32_t hw) { return 0xF2800000u | (hw << 21) | ((imm & 0xFFFF) << 5) | rd; }
+static inline uint32_t bCond(uint32_t cond, int32_t words)          { return 0x54000000u | ((static_cast<uint32_t>(words) & 0x7FFFF) << 5) | cond; }
+static inline uint32_t bRel(int32_t words)                           { return 0x14000000u | (static_cast<uint32_t>(words) & 0x3FFFFFF); }
+
+static inline int32_t wordsTo(const JitAsm& a, const uint8_t* target) {
+    return static_cast<int32_t>((target - a.p) / 4);
+}
+
+static void movImmW(JitAsm& a, uint32_t rd, uint32_t imm) {
+    put32(a, movzW(rd, imm, 0));
+    if (imm >> 16) put32(a, movkW(rd, imm >> 16, 1));
+}
+
+static void movImmX(JitAsm& a, uint32_t rd, uint64_t imm) {
+    put32(a, movzX(rd, static_cast<uint32_t>(imm), 0));
+    for (uint32_t hw = 1; hw < 4; ++hw) {
+        const uint32_t part = static_cast<uint32_t>(imm >> (hw * 16)) & 0xFFFF;
+        if (part) put32(a, movkX(rd, part, hw));
+    }
+}
+
+void jitEmitStubs(JitAsm& a, JitStubs& s) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+
+    s.enter = a.p;
+    put32(a, 0xA9BD7BFDu);          // stp x29, x30, [sp, #-48]!
+    put32(a, 0x910003FDu);          // mov x29, sp
+    put32(a, 0xA90153F3u);          // stp x19, x20, [sp, #16]
+    put32(a, 0xA9025BF5u);          // stp x21, x22, [sp, #32]
+    put32(a, movX(X19, 0));         // mov x19, x0
+    put32(a, movX(X20, 1));         // mov x20, x1
+    put32(a, movX(X21, 2));         // mov x21, x2
+    put32(a, movX(X22, 4));         // mov x22, x4
+    put32(a, 0xD61F0060u);          // br x3
+
+    s.exitExc = a.p;
+    put32(a, movzW(0, 1, 0));       // mov w0, #1
+    put32(a, bRel(2));              // b +8
+
+    s.exitOk = a.p;
+    put32(a, movzW(0, 0, 0));       // mov w0, #0
+    put32(a, 0xA9425BF5u);          // ldp x21, x22, [sp, #32]
+    put32(a, 0xA94153F3u);          // ldp x19, x20, [sp, #16]
+    put32(a, 0xA8C37BFDu);          // ldp x29, x30, [sp], #48
+    put32(a, 0xD65F03C0u);          // ret
+}
+
+void jitEmitBudget(JitAsm& a, uint32_t ops) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, ldrW(2, X21, 0));                           // ldr w2, [x21]
+    put32(a, 0x51000000u | ((ops & 0xFFF) << 10) | (2 << 5) | 2); // sub w2, w2, #ops
+    put32(a, strW(2, X21, 0));                           // str w2, [x21]
+}
+
+void jitEmitLoad(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, ldrW(static_cast<uint32_t>(r), X19, off));
+}
+
+void jitEmitLoadZero(JitAsm& a, int r) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, movzW(static_cast<uint32_t>(r), 0, 0));
+}
+
+void jitEmitStore(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, strW(static_cast<uint32_t>(r), X19, off));
+}
+
+void jitEmitStoreSx(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    const uint32_t n = static_cast<uint32_t>(r);
+    put32(a, 0x93407C00u | (n << 5) | n); // sxtw xN, wN
+    put32(a, strX(n, X19, off));          // str xN, [x19, #off]
+}
+
+void jitEmitStoreByte(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, strB(static_cast<uint32_t>(r), X19, off));
+}
+
+void jitEmitStoreImm(JitAsm& a, uint32_t off, uint32_t imm) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    movImmW(a, 2, imm);
+    put32(a, strW(2, X19, off));
+}
+
+static uint32_t aluRegBase(JitAlu op) {
+    switch (op) {
+        case JitAlu::Add: return 0x0B000000u; // add
+        case JitAlu::Sub: return 0x4B000000u; // sub
+        case JitAlu::And: return 0x0A000000u; // and
+        case JitAlu::Or:  return 0x2A000000u; // orr
+        case JitAlu::Xor: return 0x4A000000u; // eor
+        case JitAlu::Nor: return 0x2A200000u; // orn (combined with orr below)
+    }
+    return 0;
+}
+
+void jitEmitAluImm(JitAsm& a, JitAlu op, uint32_t imm) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    if (op == JitAlu::Nor) { a.full = true; return; }
+    movImmW(a, 2, imm);
+    put32(a, aluRegBase(op) | (2 << 16) | (0 << 5) | 0); // op w0, w0, w2
+}
+
+void jitEmitAlu(JitAsm& a, JitAlu op) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    if (op == JitAlu::Nor) {
+        put32(a, aluRegBase(JitAlu::Or) | (1 << 16) | (0 << 5) | 0); // orr w0, w0, w1
+        put32(a, 0x2A2003E0u);                                      // mvn w0, w0
+        return;
+    }
+    put32(a, aluRegBase(op) | (1 << 16) | (0 << 5) | 0);            // op w0, w0, w1
+}
+
+void jitEmitShift(JitAsm& a, JitShift op, uint32_t sa) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    const uint32_t base = op == JitShift::Sll ? 0x1AC02000u : op == JitShift::Srl ? 0x1AC02400u : 0x1AC02800u;
+    put32(a, movzW(2, sa & 31, 0));                 // mov w2, #sa
+    put32(a, base | (2 << 16) | (0 << 5) | 0);      // lslv/lsrv/asrv w0, w0, w2
+}
+
+void jitEmitCmp(JitAsm& a, JitCmp cc) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    uint32_t inv = CC_NE;
+    switch (cc) {
+        case JitCmp::Eq:  inv = CC_NE; break;
+        case JitCmp::Ne:  inv = CC_EQ; break;
+        case JitCmp::Lt:  inv = CC_GE; break;
+        case JitCmp::Ltu: inv = CC_HS; break;
+    }
+    put32(a, 0x6B00001Fu | (1 << 16) | (0 << 5));   // cmp w0, w1
+    put32(a, 0x1A9F07E0u | (inv << 12));            // cset w0, cc
+}
+
+void jitEmitCall(JitAsm& a, const void* fn, const void* arg, uint32_t unrun, const JitStubs& s) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, movX(0, X19));                                      // mov x0, x19
+    put32(a, movX(1, X20));                                      // mov x1, x20
+    movImmX(a, 2, reinterpret_cast<uint64_t>(arg));              // mov x2, arg
+    movImmX(a, X16, reinterpret_cast<uint64_t>(fn));             // mov x16, fn
+    put32(a, 0xD63F0200u);                                       // blr x16
+    put32(a, 0x34000000u | (5 << 5) | 0);                        // cbz w0, ok
+    put32(a, ldrW(2, X21, 0));                                   // ldr w2, [x21]
+    put32(a, 0x11000000u | ((unrun & 0xFFF) << 10) | (2 << 5) | 2); // add w2, w2, #unrun
+    put32(a, strW(2, X21, 0));                                   // str w2, [x21]
+    put32(a, bRel(wordsTo(a, s.exitExc)));                       // b exitExc
+}
+
+uint8_t* jitEmitSkipIfByteZero(JitAsm& a, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    put32(a, ldrB(2, X19, off));       // ldrb w2, [x19, #off]
+    uint8_t* fixup = a.p;
+    put32(a, 0x34000000u | 2);         // cbz w2, <patched>
+    return fixup;
+}
+
+uint8_t* jitEmitSkipIfMasked(JitAsm& a, uint32_t mask) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    movImmW(a, 2, mask);               // mov w2, #mask
+    put32(a, 0x0A020002u);             // and w2, w0, w2
+    uint8_t* fixup = a.p;
+    put32(a, 0x35000000u | 2);         // cbnz w2, <patched>
+    return fixup;
+}
+
+void jitBind(JitAsm& a, uint8_t* fixup) {
+    if (a.full || !fixup) return;
+    uint32_t insn;
+    std::memcpy(&insn, fixup, 4);
+    const int32_t words = static_cast<int32_t>((a.p - fixup) / 4);
+    insn |= (static_cast<uint32_t>(words) & 0x7FFFF) << 5;
+    std::memcpy(fixup, &insn, 4);
+}
+
+void jitEmitExit(JitAsm& a, uint32_t pcOff, uint32_t nextOff, uint32_t target,
+                 void* const* cell, const JitStubs& s) {
+    jitEmitStoreImm(a, pcOff, target);
+    jitEmitStoreImm(a, nextOff, target + 4);
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, ldrW(2, X21, 0));                          // ldr w2, [x21]
+    put32(a, 0x7100005Fu);                              // cmp w2, #0
+    put32(a, bCond(CC_GT, 2));                          // b.gt +8
+    put32(a, bRel(wordsTo(a, s.exitOk)));               // b exitOk
+    movImmX(a, X16, reinterpret_cast<uint64_t>(cell));  // mov x16, cell
+    put32(a, ldrX(X16, X16, 0));                        // ldr x16, [x16]
+    put32(a, 0xB5000000u | (2 << 5) | X16);             // cbnz x16, +8
+    put32(a, bRel(wordsTo(a, s.exitOk)));               // b exitOk
+    put32(a, 0xD61F0200u);                              // br x16
+}
+
+void jitEmitExitDynamic(JitAsm& a, uint32_t srcOff, uint32_t pcOff, uint32_t nextOff,
+                        const JitStubs& s) {
+    jitEmitLoad(a, 0, srcOff);
+    jitEmitStore(a, 0, pcOff);
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, 0x11001000u);                              // add w0, w0, #4
+    put32(a, strW(0, X19, nextOff));                    // str w0, [x19, #next]
+    put32(a, bRel(wordsTo(a, s.exitOk)));               // b exitOk
+}
+
+void jitEmitJump(JitAsm& a, const uint8_t* target) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put32(a, bRel(wordsTo(a, target)));                 // b target
+}
+
+const uint8_t* jitEmitFastLoad(JitAsm& a, uint32_t bytes, bool sign) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    const uint8_t* at = a.p;
+    // ldr(s)b / ldr(s)h / ldr w0, [x22, w0, uxtw]
+    const uint32_t base = bytes == 1 ? (sign ? 0x38E04800u : 0x38604800u)
+                        : bytes == 2 ? (sign ? 0x78E04800u : 0x78604800u)
+                        :              0xB8604800u;
+    put32(a, base | (0 << 16) | (X22 << 5) | 0);
+    return at;
+}
+
+void jitPatchJump(uint8_t* at, const uint8_t* target) {
+    const uint32_t insn = bRel(static_cast<int32_t>((target - at) / 4));
+    std::memcpy(at, &insn, 4);
+    __builtin___clear_cache(reinterpret_cast<char*>(at), reinterpret_cast<char*>(at + 4));
+}
+
+uintptr_t* jitFaultPc(void* ucontext) {
+    return reinterpret_cast<uintptr_t*>(&static_cast<ucontext_t*>(ucontext)->uc_mcontext.pc);
+}
+
+void jitFlushICache(uint8_t* begin, uint8_t* end) {
+    __builtin___clear_cache(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end));
+}
+
+#endif // __aarch64__
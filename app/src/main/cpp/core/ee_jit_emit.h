@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Internal interface between the EE recompiler (ee_jit.cpp) and the host
+// backends (ee_jit_x64.cpp, ee_jit_a64.cpp). Only one backend is compiled in.
+//
+// Compiled code keeps the EERegs pointer, Mem pointer, instruction budget
+// pointer and fastmem base in callee-saved host registers; r0/r1 below are
+// scratch registers.
+
+// Host code buffer being filled by a backend
+struct JitAsm {
+    uint8_t* p;
+    uint8_t* end;
+    bool     full; // ran out of room, output is unusable
+};
+
+// Shared entry/exit stubs at the start of the code cache
+struct JitStubs {
+    const uint8_t* enter;   // uint32_t (*)(EERegs*, Mem*, int32_t* budget, const void* body, uint8_t* fastmem)
+    const uint8_t* exitOk;  // leave compiled code returning 0
+    const uint8_t* exitExc; // leave compiled code returning 1
+};
+
+enum class JitAlu   : uint8_t { Add, Or, Sub, And, Xor, Nor };
+enum class JitShift : uint8_t { Sll, Srl, Sra };
+enum class JitCmp   : uint8_t { Eq, Ne, Lt, Ltu };
+
+void     jitEmitStubs(JitAsm& a, JitStubs& s);
+
+// *budget -= ops
+void     jitEmitBudget(JitAsm& a, uint32_t ops);
+
+// rN <-> 32-bit field at EERegs + off
+void     jitEmitLoad(JitAsm& a, int r, uint32_t off);
+void     jitEmitLoadZero(JitAsm& a, int r);
+void     jitEmitStore(JitAsm& a, int r, uint32_t off);
+void     jitEmitStoreByte(JitAsm& a, int r, uint32_t off);
+// rN sign-extended into the 64-bit field at EERegs + off (8-byte aligned)
+void     jitEmitStoreSx(JitAsm& a, int r, uint32_t off);
+void     jitEmitStoreImm(JitAsm& a, uint32_t off, uint32_t imm);
+
+// r0 = r0 op imm / r0 = r0 op r1 / r0 = r0 shift sa / r0 = (r0 cc r1)
+void     jitEmitAluImm(JitAsm& a, JitAlu op, uint32_t imm);
+void     jitEmitAlu(JitAsm& a, JitAlu op);
+void     jitEmitShift(JitAsm& a, JitShift op, uint32_t sa);
+void     jitEmitCmp(JitAsm& a, JitCmp cc);
+
+// Call fn(ee, mem, arg); on a non-zero result give back `unrun` budget and
+// leave through exitExc.
+void     jitEmitCall(JitAsm& a, const void* fn, const void* arg, uint32_t unrun, const JitStubs& s);
+
+// Forward branch taken when the byte at EERegs + off is zero / when
+// r0 & mask is non-zero; bind with jitBind
+uint8_t* jitEmitSkipIfByteZero(JitAsm& a, uint32_t off);
+uint8_t* jitEmitSkipIfMasked(JitAsm& a, uint32_t mask);
+void     jitBind(JitAsm& a, uint8_t* fixup);
+void     jitEmitJump(JitAsm& a, const uint8_t* target);
+
+// r0 = 1/2/4-byte load from fastmem + r0, sign- or zero-extended to 32 bits.
+// Returns the access instruction, the one that faults on an MMIO page; it
+// is long enough for jitPatchJump to overwrite.
+const uint8_t* jitEmitFastLoad(JitAsm& a, uint32_t bytes, bool sign);
+void     jitPatchJump(uint8_t* at, const uint8_t* target);
+
+// Host PC slot in a signal handler's ucontext
+uintptr_t* jitFaultPc(void* ucontext);
+
+// Leave the block for a constant guest target: set pc/nextPc, then chain
+// through *cell when it is non-null and budget remains, else exitOk.
+void     jitEmitExit(JitAsm& a, uint32_t pcOff, uint32_t nextOff, uint32_t target,
+                     void* const* cell, const JitStubs& s);
+
+// Leave the block for the guest target held at EERegs + srcOff
+void     jitEmitExitDynamic(JitAsm& a, uint32_t srcOff, uint32_t pcOff, uint32_t nextOff,
+                            const JitStubs& s);
+
+void     jitFlushICache(uint8_t* begin, uint8_t* end);
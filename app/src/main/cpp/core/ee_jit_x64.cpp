@@ -0,0 +1,236 @@
+// x86-64 (System V) backend for the EE recompiler.
+// rbx = EERegs*, r12 = Mem*, r13 = int32_t* budget, r14 = fastmem base;
+// eax/ecx are r0/r1.
+#if defined(__x86_64__)
+#include "ee_jit_emit.h"
+#include <cstring>
+#include <ucontext.h>
+
+static inline bool jitRoom(JitAsm& a, size_t n) {
+    if (a.full || a.p + n > a.end) { a.full = true; return false; }
+    return true;
+}
+
+static inline void put8(JitAsm& a, uint8_t v) { *a.p++ = v; }
+static inline void put32(JitAsm& a, uint32_t v) { std::memcpy(a.p, &v, 4); a.p += 4; }
+static inline void put64(JitAsm& a, uint64_t v) { std::memcpy(a.p, &v, 8); a.p += 8; }
+
+static inline void rel32To(JitAsm& a, const uint8_t* target) {
+    put32(a, static_cast<uint32_t>(target - (a.p + 4)));
+}
+
+// Every emitter below writes at most this many bytes
+static constexpr size_t MAX_SEQ = 96;
+
+void jitEmitStubs(JitAsm& a, JitStubs& s) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+
+    s.enter = a.p;
+    put8(a, 0x53);                                // push rbx
+    put8(a, 0x41); put8(a, 0x54);                 // push r12
+    put8(a, 0x41); put8(a, 0x55);                 // push r13
+    put8(a, 0x41); put8(a, 0x56);                 // push r14
+    put8(a, 0x41); put8(a, 0x57);                 // push r15 (rsp now 16-aligned)
+    put8(a, 0x48); put8(a, 0x89); put8(a, 0xFB);  // mov rbx, rdi
+    put8(a, 0x49); put8(a, 0x89); put8(a, 0xF4);  // mov r12, rsi
+    put8(a, 0x49); put8(a, 0x89); put8(a, 0xD5);  // mov r13, rdx
+    put8(a, 0x4D); put8(a, 0x89); put8(a, 0xC6);  // mov r14, r8
+    put8(a, 0xFF); put8(a, 0xE1);                 // jmp rcx
+
+    s.exitExc = a.p;
+    put8(a, 0xB8); put32(a, 1);                   // mov eax, 1
+    put8(a, 0xEB); put8(a, 0x02);                 // jmp +2
+
+    s.exitOk = a.p;
+    put8(a, 0x31); put8(a, 0xC0);                 // xor eax, eax
+    put8(a, 0x41); put8(a, 0x5F);                 // pop r15
+    put8(a, 0x41); put8(a, 0x5E);                 // pop r14
+    put8(a, 0x41); put8(a, 0x5D);                 // pop r13
+    put8(a, 0x41); put8(a, 0x5C);                 // pop r12
+    put8(a, 0x5B);                                // pop rbx
+    put8(a, 0xC3);                                // ret
+}
+
+void jitEmitBudget(JitAsm& a, uint32_t ops) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x41); put8(a, 0x81); put8(a, 0x6D); put8(a, 0x00); put32(a, ops); // sub dword [r13], ops
+}
+
+void jitEmitLoad(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x8B); put8(a, 0x83 | (r << 3)); put32(a, off); // mov rN, [rbx+off]
+}
+
+void jitEmitLoadZero(JitAsm& a, int r) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x31); put8(a, 0xC0 | (r << 3) | r);            // xor rN, rN
+}
+
+void jitEmitStore(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x89); put8(a, 0x83 | (r << 3)); put32(a, off); // mov [rbx+off], rN
+}
+
+void jitEmitStoreSx(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x48); put8(a, 0x63); put8(a, 0xC0 | (r << 3) | r);         // movsxd rN, rN
+    put8(a, 0x48); put8(a, 0x89); put8(a, 0x83 | (r << 3)); put32(a, off); // mov [rbx+off], rN
+}
+
+void jitEmitStoreByte(JitAsm& a, int r, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x88); put8(a, 0x83 | (r << 3)); put32(a, off); // mov [rbx+off], rNb
+}
+
+void jitEmitStoreImm(JitAsm& a, uint32_t off, uint32_t imm) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0xC7); put8(a, 0x83); put32(a, off); put32(a, imm); // mov dword [rbx+off], imm
+}
+
+void jitEmitAluImm(JitAsm& a, JitAlu op, uint32_t imm) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    uint8_t ext = 0;
+    switch (op) {
+        case JitAlu::Add: ext = 0; break;
+        case JitAlu::Or:  ext = 1; break;
+        case JitAlu::And: ext = 4; break;
+        case JitAlu::Sub: ext = 5; break;
+        case JitAlu::Xor: ext = 6; break;
+        case JitAlu::Nor: // not reachable with an immediate on MIPS
+            a.full = true; return;
+    }
+    put8(a, 0x81); put8(a, 0xC0 | (ext << 3)); put32(a, imm);  // op eax, imm32
+}
+
+void jitEmitAlu(JitAsm& a, JitAlu op) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    switch (op) {
+        case JitAlu::Add: put8(a, 0x01); break;
+        case JitAlu::Or:  put8(a, 0x09); break;
+        case JitAlu::Sub: put8(a, 0x29); break;
+        case JitAlu::And: put8(a, 0x21); break;
+        case JitAlu::Xor: put8(a, 0x31); break;
+        case JitAlu::Nor: put8(a, 0x09); break;
+    }
+    put8(a, 0xC8);                                       // op eax, ecx
+    if (op == JitAlu::Nor) { put8(a, 0xF7); put8(a, 0xD0); } // not eax
+}
+
+void jitEmitShift(JitAsm& a, JitShift op, uint32_t sa) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    const uint8_t modrm = op == JitShift::Sll ? 0xE0 : op == JitShift::Srl ? 0xE8 : 0xF8;
+    put8(a, 0xC1); put8(a, modrm); put8(a, static_cast<uint8_t>(sa & 31));
+}
+
+void jitEmitCmp(JitAsm& a, JitCmp cc) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    uint8_t setcc = 0x94;
+    switch (cc) {
+        case JitCmp::Eq:  setcc = 0x94; break; // sete
+        case JitCmp::Ne:  setcc = 0x95; break; // setne
+        case JitCmp::Lt:  setcc = 0x9C; break; // setl
+        case JitCmp::Ltu: setcc = 0x92; break; // setb
+    }
+    put8(a, 0x39); put8(a, 0xC8);                 // cmp eax, ecx
+    put8(a, 0x0F); put8(a, setcc); put8(a, 0xC0); // setcc al
+    put8(a, 0x0F); put8(a, 0xB6); put8(a, 0xC0);  // movzx eax, al
+}
+
+void jitEmitCall(JitAsm& a, const void* fn, const void* arg, uint32_t unrun, const JitStubs& s) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x48); put8(a, 0x89); put8(a, 0xDF);                    // mov rdi, rbx
+    put8(a, 0x4C); put8(a, 0x89); put8(a, 0xE6);                    // mov rsi, r12
+    put8(a, 0x48); put8(a, 0xBA); put64(a, reinterpret_cast<uint64_t>(arg)); // mov rdx, arg
+    put8(a, 0x48); put8(a, 0xB8); put64(a, reinterpret_cast<uint64_t>(fn));  // mov rax, fn
+    put8(a, 0xFF); put8(a, 0xD0);                                   // call rax
+    put8(a, 0x85); put8(a, 0xC0);                                   // test eax, eax
+    put8(a, 0x74); put8(a, 13);                                     // jz ok
+    put8(a, 0x41); put8(a, 0x81); put8(a, 0x45); put8(a, 0x00); put32(a, unrun); // add [r13], unrun
+    put8(a, 0xE9); rel32To(a, s.exitExc);                           // jmp exitExc
+}
+
+uint8_t* jitEmitSkipIfByteZero(JitAsm& a, uint32_t off) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    put8(a, 0x80); put8(a, 0xBB); put32(a, off); put8(a, 0x00); // cmp byte [rbx+off], 0
+    put8(a, 0x0F); put8(a, 0x84);                               // je rel32
+    uint8_t* fixup = a.p;
+    put32(a, 0);
+    return fixup;
+}
+
+uint8_t* jitEmitSkipIfMasked(JitAsm& a, uint32_t mask) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    put8(a, 0xA9); put32(a, mask);                              // test eax, mask
+    put8(a, 0x0F); put8(a, 0x85);                               // jnz rel32
+    uint8_t* fixup = a.p;
+    put32(a, 0);
+    return fixup;
+}
+
+void jitBind(JitAsm& a, uint8_t* fixup) {
+    if (a.full || !fixup) return;
+    const uint32_t rel = static_cast<uint32_t>(a.p - (fixup + 4));
+    std::memcpy(fixup, &rel, 4);
+}
+
+void jitEmitJump(JitAsm& a, const uint8_t* target) {
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0xE9); rel32To(a, target);                          // jmp target
+}
+
+const uint8_t* jitEmitFastLoad(JitAsm& a, uint32_t bytes, bool sign) {
+    if (!jitRoom(a, MAX_SEQ)) return nullptr;
+    const uint8_t* at = a.p;
+    switch (bytes) {
+        case 1:  // movsx/movzx eax, byte [r14+rax]
+            put8(a, 0x41); put8(a, 0x0F); put8(a, sign ? 0xBE : 0xB6); put8(a, 0x04); put8(a, 0x06);
+            break;
+        case 2:  // movsx/movzx eax, word [r14+rax]
+            put8(a, 0x41); put8(a, 0x0F); put8(a, sign ? 0xBF : 0xB7); put8(a, 0x04); put8(a, 0x06);
+            break;
+        default: // mov eax, [r14+rax]; nop (room for a jmp rel32)
+            put8(a, 0x41); put8(a, 0x8B); put8(a, 0x04); put8(a, 0x06); put8(a, 0x90);
+            break;
+    }
+    return at;
+}
+
+void jitPatchJump(uint8_t* at, const uint8_t* target) {
+    const uint32_t rel = static_cast<uint32_t>(target - (at + 5));
+    at[0] = 0xE9;
+    std::memcpy(at + 1, &rel, 4);
+}
+
+uintptr_t* jitFaultPc(void* ucontext) {
+    return reinterpret_cast<uintptr_t*>(&static_cast<ucontext_t*>(ucontext)->uc_mcontext.gregs[REG_RIP]);
+}
+
+void jitEmitExit(JitAsm& a, uint32_t pcOff, uint32_t nextOff, uint32_t target,
+                 void* const* cell, const JitStubs& s) {
+    jitEmitStoreImm(a, pcOff, target);
+    jitEmitStoreImm(a, nextOff, target + 4);
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0x41); put8(a, 0x83); put8(a, 0x7D); put8(a, 0x00); put8(a, 0x00); // cmp dword [r13], 0
+    put8(a, 0x0F); put8(a, 0x8E); rel32To(a, s.exitOk);                       // jle exitOk
+    put8(a, 0x48); put8(a, 0xB8); put64(a, reinterpret_cast<uint64_t>(cell)); // mov rax, cell
+    put8(a, 0x48); put8(a, 0x8B); put8(a, 0x00);                              // mov rax, [rax]
+    put8(a, 0x48); put8(a, 0x85); put8(a, 0xC0);                              // test rax, rax
+    put8(a, 0x0F); put8(a, 0x84); rel32To(a, s.exitOk);                       // jz exitOk
+    put8(a, 0xFF); put8(a, 0xE0);                                             // jmp rax
+}
+
+void jitEmitExitDynamic(JitAsm& a, uint32_t srcOff, uint32_t pcOff, uint32_t nextOff,
+                        const JitStubs& s) {
+    jitEmitLoad(a, 0, srcOff);
+    jitEmitStore(a, 0, pcOff);
+    jitEmitAluImm(a, JitAlu::Add, 4);
+    jitEmitStore(a, 0, nextOff);
+    if (!jitRoom(a, MAX_SEQ)) return;
+    put8(a, 0xE9); rel32To(a, s.exitOk);                                      // jmp exitOk
+}
+
+void jitFlushICache(uint8_t*, uint8_t*) {
+    // x86 keeps instruction fetch coherent with data writes
+}
+
+#endif // __x86_64__
@@ -0,0 +1,951 @@
+#include "ee_cpu.h"
+#include "ee_optable.h"
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// EE_MMI_SCALAR builds only the scalar reference, whatever the host
+#if defined(__SSE2__) && !defined(EE_MMI_SCALAR)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__aarch64__) && !defined(EE_MMI_SCALAR)
+#include <arm_neon.h>
+#endif
+
+// MMI (multimedia) instructions. Lane-parallel operations are written once
+// per backend: MmiRef is the scalar reference, MmiSse/MmiNeon the vector
+// kernels. Multiply/divide, HI/LO moves and bit-field ops are shared scalar
+// code. eeMmiVerify runs every slot through both paths.
+
+static constexpr uint64_t SX32(uint32_t v) { return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))); }
+
+// -----------------------------------------------------------------------------
+// Scalar reference
+// -----------------------------------------------------------------------------
+
+template <typename T> static inline T*       lane(EEGpr& r);
+template <> inline uint8_t*  lane<uint8_t>(EEGpr& r)  { return r.UC; }
+template <> inline int8_t*   lane<int8_t>(EEGpr& r)   { return r.SC; }
+template <> inline uint16_t* lane<uint16_t>(EEGpr& r) { return r.US; }
+template <> inline int16_t*  lane<int16_t>(EEGpr& r)  { return r.SS; }
+template <> inline uint32_t* lane<uint32_t>(EEGpr& r) { return r.UL; }
+template <> inline int32_t*  lane<int32_t>(EEGpr& r)  { return r.SL; }
+
+template <typename T>
+static inline const T* lane(const EEGpr& r) { return lane<T>(const_cast<EEGpr&>(r)); }
+
+template <typename T>
+static inline T sat(int64_t v) {
+    if (v < std::numeric_limits<T>::min()) return std::numeric_limits<T>::min();
+    if (v > std::numeric_limits<T>::max()) return std::numeric_limits<T>::max();
+    return static_cast<T>(v);
+}
+
+// r[i] = f(a[i], b[i]) over lanes of type T
+template <typename T, typename F>
+static inline EEGpr lanes(const EEGpr& a, const EEGpr& b, F f) {
+    EEGpr r;
+    for (size_t i = 0; i < 16 / sizeof(T); ++i) lane<T>(r)[i] = static_cast<T>(f(lane<T>(a)[i], lane<T>(b)[i]));
+    return r;
+}
+
+// PPACx: even lanes of b, then even lanes of a
+template <typename T>
+static inline EEGpr pack(const EEGpr& a, const EEGpr& b) {
+    EEGpr r;
+    const size_t n = 16 / sizeof(T);
+    for (size_t i = 0; i < n / 2; ++i) {
+        lane<T>(r)[i]         = lane<T>(b)[i * 2];
+        lane<T>(r)[i + n / 2] = lane<T>(a)[i * 2];
+    }
+    return r;
+}
+
+// PEXTx: lanes of b and a alternately, starting at lane 'first'
+template <typename T>
+static inline EEGpr interleave(const EEGpr& a, const EEGpr& b, size_t first) {
+    EEGpr r;
+    for (size_t i = 0; i < 8 / sizeof(T); ++i) {
+        lane<T>(r)[i * 2]     = lane<T>(b)[first + i];
+        lane<T>(r)[i * 2 + 1] = lane<T>(a)[first + i];
+    }
+    return r;
+}
+
+// r[i] = src[idx[i]] within each 64-bit half (halfwords) or the quadword (words)
+static inline EEGpr permute16(const EEGpr& b, const int (&idx)[4]) {
+    EEGpr r;
+    for (int i = 0; i < 4; ++i) { r.US[i] = b.US[idx[i]]; r.US[i + 4] = b.US[idx[i] + 4]; }
+    return r;
+}
+static inline EEGpr permute32(const EEGpr& b, const int (&idx)[4]) {
+    EEGpr r;
+    for (int i = 0; i < 4; ++i) r.UL[i] = b.UL[idx[i]];
+    return r;
+}
+
+struct MmiRef {
+    using V = EEGpr;
+    static V load(const EEGpr& r) { return r; }
+    static void store(EEGpr& r, V v) { r = v; }
+
+    template <typename T> static T cgt(T x, T y) { return x > y ? static_cast<T>(~0) : 0; }
+    template <typename T> static T ceq(T x, T y) { return x == y ? static_cast<T>(~0) : 0; }
+    template <typename T> static T adds(T x, T y) { return sat<T>(static_cast<int64_t>(x) + y); }
+    template <typename T> static T subs(T x, T y) { return sat<T>(static_cast<int64_t>(x) - y); }
+    template <typename T> static T abss(T, T y) { return sat<T>(y < 0 ? -static_cast<int64_t>(y) : y); }
+
+    static V paddw(V a, V b)  { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x + y; }); }
+    static V psubw(V a, V b)  { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x - y; }); }
+    static V pcgtw(V a, V b)  { return lanes<int32_t>(a, b, cgt<int32_t>); }
+    static V pmaxw(V a, V b)  { return lanes<int32_t>(a, b, [](int32_t x, int32_t y) { return x > y ? x : y; }); }
+    static V paddh(V a, V b)  { return lanes<uint16_t>(a, b, [](uint16_t x, uint16_t y) { return x + y; }); }
+    static V psubh(V a, V b)  { return lanes<uint16_t>(a, b, [](uint16_t x, uint16_t y) { return x - y; }); }
+    static V pcgth(V a, V b)  { return lanes<int16_t>(a, b, cgt<int16_t>); }
+    static V pmaxh(V a, V b)  { return lanes<int16_t>(a, b, [](int16_t x, int16_t y) { return x > y ? x : y; }); }
+    static V paddb(V a, V b)  { return lanes<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return x + y; }); }
+    static V psubb(V a, V b)  { return lanes<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return x - y; }); }
+    static V pcgtb(V a, V b)  { return lanes<int8_t>(a, b, cgt<int8_t>); }
+    static V paddsw(V a, V b) { return lanes<int32_t>(a, b, adds<int32_t>); }
+    static V psubsw(V a, V b) { return lanes<int32_t>(a, b, subs<int32_t>); }
+    static V pextlw(V a, V b) { return interleave<uint32_t>(a, b, 0); }
+    static V ppacw(V a, V b)  { return pack<uint32_t>(a, b); }
+    static V paddsh(V a, V b) { return lanes<int16_t>(a, b, adds<int16_t>); }
+    static V psubsh(V a, V b) { return lanes<int16_t>(a, b, subs<int16_t>); }
+    static V pextlh(V a, V b) { return interleave<uint16_t>(a, b, 0); }
+    static V ppach(V a, V b)  { return pack<uint16_t>(a, b); }
+    static V paddsb(V a, V b) { return lanes<int8_t>(a, b, adds<int8_t>); }
+    static V psubsb(V a, V b) { return lanes<int8_t>(a, b, subs<int8_t>); }
+    static V pextlb(V a, V b) { return interleave<uint8_t>(a, b, 0); }
+    static V ppacb(V a, V b)  { return pack<uint8_t>(a, b); }
+
+    static V pabsw(V a, V b)  { return lanes<int32_t>(a, b, abss<int32_t>); }
+    static V pceqw(V a, V b)  { return lanes<uint32_t>(a, b, ceq<uint32_t>); }
+    static V pminw(V a, V b)  { return lanes<int32_t>(a, b, [](int32_t x, int32_t y) { return x < y ? x : y; }); }
+    static V padsbh(V a, V b) {
+        V r = lanes<uint16_t>(a, b, [](uint16_t x, uint16_t y) { return x + y; });
+        for (int i = 0; i < 4; ++i) r.US[i] = static_cast<uint16_t>(a.US[i] - b.US[i]);
+        return r;
+    }
+    static V pabsh(V a, V b)  { return lanes<int16_t>(a, b, abss<int16_t>); }
+    static V pceqh(V a, V b)  { return lanes<uint16_t>(a, b, ceq<uint16_t>); }
+    static V pminh(V a, V b)  { return lanes<int16_t>(a, b, [](int16_t x, int16_t y) { return x < y ? x : y; }); }
+    static V pceqb(V a, V b)  { return lanes<uint8_t>(a, b, ceq<uint8_t>); }
+    static V padduw(V a, V b) { return lanes<uint32_t>(a, b, adds<uint32_t>); }
+    static V psubuw(V a, V b) { return lanes<uint32_t>(a, b, subs<uint32_t>); }
+    static V pextuw(V a, V b) { return interleave<uint32_t>(a, b, 2); }
+    static V padduh(V a, V b) { return lanes<uint16_t>(a, b, adds<uint16_t>); }
+    static V psubuh(V a, V b) { return lanes<uint16_t>(a, b, subs<uint16_t>); }
+    static V pextuh(V a, V b) { return interleave<uint16_t>(a, b, 4); }
+    static V paddub(V a, V b) { return lanes<uint8_t>(a, b, adds<uint8_t>); }
+    static V psubub(V a, V b) { return lanes<uint8_t>(a, b, subs<uint8_t>); }
+    static V pextub(V a, V b) { return interleave<uint8_t>(a, b, 8); }
+
+    static V pand(V a, V b)   { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+    static V por(V a, V b)    { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+    static V pxor(V a, V b)   { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x ^ y; }); }
+    static V pnor(V a, V b)   { return lanes<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return ~(x | y); }); }
+    static V pinth(V a, V b) {
+        V hi = a;
+        hi.UD[0] = a.UD[1];
+        return interleave<uint16_t>(hi, b, 0);
+    }
+    static V pinteh(V a, V b) {
+        V r;
+        for (int i = 0; i < 4; ++i) r.UL[i] = (b.UL[i] & 0xFFFFu) | (a.UL[i] << 16);
+        return r;
+    }
+    static V pcpyld(V a, V b) { V r; r.UD[0] = b.UD[0]; r.UD[1] = a.UD[0]; return r; }
+    static V pcpyud(V a, V b) { V r; r.UD[0] = a.UD[1]; r.UD[1] = b.UD[1]; return r; }
+    static V pcpyh(V, V b)    { return permute16(b, {0, 0, 0, 0}); }
+    static V pexeh(V, V b)    { return permute16(b, {2, 1, 0, 3}); }
+    static V prevh(V, V b)    { return permute16(b, {3, 2, 1, 0}); }
+    static V pexch(V, V b)    { return permute16(b, {0, 2, 1, 3}); }
+    static V pexew(V, V b)    { return permute32(b, {2, 1, 0, 3}); }
+    static V prot3w(V, V b)   { return permute32(b, {1, 2, 0, 3}); }
+    static V pexcw(V, V b)    { return permute32(b, {0, 2, 1, 3}); }
+
+    static V psllh(V b, uint32_t s) { return lanes<uint16_t>(b, b, [s](uint16_t x, uint16_t) { return x << (s & 15); }); }
+    static V psrlh(V b, uint32_t s) { return lanes<uint16_t>(b, b, [s](uint16_t x, uint16_t) { return x >> (s & 15); }); }
+    static V psrah(V b, uint32_t s) { return lanes<int16_t>(b, b, [s](int16_t x, int16_t) { return x >> (s & 15); }); }
+    static V psllw(V b, uint32_t s) { return lanes<uint32_t>(b, b, [s](uint32_t x, uint32_t) { return x << (s & 31); }); }
+    static V psrlw(V b, uint32_t s) { return lanes<uint32_t>(b, b, [s](uint32_t x, uint32_t) { return x >> (s & 31); }); }
+    static V psraw(V b, uint32_t s) { return lanes<int32_t>(b, b, [s](int32_t x, int32_t) { return x >> (s & 31); }); }
+
+    // Halfword multiplies. p[i] = a.SS[i] * b.SS[i]; LO takes p0,p1,p4,p5 and
+    // HI p2,p3,p6,p7. Sub/Acc select PMSUBH/PMADDH over PMULTH.
+    template <bool Acc, bool Sub>
+    static V pmulth(V a, V b, V& lo, V& hi) {
+        static constexpr int dst[8] = {0, 1, 4, 5, 2, 3, 6, 7}; // LO.UL[0..3] then HI.UL[0..3]
+        V r;
+        for (int i = 0; i < 8; ++i) {
+            const uint32_t p = static_cast<uint32_t>(a.SS[i] * b.SS[i]);
+            uint32_t& acc = dst[i] < 4 ? lo.UL[dst[i]] : hi.UL[dst[i] - 4];
+            acc = !Acc ? p : Sub ? acc - p : acc + p;
+            if (!(i & 1)) r.UL[i / 2] = acc;
+        }
+        return r;
+    }
+    static V pmulth(V a, V b, V& lo, V& hi) { return pmulth<false, false>(a, b, lo, hi); }
+    static V pmaddh(V a, V b, V& lo, V& hi) { return pmulth<true, false>(a, b, lo, hi); }
+    static V pmsubh(V a, V b, V& lo, V& hi) { return pmulth<true, true>(a, b, lo, hi); }
+
+    // Horizontal pairs: rd/LO/HI get the pair sums (PHMADH) or odd-minus-even
+    // differences (PHMSBH); the odd word of each LO/HI pair keeps the odd
+    // product (inverted for PHMSBH)
+    template <bool Sub>
+    static V phmadh(V a, V b, V& lo, V& hi) {
+        V r;
+        for (int i = 0; i < 4; ++i) {
+            const uint32_t p0 = static_cast<uint32_t>(a.SS[i * 2] * b.SS[i * 2]);
+            const uint32_t p1 = static_cast<uint32_t>(a.SS[i * 2 + 1] * b.SS[i * 2 + 1]);
+            r.UL[i] = Sub ? p1 - p0 : p1 + p0;
+            V& dst = (i & 1) ? hi : lo;
+            dst.UL[(i & 2)]     = r.UL[i];
+            dst.UL[(i & 2) + 1] = Sub ? ~p1 : p1;
+        }
+        return r;
+    }
+    static V phmadh(V a, V b, V& lo, V& hi) { return phmadh<false>(a, b, lo, hi); }
+    static V phmsbh(V a, V b, V& lo, V& hi) { return phmadh<true>(a, b, lo, hi); }
+};
+
+// -----------------------------------------------------------------------------
+// SSE2 (SSE4.1 where available)
+// -----------------------------------------------------------------------------
+
+#if defined(__SSE2__) && !defined(EE_MMI_SCALAR)
+struct MmiSse {
+    using V = __m128i;
+    static V load(const EEGpr& r) { return _mm_load_si128(reinterpret_cast<const __m128i*>(&r)); }
+    static void store(EEGpr& r, V v) { _mm_store_si128(reinterpret_cast<__m128i*>(&r), v); }
+
+    static V ones() { return _mm_set1_epi32(-1); }
+    static V select(V m, V x, V y) { return _mm_or_si128(_mm_and_si128(m, x), _mm_andnot_si128(m, y)); }
+    template <int Imm>
+    static V shufps(V a, V b) { return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), Imm)); }
+
+    static V paddw(V a, V b)  { return _mm_add_epi32(a, b); }
+    static V psubw(V a, V b)  { return _mm_sub_epi32(a, b); }
+    static V pcgtw(V a, V b)  { return _mm_cmpgt_epi32(a, b); }
+#if defined(__SSE4_1__)
+    static V pmaxw(V a, V b)  { return _mm_max_epi32(a, b); }
+    static V pminw(V a, V b)  { return _mm_min_epi32(a, b); }
+#else
+    static V pmaxw(V a, V b)  { return select(_mm_cmpgt_epi32(a, b), a, b); }
+    static V pminw(V a, V b)  { return select(_mm_cmpgt_epi32(a, b), b, a); }
+#endif
+    static V paddh(V a, V b)  { return _mm_add_epi16(a, b); }
+    static V psubh(V a, V b)  { return _mm_sub_epi16(a, b); }
+    static V pcgth(V a, V b)  { return _mm_cmpgt_epi16(a, b); }
+    static V pmaxh(V a, V b)  { return _mm_max_epi16(a, b); }
+    static V paddb(V a, V b)  { return _mm_add_epi8(a, b); }
+    static V psubb(V a, V b)  { return _mm_sub_epi8(a, b); }
+    static V pcgtb(V a, V b)  { return _mm_cmpgt_epi8(a, b); }
+
+    // Signed 32-bit saturation: on overflow the result takes the sign of a
+    static V paddsw(V a, V b) {
+        const V r = _mm_add_epi32(a, b);
+        const V ovf = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, r), _mm_xor_si128(b, r)), 31);
+        const V limit = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7FFFFFFF));
+        return select(ovf, limit, r);
+    }
+    static V psubsw(V a, V b) {
+        const V r = _mm_sub_epi32(a, b);
+        const V ovf = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, r)), 31);
+        const V limit = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7FFFFFFF));
+        return select(ovf, limit, r);
+    }
+    static V pextlw(V a, V b) { return _mm_unpacklo_epi32(b, a); }
+    static V ppacw(V a, V b)  { return shufps<_MM_SHUFFLE(2, 0, 2, 0)>(b, a); }
+    static V paddsh(V a, V b) { return _mm_adds_epi16(a, b); }
+    static V psubsh(V a, V b) { return _mm_subs_epi16(a, b); }
+    static V pextlh(V a, V b) { return _mm_unpacklo_epi16(b, a); }
+    static V ppach(V a, V b) {
+        // Sign-extend the even halfwords so the saturating pack is exact
+        return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(b, 16), 16),
+                               _mm_srai_epi32(_mm_slli_epi32(a, 16), 16));
+    }
+    static V paddsb(V a, V b) { return _mm_adds_epi8(a, b); }
+    static V psubsb(V a, V b) { return _mm_subs_epi8(a, b); }
+    static V pextlb(V a, V b) { return _mm_unpacklo_epi8(b, a); }
+    static V ppacb(V a, V b) {
+        const V m = _mm_set1_epi16(0x00FF);
+        return _mm_packus_epi16(_mm_and_si128(b, m), _mm_and_si128(a, m));
+    }
+
+    static V pabsw(V, V b) {
+        // |x| via (x ^ s) - s, then 0x80000000 (still negative) drops to 0x7FFFFFFF
+        const V s = _mm_srai_epi32(b, 31);
+        const V r = _mm_sub_epi32(_mm_xor_si128(b, s), s);
+        return _mm_add_epi32(r, _mm_srai_epi32(r, 31));
+    }
+    static V pceqw(V a, V b)  { return _mm_cmpeq_epi32(a, b); }
+    static V padsbh(V a, V b) {
+        return _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(_mm_add_epi16(a, b)),
+                                            _mm_castsi128_pd(_mm_sub_epi16(a, b))));
+    }
+    static V pabsh(V, V b)    { return _mm_max_epi16(b, _mm_subs_epi16(_mm_setzero_si128(), b)); }
+    static V pceqh(V a, V b)  { return _mm_cmpeq_epi16(a, b); }
+    static V pminh(V a, V b)  { return _mm_min_epi16(a, b); }
+    static V pceqb(V a, V b)  { return _mm_cmpeq_epi8(a, b); }
+
+    // Unsigned 32-bit saturation through biased signed compares
+    static V padduw(V a, V b) {
+        const V bias = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+        const V r = _mm_add_epi32(a, b);
+        return _mm_or_si128(r, _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(r, bias)));
+    }
+    static V psubuw(V a, V b) {
+        const V bias = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+        const V borrow = _mm_cmpgt_epi32(_mm_xor_si128(b, bias), _mm_xor_si128(a, bias));
+        return _mm_andnot_si128(borrow, _mm_sub_epi32(a, b));
+    }
+    static V pextuw(V a, V b) { return _mm_unpackhi_epi32(b, a); }
+    static V padduh(V a, V b) { return _mm_adds_epu16(a, b); }
+    static V psubuh(V a, V b) { return _mm_subs_epu16(a, b); }
+    static V pextuh(V a, V b) { return _mm_unpackhi_epi16(b, a); }
+    static V paddub(V a, V b) { return _mm_adds_epu8(a, b); }
+    static V psubub(V a, V b) { return _mm_subs_epu8(a, b); }
+    static V pextub(V a, V b) { return _mm_unpackhi_epi8(b, a); }
+
+    static V pand(V a, V b)   { return _mm_and_si128(a, b); }
+    static V por(V a, V b)    { return _mm_or_si128(a, b); }
+    static V pxor(V a, V b)   { return _mm_xor_si128(a, b); }
+    static V pnor(V a, V b)   { return _mm_xor_si128(_mm_or_si128(a, b), ones()); }
+    static V pinth(V a, V b)  { return _mm_unpacklo_epi16(b, _mm_srli_si128(a, 8)); }
+    static V pinteh(V a, V b) { return _mm_or_si128(_mm_and_si128(b, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(a, 16)); }
+    static V pcpyld(V a, V b) { return _mm_unpacklo_epi64(b, a); }
+    static V pcpyud(V a, V b) { return _mm_unpackhi_epi64(a, b); }
+    static V pcpyh(V, V b)    { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0x00), 0x00); }
+    static V pexeh(V, V b)    { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0xC6), 0xC6); }
+    static V prevh(V, V b)    { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0x1B), 0x1B); }
+    static V pexch(V, V b)    { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0xD8), 0xD8); }
+    static V pexew(V, V b)    { return _mm_shuffle_epi32(b, 0xC6); }
+    static V prot3w(V, V b)   { return _mm_shuffle_epi32(b, 0xC9); }
+    static V pexcw(V, V b)    { return _mm_shuffle_epi32(b, 0xD8); }
+
+    static V psllh(V b, uint32_t s) { return _mm_sll_epi16(b, _mm_cvtsi32_si128(s & 15)); }
+    static V psrlh(V b, uint32_t s) { return _mm_srl_epi16(b, _mm_cvtsi32_si128(s & 15)); }
+    static V psrah(V b, uint32_t s) { return _mm_sra_epi16(b, _mm_cvtsi32_si128(s & 15)); }
+    static V psllw(V b, uint32_t s) { return _mm_sll_epi32(b, _mm_cvtsi32_si128(s & 31)); }
+    static V psrlw(V b, uint32_t s) { return _mm_srl_epi32(b, _mm_cvtsi32_si128(s & 31)); }
+    static V psraw(V b, uint32_t s) { return _mm_sra_epi32(b, _mm_cvtsi32_si128(s & 31)); }
+
+    // 32-bit products of the halfwords: pl = p0..p3, ph = p4..p7
+    static void mul16(V a, V b, V& pl, V& ph) {
+        const V lo = _mm_mullo_epi16(a, b), hi = _mm_mulhi_epi16(a, b);
+        pl = _mm_unpacklo_epi16(lo, hi);
+        ph = _mm_unpackhi_epi16(lo, hi);
+    }
+    template <bool Acc, bool Sub>
+    static V pmulth(V a, V b, V& lo, V& hi) {
+        V pl, ph;
+        mul16(a, b, pl, ph);
+        const V l = _mm_unpacklo_epi64(pl, ph), h = _mm_unpackhi_epi64(pl, ph);
+        lo = !Acc ? l : Sub ? _mm_sub_epi32(lo, l) : _mm_add_epi32(lo, l);
+        hi = !Acc ? h : Sub ? _mm_sub_epi32(hi, h) : _mm_add_epi32(hi, h);
+        // rd = LO.UL[0], HI.UL[0], LO.UL[2], HI.UL[2]
+        return _mm_unpacklo_epi32(shufps<_MM_SHUFFLE(2, 0, 2, 0)>(lo, lo), shufps<_MM_SHUFFLE(2, 0, 2, 0)>(hi, hi));
+    }
+    static V pmulth(V a, V b, V& lo, V& hi) { return pmulth<false, false>(a, b, lo, hi); }
+    static V pmaddh(V a, V b, V& lo, V& hi) { return pmulth<true, false>(a, b, lo, hi); }
+    static V pmsubh(V a, V b, V& lo, V& hi) { return pmulth<true, true>(a, b, lo, hi); }
+
+    template <bool Sub>
+    static V phmadh(V a, V b, V& lo, V& hi) {
+        V pl, ph;
+        mul16(a, b, pl, ph);
+        const V even = shufps<_MM_SHUFFLE(2, 0, 2, 0)>(pl, ph);
+        V odd = shufps<_MM_SHUFFLE(3, 1, 3, 1)>(pl, ph);
+        const V r = Sub ? _mm_sub_epi32(odd, even) : _mm_madd_epi16(a, b);
+        if (Sub) odd = _mm_xor_si128(odd, ones());
+        const V t0 = _mm_unpacklo_epi32(r, odd), t1 = _mm_unpackhi_epi32(r, odd);
+        lo = _mm_unpacklo_epi64(t0, t1);
+        hi = _mm_unpackhi_epi64(t0, t1);
+        return r;
+    }
+    static V phmadh(V a, V b, V& lo, V& hi) { return phmadh<false>(a, b, lo, hi); }
+    static V phmsbh(V a, V b, V& lo, V& hi) { return phmadh<true>(a, b, lo, hi); }
+};
+using MmiHost = MmiSse;
+
+// -----------------------------------------------------------------------------
+// AArch64 NEON
+// -----------------------------------------------------------------------------
+
+#elif defined(__aarch64__) && !defined(EE_MMI_SCALAR)
+struct MmiNeon {
+    using V = uint32x4_t;
+    static V load(const EEGpr& r) { return vld1q_u32(r.UL); }
+    static void store(EEGpr& r, V v) { vst1q_u32(r.UL, v); }
+
+    static int32x4_t s32(V v) { return vreinterpretq_s32_u32(v); }
+    static int16x8_t s16(V v) { return vreinterpretq_s16_u32(v); }
+    static uint16x8_t u16(V v) { return vreinterpretq_u16_u32(v); }
+    static int8x16_t s8(V v) { return vreinterpretq_s8_u32(v); }
+    static uint8x16_t u8(V v) { return vreinterpretq_u8_u32(v); }
+    static uint64x2_t u64(V v) { return vreinterpretq_u64_u32(v); }
+    static V v(int32x4_t x) { return vreinterpretq_u32_s32(x); }
+    static V v(int16x8_t x) { return vreinterpretq_u32_s16(x); }
+    static V v(uint16x8_t x) { return vreinterpretq_u32_u16(x); }
+    static V v(int8x16_t x) { return vreinterpretq_u32_s8(x); }
+    static V v(uint8x16_t x) { return vreinterpretq_u32_u8(x); }
+    static V v(uint64x2_t x) { return vreinterpretq_u32_u64(x); }
+
+    // Byte permutation of b by a constant index table
+    static V tbl(V b, const uint8_t (&idx)[16]) { return v(vqtbl1q_u8(u8(b), vld1q_u8(idx))); }
+
+    static V paddw(V a, V b)  { return vaddq_u32(a, b); }
+    static V psubw(V a, V b)  { return vsubq_u32(a, b); }
+    static V pcgtw(V a, V b)  { return vcgtq_s32(s32(a), s32(b)); }
+    static V pmaxw(V a, V b)  { return v(vmaxq_s32(s32(a), s32(b))); }
+    static V pminw(V a, V b)  { return v(vminq_s32(s32(a), s32(b))); }
+    static V paddh(V a, V b)  { return v(vaddq_u16(u16(a), u16(b))); }
+    static V psubh(V a, V b)  { return v(vsubq_u16(u16(a), u16(b))); }
+    static V pcgth(V a, V b)  { return v(vcgtq_s16(s16(a), s16(b))); }
+    static V pmaxh(V a, V b)  { return v(vmaxq_s16(s16(a), s16(b))); }
+    static V paddb(V a, V b)  { return v(vaddq_u8(u8(a), u8(b))); }
+    static V psubb(V a, V b)  { return v(vsubq_u8(u8(a), u8(b))); }
+    static V pcgtb(V a, V b)  { return v(vcgtq_s8(s8(a), s8(b))); }
+    static V paddsw(V a, V b) { return v(vqaddq_s32(s32(a), s32(b))); }
+    static V psubsw(V a, V b) { return v(vqsubq_s32(s32(a), s32(b))); }
+    static V pextlw(V a, V b) { return vzip1q_u32(b, a); }
+    static V ppacw(V a, V b)  { return vuzp1q_u32(b, a); }
+    static V paddsh(V a, V b) { return v(vqaddq_s16(s16(a), s16(b))); }
+    static V psubsh(V a, V b) { return v(vqsubq_s16(s16(a), s16(b))); }
+    static V pextlh(V a, V b) { return v(vzip1q_u16(u16(b), u16(a))); }
+    static V ppach(V a, V b)  { return v(vuzp1q_u16(u16(b), u16(a))); }
+    static V paddsb(V a, V b) { return v(vqaddq_s8(s8(a), s8(b))); }
+    static V psubsb(V a, V b) { return v(vqsubq_s8(s8(a), s8(b))); }
+    static V pextlb(V a, V b) { return v(vzip1q_u8(u8(b), u8(a))); }
+    static V ppacb(V a, V b)  { return v(vuzp1q_u8(u8(b), u8(a))); }
+
+    static V pabsw(V, V b)    { return v(vqabsq_s32(s32(b))); }
+    static V pceqw(V a, V b)  { return vceqq_u32(a, b); }
+    static V padsbh(V a, V b) {
+        return v(vcombine_u16(vget_low_u16(vsubq_u16(u16(a), u16(b))), vget_high_u16(vaddq_u16(u16(a), u16(b)))));
+    }
+    static V pabsh(V, V b)    { return v(vqabsq_s16(s16(b))); }
+    static V pceqh(V a, V b)  { return v(vceqq_u16(u16(a), u16(b))); }
+    static V pminh(V a, V b)  { return v(vminq_s16(s16(a), s16(b))); }
+    static V pceqb(V a, V b)  { return v(vceqq_u8(u8(a), u8(b))); }
+    static V padduw(V a, V b) { return vqaddq_u32(a, b); }
+    static V psubuw(V a, V b) { return vqsubq_u32(a, b); }
+    static V pextuw(V a, V b) { return vzip2q_u32(b, a); }
+    static V padduh(V a, V b) { return v(vqaddq_u16(u16(a), u16(b))); }
+    static V psubuh(V a, V b) { return v(vqsubq_u16(u16(a), u16(b))); }
+    static V pextuh(V a, V b) { return v(vzip2q_u16(u16(b), u16(a))); }
+    static V paddub(V a, V b) { return v(vqaddq_u8(u8(a), u8(b))); }
+    static V psubub(V a, V b) { return v(vqsubq_u8(u8(a), u8(b))); }
+    static V pextub(V a, V b) { return v(vzip2q_u8(u8(b), u8(a))); }
+
+    static V pand(V a, V b)   { return vandq_u32(a, b); }
+    static V por(V a, V b)    { return vorrq_u32(a, b); }
+    static V pxor(V a, V b)   { return veorq_u32(a, b); }
+    static V pnor(V a, V b)   { return vmvnq_u32(vorrq_u32(a, b)); }
+    static V pinth(V a, V b)  { return v(vzip1q_u16(u16(b), vextq_u16(u16(a), u16(a), 4))); }
+    static V pinteh(V a, V b) { return v(vtrn1q_u16(u16(b), u16(a))); }
+    static V pcpyld(V a, V b) { return v(vcombine_u64(vget_low_u64(u64(b)), vget_low_u64(u64(a)))); }
+    static V pcpyud(V a, V b) { return v(vcombine_u64(vget_high_u64(u64(a)), vget_high_u64(u64(b)))); }
+    static V pcpyh(V, V b) {
+        return v(vcombine_u16(vdup_lane_u16(vget_low_u16(u16(b)), 0), vdup_lane_u16(vget_high_u16(u16(b)), 0)));
+    }
+    static V pexeh(V, V b) {
+        static const uint8_t idx[16] = {4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15};
+        return tbl(b, idx);
+    }
+    static V prevh(V, V b)    { return v(vrev64q_u16(u16(b))); }
+    static V pexch(V, V b) {
+        static const uint8_t idx[16] = {0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15};
+        return tbl(b, idx);
+    }
+    static V pexew(V, V b) {
+        static const uint8_t idx[16] = {8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15};
+        return tbl(b, idx);
+    }
+    static V prot3w(V, V b) {
+        static const uint8_t idx[16] = {4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 12, 13, 14, 15};
+        return tbl(b, idx);
+    }
+    static V pexcw(V, V b) {
+        static const uint8_t idx[16] = {0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15};
+        return tbl(b, idx);
+    }
+
+    // Register shifts: negative counts shift right
+    static V psllh(V b, uint32_t s) { return v(vshlq_u16(u16(b), vdupq_n_s16(static_cast<int16_t>(s & 15)))); }
+    static V psrlh(V b, uint32_t s) { return v(vshlq_u16(u16(b), vdupq_n_s16(-static_cast<int16_t>(s & 15)))); }
+    static V psrah(V b, uint32_t s) { return v(vshlq_s16(s16(b), vdupq_n_s16(-static_cast<int16_t>(s & 15)))); }
+    static V psllw(V b, uint32_t s) { return vshlq_u32(b, vdupq_n_s32(static_cast<int32_t>(s & 31))); }
+    static V psrlw(V b, uint32_t s) { return vshlq_u32(b, vdupq_n_s32(-static_cast<int32_t>(s & 31))); }
+    static V psraw(V b, uint32_t s) { return v(vshlq_s32(s32(b), vdupq_n_s32(-static_cast<int32_t>(s & 31)))); }
+
+    // 32-bit products of the halfwords: pl = p0..p3, ph = p4..p7
+    static void mul16(V a, V b, V& pl, V& ph) {
+        pl = v(vmull_s16(vget_low_s16(s16(a)), vget_low_s16(s16(b))));
+        ph = v(vmull_high_s16(s16(a), s16(b)));
+    }
+    template <bool Acc, bool Sub>
+    static V pmulth(V a, V b, V& lo, V& hi) {
+        V pl, ph;
+        mul16(a, b, pl, ph);
+        const V l = v(vcombine_u64(vget_low_u64(u64(pl)), vget_low_u64(u64(ph))));
+        const V h = v(vcombine_u64(vget_high_u64(u64(pl)), vget_high_u64(u64(ph))));
+        lo = !Acc ? l : Sub ? vsubq_u32(lo, l) : vaddq_u32(lo, l);
+        hi = !Acc ? h : Sub ? vsubq_u32(hi, h) : vaddq_u32(hi, h);
+        // rd = LO.UL[0], HI.UL[0], LO.UL[2], HI.UL[2]
+        return vtrn1q_u32(lo, hi);
+    }
+    static V pmulth(V a, V b, V& lo, V& hi) { return pmulth<false, false>(a, b, lo, hi); }
+    static V pmaddh(V a, V b, V& lo, V& hi) { return pmulth<true, false>(a, b, lo, hi); }
+    static V pmsubh(V a, V b, V& lo, V& hi) { return pmulth<true, true>(a, b, lo, hi); }
+
+    template <bool Sub>
+    static V phmadh(V a, V b, V& lo, V& hi) {
+        V pl, ph;
+        mul16(a, b, pl, ph);
+        const V even = vuzp1q_u32(pl, ph);
+        V odd = vuzp2q_u32(pl, ph);
+        const V r = Sub ? vsubq_u32(odd, even) : vaddq_u32(odd, even);
+        if (Sub) odd = vmvnq_u32(odd);
+        lo = vtrn1q_u32(r, odd);
+        hi = vtrn2q_u32(r, odd);
+        return r;
+    }
+    static V phmadh(V a, V b, V& lo, V& hi) { return phmadh<false>(a, b, lo, hi); }
+    static V phmsbh(V a, V b, V& lo, V& hi) { return phmadh<true>(a, b, lo, hi); }
+};
+using MmiHost = MmiNeon;
+
+#else
+// 32-bit ARM, other hosts and EE_MMI_SCALAR builds run the scalar reference
+using MmiHost = MmiRef;
+#endif
+
+// -----------------------------------------------------------------------------
+// Handlers
+// -----------------------------------------------------------------------------
+
+// rd = F(rs, rt)
+template <class B, typename B::V (*F)(typename B::V, typename B::V)>
+static ExecResult opPV(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (d.rd) B::store(ee.GPR[d.rd], F(B::load(ee.GPR[d.rs]), B::load(ee.GPR[d.rt])));
+    return ExecResult::Ok;
+}
+
+// rd = F(rt, sa)
+template <class B, typename B::V (*F)(typename B::V, uint32_t)>
+static ExecResult opPS(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (d.rd) B::store(ee.GPR[d.rd], F(B::load(ee.GPR[d.rt]), d.sa));
+    return ExecResult::Ok;
+}
+
+// rd = F(rs, rt, LO, HI), updating LO/HI
+template <class B, typename B::V (*F)(typename B::V, typename B::V, typename B::V&, typename B::V&)>
+static ExecResult opPH(EERegs& ee, Mem&, const DecodedOp& d) {
+    typename B::V lo = B::load(ee.LO), hi = B::load(ee.HI);
+    const typename B::V r = F(B::load(ee.GPR[d.rs]), B::load(ee.GPR[d.rt]), lo, hi);
+    B::store(ee.LO, lo);
+    B::store(ee.HI, hi);
+    if (d.rd) B::store(ee.GPR[d.rd], r);
+    return ExecResult::Ok;
+}
+
+// Pipeline 1 multiply/divide (MULT1, DIV1, ...) and multiply-add on either
+// pipeline. P selects the doubleword of HI/LO.
+template <int P, bool Signed, bool Acc>
+static ExecResult opMult(EERegs& ee, Mem&, const DecodedOp& d) {
+    const uint32_t a = eeGetReg(ee, d.rs), b = eeGetReg(ee, d.rt);
+    uint64_t p = Signed
+        ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(a)) * static_cast<int32_t>(b))
+        : static_cast<uint64_t>(a) * b;
+    if (Acc) p += static_cast<uint64_t>(ee.HI.UL[P * 2]) << 32 | ee.LO.UL[P * 2];
+    ee.LO.UD[P] = SX32(static_cast<uint32_t>(p));
+    ee.HI.UD[P] = SX32(static_cast<uint32_t>(p >> 32));
+    eeSetReg64(ee, d.rd, ee.LO.UD[P]);
+    return ExecResult::Ok;
+}
+
+template <bool Signed>
+static ExecResult opDiv1(EERegs& ee, Mem&, const DecodedOp& d) {
+    uint32_t lo, hi;
+    eeDivide<Signed>(eeGetReg(ee, d.rs), eeGetReg(ee, d.rt), lo, hi);
+    ee.LO.UD[1] = SX32(lo);
+    ee.HI.UD[1] = SX32(hi);
+    return ExecResult::Ok;
+}
+
+static ExecResult opMFHI1(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rd, ee.HI.UD[1]); return ExecResult::Ok; }
+static ExecResult opMFLO1(EERegs& ee, Mem&, const DecodedOp& d) { eeSetReg64(ee, d.rd, ee.LO.UD[1]); return ExecResult::Ok; }
+static ExecResult opMTHI1(EERegs& ee, Mem&, const DecodedOp& d) { ee.HI.UD[1] = eeGetReg64(ee, d.rs); return ExecResult::Ok; }
+static ExecResult opMTLO1(EERegs& ee, Mem&, const DecodedOp& d) { ee.LO.UD[1] = eeGetReg64(ee, d.rs); return ExecResult::Ok; }
+
+// Whole-quadword HI/LO moves
+static ExecResult opPMFHI(EERegs& ee, Mem&, const DecodedOp& d) { if (d.rd) ee.GPR[d.rd] = ee.HI; return ExecResult::Ok; }
+static ExecResult opPMFLO(EERegs& ee, Mem&, const DecodedOp& d) { if (d.rd) ee.GPR[d.rd] = ee.LO; return ExecResult::Ok; }
+static ExecResult opPMTHI(EERegs& ee, Mem&, const DecodedOp& d) { ee.HI = ee.GPR[d.rs]; return ExecResult::Ok; }
+static ExecResult opPMTLO(EERegs& ee, Mem&, const DecodedOp& d) { ee.LO = ee.GPR[d.rs]; return ExecResult::Ok; }
+
+// Leading sign bits minus one, for the two low words
+static ExecResult opPLZCW(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (!d.rd) return ExecResult::Ok;
+    for (int i = 0; i < 2; ++i) {
+        uint32_t x = ee.GPR[d.rs].UL[i];
+        if (x & 0x80000000u) x = ~x;
+        ee.GPR[d.rd].UL[i] = (x ? static_cast<uint32_t>(__builtin_clz(x)) : 32u) - 1;
+    }
+    return ExecResult::Ok;
+}
+
+// HI/LO to rd in the format selected by sa
+static ExecResult opPMFHL(EERegs& ee, Mem&, const DecodedOp& d) {
+    const EEGpr& lo = ee.LO;
+    const EEGpr& hi = ee.HI;
+    EEGpr r;
+    switch (d.sa) {
+        case 0: // LW
+            r.UL[0] = lo.UL[0]; r.UL[1] = hi.UL[0]; r.UL[2] = lo.UL[2]; r.UL[3] = hi.UL[2];
+            break;
+        case 1: // UW
+            r.UL[0] = lo.UL[1]; r.UL[1] = hi.UL[1]; r.UL[2] = lo.UL[3]; r.UL[3] = hi.UL[3];
+            break;
+        case 2: // SLW: {HI,LO} words as 64-bit values saturated to 32 bits
+            for (int i = 0; i < 2; ++i) {
+                const int64_t v = static_cast<int64_t>(static_cast<uint64_t>(hi.UL[i * 2]) << 32 | lo.UL[i * 2]);
+                r.SD[i] = sat<int32_t>(v);
+            }
+            break;
+        case 3: // LH
+            for (int i = 0; i < 2; ++i) {
+                r.US[i * 4 + 0] = lo.US[i * 4 + 0]; r.US[i * 4 + 1] = lo.US[i * 4 + 2];
+                r.US[i * 4 + 2] = hi.US[i * 4 + 0]; r.US[i * 4 + 3] = hi.US[i * 4 + 2];
+            }
+            break;
+        case 4: // SH
+            for (int i = 0; i < 2; ++i) {
+                r.SS[i * 4 + 0] = sat<int16_t>(lo.SL[i * 2]);     r.SS[i * 4 + 1] = sat<int16_t>(lo.SL[i * 2 + 1]);
+                r.SS[i * 4 + 2] = sat<int16_t>(hi.SL[i * 2]);     r.SS[i * 4 + 3] = sat<int16_t>(hi.SL[i * 2 + 1]);
+            }
+            break;
+        default:
+            return eeRaiseException(ee, EEExc::Reserved);
+    }
+    if (d.rd) ee.GPR[d.rd] = r;
+    return ExecResult::Ok;
+}
+
+static ExecResult opPMTHL(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (d.sa != 0) return eeRaiseException(ee, EEExc::Reserved);
+    const EEGpr s = ee.GPR[d.rs];
+    ee.LO.UL[0] = s.UL[0]; ee.HI.UL[0] = s.UL[1];
+    ee.LO.UL[2] = s.UL[2]; ee.HI.UL[2] = s.UL[3];
+    return ExecResult::Ok;
+}
+
+// Word multiplies on lanes 0 and 2: rd gets the 64-bit products, LO/HI their halves
+template <bool Signed, int Acc> // Acc: 0 none, 1 add, -1 subtract
+static ExecResult opPMultW(EERegs& ee, Mem&, const DecodedOp& d) {
+    const EEGpr a = ee.GPR[d.rs], b = ee.GPR[d.rt];
+    for (int i = 0; i < 2; ++i) {
+        uint64_t p = Signed
+            ? static_cast<uint64_t>(static_cast<int64_t>(a.SL[i * 2]) * b.SL[i * 2])
+            : static_cast<uint64_t>(a.UL[i * 2]) * b.UL[i * 2];
+        const uint64_t acc = static_cast<uint64_t>(ee.HI.UL[i * 2]) << 32 | ee.LO.UL[i * 2];
+        if (Acc > 0) p = acc + p;
+        if (Acc < 0) p = acc - p;
+        ee.LO.UD[i] = SX32(static_cast<uint32_t>(p));
+        ee.HI.UD[i] = SX32(static_cast<uint32_t>(p >> 32));
+        if (d.rd) ee.GPR[d.rd].UD[i] = p;
+    }
+    return ExecResult::Ok;
+}
+
+template <bool Signed>
+static ExecResult opPDivW(EERegs& ee, Mem&, const DecodedOp& d) {
+    const EEGpr a = ee.GPR[d.rs], b = ee.GPR[d.rt];
+    for (int i = 0; i < 2; ++i) {
+        uint32_t lo, hi;
+        eeDivide<Signed>(a.UL[i * 2], b.UL[i * 2], lo, hi);
+        ee.LO.UD[i] = SX32(lo);
+        ee.HI.UD[i] = SX32(hi);
+    }
+    return ExecResult::Ok;
+}
+
+// Four words of rs by the low halfword of rt; remainders are halfwords
+static ExecResult opPDIVBW(EERegs& ee, Mem&, const DecodedOp& d) {
+    const EEGpr a = ee.GPR[d.rs];
+    const uint32_t div = static_cast<uint32_t>(static_cast<int32_t>(ee.GPR[d.rt].SS[0]));
+    for (int i = 0; i < 4; ++i) {
+        uint32_t lo, hi;
+        eeDivide<true>(a.UL[i], div, lo, hi);
+        ee.LO.UL[i] = lo;
+        ee.HI.SL[i] = static_cast<int16_t>(hi);
+    }
+    return ExecResult::Ok;
+}
+
+// Variable word shifts on lanes 0 and 2, sign-extended to doublewords
+template <uint64_t (*F)(uint32_t, uint32_t)>
+static ExecResult opPShiftVW(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (!d.rd) return ExecResult::Ok;
+    const EEGpr a = ee.GPR[d.rs], b = ee.GPR[d.rt];
+    for (int i = 0; i < 2; ++i) ee.GPR[d.rd].UD[i] = SX32(static_cast<uint32_t>(F(b.UL[i * 2], a.UL[i * 2] & 31)));
+    return ExecResult::Ok;
+}
+static uint64_t shlW(uint32_t x, uint32_t s) { return x << s; }
+static uint64_t shrW(uint32_t x, uint32_t s) { return x >> s; }
+static uint64_t sarW(uint32_t x, uint32_t s) { return static_cast<uint32_t>(static_cast<int32_t>(x) >> s); }
+
+// RGBA5551 <-> RGBA8888 per word
+static ExecResult opPEXT5(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (!d.rd) return ExecResult::Ok;
+    const EEGpr b = ee.GPR[d.rt];
+    for (int i = 0; i < 4; ++i) {
+        const uint32_t x = b.UL[i];
+        ee.GPR[d.rd].UL[i] = ((x & 0x001Fu) << 3) | ((x & 0x03E0u) << 6) | ((x & 0x7C00u) << 9) | ((x & 0x8000u) << 16);
+    }
+    return ExecResult::Ok;
+}
+static ExecResult opPPAC5(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (!d.rd) return ExecResult::Ok;
+    const EEGpr b = ee.GPR[d.rt];
+    for (int i = 0; i < 4; ++i) {
+        const uint32_t x = b.UL[i];
+        ee.GPR[d.rd].UL[i] = ((x >> 3) & 0x001Fu) | ((x >> 6) & 0x03E0u) | ((x >> 9) & 0x7C00u) | ((x >> 16) & 0x8000u);
+    }
+    return ExecResult::Ok;
+}
+
+// Funnel shift of rs:rt right by SA bytes
+static ExecResult opQFSRV(EERegs& ee, Mem&, const DecodedOp& d) {
+    if (!d.rd) return ExecResult::Ok;
+    uint8_t both[32];
+    std::memcpy(both, ee.GPR[d.rt].UC, 16);
+    std::memcpy(both + 16, ee.GPR[d.rs].UC, 16);
+    std::memcpy(ee.GPR[d.rd].UC, both + (ee.SA & 15), 16);
+    return ExecResult::Ok;
+}
+
+// -----------------------------------------------------------------------------
+// Tables, one set per backend
+// -----------------------------------------------------------------------------
+
+// MMI by funct
+template <class B>
+static constexpr EEOpTable<64> eeMakeMmi() {
+    EEOpTableBuilder<64> b;
+    b.op(0x00, opMult<0, true,  true>, "MADD");
+    b.op(0x01, opMult<0, false, true>, "MADDU");
+    b.op(0x04, opPLZCW, "PLZCW");
+    b.name(0x08, "MMI0");     b.name(0x09, "MMI2");
+    b.op(0x10, opMFHI1, "MFHI1");
+    b.op(0x11, opMTHI1, "MTHI1");
+    b.op(0x12, opMFLO1, "MFLO1");
+    b.op(0x13, opMTLO1, "MTLO1");
+    b.op(0x18, opMult<1, true,  false>, "MULT1");
+    b.op(0x19, opMult<1, false, false>, "MULTU1");
+    b.op(0x1A, opDiv1<true>,  "DIV1");
+    b.op(0x1B, opDiv1<false>, "DIVU1");
+    b.op(0x20, opMult<1, true,  true>, "MADD1");
+    b.op(0x21, opMult<1, false, true>, "MADDU1");
+    b.name(0x28, "MMI1");     b.name(0x29, "MMI3");
+    b.op(0x30, opPMFHL, "PMFHL");
+    b.op(0x31, opPMTHL, "PMTHL");
+    b.op(0x34, opPS<B, B::psllh>, "PSLLH");
+    b.op(0x36, opPS<B, B::psrlh>, "PSRLH");
+    b.op(0x37, opPS<B, B::psrah>, "PSRAH");
+    b.op(0x3C, opPS<B, B::psllw>, "PSLLW");
+    b.op(0x3E, opPS<B, B::psrlw>, "PSRLW");
+    b.op(0x3F, opPS<B, B::psraw>, "PSRAW");
+    return b.t;
+}
+
+// MMI0 by sa
+template <class B>
+static constexpr EEOpTable<32> eeMakeMmi0() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opPV<B, B::paddw>,  "PADDW");
+    b.op(0x01, opPV<B, B::psubw>,  "PSUBW");
+    b.op(0x02, opPV<B, B::pcgtw>,  "PCGTW");
+    b.op(0x03, opPV<B, B::pmaxw>,  "PMAXW");
+    b.op(0x04, opPV<B, B::paddh>,  "PADDH");
+    b.op(0x05, opPV<B, B::psubh>,  "PSUBH");
+    b.op(0x06, opPV<B, B::pcgth>,  "PCGTH");
+    b.op(0x07, opPV<B, B::pmaxh>,  "PMAXH");
+    b.op(0x08, opPV<B, B::paddb>,  "PADDB");
+    b.op(0x09, opPV<B, B::psubb>,  "PSUBB");
+    b.op(0x0A, opPV<B, B::pcgtb>,  "PCGTB");
+    b.op(0x10, opPV<B, B::paddsw>, "PADDSW");
+    b.op(0x11, opPV<B, B::psubsw>, "PSUBSW");
+    b.op(0x12, opPV<B, B::pextlw>, "PEXTLW");
+    b.op(0x13, opPV<B, B::ppacw>,  "PPACW");
+    b.op(0x14, opPV<B, B::paddsh>, "PADDSH");
+    b.op(0x15, opPV<B, B::psubsh>, "PSUBSH");
+    b.op(0x16, opPV<B, B::pextlh>, "PEXTLH");
+    b.op(0x17, opPV<B, B::ppach>,  "PPACH");
+    b.op(0x18, opPV<B, B::paddsb>, "PADDSB");
+    b.op(0x19, opPV<B, B::psubsb>, "PSUBSB");
+    b.op(0x1A, opPV<B, B::pextlb>, "PEXTLB");
+    b.op(0x1B, opPV<B, B::ppacb>,  "PPACB");
+    b.op(0x1E, opPEXT5, "PEXT5");
+    b.op(0x1F, opPPAC5, "PPAC5");
+    return b.t;
+}
+
+// MMI1 by sa
+template <class B>
+static constexpr EEOpTable<32> eeMakeMmi1() {
+    EEOpTableBuilder<32> b;
+    b.op(0x01, opPV<B, B::pabsw>,  "PABSW");
+    b.op(0x02, opPV<B, B::pceqw>,  "PCEQW");
+    b.op(0x03, opPV<B, B::pminw>,  "PMINW");
+    b.op(0x04, opPV<B, B::padsbh>, "PADSBH");
+    b.op(0x05, opPV<B, B::pabsh>,  "PABSH");
+    b.op(0x06, opPV<B, B::pceqh>,  "PCEQH");
+    b.op(0x07, opPV<B, B::pminh>,  "PMINH");
+    b.op(0x0A, opPV<B, B::pceqb>,  "PCEQB");
+    b.op(0x10, opPV<B, B::padduw>, "PADDUW");
+    b.op(0x11, opPV<B, B::psubuw>, "PSUBUW");
+    b.op(0x12, opPV<B, B::pextuw>, "PEXTUW");
+    b.op(0x14, opPV<B, B::padduh>, "PADDUH");
+    b.op(0x15, opPV<B, B::psubuh>, "PSUBUH");
+    b.op(0x16, opPV<B, B::pextuh>, "PEXTUH");
+    b.op(0x18, opPV<B, B::paddub>, "PADDUB");
+    b.op(0x19, opPV<B, B::psubub>, "PSUBUB");
+    b.op(0x1A, opPV<B, B::pextub>, "PEXTUB");
+    b.op(0x1B, opQFSRV, "QFSRV");
+    return b.t;
+}
+
+// MMI2 by sa
+template <class B>
+static constexpr EEOpTable<32> eeMakeMmi2() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opPMultW<true, 1>, "PMADDW");
+    b.op(0x02, opPShiftVW<shlW>, "PSLLVW");
+    b.op(0x03, opPShiftVW<shrW>, "PSRLVW");
+    b.op(0x04, opPMultW<true, -1>, "PMSUBW");
+    b.op(0x08, opPMFHI, "PMFHI");
+    b.op(0x09, opPMFLO, "PMFLO");
+    b.op(0x0A, opPV<B, B::pinth>,  "PINTH");
+    b.op(0x0C, opPMultW<true, 0>, "PMULTW");
+    b.op(0x0D, opPDivW<true>, "PDIVW");
+    b.op(0x0E, opPV<B, B::pcpyld>, "PCPYLD");
+    b.op(0x10, opPH<B, B::pmaddh>, "PMADDH");
+    b.op(0x11, opPH<B, B::phmadh>, "PHMADH");
+    b.op(0x12, opPV<B, B::pand>,   "PAND");
+    b.op(0x13, opPV<B, B::pxor>,   "PXOR");
+    b.op(0x14, opPH<B, B::pmsubh>, "PMSUBH");
+    b.op(0x15, opPH<B, B::phmsbh>, "PHMSBH");
+    b.op(0x1A, opPV<B, B::pexeh>,  "PEXEH");
+    b.op(0x1B, opPV<B, B::prevh>,  "PREVH");
+    b.op(0x1C, opPH<B, B::pmulth>, "PMULTH");
+    b.op(0x1D, opPDIVBW, "PDIVBW");
+    b.op(0x1E, opPV<B, B::pexew>,  "PEXEW");
+    b.op(0x1F, opPV<B, B::prot3w>, "PROT3W");
+    return b.t;
+}
+
+// MMI3 by sa
+template <class B>
+static constexpr EEOpTable<32> eeMakeMmi3() {
+    EEOpTableBuilder<32> b;
+    b.op(0x00, opPMultW<false, 1>, "PMADDUW");
+    b.op(0x03, opPShiftVW<sarW>, "PSRAVW");
+    b.op(0x08, opPMTHI, "PMTHI");
+    b.op(0x09, opPMTLO, "PMTLO");
+    b.op(0x0A, opPV<B, B::pinteh>, "PINTEH");
+    b.op(0x0C, opPMultW<false, 0>, "PMULTUW");
+    b.op(0x0D, opPDivW<false>, "PDIVUW");
+    b.op(0x0E, opPV<B, B::pcpyud>, "PCPYUD");
+    b.op(0x12, opPV<B, B::por>,    "POR");
+    b.op(0x13, opPV<B, B::pnor>,   "PNOR");
+    b.op(0x1A, opPV<B, B::pexch>,  "PEXCH");
+    b.op(0x1B, opPV<B, B::pcpyh>,  "PCPYH");
+    b.op(0x1E, opPV<B, B::pexcw>,  "PEXCW");
+    return b.t;
+}
+
+template <class B>
+struct EEMmiTables {
+    static constexpr EEOpTable<64> mmi  = eeMakeMmi<B>();
+    static constexpr EEOpTable<32> mmi0 = eeMakeMmi0<B>();
+    static constexpr EEOpTable<32> mmi1 = eeMakeMmi1<B>();
+    static constexpr EEOpTable<32> mmi2 = eeMakeMmi2<B>();
+    static constexpr EEOpTable<32> mmi3 = eeMakeMmi3<B>();
+};
+
+template <class B>
+static const EEOpEntry& eeMmiEntryT(const DecodedOp& d, uint32_t& key) {
+    using T = EEMmiTables<B>;
+    switch (d.func) {
+        case 0x08: key = TBL_MMI0 << 8 | d.sa; return T::mmi0[d.sa];
+        case 0x28: key = TBL_MMI1 << 8 | d.sa; return T::mmi1[d.sa];
+        case 0x09: key = TBL_MMI2 << 8 | d.sa; return T::mmi2[d.sa];
+        case 0x29: key = TBL_MMI3 << 8 | d.sa; return T::mmi3[d.sa];
+        default:   key = TBL_MMI << 8 | d.func; return T::mmi[d.func];
+    }
+}
+
+const EEOpEntry& eeMmiEntry(const DecodedOp& d, uint32_t& key, bool reference) {
+    return reference ? eeMmiEntryT<MmiRef>(d, key) : eeMmiEntryT<MmiHost>(d, key);
+}
+
+// -----------------------------------------------------------------------------
+// Host vs reference check
+// -----------------------------------------------------------------------------
+
+static inline uint64_t mmiRand(uint64_t& s) {
+    s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+    return s;
+}
+
+// Operands biased towards lane boundaries so saturation and sign paths run
+static inline void mmiRandReg(EEGpr& r, uint64_t& s) {
+    static constexpr uint32_t edges[] = {0, 1, 0x7FFF, 0x8000, 0xFFFF, 0x7FFFFFFF, 0x80000000u, 0xFFFFFFFFu};
+    for (uint32_t& w : r.UL) {
+        const uint64_t x = mmiRand(s);
+        w = (x & 3) == 0 ? edges[(x >> 2) & 7] : static_cast<uint32_t>(x >> 32);
+    }
+}
+
+uint32_t eeMmiVerify(uint32_t iterations, uint64_t seed) {
+    uint64_t s = seed | 1;
+    uint32_t mismatches = 0;
+    Mem mem{};
+    for (uint32_t it = 0; it < iterations; ++it) {
+        for (uint32_t func = 0; func < 64; ++func) {
+            for (uint32_t sa = 0; sa < 32; ++sa) {
+                const bool sub = func == 0x08 || func == 0x09 || func == 0x28 || func == 0x29;
+                if (!sub && sa > 4 && func != 0x34 && func != 0x36 && func != 0x37 &&
+                    func != 0x3C && func != 0x3E && func != 0x3F) continue;
+
+                const DecodedOp d = decode(0x1Cu << 26 | 1u << 21 | 2u << 16 | 3u << 11 | sa << 6 | func);
+                uint32_t key;
+                const EEOpHandler host = eeMmiEntry(d, key, false).fn;
+                const EEOpHandler ref  = eeMmiEntry(d, key, true).fn;
+                if (host == ref) continue;
+
+                EERegs a;
+                eeInit(a, 0);
+                for (int r = 1; r < 4; ++r) mmiRandReg(a.GPR[r], s);
+                mmiRandReg(a.HI, s);
+                mmiRandReg(a.LO, s);
+                EERegs b = a;
+
+                host(a, mem, d);
+                ref(b, mem, d);
+                if (std::memcmp(&a.GPR[3], &b.GPR[3], sizeof(EEGpr)) != 0 ||
+                    std::memcmp(&a.HI, &b.HI, sizeof(EEGpr)) != 0 ||
+                    std::memcmp(&a.LO, &b.LO, sizeof(EEGpr)) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
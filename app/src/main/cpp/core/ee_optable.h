@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include "ee_cpu.h"
+
+// Internal: opcode table layout shared by ee_cpu.cpp and ee_mmi.cpp.
+// Keys are table id << 8 | slot (see eeOpKey).
+
+enum EEOpTableId : uint32_t {
+    TBL_PRIMARY, TBL_SPECIAL, TBL_REGIMM, TBL_COP0, TBL_COP0_CO, TBL_MMI, TBL_COP1, TBL_COP2,
+    TBL_MMI0, TBL_MMI1, TBL_MMI2, TBL_MMI3, TBL_COP1_S, TBL_COP1_W, TBL_COP2_MACRO,
+    TBL_COUNT
+};
+
+struct EEOpEntry {
+    EEOpHandler fn;
+    const char* name;
+};
+
+// Counted slow path for named instructions without a handler
+ExecResult eeOpUnimplemented(EERegs& ee, Mem& mem, const DecodedOp& d);
+// Reserved-instruction exception for unassigned encodings
+ExecResult eeOpReserved(EERegs& ee, Mem& mem, const DecodedOp& d);
+
+template <size_t N>
+using EEOpTable = std::array<EEOpEntry, N>;
+
+// Slots start reserved; name() marks an instruction the core does not handle yet
+template <size_t N>
+struct EEOpTableBuilder {
+    EEOpTable<N> t{};
+    constexpr EEOpTableBuilder() { for (auto& e : t) e = EEOpEntry{eeOpReserved, nullptr}; }
+    constexpr void op(size_t i, EEOpHandler fn, const char* name) { t[i] = EEOpEntry{fn, name}; }
+    constexpr void name(size_t i, const char* name) { t[i] = EEOpEntry{eeOpUnimplemented, name}; }
+};
+
+// DIV/DIVU results. Division by zero does not trap; results follow the hardware.
+template <bool Signed>
+inline void eeDivide(uint32_t a, uint32_t b, uint32_t& lo, uint32_t& hi) {
+    if (Signed) {
+        const int32_t sa = static_cast<int32_t>(a), sb = static_cast<int32_t>(b);
+        if (sb == 0) {
+            lo = sa < 0 ? 1u : 0xFFFFFFFFu;
+            hi = a;
+        } else if (a == 0x80000000u && sb == -1) {
+            lo = 0x80000000u;
+            hi = 0;
+        } else {
+            lo = static_cast<uint32_t>(sa / sb);
+            hi = static_cast<uint32_t>(sa % sb);
+        }
+    } else if (b == 0) {
+        lo = 0xFFFFFFFFu;
+        hi = a;
+    } else {
+        lo = a / b;
+        hi = a % b;
+    }
+}
+
+// MMI (opcode 0x1C) entry and key for an instruction. reference selects the
+// scalar implementation of the SIMD kernels instead of the host one.
+const EEOpEntry& eeMmiEntry(const DecodedOp& d, uint32_t& key, bool reference);
+
+// COP1 (opcode 0x11) entry and key, with arithmetic in the given mode
+const EEOpEntry& eeFpuEntry(const DecodedOp& d, uint32_t& key, EEFpuMode mode);
+
+// COP2 (opcode 0x12) entry and key; rs >= 0x10 selects VU0 macro ops
+const EEOpEntry& eeCop2Entry(const DecodedOp& d, uint32_t& key);
+
+// LQC2/SQC2 (primary opcodes 0x36/0x3E)
+ExecResult eeOpLQC2(EERegs& ee, Mem& mem, const DecodedOp& d);
+ExecResult eeOpSQC2(EERegs& ee, Mem& mem, const DecodedOp& d);
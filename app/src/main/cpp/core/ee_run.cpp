@@ -0,0 +1,42 @@
+#include "ee_run.h"
+#include "ee_jit.h"
+
+template <class P>
+static ExecResult eeRunT(EEJit& jit, EERegs& ee, Mem& mem, EERunHooks& hooks,
+                         int32_t budget, uint32_t& executed) {
+    if constexpr (!P::hooked) {
+        (void)hooks;
+        return eeJitRun(jit, ee, mem, budget, executed);
+    } else {
+        int32_t left = budget;
+        ee.budget = &left;
+        ee.budgetStart = budget;
+        ExecResult r = ExecResult::Ok;
+        while (left > 0) {
+            EEBlock* b = eeBlockLookup(*jit.cache, ee, mem);
+            if (!b) { r = ExecResult::Exception; break; }
+            // Charge the whole block up front, as compiled code does
+            const int32_t len = static_cast<int32_t>(b->ops.size());
+            ee.blockEnd = b->endPc;
+            left -= len;
+            uint32_t n = 0;
+            r = eeExecBlockT<P>(ee, mem, *b, &hooks, n);
+            left += len - static_cast<int32_t>(n);
+            if (r != ExecResult::Ok) break;
+            if (eeBlockSpun(*b, ee, mem)) { r = ExecResult::Idle; break; }
+        }
+        ee.budget = nullptr;
+        executed = static_cast<uint32_t>(budget - left);
+        return r;
+    }
+}
+
+EERunFn eeSelectRun(bool trace, bool cycleAccurate, bool breakpoints) {
+    static constexpr EERunFn table[8] = {
+        eeRunT<RunPolicy<false, false, false>>, eeRunT<RunPolicy<true, false, false>>,
+        eeRunT<RunPolicy<false, true,  false>>, eeRunT<RunPolicy<true, true,  false>>,
+        eeRunT<RunPolicy<false, false, true>>,  eeRunT<RunPolicy<true, false, true>>,
+        eeRunT<RunPolicy<false, true,  true>>,  eeRunT<RunPolicy<true, true,  true>>,
+    };
+    return table[(trace ? 1 : 0) | (cycleAccurate ? 2 : 0) | (breakpoints ? 4 : 0)];
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <unordered_set>
+#include "ee_block.h"
+
+struct EEJit;
+
+// Compile-time switches for the EE run loop. Every combination is its own
+// instantiation, so hooks that are off cost nothing per instruction.
+template <bool Trace, bool CycleAccurate, bool Breakpoints>
+struct RunPolicy {
+    static constexpr bool trace         = Trace;         // record each executed instruction
+    static constexpr bool cycleAccurate = CycleAccurate; // report time after each instruction
+    static constexpr bool breakpoints   = Breakpoints;   // stop before listed PCs
+    static constexpr bool hooked        = Trace || CycleAccurate || Breakpoints;
+};
+
+using EERunFast = RunPolicy<false, false, false>;
+
+static constexpr uint32_t EE_TRACE_SIZE = 256; // power of two
+
+struct EETraceEntry {
+    uint32_t pc;
+    uint32_t raw;
+};
+
+// State behind the optional hooks; only touched by policies that enable them
+struct EERunHooks {
+    // Trace: ring of the most recent instructions, oldest overwritten
+    EETraceEntry trace[EE_TRACE_SIZE] = {};
+    uint64_t     traced = 0;
+
+    // Breakpoints: the loop stops with ee.pc on the listed address. The
+    // next run steps over it once so execution can resume.
+    std::unordered_set<uint32_t> breakpoints;
+    uint32_t stepOver = 0;
+    bool     stepOverArmed = false;
+
+    // CycleAccurate: called after every instruction with its cycle cost
+    void (*onCycles)(void* user, uint32_t cycles) = nullptr;
+    void* onCyclesUser = nullptr;
+};
+
+// Interpret one whole block under policy P. hooks may be null for EERunFast.
+// Breakpoints are checked on block bodies, not on branch delay slots.
+template <class P>
+ExecResult eeExecBlockT(EERegs& ee, Mem& mem, EEBlock& blk, EERunHooks* hooks, uint32_t& executed) {
+    // Counted in a local and stored on each return: the handlers are opaque
+    // calls, so a count kept behind the reference would be reloaded and
+    // stored around every one of them
+    uint32_t n = 0;
+    const EEBlock* b = &blk;
+    blk.hits++;
+
+    ee.branchTaken = false;
+
+    auto before = [&](const EEBlockOp& op) {
+        if constexpr (P::trace) {
+            hooks->trace[hooks->traced++ & (EE_TRACE_SIZE - 1)] = EETraceEntry{ee.pc, op.d.raw};
+        }
+    };
+    auto after = [&]() {
+        ++n;
+        if constexpr (P::cycleAccurate) {
+            if (hooks->onCycles) hooks->onCycles(hooks->onCyclesUser, 1);
+        }
+    };
+
+    // On a fault the handler has already redirected ee.pc to the vector
+    const int32_t body = b->branchIdx < 0 ? static_cast<int32_t>(b->ops.size()) : b->branchIdx + 1;
+    for (int32_t i = 0; i < body; ++i) {
+        const EEBlockOp& op = b->ops[i];
+        ee.pc = b->startPc + (static_cast<uint32_t>(i) << 2);
+
+        if constexpr (P::breakpoints) {
+            if (hooks->stepOverArmed && hooks->stepOver == ee.pc) {
+                hooks->stepOverArmed = false;
+            } else if (hooks->breakpoints.count(ee.pc)) {
+                hooks->stepOver = ee.pc;
+                hooks->stepOverArmed = true;
+                ee.nextPc = ee.pc + 4;
+                executed = n;
+                return ExecResult::Breakpoint;
+            }
+        }
+
+        before(op);
+        if (op.fn(ee, mem, op.d) == ExecResult::Exception) {
+            executed = n;
+            return ExecResult::Exception;
+        }
+        after();
+    }
+
+    const bool taken = ee.branchTaken;
+    const uint32_t target = ee.branchTarget;
+    ee.branchTaken = false;
+
+    if (b->flow == EEFlow::Branch || (b->flow == EEFlow::BranchLikely && taken)) {
+        // Delay slot; a branch in it is ignored, as in eeStep
+        const EEBlockOp& op = b->ops[body];
+        ee.pc = b->startPc + (static_cast<uint32_t>(body) << 2);
+        before(op);
+        ee.delaySlot = true;
+        const ExecResult r = op.fn(ee, mem, op.d);
+        ee.delaySlot = false;
+        ee.branchTaken = false;
+        if (r == ExecResult::Exception) {
+            executed = n;
+            return r;
+        }
+        after();
+    }
+
+    ee.pc = taken ? target : b->endPc;
+    ee.nextPc = ee.pc + 4;
+    executed = n;
+    return ExecResult::Ok;
+}
+
+// Run loop entry point for one policy. EERunFast goes through the
+// recompiler; hooked policies interpret so every instruction is seen.
+using EERunFn = ExecResult (*)(EEJit& jit, EERegs& ee, Mem& mem, EERunHooks& hooks,
+                               int32_t budget, uint32_t& executed);
+
+// Pick the instantiation for a feature set; call once when the set changes
+EERunFn eeSelectRun(bool trace, bool cycleAccurate, bool breakpoints);
+
+// Instructions retired so far in the slice being run, up to but not
+// including the one at ee.pc; 0 between slices. Block-level bookkeeping
+// only: the run loops charge ee.budget for a whole block before running it,
+// so the ops of that block still ahead of ee.pc are handed back here.
+inline uint32_t eeSliceCycles(const EERegs& ee) {
+    if (!ee.budget) return 0;
+    const int32_t ahead = static_cast<int32_t>(ee.blockEnd - ee.pc) >> 2;
+    const int32_t done = ee.budgetStart - *ee.budget - ahead;
+    return done > 0 ? static_cast<uint32_t>(done) : 0;
+}
@@ -0,0 +1,186 @@
+#include "ee_tcache.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint32_t TCACHE_MAGIC = 0x43545853; // "SXTC"
+
+struct TcacheHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t buildId;
+    uint64_t imageHash;
+    uint32_t imageBase;
+    uint32_t imageSize;
+    uint32_t blockCount;
+    uint32_t opCount;
+    uint64_t payloadHash;
+};
+
+struct TcacheBlock {
+    uint32_t startPc;
+    uint32_t endPc;
+    int32_t  branchIdx;
+    uint16_t numOps;
+    uint8_t  hot;
+    uint8_t  pad;
+};
+
+static inline uint64_t mix64(uint64_t h) {
+    h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t eeTcacheHash(const uint8_t* data, size_t size) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ mix64(w)) * 0x100000001B3ull;
+    }
+    for (; i < size; ++i) h = (h ^ data[i]) * 0x100000001B3ull;
+    return mix64(h);
+}
+
+// PS2_BUILD_ID comes from the build (the git revision). Without one, fall
+// back to when this file was compiled, which misses rebuilds of the rest.
+#ifndef PS2_BUILD_ID
+#define PS2_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+uint64_t eeTcacheBuildId() {
+    static const char id[] = PS2_BUILD_ID;
+    const uint64_t layout = (uint64_t(EE_TCACHE_FORMAT) << 32) |
+                            (uint64_t(sizeof(DecodedOp)) << 16) | EE_BLOCK_MAX_OPS;
+    return eeTcacheHash(reinterpret_cast<const uint8_t*>(id), sizeof(id) - 1) ^ mix64(layout);
+}
+
+std::string eeTcachePath(const std::string& dir, uint64_t imageHash, uint32_t base) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "/ee-%016llx-%08X.tcache", (unsigned long long)imageHash, base);
+    return dir + name;
+}
+
+uint32_t eeTcacheLoad(const std::string& path, EEBlockCache& c, Mem& mem,
+                      uint64_t imageHash, uint32_t base, uint32_t size, uint64_t hotHits) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(TcacheHeader))) {
+        close(fd);
+        return 0;
+    }
+    const size_t fileSize = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(map);
+    TcacheHeader h;
+    std::memcpy(&h, bytes, sizeof(h));
+
+    const size_t payload = sizeof(TcacheBlock) * size_t(h.blockCount) + sizeof(DecodedOp) * size_t(h.opCount);
+    const bool valid = h.magic == TCACHE_MAGIC && h.format == EE_TCACHE_FORMAT &&
+                       h.buildId == eeTcacheBuildId() && h.imageHash == imageHash &&
+                       h.imageBase == base && h.imageSize == size &&
+                       sizeof(h) + payload == fileSize &&
+                       eeTcacheHash(bytes + sizeof(h), payload) == h.payloadHash;
+
+    uint32_t loaded = 0;
+    if (valid) {
+        const uint8_t* blk = bytes + sizeof(h);
+        const uint8_t* ops = blk + sizeof(TcacheBlock) * size_t(h.blockCount);
+        uint32_t opsLeft = h.opCount;
+
+        for (uint32_t i = 0; i < h.blockCount; ++i, blk += sizeof(TcacheBlock)) {
+            TcacheBlock tb;
+            std::memcpy(&tb, blk, sizeof(tb));
+            if (tb.numOps == 0 || tb.numOps > EE_BLOCK_MAX_OPS + 1 || tb.numOps > opsLeft) break;
+
+            EEBlock b;
+            b.startPc = tb.startPc;
+            b.endPc = tb.endPc;
+            b.branchIdx = tb.branchIdx;
+            b.hits = tb.hot ? hotHits : 0;
+            b.fpu = eeBlockFpuMode(c, b.startPc);
+            b.ops.resize(tb.numOps);
+            for (uint32_t k = 0; k < tb.numOps; ++k, ops += sizeof(DecodedOp)) {
+                std::memcpy(&b.ops[k].d, ops, sizeof(DecodedOp));
+                b.ops[k].fn = eeLookupHandler(b.ops[k].d, b.fpu);
+            }
+            opsLeft -= tb.numOps;
+            if (b.branchIdx >= static_cast<int32_t>(tb.numOps)) break;
+            if (b.branchIdx >= 0) b.flow = eeFlow(b.ops[b.branchIdx].d);
+
+            eeBlockInsert(c, mem, std::move(b));
+            ++loaded;
+        }
+    }
+
+    munmap(map, fileSize);
+    return loaded;
+}
+
+bool eeTcacheSave(const std::string& path, const EEBlockCache& c,
+                  uint64_t imageHash, uint32_t base, uint32_t size, uint64_t hotHits) {
+    std::vector<uint8_t> blocks;
+    std::vector<uint8_t> ops;
+    uint32_t blockCount = 0;
+    uint32_t opCount = 0;
+
+    for (const auto& kv : c.blocks) {
+        const EEBlock& b = kv.second;
+        if (b.startPc < base || b.endPc > base + size || b.ops.empty()) continue;
+
+        TcacheBlock tb{};
+        tb.startPc = b.startPc;
+        tb.endPc = b.endPc;
+        tb.branchIdx = b.branchIdx;
+        tb.numOps = static_cast<uint16_t>(b.ops.size());
+        tb.hot = (b.hits >= hotHits || b.jitCode) ? 1 : 0;
+        blocks.insert(blocks.end(), reinterpret_cast<const uint8_t*>(&tb),
+                      reinterpret_cast<const uint8_t*>(&tb) + sizeof(tb));
+
+        for (const EEBlockOp& op : b.ops) {
+            ops.insert(ops.end(), reinterpret_cast<const uint8_t*>(&op.d),
+                       reinterpret_cast<const uint8_t*>(&op.d) + sizeof(DecodedOp));
+        }
+        blockCount++;
+        opCount += tb.numOps;
+    }
+    if (blockCount == 0) return true; // nothing worth keeping
+
+    blocks.insert(blocks.end(), ops.begin(), ops.end());
+
+    TcacheHeader h{};
+    h.magic = TCACHE_MAGIC;
+    h.format = EE_TCACHE_FORMAT;
+    h.buildId = eeTcacheBuildId();
+    h.imageHash = imageHash;
+    h.imageBase = base;
+    h.imageSize = size;
+    h.blockCount = blockCount;
+    h.opCount = opCount;
+    h.payloadHash = eeTcacheHash(blocks.data(), blocks.size());
+
+    // Write to a temp file and rename so a crash never leaves a torn cache
+    const std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+              std::fwrite(blocks.data(), 1, blocks.size(), f) == blocks.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "ee_block.h"
+
+// Persistent translation cache: pre-decoded EE blocks for one code image
+// (the BIOS ROM, or an ELF once it is in memory) saved to disk and mapped
+// back in at startup. Host code is not stored; blocks that were hot when
+// saved come back primed so the recompiler picks them up on first dispatch.
+//
+// A file is only accepted when its image hash, image range and build id
+// match, so a different ROM or a different emulator build starts cold.
+
+// Bump when the file layout or the decode of any instruction changes
+static constexpr uint32_t EE_TCACHE_FORMAT = 2;
+
+// 64-bit hash of an image's bytes, used to key and validate cache files
+uint64_t eeTcacheHash(const uint8_t* data, size_t size);
+
+// Build id stored in and checked against every file: the emulator build
+// (PS2_BUILD_ID, the git revision) combined with the decoded layout
+uint64_t eeTcacheBuildId();
+
+// Cache file path inside dir for the blocks of an image mapped at base
+std::string eeTcachePath(const std::string& dir, uint64_t imageHash, uint32_t base);
+
+// Insert the blocks of a valid cache file covering [base, base+size) into c.
+// hotHits is the hit count given to blocks saved as hot. Returns the
+// number of blocks loaded, 0 when the file is missing, stale or corrupt.
+// For RAM images call this after the image has been copied into memory.
+uint32_t eeTcacheLoad(const std::string& path, EEBlockCache& c, Mem& mem,
+                      uint64_t imageHash, uint32_t base, uint32_t size, uint64_t hotHits);
+
+// Write every cached block lying in [base, base+size) to path (atomically
+// replacing any previous file). Blocks with at least hotHits dispatches or
+// compiled code are marked hot. Returns false on I/O failure.
+bool eeTcacheSave(const std::string& path, const EEBlockCache& c,
+                  uint64_t imageHash, uint32_t base, uint32_t size, uint64_t hotHits);
@@ -0,0 +1,160 @@
+#include "ee_tlb.h"
+
+static constexpr uint32_t TLB_ASID = 0xFF;
+
+static inline uint32_t tlbMask(const EETlbEntry& e) { return e.pageMask & 0x01FFE000u; }
+static inline uint32_t tlbBase(const EETlbEntry& e) { return e.entryHi & ~(tlbMask(e) | 0x1FFFu); }
+static inline bool     tlbScratch(const EETlbEntry& e) { return (e.entryLo0 & EE_TLB_S) != 0; }
+static inline bool     tlbGlobal(const EETlbEntry& e) { return (e.entryLo0 & e.entryLo1 & EE_TLB_G) != 0; }
+
+// Bytes behind each of the entry's two halves, and the whole range
+static inline uint32_t tlbHalf(const EETlbEntry& e) { return (tlbMask(e) >> 1) + MEM_PAGE_SIZE; }
+static inline uint32_t tlbSize(const EETlbEntry& e) { return tlbScratch(e) ? MEM_SCRATCH_SIZE : 2 * tlbHalf(e); }
+
+static inline uint32_t tlbAsid(const EERegs& ee) { return ee.cop0[COP0_ENTRYHI] & TLB_ASID; }
+
+static inline bool tlbMatches(const EETlbEntry& e, uint32_t addr, uint32_t asid) {
+    return ((addr ^ e.entryHi) & ~(tlbMask(e) | 0x1FFFu)) == 0 &&
+           (tlbGlobal(e) || (e.entryHi & TLB_ASID) == asid);
+}
+
+// KSEG0/KSEG1 are never translated
+static inline bool tlbTranslated(uint32_t addr) { return addr - MEM_KSEG0 >= 0x40000000u; }
+
+// Does the entry map anything under the current ASID?
+static inline bool tlbActive(const EERegs& ee, const EETlbEntry& e) {
+    return tlbTranslated(tlbBase(e)) && (tlbGlobal(e) || (e.entryHi & TLB_ASID) == tlbAsid(ee));
+}
+
+static inline bool tlbOverlaps(const EETlbEntry& e, uint32_t base, uint32_t size) {
+    const uint64_t first = tlbBase(e), end = first + tlbSize(e);
+    return first < uint64_t(base) + size && base < end;
+}
+
+static void tlbMap(Mem& mem, const EETlbEntry& e) {
+    const uint32_t base = tlbBase(e);
+    if (tlbScratch(e)) {
+        memMapPhys(mem, base, MEM_SCRATCH_BASE, MEM_SCRATCH_SIZE, true);
+        return;
+    }
+    const uint32_t half = tlbHalf(e);
+    for (uint32_t i = 0; i < 2; ++i) {
+        const uint32_t lo = i ? e.entryLo1 : e.entryLo0;
+        const uint32_t vaddr = base + i * half;
+        const uint32_t paddr = ((lo >> 6) << MEM_PAGE_SHIFT) & ~(half - 1);
+        if (lo & EE_TLB_V) memMapPhys(mem, vaddr, paddr, half, (lo & EE_TLB_D) != 0);
+        else               memMapInvalid(mem, vaddr, half);
+    }
+}
+
+// Untranslated view back for an entry's old range, then whatever other
+// entries still cover part of it
+static void tlbUnmap(EERegs& ee, Mem& mem, const EETlbEntry& e, uint32_t skip) {
+    const uint32_t base = tlbBase(e), size = tlbSize(e);
+    memMapDefault(mem, base, size);
+    for (uint32_t i = 0; i < EE_TLB_ENTRIES; ++i) {
+        if (i != skip && tlbActive(ee, ee.tlb[i]) && tlbOverlaps(ee.tlb[i], base, size)) tlbMap(mem, ee.tlb[i]);
+    }
+}
+
+void eeTlbWrite(EERegs& ee, Mem& mem, uint32_t index) {
+    index &= 63;
+    if (index >= EE_TLB_ENTRIES) return;
+    EETlbEntry& e = ee.tlb[index];
+    const EETlbEntry old = e;
+    e.pageMask = ee.cop0[COP0_PAGEMASK] & 0x01FFE000u;
+    e.entryHi  = ee.cop0[COP0_ENTRYHI] & (~(e.pageMask | 0x1FFFu) | TLB_ASID);
+    e.entryLo0 = ee.cop0[COP0_ENTRYLO0] & 0x83FFFFFFu;
+    e.entryLo1 = ee.cop0[COP0_ENTRYLO1] & 0x03FFFFFFu;
+
+    if (tlbActive(ee, old)) tlbUnmap(ee, mem, old, index);
+    if (tlbActive(ee, e)) tlbMap(mem, e);
+}
+
+void eeTlbRead(EERegs& ee, Mem& mem, uint32_t index) {
+    index &= 63;
+    if (index >= EE_TLB_ENTRIES) return;
+    const EETlbEntry& e = ee.tlb[index];
+    ee.cop0[COP0_PAGEMASK] = e.pageMask;
+    ee.cop0[COP0_ENTRYLO0] = e.entryLo0;
+    ee.cop0[COP0_ENTRYLO1] = e.entryLo1;
+    eeTlbSetEntryHi(ee, mem, e.entryHi);
+}
+
+void eeTlbProbe(EERegs& ee) {
+    const uint32_t hi = ee.cop0[COP0_ENTRYHI];
+    for (uint32_t i = 0; i < EE_TLB_ENTRIES; ++i) {
+        if (tlbMatches(ee.tlb[i], hi, hi & TLB_ASID)) {
+            ee.cop0[COP0_INDEX] = i;
+            return;
+        }
+    }
+    ee.cop0[COP0_INDEX] = 0x80000000u;
+}
+
+uint32_t eeTlbRandom(EERegs& ee) {
+    uint32_t& random = ee.cop0[COP0_RANDOM];
+    const uint32_t wired = ee.cop0[COP0_WIRED] & 63;
+    const uint32_t index = (random < wired || random >= EE_TLB_ENTRIES) ? EE_TLB_ENTRIES - 1 : random;
+    random = index <= wired ? EE_TLB_ENTRIES - 1 : index - 1;
+    return index;
+}
+
+void eeTlbSetEntryHi(EERegs& ee, Mem& mem, uint32_t value) {
+    const uint32_t before = tlbAsid(ee);
+    ee.cop0[COP0_ENTRYHI] = value & (0xFFFFE000u | TLB_ASID);
+    const uint32_t asid = tlbAsid(ee);
+    if (asid == before) return;
+
+    // Entries of the old address space go first, then the new one's
+    for (uint32_t i = 0; i < EE_TLB_ENTRIES; ++i) {
+        const EETlbEntry& e = ee.tlb[i];
+        if (!tlbGlobal(e) && (e.entryHi & TLB_ASID) == before && tlbTranslated(tlbBase(e))) {
+            tlbUnmap(ee, mem, e, i);
+        }
+    }
+    for (const EETlbEntry& e : ee.tlb) {
+        if (!tlbGlobal(e) && tlbActive(ee, e)) tlbMap(mem, e);
+    }
+}
+
+void eeTlbReset(EERegs& ee, Mem& mem) {
+    for (const EETlbEntry& e : ee.tlb) {
+        if (tlbActive(ee, e)) memMapDefault(mem, tlbBase(e), tlbSize(e));
+    }
+}
+
+ExecResult eeTlbMiss(EERegs& ee, uint32_t addr, bool store) {
+    const uint32_t status = ee.cop0[COP0_STATUS];
+    if (!tlbTranslated(addr)) return ExecResult::Ok;
+    if (addr < MEM_KSEG0 && (status & STATUS_ERL)) return ExecResult::Ok; // kuseg is unmapped under ERL
+
+    const uint32_t asid = tlbAsid(ee);
+    const EETlbEntry* hit = nullptr;
+    for (const EETlbEntry& e : ee.tlb) {
+        if (tlbMatches(e, addr, asid)) {
+            hit = &e;
+            break;
+        }
+    }
+
+    EEExc code = store ? EEExc::TLBS : EEExc::TLBL;
+    uint32_t vector = 0x180;
+    if (!hit) {
+        if (!(status & STATUS_EXL)) vector = 0; // refill
+    } else if (tlbScratch(*hit)) {
+        return ExecResult::Ok;
+    } else {
+        const uint32_t lo = addr - tlbBase(*hit) < tlbHalf(*hit) ? hit->entryLo0 : hit->entryLo1;
+        if (lo & EE_TLB_V) {
+            // Valid and mapped to nothing the tables know (no bus error model)
+            if (!store || (lo & EE_TLB_D)) return ExecResult::Ok;
+            code = EEExc::Mod;
+        }
+    }
+
+    ee.cop0[COP0_BADVADDR] = addr;
+    ee.cop0[COP0_CONTEXT]  = (ee.cop0[COP0_CONTEXT] & 0xFF800000u) | ((addr >> 9) & 0x007FFFF0u);
+    ee.cop0[COP0_ENTRYHI]  = (addr & 0xFFFFE000u) | asid;
+    return eeRaiseException(ee, code, vector);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include "ee_cpu.h"
+
+// EE TLB (COP0 TLBR/TLBWI/TLBWR/TLBP). Entries are materialized into the
+// page tables when written, so a translated access takes the same fast path
+// as any other; only an access to a page the tables leave unmapped ends up
+// in eeTlbMiss, which walks the entries to pick the exception.
+//
+// Pages no entry covers keep their untranslated mapping (kuseg is physical
+// memory), as they did before the TLB existed.
+
+// EntryLo bits
+static constexpr uint32_t EE_TLB_G = 1u << 0;
+static constexpr uint32_t EE_TLB_V = 1u << 1;
+static constexpr uint32_t EE_TLB_D = 1u << 2;
+static constexpr uint32_t EE_TLB_S = 1u << 31; // EntryLo0: maps the scratchpad
+
+// Write entry index from PageMask/EntryHi/EntryLo0/EntryLo1, remapping only
+// the pages it covered and now covers
+void       eeTlbWrite(EERegs& ee, Mem& mem, uint32_t index);
+void       eeTlbRead(EERegs& ee, Mem& mem, uint32_t index);
+void       eeTlbProbe(EERegs& ee);
+
+// Index TLBWR writes: Random, which counts down from 47 to Wired
+uint32_t   eeTlbRandom(EERegs& ee);
+
+// MTC0 EntryHi; a new ASID remaps the entries that aren't global
+void       eeTlbSetEntryHi(EERegs& ee, Mem& mem, uint32_t value);
+
+// Give every mapped page back its untranslated view (before eeInit)
+void       eeTlbReset(EERegs& ee, Mem& mem);
+
+// addr found nothing in the page tables. Raises TLB refill/invalid/modified
+// and returns ExecResult::Exception, or returns Ok when the address isn't
+// translated (the access goes to the fallback hooks).
+ExecResult eeTlbMiss(EERegs& ee, uint32_t addr, bool store);
+
+// Data access through the TLB; false once the exception is raised
+template <typename T>
+inline bool eeLoad(EERegs& ee, const Mem& mem, uint32_t addr, T& v) {
+    if (memTryRead(mem, addr, v)) return true;
+    if (eeTlbMiss(ee, addr, false) != ExecResult::Ok) return false;
+    memReadSlow(mem, MemAccess<T>::align(addr), &v, sizeof(T));
+    return true;
+}
+
+template <typename T>
+inline bool eeStore(EERegs& ee, Mem& mem, uint32_t addr, const T& v) {
+    if (memTryWrite(mem, addr, v)) return true;
+    if (eeTlbMiss(ee, addr, true) != ExecResult::Ok) return false;
+    memWriteSlow(mem, MemAccess<T>::align(addr), &v, sizeof(T));
+    return true;
+}
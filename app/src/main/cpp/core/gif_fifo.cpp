@@ -0,0 +1,125 @@
+#include "gif_fifo.h"
+#include "gs_stub.h"
+#include <algorithm>
+#include <cstring>
+
+// Each transfer is one entry, contiguous in the ring so the GS thread can
+// hand it over in place: one that would cross the ring end is preceded by a
+// skip entry padding out to the start. Transfers longer than GIF_MAX_PACKET
+// are split; anything shorter reaches gsProcessGifPacket whole, as inline.
+
+static constexpr uint32_t GIF_RING_QWORDS = 1u << 16;   // 1 MB
+static constexpr uint32_t GIF_MAX_PACKET  = GIF_RING_QWORDS / 4;
+
+// -----------------------------------------------------------------------------
+// Consumer (GS thread)
+// -----------------------------------------------------------------------------
+
+static uint32_t gifConsume(void* user, uint32_t pos) {
+    GIFFifo& f = *static_cast<GIFFifo*>(user);
+    const uint32_t qwc = spscSlot(f.ring, pos)[0];
+    if (!qwc) return spscRoomToEnd(f.ring, pos);
+    gsProcessGifPacket(*f.gs, spscSlot(f.ring, pos + 1), static_cast<int>(qwc));
+    return 1 + qwc;
+}
+
+void gifFifoInit(GIFFifo& f, GS& gs) {
+    gifFifoShutdown(f);
+    f.gs = &gs;
+    gs.gif = &f;
+    spscInit(f.ring, GIF_RING_QWORDS, gifConsume, &f);
+    f.packets = 0; f.qwords = 0; f.ringStalls = 0; f.stallNs = 0; f.syncs = 0; f.syncNs = 0;
+    f.maxOccupancy = 0;
+}
+
+void gifFifoShutdown(GIFFifo& f) {
+    if (f.threaded) gifFifoSync(f);
+    spscStopWorker(f.ring);
+    f.threaded = false;
+}
+
+GIFFifo::~GIFFifo() {
+    gifFifoShutdown(*this);
+}
+
+void gifFifoSetThreaded(GIFFifo& f, bool threaded) {
+    if (threaded == f.threaded || !f.gs) return;
+    if (f.threaded) {
+        gifFifoSync(f);
+        spscStopWorker(f.ring);
+    } else {
+        spscStartWorker(f.ring);
+    }
+    f.threaded = threaded;
+}
+
+void gifFifoPush(GIFFifo& f, const uint32_t* data, uint32_t qwc) {
+    f.packets.fetch_add(1, std::memory_order_relaxed);
+    f.qwords.fetch_add(qwc, std::memory_order_relaxed);
+    if (!f.threaded) {
+        gsProcessGifPacket(*f.gs, data, static_cast<int>(qwc));
+        return;
+    }
+    while (qwc) {
+        const uint32_t n = std::min(qwc, GIF_MAX_PACKET);
+        uint64_t ns = 0;
+        const uint32_t h = spscReserveEntry(f.ring, 1 + n, ns);
+        if (ns) {
+            f.ringStalls.fetch_add(1, std::memory_order_relaxed);
+            f.stallNs.fetch_add(ns, std::memory_order_relaxed);
+        }
+        uint32_t* hdr = spscSlot(f.ring, h);
+        hdr[0] = n;
+        hdr[1] = hdr[2] = hdr[3] = 0;
+        std::memcpy(spscSlot(f.ring, h + 1), data, size_t(n) * 16);
+        const uint32_t queued = h + 1 + n - f.ring.tail.load(std::memory_order_relaxed);
+        if (queued > f.maxOccupancy.load(std::memory_order_relaxed)) f.maxOccupancy.store(queued, std::memory_order_relaxed);
+        spscCommit(f.ring, h + 1 + n);
+        data += n * 4;
+        qwc -= n;
+    }
+}
+
+// GIFtag: NLOOP bits 0-14, EOP bit 15, FLG bits 58-59, NREG bits 60-63
+uint32_t gifPacketChainSize(const uint32_t* mem, uint32_t qwords, uint32_t qaddr) {
+    uint32_t n = 0;
+    while (n < qwords) {
+        const uint32_t* tag = mem + size_t((qaddr + n) & (qwords - 1)) * 4;
+        const uint32_t nloop = tag[0] & 0x7FFF;
+        const uint32_t nreg = (tag[1] >> 28) ? (tag[1] >> 28) : 16;
+        switch ((tag[1] >> 26) & 3) {
+            case 0:  n += 1 + nloop * nreg; break;            // PACKED
+            case 1:  n += 1 + (nloop * nreg + 1) / 2; break;  // REGLIST, two per quadword
+            default: n += 1 + nloop; break;                   // IMAGE
+        }
+        if (tag[0] & 0x8000) break;
+    }
+    return std::min(n, qwords);
+}
+
+bool gifFifoBusy(const GIFFifo& f) {
+    return f.threaded && spscBusy(f.ring);
+}
+
+void gifFifoSync(GIFFifo& f) {
+    if (!f.threaded) return;
+    if (const uint64_t ns = spscDrain(f.ring)) {
+        f.syncs.fetch_add(1, std::memory_order_relaxed);
+        f.syncNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+}
+
+GIFFifoStats gifFifoStats(const GIFFifo& f) {
+    GIFFifoStats s;
+    s.packets = f.packets.load(std::memory_order_relaxed);
+    s.qwords = f.qwords.load(std::memory_order_relaxed);
+    const uint32_t t = f.ring.tail.load(std::memory_order_acquire);
+    s.occupancy = f.ring.head.load(std::memory_order_acquire) - t;
+    s.maxOccupancy = f.maxOccupancy.load(std::memory_order_relaxed);
+    s.capacity = spscCapacity(f.ring);
+    s.ringStalls = f.ringStalls.load(std::memory_order_relaxed);
+    s.stallNs = f.stallNs.load(std::memory_order_relaxed);
+    s.syncs = f.syncs.load(std::memory_order_relaxed);
+    s.syncNs = f.syncNs.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "spsc_ring.h"
+
+struct GS; // forward declaration
+
+// GS front end. Inline mode hands each GIF transfer (PATH1 XGKICK, PATH2
+// DIRECT, PATH3 DMA) to gsProcessGifPacket on the EE thread. Threaded mode copies it into
+// a single-producer/single-consumer ring of quadwords that a GS thread
+// drains; the EE only waits when the ring is full or before it touches GS
+// state the packets may change (gifFifoSync: CSR, SIGLBLID, resets).
+//
+// Either way gsProcessGifPacket sees transfers, not GIF packets: a DMA
+// burst or VIF DIRECT can end mid-packet, so it carries GIFtag state from
+// one call to the next.
+
+struct GIFFifoStats {
+    uint64_t packets = 0;       // transfers submitted
+    uint64_t qwords = 0;
+    uint32_t occupancy = 0;     // quadwords queued right now
+    uint32_t maxOccupancy = 0;  // high-water mark
+    uint32_t capacity = 0;
+    uint64_t ringStalls = 0;    // pushes that found the ring full
+    uint64_t stallNs = 0;       // EE time spent waiting for room
+    uint64_t syncs = 0;         // GS state reads that found packets queued
+    uint64_t syncNs = 0;        // EE time spent waiting on those
+};
+
+struct GIFFifo {
+    GS* gs = nullptr;
+    bool threaded = false;      // producer thread only; change through gifFifoSetThreaded
+
+    // A header quadword (payload size, 0 = skip to the ring end), then the
+    // payload; see gifFifoPush
+    SPSCRing ring;
+
+    std::atomic<uint64_t> packets{0}, qwords{0}, ringStalls{0}, stallNs{0}, syncs{0}, syncNs{0};
+    std::atomic<uint32_t> maxOccupancy{0};
+
+    // Stops the GS thread, which would otherwise still be waiting on cv
+    // when a static FIFO is destroyed at exit
+    ~GIFFifo();
+};
+
+// Also points gs.gif at the FIFO so GS register reads can sync
+void     gifFifoInit(GIFFifo& f, GS& gs);
+void     gifFifoShutdown(GIFFifo& f);
+
+// Switch modes; drains the ring first. Call it from the producer thread,
+// between pushes: a push racing the switch could land in a ring nobody drains.
+void     gifFifoSetThreaded(GIFFifo& f, bool threaded);
+
+// Producer side (EE thread): submit qwc quadwords of GIF data. Waits only
+// while the ring has no room.
+void     gifFifoPush(GIFFifo& f, const uint32_t* data, uint32_t qwc);
+
+// PATH1 (VU1 XGKICK): quadwords of the GIF packets starting at quadword
+// qaddr of a memory of `qwords` quadwords (a power of two), through the one
+// tagged EOP. Wraps at the end of the memory and stops after `qwords`.
+uint32_t gifPacketChainSize(const uint32_t* mem, uint32_t qwords, uint32_t qaddr);
+
+// Packets queued or being processed. Never waits.
+bool     gifFifoBusy(const GIFFifo& f);
+
+// Wait until the GS thread has processed everything queued
+void     gifFifoSync(GIFFifo& f);
+
+GIFFifoStats gifFifoStats(const GIFFifo& f);
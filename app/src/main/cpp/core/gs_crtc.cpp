@@ -0,0 +1,81 @@
+#include "gs_crtc.h"
+#include "gs_stub.h"
+#include "scheduler.h"
+
+// INTC bits
+static constexpr uint32_t INTC_GS   = 1u << 0;
+static constexpr uint32_t INTC_VBON = 1u << 2;
+static constexpr uint32_t INTC_VBOF = 1u << 3;
+
+struct CrtcTiming {
+    uint32_t fieldCycles;
+    uint32_t lineCycles;
+    uint32_t blankLines;   // lines of each field spent in VBLANK
+};
+
+// EE cycles; NTSC is 60000/1001 fields of 262.5 lines, PAL 50 of 312.5
+static constexpr CrtcTiming CRTC_NTSC = {uint32_t(uint64_t(EE_CLOCK_HZ) * 1001 / 60000), EE_CLOCK_HZ / 15734, 22};
+static constexpr CrtcTiming CRTC_PAL  = {EE_CLOCK_HZ / 50, EE_CLOCK_HZ / 15625, 25};
+
+static inline const CrtcTiming& crtcTiming(GSVideoMode mode) {
+    return mode == GSVideoMode::PAL ? CRTC_PAL : CRTC_NTSC;
+}
+
+uint32_t gsCrtcFieldCycles(GSVideoMode mode) {
+    return crtcTiming(mode).fieldCycles;
+}
+
+uint32_t gsCrtcLineCycles(GSVideoMode mode) {
+    return crtcTiming(mode).lineCycles;
+}
+
+double gsCrtcFieldRate(GSVideoMode mode) {
+    return mode == GSVideoMode::PAL ? 50.0 : 60000.0 / 1001.0;
+}
+
+// Set a CSR flag; the GS interrupt fires on its rising edge unless masked
+static void crtcRaiseGs(GSCrtc& c, uint64_t flag, uint64_t mask) {
+    GS& gs = *c.gs;
+    if (gs.csr & flag) return;
+    gs.csr |= flag;
+    if (!(gs.imr & mask)) *c.intcStat |= INTC_GS;
+}
+
+static void crtcHblank(void* dev, uint64_t when) {
+    GSCrtc& c = *static_cast<GSCrtc*>(dev);
+    crtcRaiseGs(c, GS_CSR_HSINT, GS_IMR_HSMSK);
+    schedAt(*c.sched, SCHED_HBLANK, when + crtcTiming(c.mode).lineCycles);
+}
+
+// One event alternates between the start and the end of VBLANK
+static void crtcVblank(void* dev, uint64_t when) {
+    GSCrtc& c = *static_cast<GSCrtc*>(dev);
+    const CrtcTiming& t = crtcTiming(c.mode);
+    if (!c.vblank) {
+        c.vblank = true;
+        c.fields++;
+        *c.intcStat |= INTC_VBON;
+        c.gs->csr ^= GS_CSR_FIELD;
+        crtcRaiseGs(c, GS_CSR_VSINT, GS_IMR_VSMSK);
+        schedAt(*c.sched, SCHED_VBLANK, c.fieldStart + t.fieldCycles);
+    } else {
+        c.vblank = false;
+        *c.intcStat |= INTC_VBOF;
+        c.fieldStart = when;
+        schedAt(*c.sched, SCHED_VBLANK, when + t.fieldCycles - t.blankLines * t.lineCycles);
+    }
+}
+
+void gsCrtcInit(GSCrtc& c, GS& gs, Scheduler& sched, uint32_t& intc_stat, GSVideoMode mode) {
+    c = GSCrtc{};
+    c.mode = mode;
+    c.gs = &gs;
+    c.sched = &sched;
+    c.intcStat = &intc_stat;
+    c.fieldStart = sched.now;
+    const CrtcTiming& t = crtcTiming(mode);
+    schedSetHandler(sched, SCHED_HBLANK, crtcHblank, &c);
+    schedSetHandler(sched, SCHED_VBLANK, crtcVblank, &c);
+    schedAt(sched, SCHED_HBLANK, sched.now + t.lineCycles);
+    schedAt(sched, SCHED_VBLANK, sched.now + t.fieldCycles - t.blankLines * t.lineCycles);
+}
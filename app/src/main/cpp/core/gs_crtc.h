@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+struct GS;
+struct Scheduler;
+
+// CRTC timing: HBLANK every line and VBLANK start/end every field, as
+// scheduler events. VBLANK start/end reach the INTC (VBON/VBOF); both also
+// set the GS CSR HSINT/VSINT flags, which raise the GS interrupt unless
+// masked in IMR.
+enum class GSVideoMode : uint8_t {
+    NTSC,   // 59.94 fields/s
+    PAL     // 50 fields/s
+};
+
+struct GSCrtc {
+    GSVideoMode mode = GSVideoMode::NTSC;
+    bool     vblank = false;
+    uint64_t fieldStart = 0;   // EE cycle the current field's display began
+    uint64_t fields = 0;       // VBLANK starts so far
+
+    GS*        gs = nullptr;
+    Scheduler* sched = nullptr;
+    uint32_t*  intcStat = nullptr;
+};
+
+// Starts the first field now and posts the CRTC events
+void     gsCrtcInit(GSCrtc& crtc, GS& gs, Scheduler& sched, uint32_t& intc_stat, GSVideoMode mode);
+
+// EE cycles per field and per line (HBLANK period), and fields per second
+// of a mode
+uint32_t gsCrtcFieldCycles(GSVideoMode mode);
+uint32_t gsCrtcLineCycles(GSVideoMode mode);
+double   gsCrtcFieldRate(GSVideoMode mode);
@@ -1,5 +1,9 @@
 // gs_stub.cpp
 #include "gs_stub.h"
+#include "mem_map.h"
+#include "gif_fifo.h"
+#include <algorithm>
+#include <iterator>
 #include <cstdint>
 #include <string>
 #include <atomic>
@@ -66,4 +70,59 @@ void gsProcessGifPacket(GS& gs, const uint32_t* data, int qwc) {
 
     // TODO (v0.6+): parse GIF tags, route to GS registers, simulate drawing
     // For now, this is a no-op placeholder
-}
\ No newline at end of file
+}
+// -----------------------------------------------------------------------------
+// Privileged registers (EE side, 0x12000000)
+// -----------------------------------------------------------------------------
+
+void gsResetPriv(GS& gs) {
+    std::fill(std::begin(gs.priv), std::end(gs.priv), 0);
+    gs.csr = 0;
+    gs.imr = GS_IMR_RESET;
+    gs.busdir = 0;
+    gs.siglblid = 0;
+}
+
+// The registers the GIF packets can change: the GS thread catches up first
+static inline GS& gsSynced(void* dev) {
+    auto& gs = *static_cast<GS*>(dev);
+    if (gs.gif) gifFifoSync(*gs.gif);
+    return gs;
+}
+
+static inline uint64_t gsReadPart(uint64_t v, uint32_t addr, uint32_t size) {
+    const uint64_t shifted = v >> ((addr & 7) * 8);
+    return size >= 8 ? shifted : shifted & ((1ull << (size * 8)) - 1);
+}
+
+// CSR: the FIFO reads empty once synced; SIGNAL..EDWINT clear on 1, RESET
+// clears all
+static uint64_t gsReadCsr(void* dev, uint32_t addr, uint32_t size) {
+    return gsReadPart((gsSynced(dev).csr & 0x3FFF) | GS_CSR_READ, addr, size);
+}
+
+static void gsWriteCsr(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    if (addr & 7) return;
+    GS& gs = gsSynced(dev);
+    if (value & GS_CSR_RESET) gs.csr = 0;
+    else gs.csr &= ~(value & 0x1F);
+}
+
+static uint64_t gsReadSiglblid(void* dev, uint32_t addr, uint32_t size) {
+    return gsReadPart(gsSynced(dev).siglblid, addr, size);
+}
+
+static void gsWriteSiglblid(void* dev, uint32_t addr, uint64_t value, uint32_t size) {
+    GS& gs = gsSynced(dev);
+    const uint32_t shift = (addr & 7) * 8;
+    const uint64_t mask = (size >= 8 ? ~0ull : (1ull << (size * 8)) - 1) << shift;
+    gs.siglblid = (gs.siglblid & ~mask) | ((value << shift) & mask);
+}
+
+void gsMapMmio(GS& gs, Mem& mem) {
+    for (uint32_t i = 0; i < 15; ++i) memMapMmio(mem, 0x12000000 + i * 0x10, 16, memMmioReg(&gs.priv[i]));
+    memMapMmio(mem, 0x12001000, 16, MemMmioSlot{gsReadCsr, gsWriteCsr, nullptr, nullptr, &gs});
+    memMapMmio(mem, 0x12001010, 16, memMmioReg(&gs.imr));
+    memMapMmio(mem, 0x12001040, 16, memMmioReg(&gs.busdir));
+    memMapMmio(mem, 0x12001080, 16, MemMmioSlot{gsReadSiglblid, gsWriteSiglblid, nullptr, nullptr, &gs});
+}
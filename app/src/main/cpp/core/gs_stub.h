@@ -2,6 +2,21 @@
 #include <cstdint>
 #include <vector>
 
+struct Mem;     // forward declaration
+struct GIFFifo; // forward declaration
+
+// CSR as read: FIFO empty, revision 0x1B, ID 0x55
+static constexpr uint64_t GS_CSR_READ  = 0x551B4000;
+static constexpr uint64_t GS_CSR_RESET = 1u << 9;
+static constexpr uint64_t GS_IMR_RESET = 0x7F00;
+
+// CSR interrupt/status bits and their IMR masks
+static constexpr uint64_t GS_CSR_HSINT = 1u << 2;
+static constexpr uint64_t GS_CSR_VSINT = 1u << 3;
+static constexpr uint64_t GS_CSR_FIELD = 1u << 13;
+static constexpr uint64_t GS_IMR_HSMSK = 1u << 10;
+static constexpr uint64_t GS_IMR_VSMSK = 1u << 11;
+
 enum class GSPrim : uint8_t {
     None = 0,
     Point = 1,
@@ -14,6 +29,18 @@ struct GS {
     int height = 0;
     uint64_t tick = 0;
 
+    // Privileged registers: PMODE..BGCOLOR at 0x12000000 + n * 0x10, then
+    // the block at 0x12001000
+    uint64_t priv[15] = {0};
+    uint64_t csr = 0;
+    uint64_t imr = GS_IMR_RESET;
+    uint64_t busdir = 0;
+    uint64_t siglblid = 0;
+
+    // Packets still queued for the GS thread; drained before the EE reads or
+    // writes CSR/SIGLBLID
+    GIFFifo* gif = nullptr;
+
     // Core GS registers (AD writes)
     uint64_t FRAME = 0;
     uint64_t ZBUF  = 0;
@@ -40,4 +67,8 @@ struct GS {
 void gsInit(GS& gs, int w, int h);
 void gsStep(GS& gs, uint64_t tick);
 void gsProcessGifPacket(GS& gs, const uint32_t* data, int qwc);
-const uint32_t* gsData(const GS& gs);
\ No newline at end of file
+const uint32_t* gsData(const GS& gs);
+
+// Privileged registers back to their reset values
+void gsResetPriv(GS& gs);
+void gsMapMmio(GS& gs, Mem& mem);
\ No newline at end of file
@@ -0,0 +1,1037 @@
+#include "ipu.h"
+#include "mem_map.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Decoding runs in three passes per block: the VLC decoder drops run/level
+// pairs into a raster-order int16 block, a SIMD pass dequantises all 64
+// coefficients at once, and a separable float IDCT (two 8x8 matrix passes,
+// zero rows skipped) produces the samples. Colour conversion works on four
+// pixels per vector. Commands are transactional: one that runs out of input
+// is rolled back and retried when more data arrives.
+
+// -----------------------------------------------------------------------------
+// vec4 layer: float for the IDCT and CSC, int32 for packing pixels
+// -----------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+using F4 = __m128;
+using I4 = __m128i;
+
+static inline F4   f4Load(const float* p)         { return _mm_load_ps(p); }
+static inline void f4Store(float* p, F4 x)        { _mm_store_ps(p, x); }
+static inline F4   f4Splat(float f)               { return _mm_set1_ps(f); }
+static inline F4   f4Zero()                       { return _mm_setzero_ps(); }
+static inline F4   f4Add(F4 a, F4 b)              { return _mm_add_ps(a, b); }
+static inline F4   f4Mul(F4 a, F4 b)              { return _mm_mul_ps(a, b); }
+static inline F4   f4Clamp(F4 a, float lo, float hi) { return _mm_min_ps(_mm_max_ps(a, _mm_set1_ps(lo)), _mm_set1_ps(hi)); }
+static inline I4   f4Round(F4 a)                  { return _mm_cvtps_epi32(a); }
+static inline F4   f4FromI4(I4 a)                 { return _mm_cvtepi32_ps(a); }
+
+static inline I4   i4Splat(int32_t x)             { return _mm_set1_epi32(x); }
+static inline I4   i4Load(const int32_t* p)       { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+static inline void i4Store(int32_t* p, I4 x)      { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x); }
+static inline I4   i4Or(I4 a, I4 b)               { return _mm_or_si128(a, b); }
+static inline I4   i4And(I4 a, I4 b)              { return _mm_and_si128(a, b); }
+static inline I4   i4AndNot(I4 m, I4 a)           { return _mm_andnot_si128(m, a); }
+static inline I4   i4Lt(I4 a, I4 b)               { return _mm_cmplt_epi32(a, b); }
+static inline I4   i4Select(I4 m, I4 a, I4 b)     { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+template <int N> static inline I4 i4Shl(I4 a)     { return _mm_slli_epi32(a, N); }
+template <int N> static inline I4 i4Shr(I4 a)     { return _mm_srli_epi32(a, N); }
+
+// Four bytes, or two bytes each doubled (4:2:0 chroma), widened to int32
+static inline I4 i4FromU8(const uint8_t* p) {
+    uint32_t w;
+    std::memcpy(&w, p, 4);
+    const __m128i z = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(w)), z), z);
+}
+static inline I4 i4FromU8Pair(const uint8_t* p) {
+    const uint32_t w = p[0] | static_cast<uint32_t>(p[1]) << 8;
+    const __m128i z = _mm_setzero_si128();
+    const __m128i x = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(w)), z), z);
+    return _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 1, 0, 0));
+}
+
+#elif defined(__ARM_NEON)
+
+using F4 = float32x4_t;
+using I4 = int32x4_t;
+
+static inline F4   f4Load(const float* p)         { return vld1q_f32(p); }
+static inline void f4Store(float* p, F4 x)        { vst1q_f32(p, x); }
+static inline F4   f4Splat(float f)               { return vdupq_n_f32(f); }
+static inline F4   f4Zero()                       { return vdupq_n_f32(0.0f); }
+static inline F4   f4Add(F4 a, F4 b)              { return vaddq_f32(a, b); }
+static inline F4   f4Mul(F4 a, F4 b)              { return vmulq_f32(a, b); }
+static inline F4   f4Clamp(F4 a, float lo, float hi) { return vminq_f32(vmaxq_f32(a, vdupq_n_f32(lo)), vdupq_n_f32(hi)); }
+static inline I4   f4Round(F4 a) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(a);
+#else
+    const F4 half = vbslq_f32(vcltq_f32(a, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+    return vcvtq_s32_f32(vaddq_f32(a, half));
+#endif
+}
+static inline F4   f4FromI4(I4 a)                 { return vcvtq_f32_s32(a); }
+
+static inline I4   i4Splat(int32_t x)             { return vdupq_n_s32(x); }
+static inline I4   i4Load(const int32_t* p)       { return vld1q_s32(p); }
+static inline void i4Store(int32_t* p, I4 x)      { vst1q_s32(p, x); }
+static inline I4   i4Or(I4 a, I4 b)               { return vorrq_s32(a, b); }
+static inline I4   i4And(I4 a, I4 b)              { return vandq_s32(a, b); }
+static inline I4   i4AndNot(I4 m, I4 a)           { return vbicq_s32(a, m); }
+static inline I4   i4Lt(I4 a, I4 b)               { return vreinterpretq_s32_u32(vcltq_s32(a, b)); }
+static inline I4   i4Select(I4 m, I4 a, I4 b)     { return vbslq_s32(vreinterpretq_u32_s32(m), a, b); }
+template <int N> static inline I4 i4Shl(I4 a)     { return vshlq_n_s32(a, N); }
+template <int N> static inline I4 i4Shr(I4 a)     { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), N)); }
+
+static inline I4 i4FromU8(const uint8_t* p) {
+    uint32_t w;
+    std::memcpy(&w, p, 4);
+    const uint16x8_t h = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(w)));
+    return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(h)));
+}
+static inline I4 i4FromU8Pair(const uint8_t* p) {
+    const int32_t a = p[0], b = p[1];
+    return vcombine_s32(vdup_n_s32(a), vdup_n_s32(b));
+}
+
+#else
+
+struct F4 { float v[4]; };
+struct I4 { int32_t v[4]; };
+
+static inline F4   f4Load(const float* p)         { F4 r; std::memcpy(r.v, p, 16); return r; }
+static inline void f4Store(float* p, F4 x)        { std::memcpy(p, x.v, 16); }
+static inline F4   f4Splat(float f)               { return F4{{f, f, f, f}}; }
+static inline F4   f4Zero()                       { return f4Splat(0.0f); }
+static inline F4   f4Add(F4 a, F4 b)              { for (int l = 0; l < 4; ++l) a.v[l] += b.v[l]; return a; }
+static inline F4   f4Mul(F4 a, F4 b)              { for (int l = 0; l < 4; ++l) a.v[l] *= b.v[l]; return a; }
+static inline F4   f4Clamp(F4 a, float lo, float hi) { for (int l = 0; l < 4; ++l) a.v[l] = std::min(std::max(a.v[l], lo), hi); return a; }
+static inline I4   f4Round(F4 a)                  { I4 r; for (int l = 0; l < 4; ++l) r.v[l] = static_cast<int32_t>(std::lrint(a.v[l])); return r; }
+static inline F4   f4FromI4(I4 a)                 { F4 r; for (int l = 0; l < 4; ++l) r.v[l] = static_cast<float>(a.v[l]); return r; }
+
+static inline I4   i4Splat(int32_t x)             { return I4{{x, x, x, x}}; }
+static inline I4   i4Load(const int32_t* p)       { I4 r; std::memcpy(r.v, p, 16); return r; }
+static inline void i4Store(int32_t* p, I4 x)      { std::memcpy(p, x.v, 16); }
+static inline I4   i4Or(I4 a, I4 b)               { for (int l = 0; l < 4; ++l) a.v[l] |= b.v[l]; return a; }
+static inline I4   i4And(I4 a, I4 b)              { for (int l = 0; l < 4; ++l) a.v[l] &= b.v[l]; return a; }
+static inline I4   i4AndNot(I4 m, I4 a)           { for (int l = 0; l < 4; ++l) a.v[l] &= ~m.v[l]; return a; }
+static inline I4   i4Lt(I4 a, I4 b)               { for (int l = 0; l < 4; ++l) a.v[l] = a.v[l] < b.v[l] ? -1 : 0; return a; }
+static inline I4   i4Select(I4 m, I4 a, I4 b)     { for (int l = 0; l < 4; ++l) a.v[l] = (a.v[l] & m.v[l]) | (b.v[l] & ~m.v[l]); return a; }
+template <int N> static inline I4 i4Shl(I4 a)     { for (int l = 0; l < 4; ++l) a.v[l] = static_cast<int32_t>(static_cast<uint32_t>(a.v[l]) << N); return a; }
+template <int N> static inline I4 i4Shr(I4 a)     { for (int l = 0; l < 4; ++l) a.v[l] = static_cast<int32_t>(static_cast<uint32_t>(a.v[l]) >> N); return a; }
+
+static inline I4 i4FromU8(const uint8_t* p)       { return I4{{p[0], p[1], p[2], p[3]}}; }
+static inline I4 i4FromU8Pair(const uint8_t* p)   { return I4{{p[0], p[0], p[1], p[1]}}; }
+
+#endif
+
+// -----------------------------------------------------------------------------
+// Dequantisation: F = (2 * QF + k) * W * qs / 2^shift, truncated toward
+// zero and saturated to [-2048, 2047]; k = sign(QF) for non-intra blocks.
+// Returns the low 16 bits of the coefficient sum (MPEG-2 mismatch control).
+// -----------------------------------------------------------------------------
+
+static int ipuDequant(int16_t* blk, const int16_t* wq, bool intra, int shift) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32((1 << shift) - 1);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m128i lo = _mm_set1_epi16(-2048), hi = _mm_set1_epi16(2047);
+    __m128i sum = zero;
+    for (int i = 0; i < 64; i += 8) {
+        const __m128i q = _mm_load_si128(reinterpret_cast<const __m128i*>(blk + i));
+        __m128i t = _mm_add_epi16(q, q);
+        if (!intra) t = _mm_add_epi16(t, _mm_sub_epi16(_mm_cmpgt_epi16(zero, q), _mm_cmpgt_epi16(q, zero)));
+        const __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(wq + i));
+        const __m128i pl = _mm_mullo_epi16(t, w), ph = _mm_mulhi_epi16(t, w);
+        __m128i p0 = _mm_unpacklo_epi16(pl, ph), p1 = _mm_unpackhi_epi16(pl, ph);
+        p0 = _mm_sra_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), round)), count);
+        p1 = _mm_sra_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), round)), count);
+        const __m128i r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(p0, p1), lo), hi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(blk + i), r);
+        sum = _mm_add_epi16(sum, r);
+    }
+    sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 4));
+    sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 2));
+    return _mm_cvtsi128_si32(sum) & 0xFFFF;
+#elif defined(__ARM_NEON)
+    const int32x4_t count = vdupq_n_s32(-shift), round = vdupq_n_s32((1 << shift) - 1);
+    const int16x8_t lo = vdupq_n_s16(-2048), hi = vdupq_n_s16(2047);
+    int16x8_t sum = vdupq_n_s16(0);
+    for (int i = 0; i < 64; i += 8) {
+        const int16x8_t q = vld1q_s16(blk + i);
+        int16x8_t t = vaddq_s16(q, q);
+        if (!intra) {
+            const int16x8_t s = vsubq_s16(vreinterpretq_s16_u16(vcltq_s16(q, vdupq_n_s16(0))),
+                                          vreinterpretq_s16_u16(vcgtq_s16(q, vdupq_n_s16(0))));
+            t = vsubq_s16(t, s);    // compare masks are -1, so this adds sign(q)
+        }
+        const int16x8_t w = vld1q_s16(wq + i);
+        int32x4_t p0 = vmull_s16(vget_low_s16(t), vget_low_s16(w));
+        int32x4_t p1 = vmull_s16(vget_high_s16(t), vget_high_s16(w));
+        p0 = vshlq_s32(vaddq_s32(p0, vandq_s32(vshrq_n_s32(p0, 31), round)), count);
+        p1 = vshlq_s32(vaddq_s32(p1, vandq_s32(vshrq_n_s32(p1, 31), round)), count);
+        const int16x8_t r = vminq_s16(vmaxq_s16(vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1)), lo), hi);
+        vst1q_s16(blk + i, r);
+        sum = vaddq_s16(sum, r);
+    }
+    int16_t s[8];
+    vst1q_s16(s, sum);
+    int total = 0;
+    for (int i = 0; i < 8; ++i) total += s[i];
+    return total & 0xFFFF;
+#else
+    int total = 0;
+    for (int i = 0; i < 64; ++i) {
+        const int q = blk[i];
+        const int32_t p = (2 * q + (intra ? 0 : (q > 0) - (q < 0))) * wq[i];
+        const int32_t r = (p + ((p >> 31) & ((1 << shift) - 1))) >> shift;
+        blk[i] = static_cast<int16_t>(std::min(std::max(r, -2048), 2047));
+        total += blk[i];
+    }
+    return total & 0xFFFF;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// IDCT: out = M * F * M^T, M[x][u] = C(u) / 2 * cos((2x + 1) u pi / 16)
+// -----------------------------------------------------------------------------
+
+struct IpuIdctBasis {
+    alignas(16) float b[8][8];   // b[u][x] = M[x][u]
+};
+
+static IpuIdctBasis ipuMakeIdct() {
+    IpuIdctBasis t;
+    const double pi = std::acos(-1.0);
+    for (int u = 0; u < 8; ++u)
+        for (int x = 0; x < 8; ++x)
+            t.b[u][x] = static_cast<float>((u ? 0.5 : 0.5 / std::sqrt(2.0)) * std::cos((2 * x + 1) * u * pi / 16));
+    return t;
+}
+static const IpuIdctBasis kIdct = ipuMakeIdct();
+
+// Saturates to [-256, 255]
+static void ipuIdct(int16_t* blk) {
+    alignas(16) float tmp[8][8];
+    bool rowUsed[8];
+    for (int v = 0; v < 8; ++v) {
+        F4 a = f4Zero(), b = f4Zero();
+        rowUsed[v] = false;
+        for (int u = 0; u < 8; ++u) {
+            const int16_t c = blk[v * 8 + u];
+            if (!c) continue;
+            const F4 s = f4Splat(static_cast<float>(c));
+            a = f4Add(a, f4Mul(s, f4Load(kIdct.b[u])));
+            b = f4Add(b, f4Mul(s, f4Load(kIdct.b[u] + 4)));
+            rowUsed[v] = true;
+        }
+        f4Store(tmp[v], a);
+        f4Store(tmp[v] + 4, b);
+    }
+    for (int y = 0; y < 8; ++y) {
+        F4 a = f4Zero(), b = f4Zero();
+        for (int v = 0; v < 8; ++v) {
+            if (!rowUsed[v]) continue;
+            const F4 s = f4Splat(kIdct.b[v][y]);
+            a = f4Add(a, f4Mul(s, f4Load(tmp[v])));
+            b = f4Add(b, f4Mul(s, f4Load(tmp[v] + 4)));
+        }
+        alignas(16) int32_t r[8];
+        i4Store(r, f4Round(f4Clamp(a, -256.0f, 255.0f)));
+        i4Store(r + 4, f4Round(f4Clamp(b, -256.0f, 255.0f)));
+        for (int x = 0; x < 8; ++x) blk[y * 8 + x] = static_cast<int16_t>(r[x]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// VLC tables (ISO/IEC 13818-2 annex B)
+// -----------------------------------------------------------------------------
+
+struct IpuCode { uint16_t code; uint8_t len; int16_t value; };
+struct IpuVlc  { int16_t value; uint8_t len; };
+
+// Direct lookup on the next Bits bits; len 0 marks an invalid code
+template <int Bits>
+struct IpuLut { IpuVlc e[1 << Bits]; };
+
+template <int Bits, size_t N>
+static constexpr IpuLut<Bits> ipuMakeLut(const IpuCode (&codes)[N]) {
+    IpuLut<Bits> t{};
+    for (const IpuCode& c : codes) {
+        const int shift = Bits - c.len;
+        for (uint32_t i = 0; i < (1u << shift); ++i) t.e[(static_cast<uint32_t>(c.code) << shift) | i] = IpuVlc{c.value, c.len};
+    }
+    return t;
+}
+
+static constexpr int16_t IPU_MBAI_ESCAPE = 0x100, IPU_MBAI_STUFFING = 0x101;
+
+// B-1 macroblock_address_increment
+static constexpr IpuCode kMbaiCodes[] = {
+    {0x1, 1, 1}, {0x3, 3, 2}, {0x2, 3, 3}, {0x3, 4, 4}, {0x2, 4, 5}, {0x3, 5, 6}, {0x2, 5, 7},
+    {0x7, 7, 8}, {0x6, 7, 9}, {0xB, 8, 10}, {0xA, 8, 11}, {0x9, 8, 12}, {0x8, 8, 13}, {0x7, 8, 14},
+    {0x6, 8, 15}, {0x17, 10, 16}, {0x16, 10, 17}, {0x15, 10, 18}, {0x14, 10, 19}, {0x13, 10, 20},
+    {0x12, 10, 21}, {0x23, 11, 22}, {0x22, 11, 23}, {0x21, 11, 24}, {0x20, 11, 25}, {0x1F, 11, 26},
+    {0x1E, 11, 27}, {0x1D, 11, 28}, {0x1C, 11, 29}, {0x1B, 11, 30}, {0x1A, 11, 31}, {0x19, 11, 32},
+    {0x18, 11, 33}, {0x08, 11, IPU_MBAI_ESCAPE}, {0x0F, 11, IPU_MBAI_STUFFING},
+};
+
+// macroblock_type flags: 0x01 intra, 0x02 pattern, 0x04 backward, 0x08 forward
+static constexpr int MB_QUANT = 0x10;
+
+// B-2 .. B-4 macroblock_type for I, P, B pictures; D pictures are intra only
+static constexpr IpuCode kMbTypeI[] = {{0x1, 1, 0x01}, {0x1, 2, 0x11}};
+static constexpr IpuCode kMbTypeP[] = {
+    {0x1, 1, 0x0A}, {0x1, 2, 0x02}, {0x1, 3, 0x08}, {0x3, 5, 0x01}, {0x2, 5, 0x1A}, {0x1, 5, 0x12}, {0x1, 6, 0x11},
+};
+static constexpr IpuCode kMbTypeB[] = {
+    {0x2, 2, 0x0C}, {0x3, 2, 0x0E}, {0x2, 3, 0x04}, {0x3, 3, 0x06}, {0x2, 4, 0x08}, {0x3, 4, 0x0A},
+    {0x3, 5, 0x01}, {0x2, 5, 0x1E}, {0x3, 6, 0x1A}, {0x2, 6, 0x16}, {0x1, 6, 0x11},
+};
+static constexpr IpuCode kMbTypeD[] = {{0x1, 1, 0x01}};
+
+// B-9 coded_block_pattern, by pattern value
+static constexpr IpuCode kCbpCodes[] = {
+    {0x01, 9, 0},  {0x0B, 5, 1},  {0x09, 5, 2},  {0x0D, 6, 3},  {0x0D, 4, 4},  {0x17, 7, 5},  {0x13, 7, 6},  {0x1F, 8, 7},
+    {0x0C, 4, 8},  {0x16, 7, 9},  {0x12, 7, 10}, {0x1E, 8, 11}, {0x13, 5, 12}, {0x1B, 8, 13}, {0x17, 8, 14}, {0x13, 8, 15},
+    {0x0B, 4, 16}, {0x15, 7, 17}, {0x11, 7, 18}, {0x1D, 8, 19}, {0x11, 5, 20}, {0x19, 8, 21}, {0x15, 8, 22}, {0x11, 8, 23},
+    {0x0F, 6, 24}, {0x0F, 8, 25}, {0x0D, 8, 26}, {0x03, 9, 27}, {0x0F, 5, 28}, {0x0B, 8, 29}, {0x07, 8, 30}, {0x07, 9, 31},
+    {0x0A, 4, 32}, {0x14, 7, 33}, {0x10, 7, 34}, {0x1C, 8, 35}, {0x0E, 6, 36}, {0x0E, 8, 37}, {0x0C, 8, 38}, {0x02, 9, 39},
+    {0x10, 5, 40}, {0x18, 8, 41}, {0x14, 8, 42}, {0x10, 8, 43}, {0x0E, 5, 44}, {0x0A, 8, 45}, {0x06, 8, 46}, {0x06, 9, 47},
+    {0x12, 5, 48}, {0x1A, 8, 49}, {0x16, 8, 50}, {0x12, 8, 51}, {0x0D, 5, 52}, {0x09, 8, 53}, {0x05, 8, 54}, {0x05, 9, 55},
+    {0x0C, 5, 56}, {0x08, 8, 57}, {0x04, 8, 58}, {0x04, 9, 59}, {0x07, 3, 60}, {0x0A, 5, 61}, {0x08, 5, 62}, {0x0C, 6, 63},
+};
+
+// B-10 motion_code magnitude (a sign bit follows non-zero codes)
+static constexpr IpuCode kMotionCodes[] = {
+    {0x1, 1, 0}, {0x1, 2, 1}, {0x1, 3, 2}, {0x1, 4, 3}, {0x3, 6, 4}, {0x5, 7, 5}, {0x4, 7, 6}, {0x3, 7, 7},
+    {0xB, 9, 8}, {0xA, 9, 9}, {0x9, 9, 10}, {0x11, 10, 11}, {0x10, 10, 12}, {0xF, 10, 13}, {0xE, 10, 14},
+    {0xD, 10, 15}, {0xC, 10, 16},
+};
+
+// B-11 dmvector
+static constexpr IpuCode kDmvCodes[] = {{0x0, 1, 0}, {0x2, 2, 1}, {0x3, 2, -1}};
+
+// B-12/B-13 dct_dc_size
+static constexpr IpuCode kDcLumaCodes[] = {
+    {0x4, 3, 0}, {0x0, 2, 1}, {0x1, 2, 2}, {0x5, 3, 3}, {0x6, 3, 4}, {0xE, 4, 5},
+    {0x1E, 5, 6}, {0x3E, 6, 7}, {0x7E, 7, 8}, {0xFE, 8, 9}, {0x1FE, 9, 10}, {0x1FF, 9, 11},
+};
+static constexpr IpuCode kDcChromaCodes[] = {
+    {0x0, 2, 0}, {0x1, 2, 1}, {0x2, 2, 2}, {0x6, 3, 3}, {0xE, 4, 4}, {0x1E, 5, 5},
+    {0x3E, 6, 6}, {0x7E, 7, 7}, {0xFE, 8, 8}, {0x1FE, 9, 9}, {0x3FE, 10, 10}, {0x3FF, 10, 11},
+};
+
+static constexpr IpuLut<11> kMbai     = ipuMakeLut<11>(kMbaiCodes);
+static constexpr IpuLut<6>  kMbTypes[4] = {ipuMakeLut<6>(kMbTypeI), ipuMakeLut<6>(kMbTypeP), ipuMakeLut<6>(kMbTypeB), ipuMakeLut<6>(kMbTypeD)};
+static constexpr IpuLut<9>  kCbp      = ipuMakeLut<9>(kCbpCodes);
+static constexpr IpuLut<10> kMotion   = ipuMakeLut<10>(kMotionCodes);
+static constexpr IpuLut<2>  kDmv      = ipuMakeLut<2>(kDmvCodes);
+static constexpr IpuLut<9>  kDcLuma   = ipuMakeLut<9>(kDcLumaCodes);
+static constexpr IpuLut<10> kDcChroma = ipuMakeLut<10>(kDcChromaCodes);
+
+// B-14/B-15 dct_coefficient: 113 codes each (111 run/level pairs, escape,
+// end of block), a sign bit follows the pairs. Codes longer than 8 bits all
+// start with six zeros, so the first level looks at 8 bits and the second at
+// the 10 bits after that prefix.
+static constexpr uint8_t IPU_DCT_EOB = 64, IPU_DCT_ESCAPE = 65;
+
+struct IpuDctCode { uint16_t code; uint8_t len; };
+struct IpuDct     { uint8_t run, level, len; };
+struct IpuDctLut  { IpuDct l1[256]; IpuDct l2[1024]; };
+
+static constexpr IpuDctCode kDctB14[113] = {
+    {0x3, 2}, {0x4, 4}, {0x5, 5}, {0x6, 7}, {0x26, 8}, {0x21, 8}, {0xA, 10}, {0x1D, 12},
+    {0x18, 12}, {0x13, 12}, {0x10, 12}, {0x1A, 13}, {0x19, 13}, {0x18, 13}, {0x17, 13}, {0x1F, 14},
+    {0x1E, 14}, {0x1D, 14}, {0x1C, 14}, {0x1B, 14}, {0x1A, 14}, {0x19, 14}, {0x18, 14}, {0x17, 14},
+    {0x16, 14}, {0x15, 14}, {0x14, 14}, {0x13, 14}, {0x12, 14}, {0x11, 14}, {0x10, 14}, {0x18, 15},
+    {0x17, 15}, {0x16, 15}, {0x15, 15}, {0x14, 15}, {0x13, 15}, {0x12, 15}, {0x11, 15}, {0x10, 15},
+    {0x3, 3}, {0x6, 6}, {0x25, 8}, {0xC, 10}, {0x1B, 12}, {0x16, 13}, {0x15, 13}, {0x1F, 15},
+    {0x1E, 15}, {0x1D, 15}, {0x1C, 15}, {0x1B, 15}, {0x1A, 15}, {0x19, 15}, {0x13, 16}, {0x12, 16},
+    {0x11, 16}, {0x10, 16}, {0x5, 4}, {0x4, 7}, {0xB, 10}, {0x14, 12}, {0x14, 13}, {0x7, 5},
+    {0x24, 8}, {0x1C, 12}, {0x13, 13}, {0x6, 5}, {0xF, 10}, {0x12, 12}, {0x7, 6}, {0x9, 10},
+    {0x12, 13}, {0x5, 6}, {0x1E, 12}, {0x14, 16}, {0x4, 6}, {0x15, 12}, {0x7, 7}, {0x11, 12},
+    {0x5, 7}, {0x11, 13}, {0x27, 8}, {0x10, 13}, {0x23, 8}, {0x1A, 16}, {0x22, 8}, {0x19, 16},
+    {0x20, 8}, {0x18, 16}, {0xE, 10}, {0x17, 16}, {0xD, 10}, {0x16, 16}, {0x8, 10}, {0x15, 16},
+    {0x1F, 12}, {0x1A, 12}, {0x19, 12}, {0x17, 12}, {0x16, 12}, {0x1F, 13}, {0x1E, 13}, {0x1D, 13},
+    {0x1C, 13}, {0x1B, 13}, {0x1F, 16}, {0x1E, 16}, {0x1D, 16}, {0x1C, 16}, {0x1B, 16},
+    {0x1, 6}, {0x2, 2},
+};
+static constexpr IpuDctCode kDctB15[113] = {
+    {0x2, 2}, {0x6, 3}, {0x7, 4}, {0x1C, 5}, {0x1D, 5}, {0x5, 6}, {0x4, 6}, {0x7B, 7},
+    {0x7C, 7}, {0x23, 8}, {0x22, 8}, {0xFA, 8}, {0xFB, 8}, {0xFE, 8}, {0xFF, 8}, {0x1F, 14},
+    {0x1E, 14}, {0x1D, 14}, {0x1C, 14}, {0x1B, 14}, {0x1A, 14}, {0x19, 14}, {0x18, 14}, {0x17, 14},
+    {0x16, 14}, {0x15, 14}, {0x14, 14}, {0x13, 14}, {0x12, 14}, {0x11, 14}, {0x10, 14}, {0x18, 15},
+    {0x17, 15}, {0x16, 15}, {0x15, 15}, {0x14, 15}, {0x13, 15}, {0x12, 15}, {0x11, 15}, {0x10, 15},
+    {0x2, 3}, {0x6, 5}, {0x79, 7}, {0x27, 8}, {0x20, 8}, {0x16, 13}, {0x15, 13}, {0x1F, 15},
+    {0x1E, 15}, {0x1D, 15}, {0x1C, 15}, {0x1B, 15}, {0x1A, 15}, {0x19, 15}, {0x13, 16}, {0x12, 16},
+    {0x11, 16}, {0x10, 16}, {0x5, 5}, {0x7, 7}, {0xFC, 8}, {0xC, 10}, {0x14, 13}, {0x7, 5},
+    {0x26, 8}, {0x1C, 12}, {0x13, 13}, {0x6, 6}, {0xFD, 8}, {0x12, 12}, {0x7, 6}, {0x4, 9},
+    {0x12, 13}, {0x6, 7}, {0x1E, 12}, {0x14, 16}, {0x4, 7}, {0x15, 12}, {0x5, 7}, {0x11, 12},
+    {0x78, 7}, {0x11, 13}, {0x7A, 7}, {0x10, 13}, {0x21, 8}, {0x1A, 16}, {0x25, 8}, {0x19, 16},
+    {0x24, 8}, {0x18, 16}, {0x5, 9}, {0x17, 16}, {0x7, 9}, {0x16, 16}, {0xD, 10}, {0x15, 16},
+    {0x1F, 12}, {0x1A, 12}, {0x19, 12}, {0x17, 12}, {0x16, 12}, {0x1F, 13}, {0x1E, 13}, {0x1D, 13},
+    {0x1C, 13}, {0x1B, 13}, {0x1F, 16}, {0x1E, 16}, {0x1D, 16}, {0x1C, 16}, {0x1B, 16},
+    {0x1, 6}, {0x6, 4},
+};
+
+// Run/level of the first 111 codes, shared by both tables
+static constexpr uint8_t kDctRun[111] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3,
+    3, 3, 3, 4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15, 16, 16,
+    17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+};
+static constexpr uint8_t kDctLevel[111] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+    33, 34, 35, 36, 37, 38, 39, 40, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 1, 2, 3, 4, 5, 1,
+    2, 3, 4, 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static constexpr IpuDctLut ipuMakeDctLut(const IpuDctCode (&codes)[113]) {
+    IpuDctLut t{};
+    for (int i = 0; i < 113; ++i) {
+        const IpuDct e{i < 111 ? kDctRun[i] : (i == 111 ? IPU_DCT_ESCAPE : IPU_DCT_EOB),
+                       i < 111 ? kDctLevel[i] : uint8_t(0), codes[i].len};
+        const uint32_t code16 = static_cast<uint32_t>(codes[i].code) << (16 - codes[i].len);
+        if (codes[i].len <= 8) {
+            for (uint32_t j = 0; j < (1u << (8 - codes[i].len)); ++j) t.l1[(code16 >> 8) + j] = e;
+        } else {
+            for (uint32_t j = 0; j < (1u << (16 - codes[i].len)); ++j) t.l2[(code16 & 0x3FF) + j] = e;
+        }
+    }
+    return t;
+}
+static constexpr IpuDctLut kDctLut[2] = {ipuMakeDctLut(kDctB14), ipuMakeDctLut(kDctB15)};
+
+// Scan order: raster position of the i-th coefficient
+static constexpr uint8_t kScan[2][64] = {
+    {0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+     35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63},
+    {0, 8, 16, 24, 1, 9, 2, 10, 17, 25, 32, 40, 48, 56, 57, 49, 41, 33, 26, 18, 3, 11, 4, 12, 19, 27, 34, 42, 50, 58, 35, 43,
+     51, 59, 20, 28, 5, 13, 6, 14, 21, 29, 36, 44, 52, 60, 37, 45, 53, 61, 22, 30, 7, 15, 23, 31, 38, 46, 54, 62, 39, 47, 55, 63},
+};
+
+static constexpr uint8_t kNonLinearQs[32] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 18, 20, 22, 24, 28, 32, 36, 40, 44, 48, 52, 56, 64, 72, 80, 88, 96, 104, 112,
+};
+
+// Raster order
+static constexpr uint8_t kDefaultIntra[64] = {
+    8, 16, 19, 22, 26, 27, 29, 34, 16, 16, 22, 24, 27, 29, 34, 37, 19, 22, 26, 27, 29, 34, 34, 38, 22, 22, 26, 27, 29, 34, 37, 40,
+    22, 26, 27, 29, 32, 35, 40, 48, 26, 27, 29, 32, 35, 40, 48, 58, 26, 27, 29, 34, 38, 46, 56, 69, 27, 29, 35, 38, 46, 56, 69, 83,
+};
+
+// -----------------------------------------------------------------------------
+// Bitstream reader over the input FIFO. Reads past the data hit the zero
+// slack and mark the reader starved; the command is then retried later.
+// -----------------------------------------------------------------------------
+
+// Zero bytes kept after the input: an 8-byte peek from a bit pointer up to
+// 127 bits past the data (BCLR on an empty FIFO) stays in bounds
+static constexpr size_t IPU_SLACK = 24;
+
+struct IpuBits {
+    const uint8_t* data;
+    size_t pos, end;            // in bits
+    bool starved = false;
+
+    uint32_t peek(uint32_t n) const {
+        uint64_t w;
+        std::memcpy(&w, data + (pos >> 3), 8);
+        w = __builtin_bswap64(w) << (pos & 7);
+        return static_cast<uint32_t>(w >> (64 - n));
+    }
+    void skip(uint32_t n) {
+        if (pos + n > end) { starved = true; return; }
+        pos += n;
+    }
+    uint32_t get(uint32_t n) { const uint32_t v = peek(n); skip(n); return v; }
+    size_t avail() const { return end > pos ? end - pos : 0; }
+    void align() { skip((8 - (pos & 7)) & 7); }
+};
+
+// An invalid code in the zero slack only means the data is not here yet
+template <int Bits>
+static inline IpuVlc ipuGetVlc(IpuBits& b, const IpuLut<Bits>& t) {
+    const IpuVlc e = t.e[b.peek(Bits)];
+    if (e.len) b.skip(e.len);
+    else if (b.avail() < Bits) b.starved = true;
+    return e;
+}
+
+// Signed dct_dc_differential of `size` bits
+static inline int ipuGetDcDiff(IpuBits& b, int size) {
+    if (!size) return 0;
+    const int v = static_cast<int>(b.get(size));
+    return v < (1 << (size - 1)) ? v - (1 << size) + 1 : v;
+}
+
+// Full macroblock_address_increment, escapes and stuffing included
+static int ipuGetMbai(IpuBits& b) {
+    int inc = 0;
+    for (;;) {
+        const IpuVlc e = ipuGetVlc(b, kMbai);
+        if (!e.len || b.starved) return -1;
+        if (e.value == IPU_MBAI_STUFFING) continue;
+        if (e.value == IPU_MBAI_ESCAPE) { inc += 33; continue; }
+        return inc + e.value;
+    }
+}
+
+static inline bool ipuAtStartCode(const IpuBits& b) {
+    return b.avail() >= 24 && b.peek(23) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Decoding
+// -----------------------------------------------------------------------------
+
+enum class IpuRun { Done, Starved };
+
+struct IpuMacroblock {
+    alignas(16) int16_t blk[6][64];
+    alignas(16) int16_t wqIntra[64], wqNonIntra[64];
+    int qsc = -1;
+};
+
+static inline uint32_t ipuIdp(const IPU& p) { return (p.ctrl >> 16) & 3; }
+static inline bool     ipuMpeg1(const IPU& p) { return (p.ctrl & IPU_CTRL_MP1) != 0; }
+
+static void ipuResetDc(IPU& p) {
+    const int32_t v = ipuMpeg1(p) ? 128 : 1 << (7 + ipuIdp(p));
+    p.dcPred[0] = p.dcPred[1] = p.dcPred[2] = v;
+}
+
+// Weight x quantiser scale per coefficient, rebuilt when the scale changes
+static void ipuSetQuant(const IPU& p, IpuMacroblock& mb, int qsc) {
+    if (mb.qsc == qsc) return;
+    mb.qsc = qsc;
+    const int qs = ipuMpeg1(p) ? qsc : (p.ctrl & IPU_CTRL_QST) ? kNonLinearQs[qsc] : qsc * 2;
+    for (int i = 0; i < 64; ++i) {
+        mb.wqIntra[i] = static_cast<int16_t>(p.iqIntra[i] * qs);
+        mb.wqNonIntra[i] = static_cast<int16_t>(p.iqNonIntra[i] * qs);
+    }
+}
+
+// One block: VLC decode into raster order, dequantise, IDCT. False on a
+// malformed code (sets ECD).
+static bool ipuDecodeBlock(IPU& p, IpuBits& b, IpuMacroblock& mb, int n, bool intra) {
+    int16_t* blk = mb.blk[n];
+    std::memset(blk, 0, 64 * sizeof(int16_t));
+    const bool mpeg1 = ipuMpeg1(p);
+    const uint8_t* scan = kScan[!mpeg1 && (p.ctrl & IPU_CTRL_AS) ? 1 : 0];
+    const IpuDctLut& lut = kDctLut[intra && !mpeg1 && (p.ctrl & IPU_CTRL_IVF) ? 1 : 0];
+
+    int i = 0, dc = 0;
+    if (intra) {
+        const int comp = n < 4 ? 0 : n - 3;
+        const IpuVlc size = comp ? ipuGetVlc(b, kDcChroma) : ipuGetVlc(b, kDcLuma);
+        if (b.starved) return true;
+        if (!size.len) { p.ctrl |= IPU_CTRL_ECD; return false; }
+        p.dcPred[comp] += ipuGetDcDiff(b, size.value);
+        dc = p.dcPred[comp];
+        i = 1;
+    } else if (b.peek(1)) {
+        // First coefficient of a non-intra block: '1s' is run 0, level 1
+        blk[scan[0]] = b.peek(2) & 1 ? -1 : 1;
+        b.skip(2);
+        i = 1;
+    }
+
+    for (;;) {
+        if (b.starved) return true;
+        const uint32_t bits = b.peek(16);
+        const IpuDct& e = (bits >> 10) ? lut.l1[bits >> 8] : lut.l2[bits & 0x3FF];
+        if (!e.len) {
+            if (b.avail() < 16) { b.starved = true; return true; }
+            p.ctrl |= IPU_CTRL_ECD;
+            return false;
+        }
+        b.skip(e.len);
+        if (e.run == IPU_DCT_EOB) break;
+        int run, level;
+        if (e.run == IPU_DCT_ESCAPE) {
+            run = static_cast<int>(b.get(6));
+            if (mpeg1) {
+                level = static_cast<int8_t>(b.get(8));
+                if (level == 0) level = static_cast<int>(b.get(8));
+                else if (level == -128) level = static_cast<int>(b.get(8)) - 256;
+            } else {
+                level = static_cast<int>(b.get(12) << 20) >> 20;
+            }
+        } else {
+            run = e.run;
+            level = b.get(1) ? -e.level : e.level;
+        }
+        i += run;
+        if (i > 63) { p.ctrl |= IPU_CTRL_ECD; return false; }
+        blk[scan[i++]] = static_cast<int16_t>(level);
+    }
+
+    const int sum = ipuDequant(blk, intra ? mb.wqIntra : mb.wqNonIntra, intra, mpeg1 ? 4 : 5);
+    if (intra) {
+        const int old = blk[0];
+        blk[0] = static_cast<int16_t>(dc * (mpeg1 ? 8 : 8 >> ipuIdp(p)));
+        if (!mpeg1 && !((sum - old + blk[0]) & 1)) blk[63] ^= 1;
+    } else if (!mpeg1 && !(sum & 1)) {
+        blk[63] ^= 1;
+    }
+    if (mpeg1) {
+        // Oddification toward zero
+        for (int k = intra ? 1 : 0; k < 64; ++k)
+            if (blk[k] && !(blk[k] & 1)) blk[k] = static_cast<int16_t>(blk[k] - (blk[k] > 0 ? 1 : -1));
+    }
+    ipuIdct(blk);
+    ++p.blocks;
+    return true;
+}
+
+// Luma row of block n, row r (frame or field DCT)
+static inline int ipuLumaRow(int n, int r, bool field) {
+    return field ? r * 2 + (n >> 1) : (n >> 1) * 8 + r;
+}
+
+// 16x16 Y, 8x8 Cb, 8x8 Cr
+struct IpuRaw8 { alignas(16) uint8_t y[256], cb[64], cr[64]; };
+
+static void ipuToRaw8(const IpuMacroblock& mb, bool field, IpuRaw8& raw) {
+    auto px = [](int16_t v) { return static_cast<uint8_t>(std::min(std::max<int>(v, 0), 255)); };
+    for (int n = 0; n < 4; ++n)
+        for (int r = 0; r < 8; ++r)
+            for (int x = 0; x < 8; ++x) raw.y[ipuLumaRow(n, r, field) * 16 + (n & 1) * 8 + x] = px(mb.blk[n][r * 8 + x]);
+    for (int i = 0; i < 64; ++i) { raw.cb[i] = px(mb.blk[4][i]); raw.cr[i] = px(mb.blk[5][i]); }
+}
+
+static void ipuPutRaw16(const IpuMacroblock& mb, bool field, std::vector<uint32_t>& out) {
+    alignas(16) int16_t raw[384];
+    for (int n = 0; n < 4; ++n)
+        for (int r = 0; r < 8; ++r)
+            std::memcpy(&raw[ipuLumaRow(n, r, field) * 16 + (n & 1) * 8], &mb.blk[n][r * 8], 16);
+    std::memcpy(raw + 256, mb.blk[4], 128);
+    std::memcpy(raw + 320, mb.blk[5], 128);
+    const size_t at = out.size();
+    out.resize(at + 192);
+    std::memcpy(&out[at], raw, sizeof(raw));
+}
+
+// -----------------------------------------------------------------------------
+// Colour space conversion (ITU-R BT.601), four pixels per vector. Pixels
+// below TH0 on all channels become transparent black, below TH1 half alpha.
+// RGB16 can add the 4x4 ordered dither before dropping to 5 bits.
+// -----------------------------------------------------------------------------
+
+static constexpr float kDither[4][4] = {{-4, 0, -3, 1}, {2, -2, 3, -1}, {-3, 1, -4, 0}, {3, -1, 2, -2}};
+
+static void ipuCsc(const IPU& p, const IpuRaw8& raw, bool rgb16, bool dither, std::vector<uint32_t>& out) {
+    const size_t at = out.size();
+    out.resize(at + (rgb16 ? 128 : 256));
+    uint32_t* o32 = &out[at];
+    const I4 th0 = i4Splat(p.th0), th1 = i4Splat(p.th1);
+    const I4 half = i4Splat(0x40), full = i4Splat(0x80);
+    const F4 c16 = f4Splat(-16.0f), c128 = f4Splat(-128.0f);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; x += 4) {
+            const F4 yy = f4Mul(f4Add(f4FromI4(i4FromU8(&raw.y[y * 16 + x])), c16), f4Splat(1.164f));
+            const F4 cb = f4Add(f4FromI4(i4FromU8Pair(&raw.cb[(y >> 1) * 8 + (x >> 1)])), c128);
+            const F4 cr = f4Add(f4FromI4(i4FromU8Pair(&raw.cr[(y >> 1) * 8 + (x >> 1)])), c128);
+            F4 r = f4Add(yy, f4Mul(cr, f4Splat(1.596f)));
+            F4 g = f4Add(yy, f4Add(f4Mul(cb, f4Splat(-0.391f)), f4Mul(cr, f4Splat(-0.813f))));
+            F4 b = f4Add(yy, f4Mul(cb, f4Splat(2.018f)));
+            I4 ri = f4Round(f4Clamp(r, 0.0f, 255.0f));
+            I4 gi = f4Round(f4Clamp(g, 0.0f, 255.0f));
+            I4 bi = f4Round(f4Clamp(b, 0.0f, 255.0f));
+            const I4 lt0 = i4And(i4And(i4Lt(ri, th0), i4Lt(gi, th0)), i4Lt(bi, th0));
+            const I4 lt1 = i4And(i4And(i4Lt(ri, th1), i4Lt(gi, th1)), i4Lt(bi, th1));
+            const I4 a = i4AndNot(lt0, i4Select(lt1, half, full));
+            if (!rgb16) {
+                const I4 px = i4AndNot(lt0, i4Or(i4Or(ri, i4Shl<8>(gi)), i4Shl<16>(bi)));
+                i4Store(reinterpret_cast<int32_t*>(o32 + y * 16 + x), i4Or(px, i4Shl<24>(a)));
+                continue;
+            }
+            if (dither) {
+                const F4 d = f4Load(kDither[y & 3]);
+                ri = f4Round(f4Clamp(f4Add(r, d), 0.0f, 255.0f));
+                gi = f4Round(f4Clamp(f4Add(g, d), 0.0f, 255.0f));
+                bi = f4Round(f4Clamp(f4Add(b, d), 0.0f, 255.0f));
+            }
+            const I4 px = i4Or(i4Or(i4Shr<3>(ri), i4Shl<2>(i4Shr<3>(gi))), i4Shl<7>(i4Shr<3>(bi)));
+            alignas(16) int32_t v[4];
+            i4Store(v, i4Or(i4AndNot(lt0, px), i4Shl<8>(i4And(a, i4Splat(0x80)))));
+            const int idx = y * 16 + x;
+            for (int l = 0; l < 4; ++l) {
+                const uint32_t w = static_cast<uint16_t>(v[l]);
+                uint32_t& word = o32[(idx + l) >> 1];
+                word = ((idx + l) & 1) ? (word & 0xFFFFu) | w << 16 : w;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Commands
+// -----------------------------------------------------------------------------
+
+static IpuRun ipuIdec(IPU& p, IpuBits& b, std::vector<uint32_t>& out) {
+    const uint32_t c = p.cmd;
+    b.skip(c & 0x3F);
+    const bool dtd = (c >> 24) & 1, dither = (c >> 26) & 1, rgb16 = (c >> 27) & 1;
+    IpuMacroblock mb;
+    IpuRaw8 raw;
+    int qsc = (c >> 16) & 0x1F;
+    ipuResetDc(p);
+    for (;;) {
+        const IpuVlc type = ipuGetVlc(b, kMbTypes[0]);
+        if (b.starved) return IpuRun::Starved;
+        if (!type.len) { p.ctrl |= IPU_CTRL_ECD; return IpuRun::Done; }
+        if (type.value & MB_QUANT) qsc = static_cast<int>(b.get(5));
+        const bool field = dtd && b.get(1);
+        ipuSetQuant(p, mb, qsc);
+        for (int n = 0; n < 6; ++n)
+            if (!ipuDecodeBlock(p, b, mb, n, true)) return IpuRun::Done;
+        if (b.starved) return IpuRun::Starved;
+        ipuToRaw8(mb, field, raw);
+        ipuCsc(p, raw, rgb16, dither, out);
+        ++p.macroblocks;
+        ++p.cscMacroblocks;
+
+        // The slice ends at the next start code
+        if (b.avail() < 24) return IpuRun::Starved;
+        if (ipuAtStartCode(b)) { p.ctrl |= IPU_CTRL_SCD; return IpuRun::Done; }
+        const int inc = ipuGetMbai(b);
+        if (b.starved) return IpuRun::Starved;
+        if (inc < 0) { p.ctrl |= IPU_CTRL_ECD; return IpuRun::Done; }
+        if (inc > 1) ipuResetDc(p);
+    }
+}
+
+static IpuRun ipuBdec(IPU& p, IpuBits& b, std::vector<uint32_t>& out) {
+    const uint32_t c = p.cmd;
+    b.skip(c & 0x3F);
+    const bool field = (c >> 25) & 1, intra = (c >> 27) & 1;
+    if ((c >> 26) & 1) ipuResetDc(p);
+    IpuMacroblock mb;
+    ipuSetQuant(p, mb, (c >> 16) & 0x1F);
+    uint32_t cbp = 0x3F;
+    if (!intra) {
+        const IpuVlc e = ipuGetVlc(b, kCbp);
+        if (b.starved) return IpuRun::Starved;
+        if (!e.len) { p.ctrl |= IPU_CTRL_ECD; return IpuRun::Done; }
+        cbp = static_cast<uint32_t>(e.value);
+    }
+    p.ctrl = (p.ctrl & ~(0x3Fu << 8)) | cbp << 8;
+    for (int n = 0; n < 6; ++n) {
+        if (!(cbp & (32 >> n))) { std::memset(mb.blk[n], 0, sizeof(mb.blk[n])); continue; }
+        if (!ipuDecodeBlock(p, b, mb, n, intra)) return IpuRun::Done;
+    }
+    if (b.starved) return IpuRun::Starved;
+    ipuPutRaw16(mb, field, out);
+    ++p.macroblocks;
+    return IpuRun::Done;
+}
+
+// Symbol in the low 16 bits, code length in bits 16-21
+static IpuRun ipuVdec(IPU& p, IpuBits& b) {
+    const uint32_t c = p.cmd;
+    b.skip(c & 0x3F);
+    const size_t start = b.pos;
+    int value = 0;
+    bool ok = true;
+    switch ((c >> 26) & 3) {
+        case 0:
+            value = ipuGetMbai(b);
+            ok = value >= 0;
+            break;
+        case 1: {
+            const uint32_t pct = (p.ctrl >> 24) & 7;
+            const IpuVlc e = ipuGetVlc(b, kMbTypes[pct >= 1 && pct <= 4 ? pct - 1 : 0]);
+            value = e.value;
+            ok = e.len != 0;
+            break;
+        }
+        case 2: {
+            const IpuVlc e = ipuGetVlc(b, kMotion);
+            value = e.value;
+            ok = e.len != 0;
+            if (ok && value && b.get(1)) value = -value;
+            break;
+        }
+        default: {
+            const IpuVlc e = ipuGetVlc(b, kDmv);
+            value = e.value;
+            ok = e.len != 0;
+            break;
+        }
+    }
+    if (b.starved) return IpuRun::Starved;
+    if (!ok) p.ctrl |= IPU_CTRL_ECD;
+    p.result = (static_cast<uint32_t>(value) & 0xFFFF) | static_cast<uint32_t>(b.pos - start) << 16;
+    if (ipuAtStartCode(b)) p.ctrl |= IPU_CTRL_SCD;
+    return IpuRun::Done;
+}
+
+static IpuRun ipuFdec(IPU& p, IpuBits& b) {
+    b.skip(p.cmd & 0x3F);
+    if (b.starved || b.avail() < 32) return IpuRun::Starved;
+    p.result = b.peek(32);
+    if (ipuAtStartCode(b)) p.ctrl |= IPU_CTRL_SCD;
+    return IpuRun::Done;
+}
+
+// The matrix arrives in zigzag order
+static IpuRun ipuSetIq(IPU& p, IpuBits& b) {
+    b.skip(p.cmd & 0x3F);
+    if (b.starved || b.avail() < 64 * 8) return IpuRun::Starved;
+    uint8_t* m = (p.cmd >> 27) & 1 ? p.iqNonIntra : p.iqIntra;
+    for (int i = 0; i < 64; ++i) m[kScan[0][i]] = static_cast<uint8_t>(b.get(8));
+    return IpuRun::Done;
+}
+
+static IpuRun ipuSetVq(IPU& p, IpuBits& b) {
+    b.skip(p.cmd & 0x3F);
+    if (b.starved || b.avail() < 16 * 16) return IpuRun::Starved;
+    for (uint16_t& e : p.vqclut) e = static_cast<uint16_t>(b.get(16));
+    return IpuRun::Done;
+}
+
+static IpuRun ipuCscCmd(IPU& p, IpuBits& b, std::vector<uint32_t>& out) {
+    const uint32_t c = p.cmd, count = c & 0x7FF;
+    b.align();
+    if (b.avail() < static_cast<size_t>(count) * 384 * 8) return IpuRun::Starved;
+    IpuRaw8 raw;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memcpy(&raw, b.data + (b.pos >> 3), 384);
+        b.skip(384 * 8);
+        ipuCsc(p, raw, (c >> 27) & 1, (c >> 26) & 1, out);
+        ++p.cscMacroblocks;
+    }
+    return IpuRun::Done;
+}
+
+// RGB32 to RGB16, or to 4-bit indices into the VQ CLUT (nearest colour)
+static IpuRun ipuPack(IPU& p, IpuBits& b, std::vector<uint32_t>& out) {
+    const uint32_t c = p.cmd, count = c & 0x7FF;
+    const bool rgb16 = (c >> 27) & 1, dither = (c >> 26) & 1;
+    b.align();
+    if (b.avail() < static_cast<size_t>(count) * 1024 * 8) return IpuRun::Starved;
+    for (uint32_t m = 0; m < count; ++m) {
+        const uint8_t* src = b.data + (b.pos >> 3);
+        b.skip(1024 * 8);
+        uint16_t px16[256];
+        for (int i = 0; i < 256; ++i) {
+            const int d = dither && rgb16 ? static_cast<int>(kDither[(i >> 4) & 3][i & 3]) : 0;
+            const int r = std::min(std::max(src[i * 4 + 0] + d, 0), 255) >> 3;
+            const int g = std::min(std::max(src[i * 4 + 1] + d, 0), 255) >> 3;
+            const int bl = std::min(std::max(src[i * 4 + 2] + d, 0), 255) >> 3;
+            px16[i] = static_cast<uint16_t>(r | g << 5 | bl << 10 | (src[i * 4 + 3] & 0x80) << 8);
+        }
+        const size_t at = out.size();
+        if (rgb16) {
+            out.resize(at + 128);
+            std::memcpy(&out[at], px16, sizeof(px16));
+            continue;
+        }
+        out.resize(at + 32);
+        uint8_t idx[128] = {0};
+        for (int i = 0; i < 256; ++i) {
+            int best = 0, bestDist = 1 << 30;
+            for (int k = 0; k < 16; ++k) {
+                const int dr = (px16[i] & 0x1F) - (p.vqclut[k] & 0x1F);
+                const int dg = ((px16[i] >> 5) & 0x1F) - ((p.vqclut[k] >> 5) & 0x1F);
+                const int db = ((px16[i] >> 10) & 0x1F) - ((p.vqclut[k] >> 10) & 0x1F);
+                const int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) { bestDist = dist; best = k; }
+            }
+            idx[i >> 1] |= static_cast<uint8_t>(best << ((i & 1) * 4));
+        }
+        std::memcpy(&out[at], idx, sizeof(idx));
+    }
+    return IpuRun::Done;
+}
+
+// Drop consumed input once it is far behind the read position
+static void ipuCompactInput(IPU& p) {
+    const size_t bytes = (p.bitPos >> 3) & ~size_t(15);
+    if (bytes < 4096 && bytes != p.inSize) return;
+    p.in.erase(p.in.begin(), p.in.begin() + static_cast<ptrdiff_t>(bytes));
+    p.inSize -= bytes;
+    p.bitPos -= bytes * 8;
+}
+
+// Run the pending command against the input so far; on starvation nothing
+// is committed and the command stays busy
+static void ipuTryCommand(IPU& p) {
+    if (!p.busy) return;
+    const uint32_t op = p.cmd >> 28;
+    if (op == IPU_BCLR || op == IPU_SETTH) {
+        if (op == IPU_BCLR) {
+            p.in.assign(IPU_SLACK, 0);
+            p.inSize = 0;
+            p.bitPos = p.cmd & 0x7F;
+        } else {
+            p.th0 = p.cmd & 0x1FF;
+            p.th1 = (p.cmd >> 16) & 0x1FF;
+        }
+        p.busy = false;
+        p.irq = true;
+        return;
+    }
+
+    IpuBits b{p.in.data(), p.bitPos, p.inSize * 8};
+    std::vector<uint32_t> out;
+    const uint32_t ctrl = p.ctrl;
+    int32_t dc[3];
+    std::memcpy(dc, p.dcPred, sizeof(dc));
+    const uint64_t mbs = p.macroblocks, blocks = p.blocks, csc = p.cscMacroblocks;
+
+    IpuRun r = IpuRun::Done;
+    switch (op) {
+        case IPU_IDEC:  r = ipuIdec(p, b, out); break;
+        case IPU_BDEC:  r = ipuBdec(p, b, out); break;
+        case IPU_VDEC:  r = ipuVdec(p, b); break;
+        case IPU_FDEC:  r = ipuFdec(p, b); break;
+        case IPU_SETIQ: r = ipuSetIq(p, b); break;
+        case IPU_SETVQ: r = ipuSetVq(p, b); break;
+        case IPU_CSC:   r = ipuCscCmd(p, b, out); break;
+        case IPU_PACK:  r = ipuPack(p, b, out); break;
+        default:        break;
+    }
+    if (r == IpuRun::Starved) {
+        p.ctrl = ctrl;
+        std::memcpy(p.dcPred, dc, sizeof(dc));
+        p.macroblocks = mbs; p.blocks = blocks; p.cscMacroblocks = csc;
+        return;
+    }
+    p.bitPos = b.pos;
+    if (p.outHead == p.out.size()) { p.out.clear(); p.outHead = 0; }
+    p.out.insert(p.out.end(), out.begin(), out.end());
+    p.busy = false;
+    p.irq = true;
+    ipuCompactInput(p);
+}
+
+// -----------------------------------------------------------------------------
+// Registers and DMA
+// -----------------------------------------------------------------------------
+
+void ipuReset(IPU& p) {
+    p.ctrl = 0;
+    p.cmd = p.result = 0;
+    p.busy = p.irq = false;
+    p.in.assign(IPU_SLACK, 0);
+    p.inSize = 0;
+    p.bitPos = 0;
+    p.out.clear();
+    p.outHead = 0;
+    ipuResetDc(p);
+}
+
+void ipuInit(IPU& p) {
+    ipuReset(p);
+    std::memcpy(p.iqIntra, kDefaultIntra, 64);
+    std::memset(p.iqNonIntra, 16, 64);
+    std::memset(p.vqclut, 0, sizeof(p.vqclut));
+    p.th0 = p.th1 = 0;
+    p.macroblocks = p.blocks = p.cscMacroblocks = 0;
+}
+
+// FIFO levels in qwords, as IPU_CTRL/IPU_BP report them (8 deep)
+static inline uint32_t ipuInFifo(const IPU& p)  { return std::min<uint32_t>(static_cast<uint32_t>((p.inSize * 8 - std::min(p.bitPos, p.inSize * 8)) / 128), 8); }
+static inline uint32_t ipuOutFifo(const IPU& p) { return std::min<uint32_t>(static_cast<uint32_t>((p.out.size() - p.outHead) / 4), 8); }
+
+uint32_t ipuReadReg(IPU& p, uint32_t offset) {
+    switch (offset) {
+        case 0x00: return p.result;                                     // IPU_CMD data
+        case 0x04: return p.busy ? IPU_CTRL_BUSY : 0;
+        case 0x10:                                                      // IPU_CTRL
+            return (p.ctrl & ~(IPU_CTRL_BUSY | 0xFFu)) | ipuInFifo(p) | ipuOutFifo(p) << 4 | (p.busy ? IPU_CTRL_BUSY : 0);
+        case 0x20:                                                      // IPU_BP
+            return static_cast<uint32_t>(p.bitPos & 0x7F) | ipuInFifo(p) << 8;
+        case 0x30: {                                                    // IPU_TOP
+            IpuBits b{p.in.data(), p.bitPos, p.inSize * 8};
+            return b.peek(32);
+        }
+        case 0x34: return p.busy || p.inSize * 8 < p.bitPos + 32 ? IPU_CTRL_BUSY : 0;
+        default:   return 0;
+    }
+}
+
+void ipuWriteReg(IPU& p, uint32_t offset, uint32_t value) {
+    switch (offset) {
+        case 0x00:                                                      // IPU_CMD
+            p.cmd = value;
+            p.busy = true;
+            p.ctrl &= ~(IPU_CTRL_ECD | IPU_CTRL_SCD);
+            ipuTryCommand(p);
+            break;
+        case 0x10:                                                      // IPU_CTRL
+            if (value & IPU_CTRL_RST) { ipuReset(p); break; }
+            p.ctrl = (p.ctrl & (0x3Fu << 8 | IPU_CTRL_ECD | IPU_CTRL_SCD)) | (value & 0x07FF0000u);
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t ipuPushInput(IPU& p, const uint32_t* data, uint32_t qwc) {
+    p.in.resize(p.inSize);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+    p.in.insert(p.in.end(), src, src + qwc * 16);
+    p.inSize = p.in.size();
+    p.in.resize(p.inSize + IPU_SLACK, 0);
+    ipuTryCommand(p);
+    return qwc;
+}
+
+uint32_t ipuPopOutput(IPU& p, uint32_t* data, uint32_t qwc) {
+    const uint32_t n = std::min<uint32_t>(qwc, static_cast<uint32_t>((p.out.size() - p.outHead) / 4));
+    if (!n) return 0;
+    std::memcpy(data, &p.out[p.outHead], n * 16);
+    p.outHead += n * 4;
+    if (p.outHead == p.out.size()) { p.out.clear(); p.outHead = 0; }
+    return n;
+}
+
+// 64-bit CMD/TOP reads return both words; a read at offset + 4 gets the high one
+static uint64_t ipuMmioRead(void* dev, uint32_t addr, uint32_t size) {
+    IPU& p = *static_cast<IPU*>(dev);
+    const uint32_t offset = addr & 0x3C;
+    const uint64_t lo = ipuReadReg(p, offset);
+    return size == 8 ? lo | uint64_t(ipuReadReg(p, offset + 4)) << 32 : lo;
+}
+
+static void ipuMmioWrite(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    if (!(addr & 0xF)) ipuWriteReg(*static_cast<IPU*>(dev), addr & 0x30, static_cast<uint32_t>(value));
+}
+
+// An empty output FIFO reads as zero
+static MemQword ipuOutFifoRead(void* dev, uint32_t) {
+    MemQword q{0, 0};
+    ipuPopOutput(*static_cast<IPU*>(dev), reinterpret_cast<uint32_t*>(&q), 1);
+    return q;
+}
+
+static void ipuInFifoWrite(void* dev, uint32_t, const MemQword& value) {
+    ipuPushInput(*static_cast<IPU*>(dev), reinterpret_cast<const uint32_t*>(&value), 1);
+}
+
+void ipuMapMmio(IPU& p, Mem& m) {
+    memMapMmio(m, 0x10002000, 0x40, MemMmioSlot{ipuMmioRead, ipuMmioWrite, nullptr, nullptr, &p});
+    memMapMmio(m, 0x10007000, 16, MemMmioSlot{nullptr, nullptr, ipuOutFifoRead, nullptr, &p});
+    memMapMmio(m, 0x10007010, 16, MemMmioSlot{nullptr, nullptr, nullptr, ipuInFifoWrite, &p});
+}
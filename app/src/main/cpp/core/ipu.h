@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Mem; // forward declaration
+
+// IPU: MPEG-2 (and MPEG-1) macroblock decoder. The EE writes IPU_CMD; the
+// bitstream arrives on DMA channel 4 (TO_IPU) and decoded macroblocks leave
+// on channel 3 (FROM_IPU). A command runs once the input FIFO holds all the
+// bits it needs; until then IPU_CMD/IPU_CTRL report BUSY.
+
+// IPU_CMD opcodes (bits 28-31)
+enum IPUCmd : uint32_t {
+    IPU_BCLR, IPU_IDEC, IPU_BDEC, IPU_VDEC, IPU_FDEC,
+    IPU_SETIQ, IPU_SETVQ, IPU_CSC, IPU_PACK, IPU_SETTH,
+};
+
+// IPU_CTRL bits
+static constexpr uint32_t IPU_CTRL_ECD  = 1u << 14;   // error code detected
+static constexpr uint32_t IPU_CTRL_SCD  = 1u << 15;   // start code detected
+static constexpr uint32_t IPU_CTRL_AS   = 1u << 20;   // alternate scan
+static constexpr uint32_t IPU_CTRL_IVF  = 1u << 21;   // intra VLC format (table B-15)
+static constexpr uint32_t IPU_CTRL_QST  = 1u << 22;   // non-linear quantiser scale
+static constexpr uint32_t IPU_CTRL_MP1  = 1u << 23;   // MPEG-1 bitstream
+static constexpr uint32_t IPU_CTRL_RST  = 1u << 30;
+static constexpr uint32_t IPU_CTRL_BUSY = 1u << 31;
+
+struct IPU {
+    // Registers
+    uint32_t ctrl = 0;          // IDP, AS, IVF, QST, MP1, PCT, CBP, ECD, SCD
+    uint32_t cmd = 0;           // command in progress (valid while busy)
+    uint32_t result = 0;        // IPU_CMD data
+    bool     busy = false;
+    bool     irq = false;       // command finished; cleared by the reader
+
+    // Dequantiser state: matrices in raster order, VQ CLUT, CSC thresholds
+    uint8_t  iqIntra[64] = {0}, iqNonIntra[64] = {0};
+    uint16_t vqclut[16] = {0};
+    uint16_t th0 = 0, th1 = 0;
+    int32_t  dcPred[3] = {0};
+
+    // Input bitstream (bytes in memory order, zero slack after inSize)
+    // and output FIFO of 32-bit words
+    std::vector<uint8_t>  in;
+    size_t   inSize = 0;
+    size_t   bitPos = 0;
+    std::vector<uint32_t> out;
+    size_t   outHead = 0;
+
+    // Decoded work
+    uint64_t macroblocks = 0, blocks = 0, cscMacroblocks = 0;
+};
+
+void     ipuInit(IPU& ipu);
+void     ipuReset(IPU& ipu);
+
+// Register access by offset from 0x10002000 (CMD, CTRL, BP, TOP); the
+// 64-bit CMD/TOP registers read their high words at offset + 4
+uint32_t ipuReadReg(IPU& ipu, uint32_t offset);
+void     ipuWriteReg(IPU& ipu, uint32_t offset, uint32_t value);
+
+// DMA side: channel 4 feeds the input FIFO, channel 3 drains the output
+// FIFO. Both return the qwords moved.
+uint32_t ipuPushInput(IPU& ipu, const uint32_t* data, uint32_t qwc);
+uint32_t ipuPopOutput(IPU& ipu, uint32_t* data, uint32_t qwc);
+
+// IPU_CMD..IPU_TOP at 0x10002000, the output FIFO at 0x10007000 and the
+// input FIFO at 0x10007010
+void     ipuMapMmio(IPU& ipu, Mem& mem);
@@ -1,14 +1,313 @@
 #include "mem_map.h"
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__) && UINTPTR_MAX > 0xFFFFFFFFu
+#define MEM_FASTMEM 1
+#else
+#define MEM_FASTMEM 0
+#endif
+
+// Views are mapped at host page granularity; this covers 4/16/64 KB kernels
+static constexpr size_t MEM_HOST_ALIGN = 64 * 1024;
+
+// Host part of an entry, or 0 for unmapped and register pages
+static inline uintptr_t memHostEntry(uintptr_t e) {
+    return (e & MEM_PAGE_MMIO) ? 0 : e & ~MEM_PAGE_DIRECT;
+}
+
+// -----------------------------------------------------------------------------
+// Arena and fastmem window
+// -----------------------------------------------------------------------------
+
+static int memCreateFd(const char* name, size_t size) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    const int fd = static_cast<int>(syscall(SYS_memfd_create, name, 1u /* MFD_CLOEXEC */));
+    if (fd < 0) return -1;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)name; (void)size;
+    return -1;
+#endif
+}
+
+// Zero-filled and lazily committed: pages become resident when first written
+static void* memReserve(size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Bytes of [p, p + size) backed by host memory right now
+static size_t memResident(const void* p, size_t size) {
+    if (!p || size == 0) return 0;
+    const uintptr_t hostPage = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(p) & ~(hostPage - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(p) + size;
+    std::vector<unsigned char> pages((end - begin + hostPage - 1) / hostPage);
+    if (mincore(reinterpret_cast<void*>(begin), end - begin, pages.data()) != 0) return 0;
+    size_t n = 0;
+    for (unsigned char v : pages) n += v & 1;
+    return std::min<size_t>(n * hostPage, size);
+}
+
+static bool memArenaAlloc(Mem& m, size_t size) {
+    m.arenaFd = memCreateFd("ps2-guest", size);
+    void* p = MAP_FAILED;
+    if (m.arenaFd >= 0) {
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m.arenaFd, 0);
+        if (p == MAP_FAILED) {
+            close(m.arenaFd);
+            m.arenaFd = -1;
+        }
+    }
+    if (p == MAP_FAILED) p = memReserve(size);
+    if (!p || p == MAP_FAILED) return false;
+    m.arena = static_cast<uint8_t*>(p);
+    m.arenaSize = size;
+    return true;
+}
+
+#if MEM_FASTMEM
+// 4 GB plus a guard for accesses that start just below the top
+static constexpr size_t MEM_FASTMEM_SIZE = (size_t(1) << 32) + MEM_HOST_ALIGN;
+
+static bool memFastmemView(Mem& m, uint32_t addr, int fd, size_t offset, size_t size, bool writable) {
+    void* p = mmap(m.fastmem + addr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(offset));
+    return p != MAP_FAILED;
+}
+
+static void memFastmemHole(Mem& m, uint32_t addr, size_t size) {
+    mmap(m.fastmem + addr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+}
+
+static bool memFastmemViewBuffer(Mem& m, uint32_t addr, const MemBuffer& buf) {
+    return memFastmemView(m, addr, m.arenaFd, static_cast<size_t>(buf.ptr - m.arena), buf.len, true);
+}
+
+// Granule the window can be remapped at
+static size_t memHostPage() {
+    static const size_t size = std::max<size_t>(static_cast<size_t>(sysconf(_SC_PAGESIZE)), MEM_PAGE_SIZE);
+    return size;
+}
+
+// What one host page of the window should show: fd < 0 is a hole
+struct MemView {
+    int    fd;
+    size_t offset;
+    bool   writable;
+};
+
+static MemView memFastmemTarget(const Mem& m, uint32_t at, size_t len) {
+    static constexpr MemView hole{-1, 0, false};
+    // Its guest pages have to reach consecutive host bytes
+    const uint8_t* host = memHostPtr(m, at);
+    if (!host) return hole;
+    bool writable = true;
+    for (size_t off = 0; off < len; off += MEM_PAGE_SIZE) {
+        const uint32_t v = at + static_cast<uint32_t>(off);
+        if (memHostPtr(m, v) != host + off) return hole;
+        const uintptr_t w = memHostEntry(m.writePages[v >> MEM_PAGE_SHIFT]);
+        if (!w || reinterpret_cast<const uint8_t*>(w + v) != host + off) writable = false;
+    }
+    if (host >= m.arena && host + len <= m.arena + m.arenaSize) {
+        const size_t offset = static_cast<size_t>(host - m.arena);
+        return (offset & (len - 1)) ? hole : MemView{m.arenaFd, offset, writable};
+    }
+    for (const MemRom& r : m.roms) {
+        if (r.fd < 0 || host < r.data || host + len > r.data + r.size) continue;
+        const size_t offset = r.offset + static_cast<size_t>(host - r.data);
+        if (!(offset & (len - 1))) return MemView{r.fd, offset, false};
+    }
+    return hole;
+}
+
+// Point [first, end) of the window at whatever the page tables map there,
+// a run of host pages per mmap; pages mapping registers, nothing or a ROM
+// without a file become holes for the slow path
+static void memFastmemSync(Mem& m, uint64_t first, uint64_t end) {
+    const size_t gran = memHostPage();
+    first &= ~uint64_t(gran - 1);
+    end = (end + gran - 1) & ~uint64_t(gran - 1);
+    uint64_t at = first;
+    while (at < end) {
+        const MemView view = memFastmemTarget(m, static_cast<uint32_t>(at), gran);
+        uint64_t next = at + gran;
+        for (; next < end; next += gran) {
+            const MemView v = memFastmemTarget(m, static_cast<uint32_t>(next), gran);
+            if (v.fd != view.fd || v.writable != view.writable ||
+                (view.fd >= 0 && v.offset != view.offset + (next - at))) break;
+        }
+        const size_t len = static_cast<size_t>(next - at);
+        if (view.fd < 0 || !memFastmemView(m, static_cast<uint32_t>(at), view.fd, view.offset, len, view.writable)) {
+            memFastmemHole(m, static_cast<uint32_t>(at), len);
+        }
+        at = next;
+    }
+}
+
+// ROMs backed by a file map it directly; the rest get a read-only memfd
+// copy each, shared by all their views. A ROM that can't be mapped stays a
+// hole and goes through the slow path.
+static void memFastmemMapRoms(Mem& m) {
+    std::vector<std::pair<const uint8_t*, int>> fds;
+    for (const MemRom& r : m.roms) {
+        if (r.addr & (MEM_HOST_ALIGN - 1)) continue;
+        if (memHostPtr(m, r.addr) != r.data) continue; // a TLB entry maps something else there
+        if (r.fd >= 0 && !(r.offset & (MEM_HOST_ALIGN - 1))) {
+            if (memFastmemView(m, r.addr, r.fd, r.offset, r.size, false)) continue;
+        }
+        int fd = -1;
+        for (const auto& f : fds) if (f.first == r.data) fd = f.second;
+        if (fd < 0) {
+            fd = memCreateFd("ps2-rom", r.size);
+            if (fd < 0) continue;
+            size_t done = 0;
+            while (done < r.size) {
+                const ssize_t n = pwrite(fd, r.data + done, r.size - done, static_cast<off_t>(done));
+                if (n <= 0) break;
+                done += static_cast<size_t>(n);
+            }
+            if (done < r.size) {
+                close(fd);
+                continue;
+            }
+            fds.emplace_back(r.data, fd);
+        }
+        memFastmemView(m, r.addr, fd, 0, r.size, false);
+    }
+    for (const auto& f : fds) close(f.second); // the views keep the files alive
+}
+#endif
+
+bool memFastmemEnable(Mem& m) {
+#if MEM_FASTMEM
+    if (m.fastmem) return true;
+    if (m.arenaFd < 0) return false;
+    void* p = mmap(nullptr, MEM_FASTMEM_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return false;
+    m.fastmem = static_cast<uint8_t*>(p);
+
+    bool ok = true;
+    for (uint32_t seg : {MEM_KSEG0, MEM_KSEG1}) {
+        ok = ok && memFastmemViewBuffer(m, seg, m.ram);
+        ok = ok && memFastmemViewBuffer(m, seg | MEM_IOP_BASE, m.iopRam);
+    }
+    if (!ok) {
+        memFastmemDisable(m);
+        return false;
+    }
+    // kuseg as the page tables have it, TLB entries included
+    memFastmemSync(m, 0, MEM_KSEG0);
+    memFastmemMapRoms(m);
+    return true;
+#else
+    (void)m;
+    return false;
+#endif
+}
+
+void memFastmemDisable(Mem& m) {
+#if MEM_FASTMEM
+    if (m.fastmem) munmap(m.fastmem, MEM_FASTMEM_SIZE);
+#endif
+    m.fastmem = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Page tables
+// -----------------------------------------------------------------------------
+
+static inline uintptr_t memEntry(const uint8_t* host, uint32_t addr) {
+    return reinterpret_cast<uintptr_t>(host) - (addr & ~(MEM_PAGE_SIZE - 1));
+}
+
+void memMapPages(Mem& m, uint32_t addr, uint8_t* host, size_t size, bool writable) {
+    const uint32_t first = addr >> MEM_PAGE_SHIFT;
+    const uint32_t count = static_cast<uint32_t>(size >> MEM_PAGE_SHIFT);
+    for (uint32_t i = 0; i < count && first + i < MEM_PAGE_COUNT; ++i) {
+        const uint32_t page = first + i;
+        const uintptr_t e = memEntry(host + (static_cast<size_t>(i) << MEM_PAGE_SHIFT), page << MEM_PAGE_SHIFT);
+        m.readPages[page]  = e | MEM_PAGE_DIRECT;
+        m.writePages[page] = writable ? e | MEM_PAGE_DIRECT : 0;
+    }
+}
+
+void memUnmapPages(Mem& m, uint32_t addr, size_t size) {
+    m.roms.erase(std::remove_if(m.roms.begin(), m.roms.end(), [&](const MemRom& r) {
+        return r.addr >= addr && r.addr - addr < size;
+    }), m.roms.end());
+#if MEM_FASTMEM
+    if (m.fastmem) memFastmemHole(m, addr, size);
+#endif
+
+    const uint32_t first = addr >> MEM_PAGE_SHIFT;
+    const uint32_t count = static_cast<uint32_t>((size + MEM_PAGE_SIZE - 1) >> MEM_PAGE_SHIFT);
+    for (uint32_t i = 0; i < count && first + i < MEM_PAGE_COUNT; ++i) {
+        m.readPages[first + i] = m.writePages[first + i] = 0;
+    }
+}
+
+static constexpr size_t MEM_TABLE_BYTES = MEM_PAGE_COUNT * sizeof(uintptr_t);
+
+// Map a buffer at its physical address and the KSEG0/KSEG1 windows
+static void memMapMirrored(Mem& m, uint32_t phys, MemBuffer& buf) {
+    for (uint32_t seg : {0u, MEM_KSEG0, MEM_KSEG1}) memMapPages(m, seg | phys, buf.data(), buf.size(), true);
+}
+
+void memShutdown(Mem& m) {
+    memFastmemDisable(m);
+    if (m.arena) munmap(m.arena, m.arenaSize);
+    if (m.arenaFd >= 0) close(m.arenaFd);
+    m.arena = nullptr;
+    m.arenaSize = 0;
+    m.arenaFd = -1;
+    m.ram = m.scratch = m.iopRam = MemBuffer{};
+    m.roms.clear();
+    m.mmioPages.clear();
+    m.ramAliases.clear();
+    if (m.readPages) munmap(m.readPages, MEM_TABLE_BYTES);
+    if (m.writePages) munmap(m.writePages, MEM_TABLE_BYTES);
+    m.readPages = m.writePages = nullptr;
+}
 
 bool memInit(Mem& m) {
-    m.ram.resize(2 * 1024 * 1024);
-    std::memset(m.ram.data(), 0, m.ram.size());
+    memShutdown(m);
+
+    // RAM | IOP RAM | scratchpad, each on a host page boundary
+    const size_t ramSize = 2 * 1024 * 1024;
+    const size_t iopAt = ramSize, scratchAt = iopAt + MEM_IOP_SIZE;
+    if (!memArenaAlloc(m, (scratchAt + MEM_SCRATCH_SIZE + MEM_HOST_ALIGN - 1) & ~(MEM_HOST_ALIGN - 1))) return false;
+    m.ram     = MemBuffer{m.arena, ramSize};
+    m.iopRam  = MemBuffer{m.arena + iopAt, MEM_IOP_SIZE};
+    m.scratch = MemBuffer{m.arena + scratchAt, MEM_SCRATCH_SIZE};
 
     m.tick = 0;
     m.intc_stat = 0;
-    m.romMap.clear();
+    m.intc_mask = 0;
+
+    m.readPages  = static_cast<uintptr_t*>(memReserve(MEM_TABLE_BYTES));
+    m.writePages = static_cast<uintptr_t*>(memReserve(MEM_TABLE_BYTES));
+    if (!m.readPages || !m.writePages) {
+        memShutdown(m);
+        return false;
+    }
+    memMapMirrored(m, 0, m.ram);
+    memMapMirrored(m, MEM_IOP_BASE, m.iopRam);
+    memMapPages(m, MEM_SCRATCH_BASE, m.scratch.data(), m.scratch.size(), true);
+
+    m.codePages.assign(m.ram.size() >> MEM_PAGE_SHIFT, 0);
+    m.dirtyCodePages.clear();
 
     m.rom0.clear(); m.rom0Size = 0;
     m.rom1.clear(); m.rom1Size = 0;
@@ -19,46 +318,350 @@ bool memInit(Mem& m) {
     return true;
 }
 
-uint32_t memRead32(const Mem& m, uint32_t addr) {
-    if (addr + 4 <= m.ram.size()) {
-        return *reinterpret_cast<const uint32_t*>(&m.ram[addr]);
+const uint8_t* memHostPtr(const Mem& m, uint32_t addr) {
+    const uintptr_t e = memHostEntry(m.readPages[addr >> MEM_PAGE_SHIFT]);
+    return e ? reinterpret_cast<const uint8_t*>(e + addr) : nullptr;
+}
+
+// Offset into RAM of a host pointer, or -1 for anything else
+static inline int64_t memRamOffset(const Mem& m, const uint8_t* p) {
+    if (p < m.ram.data() || p >= m.ram.data() + m.ram.size()) return -1;
+    return p - m.ram.data();
+}
+
+// Tag or untag every mapping of a RAM page in the write table
+static void memTagRamPage(Mem& m, uint32_t page, bool tag) {
+    const uint32_t phys = page << MEM_PAGE_SHIFT;
+    for (uint32_t seg : {0u, MEM_KSEG0, MEM_KSEG1}) {
+        uintptr_t& e = m.writePages[(seg | phys) >> MEM_PAGE_SHIFT];
+        if (memHostEntry(e)) e = tag ? (e & ~MEM_PAGE_DIRECT) : (e | MEM_PAGE_DIRECT);
     }
+    const auto aliases = m.ramAliases.equal_range(page);
+    for (auto it = aliases.first; it != aliases.second; ++it) {
+        uintptr_t& e = m.writePages[it->second];
+        if (memHostEntry(e)) e = tag ? (e & ~MEM_PAGE_DIRECT) : (e | MEM_PAGE_DIRECT);
+    }
+}
 
-    uint32_t base = addr & 0xFFF00000;
-    auto it = m.romMap.find(base);
-    if (it != m.romMap.end()) {
-        const MemRegion& r = it->second;
-        uint32_t offset = addr - r.base;
-        if (offset + 4 <= r.size) {
-            return *reinterpret_cast<const uint32_t*>(r.data + offset);
+static inline void memTouchCode(Mem& m, uint32_t first, uint32_t last) {
+    for (uint32_t page = first >> MEM_PAGE_SHIFT; page <= (last >> MEM_PAGE_SHIFT); ++page) {
+        if (m.codePages[page]) {
+            m.codePages[page] = 0;
+            memTagRamPage(m, page, false);
+            m.dirtyCodePages.push_back(page);
+            if (m.onCodeWrite) m.onCodeWrite(m.onCodeWriteUser, page);
         }
     }
-    return 0;
 }
 
-void memWrite32(Mem& m, uint32_t addr, uint32_t value) {
-    if (addr + 4 <= m.ram.size()) {
-        *reinterpret_cast<uint32_t*>(&m.ram[addr]) = value;
+void memReset(Mem& m) {
+    if (!m.arena) return;
+    // A shared arena has to drop the file pages too, or they'd come back
+    bool released = false;
+#if defined(__linux__)
+    released = madvise(m.arena, m.arenaSize, m.arenaFd >= 0 ? MADV_REMOVE : MADV_DONTNEED) == 0;
+#endif
+    if (!released) std::memset(m.arena, 0, m.arenaSize);
+    if (m.ram.size()) memTouchCode(m, 0, static_cast<uint32_t>(m.ram.size() - 1));
+}
+
+void memUsage(const Mem& m, MemUsage out[MEM_REGION_COUNT]) {
+    out[MEM_REGION_RAM]     = MemUsage{"RAM", m.ram.size(), memResident(m.ram.data(), m.ram.size())};
+    out[MEM_REGION_IOP]     = MemUsage{"IOP RAM", m.iopRam.size(), memResident(m.iopRam.data(), m.iopRam.size())};
+    out[MEM_REGION_SCRATCH] = MemUsage{"scratchpad", m.scratch.size(), memResident(m.scratch.data(), m.scratch.size())};
+    const bool tables = m.readPages && m.writePages;
+    out[MEM_REGION_TABLES]  = MemUsage{"page tables", tables ? 2 * MEM_TABLE_BYTES : 0,
+                                       tables ? memResident(m.readPages, MEM_TABLE_BYTES) +
+                                                memResident(m.writePages, MEM_TABLE_BYTES) : 0};
+}
+
+// Register slot for addr on a register page; addr becomes physical
+static inline const MemMmioSlot& memMmioSlot(const Mem& m, uintptr_t e, uint32_t& addr) {
+    const MemMmioPage& page = m.mmioPages[e >> MEM_PAGE_SHIFT];
+    const uint32_t off = addr & (MEM_PAGE_SIZE - 1);
+    addr = page.phys | off;
+    return page.slots[off >> MEM_MMIO_SLOT_SHIFT];
+}
+
+void memReadSlow(const Mem& m, uint32_t addr, void* out, uint32_t size) {
+    const uintptr_t e = m.readPages[addr >> MEM_PAGE_SHIFT];
+    if (const uintptr_t host = memHostEntry(e)) {
+        std::memcpy(out, reinterpret_cast<const void*>(host + addr), size);
+        return;
+    }
+    // The device owning the slot, else the catch-all hooks
+    auto read = m.mmioRead;
+    auto read128 = m.mmioRead128;
+    void* dev = m.mmioUser;
+    if (e & MEM_PAGE_MMIO) {
+        const MemMmioSlot& slot = memMmioSlot(m, e, addr);
+        if (slot.read || slot.read128) {
+            read = slot.read;
+            read128 = slot.read128;
+            dev = slot.dev;
+        }
+    }
+    if (size == 16 && read128) {
+        const MemQword q = read128(dev, addr);
+        std::memcpy(out, &q, 16);
+        return;
+    }
+    if (!read) {
+        std::memset(out, 0, size);
+        return;
+    }
+    // Without a 128-bit handler, quadword reads arrive as two 64-bit halves
+    uint8_t* dst = static_cast<uint8_t*>(out);
+    for (uint32_t done = 0; done < size; done += 8) {
+        const uint32_t n = size - done < 8 ? size - done : 8;
+        const uint64_t v = read(dev, addr + done, n);
+        std::memcpy(dst + done, &v, n);
     }
 }
 
+void memWriteSlow(Mem& m, uint32_t addr, const void* src, uint32_t size) {
+    const uintptr_t e = m.writePages[addr >> MEM_PAGE_SHIFT];
+    if (const uintptr_t host = memHostEntry(e)) {
+        uint8_t* p = reinterpret_cast<uint8_t*>(host + addr);
+        const int64_t off = memRamOffset(m, p);
+        if (off >= 0) memTouchCode(m, static_cast<uint32_t>(off), static_cast<uint32_t>(off));
+        std::memcpy(p, src, size);
+        return;
+    }
+    auto write = m.mmioWrite;
+    auto write128 = m.mmioWrite128;
+    void* dev = m.mmioUser;
+    if (e & MEM_PAGE_MMIO) {
+        const MemMmioSlot& slot = memMmioSlot(m, e, addr);
+        if (slot.write || slot.write128) {
+            write = slot.write;
+            write128 = slot.write128;
+            dev = slot.dev;
+        }
+    }
+    if (size == 16 && write128) {
+        MemQword q;
+        std::memcpy(&q, src, 16);
+        write128(dev, addr, q);
+        return;
+    }
+    if (!write) return;
+    const uint8_t* from = static_cast<const uint8_t*>(src);
+    for (uint32_t done = 0; done < size; done += 8) {
+        const uint32_t n = size - done < 8 ? size - done : 8;
+        uint64_t v = 0;
+        std::memcpy(&v, from + done, n);
+        write(dev, addr + done, v, n);
+    }
+}
+
+void memMapMmio(Mem& m, uint32_t phys, uint32_t size, const MemMmioSlot& handlers) {
+    const uint32_t slotSize = 1u << MEM_MMIO_SLOT_SHIFT;
+    for (uint32_t at = phys & ~(slotSize - 1); at < phys + size; at += slotSize) {
+        const uint32_t page = at >> MEM_PAGE_SHIFT;
+        uintptr_t e = m.readPages[page];
+        if (!(e & MEM_PAGE_MMIO)) {
+            e = static_cast<uintptr_t>(m.mmioPages.size()) << MEM_PAGE_SHIFT | MEM_PAGE_MMIO;
+            m.mmioPages.emplace_back();
+            m.mmioPages.back().phys = page << MEM_PAGE_SHIFT;
+            for (uint32_t seg : {0u, MEM_KSEG0, MEM_KSEG1}) {
+                const uint32_t mirror = (seg | page << MEM_PAGE_SHIFT) >> MEM_PAGE_SHIFT;
+                m.readPages[mirror] = m.writePages[mirror] = e;
+            }
+        }
+        m.mmioPages[e >> MEM_PAGE_SHIFT].slots[(at & (MEM_PAGE_SIZE - 1)) >> MEM_MMIO_SLOT_SHIFT] = handlers;
+    }
+}
+
+void memMmioEventDriven(Mem& m, uint32_t phys, uint32_t size) {
+    const uint32_t slotSize = 1u << MEM_MMIO_SLOT_SHIFT;
+    for (uint32_t at = phys & ~(slotSize - 1); at < phys + size; at += slotSize) {
+        const uintptr_t e = m.readPages[at >> MEM_PAGE_SHIFT];
+        if (!(e & MEM_PAGE_MMIO)) continue;
+        MemMmioSlot& slot = m.mmioPages[e >> MEM_PAGE_SHIFT].slots[(at & (MEM_PAGE_SIZE - 1)) >> MEM_MMIO_SLOT_SHIFT];
+        if (slot.read || slot.read128) slot.eventDriven = true;
+    }
+}
+
+bool memStableRead(const Mem& m, uint32_t addr) {
+    const uintptr_t e = m.readPages[addr >> MEM_PAGE_SHIFT];
+    if (!(e & MEM_PAGE_MMIO)) return e != 0;
+    return memMmioSlot(m, e, addr).eventDriven;
+}
+
+// Plain registers: an access reaches the bytes of *reg it covers
+template <uint32_t N>
+static uint64_t memRegRead(void* reg, uint32_t addr, uint32_t size) {
+    const uint32_t off = addr & (N - 1);
+    uint64_t v = 0;
+    std::memcpy(&v, static_cast<const uint8_t*>(reg) + off, size < N - off ? size : N - off);
+    return v;
+}
+
+template <uint32_t N>
+static void memRegWrite(void* reg, uint32_t addr, uint64_t value, uint32_t size) {
+    const uint32_t off = addr & (N - 1);
+    std::memcpy(static_cast<uint8_t*>(reg) + off, &value, size < N - off ? size : N - off);
+}
+
+MemMmioSlot memMmioReg(uint32_t* reg) {
+    return {memRegRead<4>, memRegWrite<4>, nullptr, nullptr, reg};
+}
+
+MemMmioSlot memMmioReg(uint64_t* reg) {
+    return {memRegRead<8>, memRegWrite<8>, nullptr, nullptr, reg};
+}
+
+void memRamWritten(Mem& m, uint32_t offset, uint32_t size) {
+    if (!size || offset >= m.ram.size()) return;
+    const size_t end = std::min<size_t>(size_t(offset) + size, m.ram.size());
+    memTouchCode(m, offset, static_cast<uint32_t>(end - 1));
+}
+
+// Page by page; unmapped and read-only pages are skipped
 void memWriteBlock(Mem& m, uint32_t addr, const uint8_t* src, size_t size) {
     if (!src || size == 0) return;
-    if (addr + size <= m.ram.size()) {
-        std::memcpy(&m.ram[addr], src, size);
+    while (size) {
+        const size_t n = std::min<size_t>(size, MEM_PAGE_SIZE - (addr & (MEM_PAGE_SIZE - 1)));
+        const uintptr_t e = memHostEntry(m.writePages[addr >> MEM_PAGE_SHIFT]);
+        if (e) {
+            uint8_t* p = reinterpret_cast<uint8_t*>(e + addr);
+            const int64_t off = memRamOffset(m, p);
+            if (off >= 0) memTouchCode(m, static_cast<uint32_t>(off), static_cast<uint32_t>(off + n - 1));
+            std::memcpy(p, src, n);
+        }
+        addr += static_cast<uint32_t>(n);
+        src += n;
+        size -= n;
+    }
+}
+
+int64_t memMarkCodePage(Mem& m, uint32_t addr) {
+    const int64_t off = memRamOffset(m, memHostPtr(m, addr));
+    if (off < 0) return -1;
+    const uint32_t page = static_cast<uint32_t>(off) >> MEM_PAGE_SHIFT;
+    m.codePages[page] = 1;
+    memTagRamPage(m, page, true);
+    return page;
+}
+
+// -----------------------------------------------------------------------------
+// Translated pages
+// -----------------------------------------------------------------------------
+
+// Entry mapping vaddr's page the way the untranslated view maps phys
+static uintptr_t memPhysEntry(const Mem& m, const uintptr_t* table, uint32_t phys, uint32_t vaddr) {
+    const uint32_t vbase = vaddr & ~(MEM_PAGE_SIZE - 1);
+    phys &= ~(MEM_PAGE_SIZE - 1);
+    if (phys - MEM_SCRATCH_BASE < MEM_SCRATCH_SIZE) {
+        return memEntry(m.scratch.data() + (phys - MEM_SCRATCH_BASE), vbase) | MEM_PAGE_DIRECT;
+    }
+    if (phys >= MEM_KSEG1 - MEM_KSEG0) return 0;
+    const uint32_t k0 = MEM_KSEG0 | phys;
+    const uintptr_t e = table[k0 >> MEM_PAGE_SHIFT];
+    // Register entries hold an index, not an offset
+    return memHostEntry(e) ? e + k0 - vbase : e;
+}
+
+// RAM page behind a translated page, or -1
+static inline int64_t memAliasedRamPage(const Mem& m, uint32_t page) {
+    const int64_t off = memRamOffset(m, memHostPtr(m, page << MEM_PAGE_SHIFT));
+    return off < 0 ? -1 : off >> MEM_PAGE_SHIFT;
+}
+
+static void memRemapPage(Mem& m, uint32_t page, uintptr_t r, uintptr_t w) {
+    const int64_t was = memAliasedRamPage(m, page);
+    if (was >= 0) {
+        const auto aliases = m.ramAliases.equal_range(static_cast<uint32_t>(was));
+        for (auto it = aliases.first; it != aliases.second; ++it) {
+            if (it->second == page) {
+                m.ramAliases.erase(it);
+                break;
+            }
+        }
+    }
+    m.readPages[page] = r;
+    m.writePages[page] = w;
+    const int64_t now = memAliasedRamPage(m, page);
+    if (now >= 0) m.ramAliases.emplace(static_cast<uint32_t>(now), page);
+
+    // Blocks decoded through the old mapping are filed under the RAM page it
+    // reached (see eeBlockTrackPages); drop them like a store to it would
+    if (was >= 0 && was != now) {
+        const uint32_t addr = static_cast<uint32_t>(was) << MEM_PAGE_SHIFT;
+        memTouchCode(m, addr, addr);
     }
 }
 
-void memMapRom(Mem& m, uint32_t physAddr, const uint8_t* data, size_t size) {
+// The fastmem window follows the remapped pages, so compiled loads from
+// translated RAM and scratchpad stay direct
+static void memRemapDone(Mem& m, uint32_t vaddr, size_t size) {
+#if MEM_FASTMEM
+    if (m.fastmem && size) memFastmemSync(m, vaddr, uint64_t(vaddr) + size);
+#else
+    (void)m; (void)vaddr; (void)size;
+#endif
+}
+
+void memMapPhys(Mem& m, uint32_t vaddr, uint32_t paddr, size_t size, bool writable) {
+    for (size_t off = 0; off < size; off += MEM_PAGE_SIZE) {
+        const uint32_t v = vaddr + static_cast<uint32_t>(off), p = paddr + static_cast<uint32_t>(off);
+        memRemapPage(m, v >> MEM_PAGE_SHIFT, memPhysEntry(m, m.readPages, p, v),
+                     writable ? memPhysEntry(m, m.writePages, p, v) : 0);
+    }
+    memRemapDone(m, vaddr, size);
+}
+
+void memMapInvalid(Mem& m, uint32_t vaddr, size_t size) {
+    for (size_t off = 0; off < size; off += MEM_PAGE_SIZE) {
+        memRemapPage(m, (vaddr + static_cast<uint32_t>(off)) >> MEM_PAGE_SHIFT, 0, 0);
+    }
+    memRemapDone(m, vaddr, size);
+}
+
+// Untranslated: the low 512 MB is physical memory, plus the scratchpad
+void memMapDefault(Mem& m, uint32_t vaddr, size_t size) {
+    for (size_t off = 0; off < size; off += MEM_PAGE_SIZE) {
+        const uint32_t v = vaddr + static_cast<uint32_t>(off);
+        const bool phys = v < MEM_KSEG1 - MEM_KSEG0 || v - MEM_SCRATCH_BASE < MEM_SCRATCH_SIZE;
+        memRemapPage(m, v >> MEM_PAGE_SHIFT, phys ? memPhysEntry(m, m.readPages, v, v) : 0,
+                     phys ? memPhysEntry(m, m.writePages, v, v) : 0);
+    }
+    memRemapDone(m, vaddr, size);
+}
+
+// ROM pages are read-only: writes land in the slow path and are dropped
+void memMapRom(Mem& m, uint32_t physAddr, const uint8_t* data, size_t size, int fd) {
     if (!data || size == 0) return;
-    m.romMap[physAddr] = MemRegion{physAddr, static_cast<uint32_t>(size), data};
+    memMapPages(m, physAddr, const_cast<uint8_t*>(data), size, false);
+    m.roms.push_back(MemRom{physAddr, size, data, fd, 0});
+#if MEM_FASTMEM
+    if (m.fastmem) memFastmemMapRoms(m);
+#endif
 }
 
 void memMapAliasKseg1(Mem& m, uint32_t aliasAddr, uint32_t physAddr, size_t size) {
-    auto it = m.romMap.find(physAddr);
-    if (it != m.romMap.end() && it->second.data) {
-        m.romMap[aliasAddr] = MemRegion{aliasAddr, static_cast<uint32_t>(size), it->second.data};
+    const uint32_t count = static_cast<uint32_t>(size >> MEM_PAGE_SHIFT);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t from = (physAddr >> MEM_PAGE_SHIFT) + i, to = (aliasAddr >> MEM_PAGE_SHIFT) + i;
+        if (from >= MEM_PAGE_COUNT || to >= MEM_PAGE_COUNT) break;
+        const uintptr_t delta = static_cast<uintptr_t>((static_cast<int64_t>(from) - to) * MEM_PAGE_SIZE);
+        const uintptr_t r = m.readPages[from], w = m.writePages[from];
+        m.readPages[to]  = memHostEntry(r) ? r + delta : r;
+        m.writePages[to] = memHostEntry(w) ? w + delta : w;
     }
+
+    auto it = std::find_if(m.roms.begin(), m.roms.end(), [&](const MemRom& r) {
+        return physAddr >= r.addr && physAddr - r.addr < r.size;
+    });
+    if (it == m.roms.end()) return;
+    const size_t skip = physAddr - it->addr;
+    const MemRom alias{aliasAddr, std::min(size, it->size - skip), it->data + skip,
+                       it->fd, it->offset + skip};
+    m.roms.push_back(alias);
+#if MEM_FASTMEM
+    if (m.fastmem) memFastmemMapRoms(m);
+#endif
 }
 
 void ps2CoreLoadNVM(const uint8_t* data, int length) {
@@ -1,16 +1,100 @@
 #pragma once
 #include <cstdint>
-#include <vector>
+#include <cstddef>
+#include <cstring>
 #include <unordered_map>
+#include <vector>
+
+// 4 KB guest pages, used for address translation and code tracking
+static constexpr uint32_t MEM_PAGE_SHIFT = 12;
+static constexpr uint32_t MEM_PAGE_SIZE  = 1u << MEM_PAGE_SHIFT;
+static constexpr uint32_t MEM_PAGE_COUNT = 1u << (32 - MEM_PAGE_SHIFT);
+
+// Page table entries hold (host page - guest page base), so a mapped access
+// is entry + addr. Host buffers are at least 4-byte aligned, which leaves
+// bit 0 to mark pages the fast path may touch directly. Anything else takes
+// the slow path: zero is unmapped, and RAM pages holding cached code drop the
+// bit in the write table. Zero being unmapped lets the tables live in lazily
+// committed memory, so only the pages that map something become resident.
+// Register pages carry MEM_PAGE_MMIO instead, with their index in
+// Mem::mmioPages above the page offset bits.
+static constexpr uintptr_t MEM_PAGE_DIRECT = 1;
+static constexpr uintptr_t MEM_PAGE_MMIO   = 2;
+
+// Fixed EE layout (physical); RAM and IOP RAM also appear in KSEG0/KSEG1
+static constexpr uint32_t MEM_SCRATCH_BASE = 0x70000000;
+static constexpr uint32_t MEM_SCRATCH_SIZE = 16 * 1024;
+static constexpr uint32_t MEM_IOP_BASE     = 0x1C000000;
+static constexpr uint32_t MEM_IOP_SIZE     = 2 * 1024 * 1024;
+static constexpr uint32_t MEM_KSEG0        = 0x80000000;
+static constexpr uint32_t MEM_KSEG1        = 0xA0000000;
+
+// Guest memory is little-endian, like every host we build for, so typed
+// accesses store values as they are
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "guest memory access assumes a little-endian host"
+#endif
+
+// A 128-bit quadword (LQ/SQ, COP2, FIFOs, DMA), low half first
+struct alignas(16) MemQword {
+    uint64_t lo;
+    uint64_t hi;
+};
+
+// Handlers for one 16-byte register slot; every EE register starts on a
+// 16-byte boundary. addr is physical and size is the access width; quadword
+// accesses use the 128-bit handlers when set and two 64-bit halves otherwise.
+struct MemMmioSlot {
+    uint64_t (*read)(void* dev, uint32_t addr, uint32_t size) = nullptr;
+    void     (*write)(void* dev, uint32_t addr, uint64_t value, uint32_t size) = nullptr;
+    MemQword (*read128)(void* dev, uint32_t addr) = nullptr;
+    void     (*write128)(void* dev, uint32_t addr, const MemQword& value) = nullptr;
+    void*    dev = nullptr;
+    bool     eventDriven = false; // see memMmioEventDriven
+};
+
+static constexpr uint32_t MEM_MMIO_SLOT_SHIFT = 4;
+
+struct MemMmioPage {
+    uint32_t    phys = 0;
+    MemMmioSlot slots[MEM_PAGE_SIZE >> MEM_MMIO_SLOT_SHIFT];
+};
 
-struct MemRegion {
-    uint32_t base;
-    uint32_t size;
+// A guest memory inside the arena
+struct MemBuffer {
+    uint8_t* ptr = nullptr;
+    size_t   len = 0;
+
+    uint8_t*       data()       { return ptr; }
+    const uint8_t* data() const { return ptr; }
+    size_t         size() const { return len; }
+    uint8_t&       operator[](size_t i)       { return ptr[i]; }
+    const uint8_t& operator[](size_t i) const { return ptr[i]; }
+};
+
+// A ROM mapped at a guest address (from the caller's buffer), and the file
+// holding the same bytes at offset, if any
+struct MemRom {
+    uint32_t       addr;
+    size_t         size;
     const uint8_t* data;
+    int            fd;
+    size_t         offset;
 };
 
 struct Mem {
-    std::vector<uint8_t> ram;
+    // RAM, IOP RAM and scratchpad share one arena, backed by a memfd when
+    // the host has one so fastmem can map more views of it
+    MemBuffer ram;
+    MemBuffer scratch;
+    MemBuffer iopRam;
+    uint8_t*  arena = nullptr;
+    size_t    arenaSize = 0;
+    int       arenaFd = -1;
+
+    // Fastmem window (base + guest address), or null when off
+    uint8_t*  fastmem = nullptr;
+    std::vector<MemRom> roms;
 
     std::vector<uint8_t> rom0; // .bin
     std::vector<uint8_t> rom1; // .rom1
@@ -26,16 +110,190 @@ struct Mem {
 
     uint64_t tick = 0;
     uint32_t intc_stat = 0;
+    uint32_t intc_mask = 0;
+
+    // One entry per guest page over the whole 32-bit space
+    uintptr_t* readPages = nullptr;
+    uintptr_t* writePages = nullptr;
+
+    // Register pages, reached through their page table entries
+    std::vector<MemMmioPage> mmioPages;
 
-    std::unordered_map<uint32_t, MemRegion> romMap;
+    // Anything else without a host mapping (unmapped pages, register slots
+    // no device claimed), called once per access with its width. Quadword
+    // accesses use the 128-bit hooks when set (FIFOs take whole quadwords)
+    // and two 64-bit halves otherwise.
+    uint64_t (*mmioRead)(void* user, uint32_t addr, uint32_t size) = nullptr;
+    void     (*mmioWrite)(void* user, uint32_t addr, uint64_t value, uint32_t size) = nullptr;
+    MemQword (*mmioRead128)(void* user, uint32_t addr) = nullptr;
+    void     (*mmioWrite128)(void* user, uint32_t addr, const MemQword& value) = nullptr;
+    void* mmioUser = nullptr;
+
+    // RAM pages holding cached EE code; a write to a flagged page clears
+    // the flag and queues the page for the block cache to invalidate.
+    std::vector<uint8_t>  codePages;
+    std::vector<uint32_t> dirtyCodePages;
+
+    // RAM page -> translated page mapping it (see memMapPhys), so tagging a
+    // code page reaches every alias
+    std::unordered_multimap<uint32_t, uint32_t> ramAliases;
+
+    // Called synchronously when a flagged page is first written (the
+    // recompiler unlinks its blocks before the queue is drained)
+    void (*onCodeWrite)(void* user, uint32_t page) = nullptr;
+    void* onCodeWriteUser = nullptr;
 };
 
 bool     memInit(Mem& m);
-uint32_t memRead32(const Mem& m, uint32_t addr);
-void     memWrite32(Mem& m, uint32_t addr, uint32_t value);
+void     memShutdown(Mem& m);
+
+// Zero RAM, IOP RAM and scratchpad by handing their pages back to the host
+// (they read as zero and cost nothing until touched again). Cached code in
+// RAM is queued for invalidation.
+void     memReset(Mem& m);
+
+// Reserved address space and resident bytes of each guest memory region
+enum MemRegion { MEM_REGION_RAM, MEM_REGION_IOP, MEM_REGION_SCRATCH, MEM_REGION_TABLES, MEM_REGION_COUNT };
+
+struct MemUsage {
+    const char* name;
+    size_t      reserved;
+    size_t      resident;
+};
+
+void     memUsage(const Mem& m, MemUsage out[MEM_REGION_COUNT]);
+
+// Reserve a 4 GB host window and map RAM, ROM and their mirrors into it at
+// base + guest address, leaving MMIO pages inaccessible. Returns false (and
+// leaves fastmem off) where the host can't; the page tables keep serving
+// every access either way.
+bool     memFastmemEnable(Mem& m);
+void     memFastmemDisable(Mem& m);
+
+// Unmapped or tagged pages (registers, code pages, ROM writes)
+void     memReadSlow(const Mem& m, uint32_t addr, void* out, uint32_t size);
+void     memWriteSlow(Mem& m, uint32_t addr, const void* src, uint32_t size);
+
+// Typed access for uint8_t through uint64_t and MemQword. Narrow accesses
+// must be naturally aligned (the CPU raises its address errors first);
+// quadwords ignore the low four address bits like the hardware does. An
+// aligned access never straddles a page, so the fast path is one table
+// load and an add (the -1 folds into the host addressing mode).
+template <typename T>
+struct MemAccess {
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                  "guest accesses are 8, 16, 32, 64 or 128 bits");
+    static uint32_t align(uint32_t addr) { return addr; }
+};
+
+template <>
+struct MemAccess<MemQword> {
+    static uint32_t align(uint32_t addr) { return addr & ~15u; }
+};
+
+template <typename T>
+static inline T memRead(const Mem& m, uint32_t addr) {
+    addr = MemAccess<T>::align(addr);
+    const uintptr_t e = m.readPages[addr >> MEM_PAGE_SHIFT];
+    T v;
+    if (e & MEM_PAGE_DIRECT) std::memcpy(&v, reinterpret_cast<const void*>(e - MEM_PAGE_DIRECT + addr), sizeof(T));
+    else                     memReadSlow(m, addr, &v, sizeof(T));
+    return v;
+}
+
+template <typename T>
+static inline void memWrite(Mem& m, uint32_t addr, const T& value) {
+    addr = MemAccess<T>::align(addr);
+    const uintptr_t e = m.writePages[addr >> MEM_PAGE_SHIFT];
+    if (e & MEM_PAGE_DIRECT) std::memcpy(reinterpret_cast<void*>(e - MEM_PAGE_DIRECT + addr), &value, sizeof(T));
+    else                     memWriteSlow(m, addr, &value, sizeof(T));
+}
+
+// For CPUs with an MMU: false, with nothing accessed, when addr lands on a
+// page nothing maps (or can't be written). The caller decides whether that
+// is a TLB exception or goes to memReadSlow/memWriteSlow after all.
+template <typename T>
+static inline bool memTryRead(const Mem& m, uint32_t addr, T& v) {
+    addr = MemAccess<T>::align(addr);
+    const uintptr_t e = m.readPages[addr >> MEM_PAGE_SHIFT];
+    if (e & MEM_PAGE_DIRECT) std::memcpy(&v, reinterpret_cast<const void*>(e - MEM_PAGE_DIRECT + addr), sizeof(T));
+    else if (e)              memReadSlow(m, addr, &v, sizeof(T));
+    return e != 0;
+}
+
+template <typename T>
+static inline bool memTryWrite(Mem& m, uint32_t addr, const T& value) {
+    addr = MemAccess<T>::align(addr);
+    const uintptr_t e = m.writePages[addr >> MEM_PAGE_SHIFT];
+    if (e & MEM_PAGE_DIRECT) std::memcpy(reinterpret_cast<void*>(e - MEM_PAGE_DIRECT + addr), &value, sizeof(T));
+    else if (e)              memWriteSlow(m, addr, &value, sizeof(T));
+    return e != 0;
+}
+
+// Shorthands
+inline uint8_t  memRead8(const Mem& m, uint32_t addr)  { return memRead<uint8_t>(m, addr); }
+inline uint16_t memRead16(const Mem& m, uint32_t addr) { return memRead<uint16_t>(m, addr); }
+inline uint32_t memRead32(const Mem& m, uint32_t addr) { return memRead<uint32_t>(m, addr); }
+inline uint64_t memRead64(const Mem& m, uint32_t addr) { return memRead<uint64_t>(m, addr); }
+inline MemQword memRead128(const Mem& m, uint32_t addr) { return memRead<MemQword>(m, addr); }
+
+inline void memWrite8(Mem& m, uint32_t addr, uint8_t value)   { memWrite(m, addr, value); }
+inline void memWrite16(Mem& m, uint32_t addr, uint16_t value) { memWrite(m, addr, value); }
+inline void memWrite32(Mem& m, uint32_t addr, uint32_t value) { memWrite(m, addr, value); }
+inline void memWrite64(Mem& m, uint32_t addr, uint64_t value) { memWrite(m, addr, value); }
+inline void memWrite128(Mem& m, uint32_t addr, const MemQword& value) { memWrite(m, addr, value); }
+
 void     memWriteBlock(Mem& m, uint32_t addr, const uint8_t* src, size_t size);
 
-void memMapRom(Mem& m, uint32_t physAddr, const uint8_t* data, size_t size);
+// Someone other than the EE (DMA) wrote RAM directly at [offset, offset +
+// size); drops cached code there the way a store would
+void     memRamWritten(Mem& m, uint32_t offset, uint32_t size);
+
+// Host pointer for guest addr (page-local), or nullptr if the page is unmapped
+const uint8_t* memHostPtr(const Mem& m, uint32_t addr);
+
+// Map size bytes of host memory at guest addr (page granular; a partial
+// last page is left unmapped). Read-only maps leave the write entry unmapped.
+void memMapPages(Mem& m, uint32_t addr, uint8_t* host, size_t size, bool writable);
+void memUnmapPages(Mem& m, uint32_t addr, size_t size);
+
+// Route the register slots covering [phys, phys + size) to a device, at the
+// physical address and its KSEG0/KSEG1 mirrors. Replaces any host mapping
+// of those pages; slots left unclaimed fall back to mmioRead/mmioWrite.
+void memMapMmio(Mem& m, uint32_t phys, uint32_t size, const MemMmioSlot& handlers);
+
+// Flag the claimed slots in [phys, phys + size) as changing only when the
+// EE writes them or a scheduler event fires (timers, INTC, DMAC), so an
+// idle loop may poll them
+void memMmioEventDriven(Mem& m, uint32_t phys, uint32_t size);
+
+// Can addr only change through EE stores, DMA or scheduler events? True
+// for memory and event-driven register slots; false for other registers
+// (VIF/GIF status moved by VU1 or the GS thread) and unmapped pages.
+bool memStableRead(const Mem& m, uint32_t addr);
+
+// Slot for a register with no side effects, kept in *reg
+MemMmioSlot memMmioReg(uint32_t* reg);
+MemMmioSlot memMmioReg(uint64_t* reg);
+
+// fd, when given, is a file holding data at offset 0; fastmem maps its pages
+// instead of copying them. Like data, it must stay valid while mapped.
+void memMapRom(Mem& m, uint32_t physAddr, const uint8_t* data, size_t size, int fd = -1);
+// Point aliasAddr's pages at whatever physAddr's pages map
 void memMapAliasKseg1(Mem& m, uint32_t aliasAddr, uint32_t physAddr, size_t size);
 
+// Translated pages (the EE TLB), page granular. memMapPhys points
+// [vaddr, vaddr + size) at physical memory as KSEG0 sees it, or at the
+// scratchpad for paddr in its window at MEM_SCRATCH_BASE; read-only maps
+// leave the write entries unmapped. memMapInvalid unmaps the range and
+// memMapDefault gives it back its untranslated mapping. Blocks cached from
+// remapped pages are queued for invalidation like written code pages.
+void memMapPhys(Mem& m, uint32_t vaddr, uint32_t paddr, size_t size, bool writable);
+void memMapInvalid(Mem& m, uint32_t vaddr, size_t size);
+void memMapDefault(Mem& m, uint32_t vaddr, size_t size);
+
+// Flag the RAM page containing addr as holding cached code. Returns the RAM
+// page index (what stores and DMA report as dirty), or -1 outside RAM.
+int64_t memMarkCodePage(Mem& m, uint32_t addr);
+
 void ps2CoreLoadNVM(const uint8_t* data, int length);
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "mtvu.h"
+#include "gif_fifo.h"
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint32_t MTVU_RING_QWORDS = 1u << 16;  // 1 MB
+static constexpr uint32_t MTVU_MAX_PAYLOAD = MTVU_RING_QWORDS; // words, a quarter of the ring
+static constexpr uint32_t MTVU_PATH1_QWORDS = 1u << 14;  // 256 KB, 16 kicks of all of VU1 data memory
+
+enum MTVUCmd : uint32_t { MTVU_KICK, MTVU_MICRO, MTVU_DATA, MTVU_TOPS };
+
+// -----------------------------------------------------------------------------
+// Consumer (worker thread)
+// -----------------------------------------------------------------------------
+
+// Runs one command; returns the number of quadwords it used
+static uint32_t mtvuExecute(void* user, uint32_t pos) {
+    MTVU& m = *static_cast<MTVU*>(user);
+    VU& vu = *m.vu;
+    const uint32_t* hdr = spscSlot(m.ring, pos);
+    const uint32_t words = hdr[0] >> 8, arg = hdr[1];
+    switch (hdr[0] & 0xFF) {
+        case MTVU_KICK:
+            vuStart(vu, arg);
+            vuFinish(vu);
+            break;
+        case MTVU_MICRO: {
+            const uint32_t start = (arg & vu.microMask) / 4;
+            const uint32_t n = std::min<uint32_t>(words, static_cast<uint32_t>(vu.micro.size()) - start);
+            spscCopyOut(m.ring, pos + 1, &vu.micro[start], n);
+            break;
+        }
+        case MTVU_DATA: {
+            const uint32_t start = arg & vu.dataMask;
+            const uint32_t n = std::min<uint32_t>(words / 4, static_cast<uint32_t>(vu.data.size()) - start);
+            spscCopyOut(m.ring, pos + 1, &vu.data[start], n * 4);
+            break;
+        }
+        case MTVU_TOPS:
+            vu.top = arg;
+            vu.itop = hdr[2];
+            break;
+        default:
+            break;
+    }
+    return 1 + (words + 3) / 4;
+}
+
+// One contiguous run of PATH1 data: to the GIF inline, queued for the EE
+// thread when threaded
+static void mtvuPath1Emit(MTVU& m, const uint32_t* data, uint32_t qwc) {
+    if (!m.threaded) {
+        gifFifoPush(*m.gif, data, qwc);
+        return;
+    }
+    uint64_t ns = 0;
+    const uint32_t h = spscReserveEntry(m.path1, 1 + qwc, ns);
+    uint32_t* hdr = spscSlot(m.path1, h);
+    hdr[0] = qwc;
+    hdr[1] = hdr[2] = hdr[3] = 0;
+    std::memcpy(spscSlot(m.path1, h + 1), data, size_t(qwc) * 16);
+    spscCommit(m.path1, h + 1 + qwc);
+}
+
+// XGKICK: the packet chain at addr, in two runs when it wraps around data
+// memory (gsProcessGifPacket carries GIFtag state across transfers)
+static void mtvuXgkick(void* user, VU& vu, uint32_t addr) {
+    MTVU& m = *static_cast<MTVU*>(user);
+    if (!m.gif) return;
+    const uint32_t* mem = vu.data[0].UL;
+    const uint32_t qwords = static_cast<uint32_t>(vu.data.size());
+    const uint32_t start = (addr / 16) & (qwords - 1);
+    const uint32_t qwc = gifPacketChainSize(mem, qwords, start);
+    const uint32_t first = std::min(qwc, qwords - start);
+    mtvuPath1Emit(m, mem + size_t(start) * 4, first);
+    if (qwc > first) mtvuPath1Emit(m, mem, qwc - first);
+}
+
+// -----------------------------------------------------------------------------
+// Producer (EE thread)
+// -----------------------------------------------------------------------------
+
+// Hands PATH1 entries from the worker to the GIF
+static uint32_t mtvuForwardPath1(void* user, uint32_t pos) {
+    MTVU& m = *static_cast<MTVU*>(user);
+    const uint32_t qwc = spscSlot(m.path1, pos)[0];
+    if (!qwc) return spscRoomToEnd(m.path1, pos);
+    gifFifoPush(*m.gif, spscSlot(m.path1, pos + 1), qwc);
+    return 1 + qwc;
+}
+
+// The worker may be waiting for PATH1 room while the EE waits on it
+static void mtvuPollPath1(void* user) {
+    spscPoll(static_cast<MTVU*>(user)->path1);
+}
+
+static void mtvuRecordWait(MTVU& m, uint64_t ns) {
+    m.syncs.fetch_add(1, std::memory_order_relaxed);
+    m.waitNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > m.maxWaitNs.load(std::memory_order_relaxed)) m.maxWaitNs.store(ns, std::memory_order_relaxed);
+}
+
+// Header quadword plus payload words, which may wrap around the ring end
+static void mtvuPush(MTVU& m, MTVUCmd cmd, uint32_t arg, uint32_t arg2, const void* payload, uint32_t words) {
+    const uint32_t qwords = 1 + (words + 3) / 4;
+    if (const uint64_t ns = spscReserve(m.ring, qwords)) {
+        m.ringStalls.fetch_add(1, std::memory_order_relaxed);
+        mtvuRecordWait(m, ns);
+    }
+    const uint32_t h = m.ring.head.load(std::memory_order_relaxed);
+    uint32_t* hdr = spscSlot(m.ring, h);
+    hdr[0] = cmd | words << 8;
+    hdr[1] = arg;
+    hdr[2] = arg2;
+    hdr[3] = 0;
+    if (words) spscCopyIn(m.ring, h + 1, payload, words);
+    spscCommit(m.ring, h + qwords);
+}
+
+void mtvuInit(MTVU& m, VU& vu1, GIFFifo* gif) {
+    mtvuShutdown(m);
+    m.vu = &vu1;
+    m.gif = gif;
+    vu1.onXgkick = mtvuXgkick;
+    vu1.xgkickUser = &m;
+    spscInit(m.ring, MTVU_RING_QWORDS, mtvuExecute, &m);
+    m.ring.onWait = mtvuPollPath1;
+    m.ring.waitUser = &m;
+    spscInit(m.path1, MTVU_PATH1_QWORDS, mtvuForwardPath1, &m);
+    m.kicks = 0; m.syncs = 0; m.waitNs = 0; m.maxWaitNs = 0; m.ringStalls = 0;
+}
+
+void mtvuShutdown(MTVU& m) {
+    if (m.threaded) mtvuSync(m);
+    spscStopWorker(m.ring);
+    m.threaded = false;
+}
+
+void mtvuSetThreaded(MTVU& m, bool threaded) {
+    if (threaded == m.threaded || !m.vu) return;
+    if (m.threaded) {
+        mtvuSync(m);
+        spscStopWorker(m.ring);
+    } else {
+        // A microprogram started inline finishes before the worker takes over
+        vuFinish(*m.vu);
+        spscStartWorker(m.ring);
+    }
+    m.threaded = threaded;
+}
+
+void mtvuKick(MTVU& m, uint32_t addr) {
+    m.kicks.fetch_add(1, std::memory_order_relaxed);
+    if (m.threaded) mtvuPush(m, MTVU_KICK, addr, 0, nullptr, 0);
+    else            vuStart(*m.vu, addr);
+}
+
+void mtvuWriteMicro(MTVU& m, uint32_t addr, const uint32_t* words, uint32_t count) {
+    if (!m.threaded) {
+        VU& vu = *m.vu;
+        const uint32_t start = (addr & vu.microMask) / 4;
+        const uint32_t n = std::min<uint32_t>(count, static_cast<uint32_t>(vu.micro.size()) - start);
+        std::memcpy(&vu.micro[start], words, n * 4);
+        return;
+    }
+    for (uint32_t done = 0; done < count;) {
+        const uint32_t n = std::min(count - done, MTVU_MAX_PAYLOAD);
+        mtvuPush(m, MTVU_MICRO, addr + done * 4, 0, words + done, n);
+        done += n;
+    }
+}
+
+void mtvuWriteData(MTVU& m, uint32_t qaddr, const VUVec* qwords, uint32_t count) {
+    if (!m.threaded) {
+        VU& vu = *m.vu;
+        const uint32_t start = qaddr & vu.dataMask;
+        const uint32_t n = std::min<uint32_t>(count, static_cast<uint32_t>(vu.data.size()) - start);
+        std::memcpy(&vu.data[start], qwords, n * sizeof(VUVec));
+        return;
+    }
+    for (uint32_t done = 0; done < count;) {
+        const uint32_t n = std::min(count - done, MTVU_MAX_PAYLOAD / 4);
+        mtvuPush(m, MTVU_DATA, qaddr + done, 0, qwords + done, n * 4);
+        done += n;
+    }
+}
+
+void mtvuSetTops(MTVU& m, uint32_t top, uint32_t itop) {
+    if (!m.threaded) {
+        m.vu->top = top;
+        m.vu->itop = itop;
+        return;
+    }
+    mtvuPush(m, MTVU_TOPS, top, itop, nullptr, 0);
+}
+
+bool mtvuBusy(const MTVU& m) {
+    if (!m.threaded) return m.vu->running;
+    return spscBusy(m.ring);
+}
+
+void mtvuSync(MTVU& m) {
+    if (!m.threaded) return;
+    if (const uint64_t ns = spscDrain(m.ring)) mtvuRecordWait(m, ns);
+    spscPoll(m.path1);
+}
+
+uint32_t mtvuRun(MTVU& m, uint32_t cycles) {
+    if (m.threaded) {
+        spscPoll(m.path1);
+        return 0;
+    }
+    if (!m.vu->running) return 0;
+    return vuRun(*m.vu, cycles);
+}
+
+MTVUStats mtvuStats(const MTVU& m) {
+    MTVUStats s;
+    s.kicks = m.kicks.load(std::memory_order_relaxed);
+    s.syncs = m.syncs.load(std::memory_order_relaxed);
+    s.waitNs = m.waitNs.load(std::memory_order_relaxed);
+    s.maxWaitNs = m.maxWaitNs.load(std::memory_order_relaxed);
+    s.ringStalls = m.ringStalls.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "spsc_ring.h"
+#include "vu.h"
+
+// VU1 front end. Inline mode runs VU1 on the EE thread in lockstep with it
+// (deterministic, the default). Threaded mode (MTVU) queues microprogram
+// kicks and VIF1 uploads on a single-producer/single-consumer ring; a
+// worker runs each microprogram to completion. The EE only waits at real
+// synchronization points (mtvuSync).
+//
+// XGKICK (PATH1) goes to the GIF FIFO, whose only producer is the EE
+// thread. Inline, VU1 pushes the packets itself. Threaded, the worker
+// queues them on a second ring flowing back, which the EE forwards from
+// mtvuRun and mtvuSync and while it waits on VU1.
+
+struct MTVUStats {
+    uint64_t kicks = 0;        // microprograms started
+    uint64_t syncs = 0;        // EE sync points that found VU1 busy
+    uint64_t waitNs = 0;       // EE time spent waiting on VU1
+    uint64_t maxWaitNs = 0;    // longest single wait
+    uint64_t ringStalls = 0;   // pushes that found the ring full
+};
+
+struct GIFFifo;
+
+struct MTVU {
+    VU* vu = nullptr;
+    GIFFifo* gif = nullptr;    // PATH1 output; none drops it
+    bool threaded = false;     // producer side only; change through mtvuSetThreaded
+
+    // Commands for the worker: a header quadword (command | payload words
+    // << 8, then its arguments), then the payload
+    SPSCRing ring;
+
+    // PATH1 from the worker: a header quadword (quadwords, 0 = skip to the
+    // ring end), then the GIF data. Drained by the EE thread, no worker.
+    SPSCRing path1;
+
+    std::atomic<uint64_t> kicks{0}, syncs{0}, waitNs{0}, maxWaitNs{0}, ringStalls{0};
+};
+
+// Also installs VU1's XGKICK hook
+void     mtvuInit(MTVU& m, VU& vu1, GIFFifo* gif);
+void     mtvuShutdown(MTVU& m);
+
+// Switch modes; drains the ring first, so VU1 state carries over
+void     mtvuSetThreaded(MTVU& m, bool threaded);
+
+// Producer side (EE thread): start a microprogram at byte address addr,
+// upload micro/data memory (VIF1 MPG/UNPACK), set the TOP/ITOP pointers
+void     mtvuKick(MTVU& m, uint32_t addr);
+void     mtvuWriteMicro(MTVU& m, uint32_t addr, const uint32_t* words, uint32_t count);
+void     mtvuWriteData(MTVU& m, uint32_t qaddr, const VUVec* qwords, uint32_t count);
+void     mtvuSetTops(MTVU& m, uint32_t top, uint32_t itop);
+
+// VPU-STAT/BC2 view: running or with queued work. Never waits.
+bool     mtvuBusy(const MTVU& m);
+
+// Wait until every queued command has run and VU1 is idle, then forward
+// its PATH1 output. Required before the EE reads or resets VU1 state.
+void     mtvuSync(MTVU& m);
+
+// Inline mode: advance VU1 by up to `cycles` pairs. Threaded: forward the
+// PATH1 output queued so far to the GIF and return 0.
+uint32_t mtvuRun(MTVU& m, uint32_t cycles);
+
+MTVUStats mtvuStats(const MTVU& m);
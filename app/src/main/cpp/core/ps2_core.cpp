@@ -1,4 +1,24 @@
 #include "ps2_core.h"
+#include "mem_map.h"
+#include "bios_image.h"
+#include "ee_cpu.h"
+#include "ee_tlb.h"
+#include "ee_block.h"
+#include "ee_jit.h"
+#include "ee_tcache.h"
+#include "ee_run.h"
+#include "vu.h"
+#include "mtvu.h"
+#include "vif.h"
+#include "ipu.h"
+#include "timers.h"
+#include "dma_stub.h"
+#include "sif_stub.h"
+#include "gs_stub.h"
+#include "gif_fifo.h"
+#include "gs_crtc.h"
+#include "scheduler.h"
+#include "debug_bus.h"
 
 #include <string>
 #include <vector>
@@ -6,150 +26,480 @@
 #include <mutex>
 #include <cstdint>
 #include <cstdio>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
 
-// BIOS storage
-static std::vector<uint8_t> g_biosData;
-static std::mutex g_biosLock;
+// BIOS: loaders publish a new image in g_biosPending and the tick thread
+// installs it between run slices. g_bios is only touched by that thread.
+static std::atomic<BiosImage*> g_biosPending{nullptr};
+static BiosImage*              g_bios = nullptr;
+static std::atomic<bool>       g_biosLoaded{false};
+
+// Control calls and the run loop; the BIOS image itself needs no lock
+static std::mutex g_stateLock;
 
 // VM state
 static std::atomic<long long> g_tickCount{0};
-static uint32_t g_pc = 0xBFC00000; // PS2 reset vector
-static std::string g_debugState = "EE loop initialized";
+static std::atomic<uint32_t> g_pc{0xBFC00000}; // PS2 reset vector
+
+// EE state
+static Mem          g_mem;
+static EERegs       g_ee;
+static EEBlockCache g_blocks;
+static EEJit        g_jit;
+static VU           g_vu0, g_vu1;
+static MTVU         g_mtvu;
+static bool         g_mtvuThreaded = false;
+static VIF          g_vif0, g_vif1;
+static IPU          g_ipu;
+static Timers       g_timers;
+static DMAC         g_dmac;
+static SIF          g_sif;
+static GS           g_gs;
+static GIFFifo      g_gif;
+static std::atomic<bool> g_gsThreaded{true}; // applied by the emulation thread
+static GSCrtc       g_crtc;
+static Scheduler    g_sched;
+static bool         g_fastmem = false;
+static bool         g_memReady = false;
+
+// Run loop variant, re-selected only when the debug features change
+static EERunHooks   g_hooks;
+static EERunFn      g_run = eeSelectRun(false, false, false);
+static bool         g_cycleAccurate = false;
+
+// Translation cache (empty dir = disabled)
+static std::string  g_cacheDir;
+
+// Virtual ranges the BIOS is executed from
+static constexpr uint32_t BIOS_CODE_BASES[] = {0xBFC00000, 0x9FC00000};
+static std::atomic<ExecResult> g_lastResult{ExecResult::Ok};
 
 // Simple register file (stubbed)
 static uint32_t g_registers[32] = {0};
 
-// --- Timing & interrupts (stubbed) ---
-static std::atomic<uint64_t> g_cycles{0};      // EE cycles (conceptual)
-static std::atomic<uint64_t> g_timer0{0};      // simple timer counter
-static std::atomic<bool>     g_irqPending{false}; // fake interrupt flag
+// --- Timing & interrupts ---
+static std::atomic<uint64_t> g_cycles{0};      // EE cycles, published from g_sched
+
+// Longest run slice when no event is due sooner
+static constexpr uint32_t MAX_SLICE_CYCLES = 4096;
+
+// Emulation thread: runs paced frames until paused or stopped. Control
+// calls come from one thread (the UI); g_runLock guards the flags.
+static std::thread             g_runThread;
+static std::mutex              g_runLock;
+static std::condition_variable g_runCv;
+static bool                    g_runPaused = false;
+static bool                    g_runStop = false;
+static std::atomic<bool>       g_running{false};
+
+// Frame pacing: ps2core_runFrame sleeps to the field rate unless in turbo.
+// The video mode applies from the next BIOS load.
+static std::atomic<bool>     g_turbo{false};
+static std::atomic<bool>     g_videoPal{false};
+static std::chrono::steady_clock::time_point g_frameDeadline;
+
+// Frames run and guest speed over the last report
+static std::atomic<uint64_t> g_frames{0};
+static std::atomic<double>   g_fps{0.0};
+static std::atomic<double>   g_speedPercent{0.0};
+static uint64_t              g_rateFrames = 0;
+static uint64_t              g_rateCycles = 0;
+static std::chrono::steady_clock::time_point g_rateTime = std::chrono::steady_clock::now();
+
+// Idle-loop fast-forward: cycles skipped, and the rate over the last report
+static std::atomic<uint64_t> g_idleSkipped{0};
+static uint64_t              g_idleSkippedLast = 0;
+static double                g_idleSkipRate = 0.0;
+static std::chrono::steady_clock::time_point g_idleRateTime = std::chrono::steady_clock::now();
 
 // BIOS base constant
 static constexpr uint32_t BIOS_BASE = 0xBFC00000;
 
-// --- Fetch ---
-static inline uint32_t read_u32_le(const uint8_t* p) {
-    // Treat BIOS bytes as little-endian for simplicity; adjust if needed
-    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+// --- Synchronize (the most important conceptual phase) ---
+static void synchronize(uint32_t cycles) {
+    // Advance virtual cycles—this is where "time moves forward"; whatever
+    // came due during the slice fires here
+    schedAdvance(g_sched, cycles);
+    g_cycles.store(g_sched.now, std::memory_order_relaxed);
+
+    // Future hooks:
+    // - DMA scheduling & progress
+    // - VU co-processor sync
+    // - GS timing (no rendering yet)
+    // - SPU2 audio timing
 }
 
-static uint32_t fetchInstruction(uint32_t pc) {
-    std::lock_guard<std::mutex> lock(g_biosLock);
-    if (g_biosData.empty()) return 0;
+// Device reads mid-slice see the EE's position in it. CycleAccurate runs
+// synchronize every instruction, so the clock is already exact there.
+static uint32_t eeSliceHook(void* ee) {
+    return eeSliceCycles(*static_cast<const EERegs*>(ee));
+}
 
-    if (pc < BIOS_BASE) return 0;
-    size_t offset = static_cast<size_t>(pc - BIOS_BASE);
-    if (offset + 4 <= g_biosData.size()) {
-        return read_u32_le(&g_biosData[offset]);
-    }
-    return 0; // NOP if out of bounds
+static void setSliceHook() {
+    g_sched.sliceCycles = g_cycleAccurate ? nullptr : eeSliceHook;
+    g_sched.sliceUser = &g_ee;
 }
 
-// --- Decode + Execute (intentionally stubbed) ---
-static void decodeAndExecute(uint32_t opcode) {
-    // Classification-only stub: side effects allowed to be no-ops
-    if (opcode == 0x00000000) { // NOP
-        g_debugState = "NOP executed";
-        return;
+// INTC: I_STAT bits clear and I_MASK bits flip when written with 1
+static void intcWriteStat(void* stat, uint32_t, uint64_t value, uint32_t) {
+    *static_cast<uint32_t*>(stat) &= ~static_cast<uint32_t>(value);
+}
+
+static void intcWriteMask(void* mask, uint32_t, uint64_t value, uint32_t) {
+    *static_cast<uint32_t*>(mask) ^= static_cast<uint32_t>(value) & 0x7FFF;
+}
+
+// Every EE register block claims its slots once; the page table keeps them
+// across BIOS reloads
+static void mapDevices() {
+    MemMmioSlot stat = memMmioReg(&g_mem.intc_stat);
+    MemMmioSlot mask = memMmioReg(&g_mem.intc_mask);
+    stat.write = intcWriteStat;
+    mask.write = intcWriteMask;
+    memMapMmio(g_mem, 0x1000F000, 16, stat);
+    memMapMmio(g_mem, 0x1000F010, 16, mask);
+    memMmioEventDriven(g_mem, 0x1000F000, 0x20);
+    timersMapMmio(g_timers, g_mem);
+    dmaMapMmio(g_dmac, g_mem);
+    vifMapMmio(g_vif0, 0, g_mem);
+    vifMapMmio(g_vif1, 1, g_mem);
+    ipuMapMmio(g_ipu, g_mem);
+    sifMapMmio(g_sif, g_mem);
+    gsMapMmio(g_gs, g_mem);
+}
+
+// Runs on the tick thread under g_stateLock, between run slices, so nothing
+// executes from the image being replaced when it is freed
+static void installBios(BiosImage* img) {
+    // Map the ROM at its physical address plus the KSEG0/KSEG1 mirrors
+    if (!g_memReady) {
+        g_memReady = memInit(g_mem);
+        if (!g_memReady) {
+            dbgPush("Mem: can't reserve guest memory");
+            biosImageFree(img);
+            return;
+        }
+        if (g_fastmem && !memFastmemEnable(g_mem)) dbgPush("Mem: fastmem unavailable, using page tables");
+        eeBlockCacheInit(g_blocks);
+        eeJitInit(g_jit, g_mem, g_blocks); // interpreter-only if unavailable
+        vuInit(g_vu0, 0);
+        vuInit(g_vu1, 1);
+        mtvuInit(g_mtvu, g_vu1, &g_gif);
+        mtvuSetThreaded(g_mtvu, g_mtvuThreaded);
+        g_ee.vu0 = &g_vu0;
+        g_ee.vu1 = &g_mtvu;
+        g_ee.dmac = &g_dmac;
+        gifFifoInit(g_gif, g_gs);
+        gifFifoSetThreaded(g_gif, g_gsThreaded.load());
+        mapDevices();
+        // Guest time keeps running across reloads, like the counters shown
+        schedInit(g_sched);
+        setSliceHook();
+#ifndef NDEBUG
+        // Debug builds check the SIMD MMI kernels against the scalar path
+        if (const uint32_t bad = eeMmiVerify(16, 0x9E3779B97F4A7C15ull)) {
+            dbgPush("EE: " + std::to_string(bad) + " MMI results differ from the reference");
+        }
+#endif
+    } else {
+        // Reloading reboots the guest: hand its memory back instead of clearing it
+        memReset(g_mem);
     }
+    g_mem.intc_stat = g_mem.intc_mask = 0;
+    const GSVideoMode videoMode =
+        g_videoPal.load(std::memory_order_relaxed) ? GSVideoMode::PAL : GSVideoMode::NTSC;
+    timersInit(g_timers, g_sched, g_mem.intc_stat, gsCrtcLineCycles(videoMode));
+    dmaInit(g_dmac, g_mem, g_sched);
+    vifInit(g_vif0, 0, &g_vu0, nullptr, nullptr);
+    vifInit(g_vif1, 1, nullptr, &g_mtvu, &g_gif);
+    dmaAttach(g_dmac, DMA_VIF0, dmaVifPort(g_vif0));
+    dmaAttach(g_dmac, DMA_VIF1, dmaVifPort(g_vif1));
+    ipuInit(g_ipu);
+    dmaAttach(g_dmac, DMA_FROM_IPU, dmaIpuOutPort(g_ipu));
+    dmaAttach(g_dmac, DMA_TO_IPU, dmaIpuInPort(g_ipu));
+    dmaAttach(g_dmac, DMA_GIF, dmaGifPort(g_gif));
+    // SIF0-2 stay detached until there is an IOP: SIF1/SIF2 sends are
+    // dropped and SIF0 never completes
+    sifInit(g_sif);
+    // The old guest's packets finish drawing before the GS resets
+    gifFifoSync(g_gif);
+    gsResetPriv(g_gs);
+    gsCrtcInit(g_crtc, g_gs, g_sched, g_mem.intc_stat, videoMode);
+    // Drop the previous image's pages before it goes away
+    for (uint32_t base : {0x1FC00000u, 0x9FC00000u, BIOS_BASE}) memUnmapPages(g_mem, base, BIOS_MAX_SIZE);
+    memMapRom(g_mem, 0x1FC00000, img->data, img->size, img->fd);
+    memMapAliasKseg1(g_mem, 0x9FC00000, 0x1FC00000, img->size);
+    memMapAliasKseg1(g_mem, BIOS_BASE, 0x1FC00000, img->size);
+    biosImageFree(g_bios);
+    g_bios = img;
 
-    // Minimal SPECIAL/J-type classification (no semantics yet)
-    uint32_t op = (opcode >> 26) & 0x3F;
-    switch (op) {
-        case 0x00: { // SPECIAL
-            uint32_t funct = opcode & 0x3F;
-            g_debugState = "SPECIAL funct=0x" + std::to_string(funct);
-            break;
+    eeTlbReset(g_ee, g_mem);
+    eeInit(g_ee, BIOS_BASE);
+    eeJitFlush(g_jit);
+    eeBlockCacheFlush(g_blocks, g_mem);
+    g_pc = g_ee.pc;
+
+    // Warm start from a previous session with this exact ROM
+    if (!g_cacheDir.empty()) {
+        for (uint32_t base : BIOS_CODE_BASES) {
+            eeTcacheLoad(eeTcachePath(g_cacheDir, img->hash, base), g_blocks, g_mem,
+                         img->hash, base, static_cast<uint32_t>(img->size),
+                         EE_JIT_HOT_THRESHOLD);
         }
-        case 0x02: { // J
-            g_debugState = "J-type opcode";
-            break;
+    }
+}
+
+// Hand a new image to the tick thread. An image published before it was
+// installed is simply replaced; the tick thread never saw it.
+static bool publishBios(BiosImage* img) {
+    if (!img) return false;
+    img->hash = eeTcacheHash(img->data, img->size);
+    biosImageFree(g_biosPending.exchange(img, std::memory_order_acq_rel));
+    g_biosLoaded.store(true, std::memory_order_release);
+    return true;
+}
+
+// --- Internal API (called from ps2_jni.cpp) ---
+bool ps2core_loadBiosPart(const char*, const uint8_t* data, size_t size) {
+    return data && size > 0 && publishBios(biosImageCopy(data, size));
+}
+
+bool ps2core_loadBiosFile(const char* path) {
+    return publishBios(biosImageOpen(path));
+}
+
+bool ps2core_loadBiosFd(int fd) {
+    return publishBios(biosImageOpenFd(fd));
+}
+
+void ps2core_setCacheDir(const char* dir) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    g_cacheDir = dir ? dir : "";
+}
+
+bool ps2core_saveCaches() {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    if (g_cacheDir.empty() || !g_bios) return false;
+
+    bool ok = true;
+    for (uint32_t base : BIOS_CODE_BASES) {
+        ok &= eeTcacheSave(eeTcachePath(g_cacheDir, g_bios->hash, base), g_blocks,
+                           g_bios->hash, base, static_cast<uint32_t>(g_bios->size),
+                           EE_JIT_HOT_THRESHOLD);
+    }
+    return ok;
+}
+
+// CycleAccurate runs report time after every instruction
+static void onEECycles(void*, uint32_t cycles) {
+    synchronize(cycles);
+}
+
+void ps2core_setRunPolicy(bool trace, bool cycleAccurate, bool breakpoints) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    g_run = eeSelectRun(trace, cycleAccurate, breakpoints);
+    g_cycleAccurate = cycleAccurate;
+    g_hooks.onCycles = cycleAccurate ? onEECycles : nullptr;
+    setSliceHook();
+}
+
+void ps2core_setBreakpoint(uint32_t pc, bool enabled) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    if (enabled) g_hooks.breakpoints.insert(pc);
+    else         g_hooks.breakpoints.erase(pc);
+}
+
+void ps2core_setFpuMode(bool accurate) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    eeSetFpuMode(accurate ? EEFpuMode::Accurate : EEFpuMode::Fast);
+    if (!g_memReady) return;
+    eeJitFlush(g_jit);
+    eeBlockCacheFlush(g_blocks, g_mem);
+}
+
+void ps2core_setBlockFpuMode(uint32_t pc, bool accurate, bool pinned) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    eeBlockSetFpuMode(g_blocks, pc, accurate ? EEFpuMode::Accurate : EEFpuMode::Fast, pinned);
+    if (g_memReady) eeJitFlush(g_jit);
+}
+
+void ps2core_setMtvu(bool threaded) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    g_mtvuThreaded = threaded;
+    if (g_memReady) mtvuSetThreaded(g_mtvu, threaded);
+}
+
+// The FIFO's mode belongs to its producer: the switch happens on the
+// emulation thread before its next slice (see ps2core_tick)
+void ps2core_setGsThread(bool threaded) {
+    g_gsThreaded.store(threaded);
+}
+
+void ps2core_setFastmem(bool enabled) {
+    std::lock_guard<std::mutex> lock(g_stateLock);
+    g_fastmem = enabled;
+    if (!g_memReady) return;
+    // The recompiler notices the change and drops code built for the old window
+    if (!enabled) memFastmemDisable(g_mem);
+    else if (!memFastmemEnable(g_mem)) dbgPush("Mem: fastmem unavailable, using page tables");
+}
+
+void ps2core_tick() {
+    // Stage 1-3: Fetch + Decode + Execute up to the next event (interpreted or compiled)
+    uint32_t executed = 0;
+    ExecResult r = ExecResult::Ok;
+    {
+        std::lock_guard<std::mutex> lock(g_stateLock);
+        if (g_biosPending.load(std::memory_order_relaxed)) {
+            installBios(g_biosPending.exchange(nullptr, std::memory_order_acq_rel));
         }
-        case 0x03: { // JAL
-            g_debugState = "JAL opcode";
-            break;
+        const bool gsThreaded = g_gsThreaded.load(std::memory_order_relaxed);
+        if (g_memReady && g_gif.threaded != gsThreaded) gifFifoSetThreaded(g_gif, gsThreaded);
+        if (g_bios) {
+            // Events fired last slice may have raised INT0 (INTC) or INT1 (DMAC)
+            eeCheckInterrupts(g_ee, (g_mem.intc_stat & g_mem.intc_mask) != 0, dmaInterrupt(g_dmac));
+            // Run up to the next deadline so no event fires late by more
+            // than the tail of one block
+            const uint32_t slice = schedCyclesToNext(g_sched, MAX_SLICE_CYCLES);
+            r = g_run(g_jit, g_ee, g_mem, g_hooks, static_cast<int32_t>(slice ? slice : 1), executed);
+            g_pc = g_ee.pc;
+            // Inline VU1 runs alongside the EE, one pair per EE cycle
+            mtvuRun(g_mtvu, executed ? executed : 1);
         }
-        default: {
-            g_debugState = "Opcode: 0x" + std::to_string(opcode);
-            break;
+
+        // Stage 4: Synchronize (advance time, timers, interrupts); cycle-accurate
+        // runs already did this per instruction. Still under the lock: event
+        // handlers (DMA) write guest memory and drop cached code.
+        if (!g_cycleAccurate && executed) synchronize(executed);
+        if (r == ExecResult::Idle) {
+            // The EE is spinning on something only an event can change
+            const uint32_t skip = schedCyclesToNext(g_sched, MAX_SLICE_CYCLES);
+            g_idleSkipped += skip;
+            mtvuRun(g_mtvu, skip); // inline VU1 keeps running while the EE waits on it
+            synchronize(skip);
+        } else if (!executed) {
+            synchronize(1);
         }
     }
-    // Side effects are intentionally minimal/no-op for v0.5
+
+    // Stage 5: Repeat is driven by ps2core_runFrame
+    g_tickCount++;
+    g_lastResult = r;
 }
 
-// --- Synchronize (the most important conceptual phase) ---
-static void synchronize() {
-    // Advance virtual cycles—this is where "time moves forward"
-    g_cycles += 1;
+void ps2core_runFrame() {
+    using Clock = std::chrono::steady_clock;
 
-    // Simple timer: increment every tick; trigger a fake IRQ periodically
-    g_timer0 += 1;
+    // Up to the next VBLANK start; a breakpoint ends the frame early
+    const uint64_t field = g_crtc.fields;
+    do {
+        ps2core_tick();
+    } while (g_bios && g_crtc.fields == field && g_lastResult != ExecResult::Breakpoint);
+    g_frames++;
 
-    // Example: raise an interrupt every 4096 cycles
-    if ((g_cycles.load() & 0xFFF) == 0) {
-        g_irqPending.store(true);
+    auto now = Clock::now();
+    if (g_turbo.load(std::memory_order_relaxed)) {
+        g_frameDeadline = now;
+    } else {
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / gsCrtcFieldRate(g_crtc.mode)));
+        g_frameDeadline += period;
+        // Too far behind (slow host, or resuming from a pause): restart the
+        // cadence rather than run a burst of frames to catch up
+        if (now - g_frameDeadline > 4 * period) g_frameDeadline = now;
+        else std::this_thread::sleep_until(g_frameDeadline);
+        now = Clock::now();
     }
 
-    // Handle pending interrupt (stubbed)
-    if (g_irqPending.load()) {
-        g_irqPending.store(false);
-        g_debugState = "IRQ serviced | cycles=" + std::to_string(g_cycles.load());
+    const double secs = std::chrono::duration<double>(now - g_rateTime).count();
+    if (secs >= 1.0) {
+        const uint64_t frames = g_frames.load(), cycles = g_cycles.load();
+        g_fps.store((frames - g_rateFrames) / secs);
+        g_speedPercent.store(100.0 * (cycles - g_rateCycles) / EE_CLOCK_HZ / secs);
+        g_rateFrames = frames;
+        g_rateCycles = cycles;
+        g_rateTime = now;
     }
-
-    // Future hooks:
-    // - DMA scheduling & progress
-    // - VU co-processor sync
-    // - GS timing (no rendering yet)
-    // - SPU2 audio timing
 }
 
-// --- Internal API (called from ps2_jni.cpp) ---
-bool ps2core_loadBiosPart(JNIEnv* env, jstring part, jbyteArray bytes) {
-    const char* partStr = env->GetStringUTFChars(part, nullptr);
-    jsize length = env->GetArrayLength(bytes);
-    jbyte* data = env->GetByteArrayElements(bytes, nullptr);
-
-    if (length <= 0 || data == nullptr) {
-        if (data) env->ReleaseByteArrayElements(bytes, data, JNI_ABORT);
-        env->ReleaseStringUTFChars(part, partStr);
-        return false;
+static void runLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(g_runLock);
+            g_runCv.wait(lock, [] { return g_runStop || !g_runPaused; });
+            if (g_runStop) return;
+        }
+        ps2core_runFrame();
+        // Stay on the breakpoint until resumed; the next run steps over it
+        if (g_lastResult.load() == ExecResult::Breakpoint) {
+            std::lock_guard<std::mutex> lock(g_runLock);
+            g_runPaused = true;
+            g_running = false;
+        }
     }
+}
 
+void ps2core_start() {
+    if (g_runThread.joinable()) {
+        ps2core_resume();
+        return;
+    }
     {
-        std::lock_guard<std::mutex> lock(g_biosLock);
-        g_biosData.assign(reinterpret_cast<uint8_t*>(data),
-                          reinterpret_cast<uint8_t*>(data) + length);
+        std::lock_guard<std::mutex> lock(g_runLock);
+        g_runStop = false;
+        g_runPaused = false;
+        g_running = true;
     }
+    g_runThread = std::thread(runLoop);
+}
 
-    env->ReleaseByteArrayElements(bytes, data, JNI_ABORT);
-    env->ReleaseStringUTFChars(part, partStr);
-    return true;
+void ps2core_pause() {
+    std::lock_guard<std::mutex> lock(g_runLock);
+    g_runPaused = true;
+    g_running = false;
 }
 
-void ps2core_tick() {
-    // Stage 1: Fetch
-    uint32_t opcode = fetchInstruction(g_pc);
-
-    // Stage 2 & 3: Decode + Execute (stubbed semantics)
-    if (!g_biosData.empty()) {
-        decodeAndExecute(opcode);
-        // Advance PC by one instruction (4 bytes)
-        g_pc += 4;
-    } else {
-        g_debugState = "BIOS not loaded";
+void ps2core_resume() {
+    {
+        std::lock_guard<std::mutex> lock(g_runLock);
+        if (!g_runThread.joinable()) return;
+        g_runPaused = false;
+        g_running = true;
     }
+    g_runCv.notify_one();
+}
 
-    // Stage 4: Synchronize (advance time, timers, interrupts)
-    synchronize();
+void ps2core_stop() {
+    if (!g_runThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(g_runLock);
+        g_runStop = true;
+        g_running = false;
+    }
+    g_runCv.notify_one();
+    g_runThread.join();
+}
 
-    // Stage 5: Repeat is driven externally by Kotlin coroutine
-    g_tickCount++;
+bool ps2core_isRunning() {
+    return g_running.load();
+}
 
-    // Update debug summary (hex PC for readability)
-    char buf[128];
-    std::snprintf(buf, sizeof(buf), "Tick %lld | PC=0x%08X | cycles=%llu",
-                  g_tickCount.load(), g_pc, (unsigned long long)g_cycles.load());
-    g_debugState = buf;
+void ps2core_setTurbo(bool enabled) {
+    g_turbo.store(enabled, std::memory_order_relaxed);
+}
+
+void ps2core_setVideoMode(bool pal) {
+    g_videoPal.store(pal, std::memory_order_relaxed);
+}
+
+double ps2core_getFps() {
+    return g_fps.load();
+}
+
+double ps2core_getSpeedPercent() {
+    return g_speedPercent.load();
 }
 
 uint32_t ps2core_getPC() {
@@ -160,6 +510,52 @@ long long ps2core_getTickCount() {
     return g_tickCount.load();
 }
 
-jstring ps2core_getDebugState(JNIEnv* env) {
-    return env->NewStringUTF(g_debugState.c_str());
-}
\ No newline at end of file
+// Formatted on request rather than every tick
+std::string ps2core_getDebugState() {
+    if (!g_biosLoaded.load(std::memory_order_acquire)) return "BIOS not loaded";
+
+    const auto now = std::chrono::steady_clock::now();
+    const double secs = std::chrono::duration<double>(now - g_idleRateTime).count();
+    if (secs >= 1.0) {
+        const uint64_t skipped = g_idleSkipped.load();
+        g_idleSkipRate = static_cast<double>(skipped - g_idleSkippedLast) / secs;
+        g_idleSkippedLast = skipped;
+        g_idleRateTime = now;
+    }
+
+    const ExecResult last = g_lastResult.load();
+    const char* status = last == ExecResult::Exception  ? " | exception" :
+                         last == ExecResult::Breakpoint ? " | breakpoint" :
+                         last == ExecResult::Idle       ? " | idle" : "";
+    const MTVUStats vu1 = mtvuStats(g_mtvu);
+    const GIFFifoStats gif = gifFifoStats(g_gif);
+    MemUsage usage[MEM_REGION_COUNT] = {};
+    const bool gsThreaded = g_gsThreaded.load();
+    bool mtvuThreaded;
+    {
+        // Between run slices, so the emulation thread isn't remapping memory
+        std::lock_guard<std::mutex> lock(g_stateLock);
+        if (g_memReady) memUsage(g_mem, usage);
+        mtvuThreaded = g_mtvuThreaded;
+    }
+    size_t reserved = 0, resident = 0;
+    for (const MemUsage& u : usage) {
+        reserved += u.reserved;
+        resident += u.resident;
+    }
+    char buf[576];
+    std::snprintf(buf, sizeof(buf),
+                  "Tick %lld | PC=0x%08X | cycles=%llu | %.1f fps (%.0f%%)%s | idle skip=%.0f cyc/s | unimpl=%llu"
+                  " | VU1%s kicks=%llu waits=%llu (%.2f ms, max %.2f ms)"
+                  " | GIF%s queue=%u/%u QW (peak %u) stalls=%llu (%.2f ms) syncs=%llu (%.2f ms)"
+                  " | mem %zu/%zu KB%s",
+                  g_tickCount.load(), g_pc.load(), (unsigned long long)g_cycles.load(),
+                  g_fps.load(), g_speedPercent.load(), g_turbo.load() ? " turbo" : "", g_idleSkipRate,
+                  (unsigned long long)eeUnimplementedTotal(), mtvuThreaded ? " (MTVU)" : "",
+                  (unsigned long long)vu1.kicks, (unsigned long long)vu1.syncs,
+                  vu1.waitNs / 1e6, vu1.maxWaitNs / 1e6, gsThreaded ? " (GS thread)" : "",
+                  gif.occupancy, gif.capacity, gif.maxOccupancy, (unsigned long long)gif.ringStalls,
+                  gif.stallNs / 1e6, (unsigned long long)gif.syncs, gif.syncNs / 1e6,
+                  resident >> 10, reserved >> 10, status);
+    return buf;
+}
@@ -1,10 +1,62 @@
 // ps2_core.h
 #pragma once
-#include <jni.h>
+#include <cstddef>
 #include <cstdint>
+#include <string>
 
-bool     ps2core_loadBiosPart(JNIEnv* env, jstring part, jbyteArray bytes);
+// Emulator front end driven by ps2_jni.cpp (and the host tests); nothing
+// here depends on JNI.
+
+// Copy a ROM dump (the .bin part) into a new BIOS image
+bool     ps2core_loadBiosPart(const char* part, const uint8_t* data, size_t size);
+// Map the ROM straight from a file (by path, or an fd the caller keeps
+// owning) instead of copying it. Any load is installed at the next tick.
+bool     ps2core_loadBiosFile(const char* path);
+bool     ps2core_loadBiosFd(int fd);
+
+// Emulation thread owned by the core, running paced frames back to back.
+// Control calls come from one thread; start resumes a paused thread and a
+// breakpoint pauses it. State getters are safe to poll while it runs.
+void     ps2core_start();
+void     ps2core_pause();
+void     ps2core_resume();
+void     ps2core_stop();
+bool     ps2core_isRunning();
+
+// One run slice, or one frame: up to the next VBLANK start, then a sleep
+// to the field rate (59.94/50 Hz) unless turbo is on. For callers driving
+// the core themselves, with the run thread stopped.
 void     ps2core_tick();
+void     ps2core_runFrame();
+void     ps2core_setTurbo(bool enabled);
+// PAL instead of NTSC timing from the next BIOS load
+void     ps2core_setVideoMode(bool pal);
+// Frames per second and percent of full guest speed, over the last second
+double   ps2core_getFps();
+double   ps2core_getSpeedPercent();
 uint32_t ps2core_getPC();
 long long ps2core_getTickCount();
-jstring  ps2core_getDebugState(JNIEnv* env);
+std::string ps2core_getDebugState();
+
+// Translation cache directory; BIOS loads after this warm-start from it
+void     ps2core_setCacheDir(const char* dir);
+bool     ps2core_saveCaches();
+
+// Debug features of the EE run loop; each combination is a separate
+// compiled loop, so features left off cost nothing
+void     ps2core_setRunPolicy(bool trace, bool cycleAccurate, bool breakpoints);
+void     ps2core_setBreakpoint(uint32_t pc, bool enabled);
+
+// FPU accuracy, globally or pinned for the block starting at pc
+void     ps2core_setFpuMode(bool accurate);
+void     ps2core_setBlockFpuMode(uint32_t pc, bool accurate, bool pinned);
+
+// Run VU1 on its own thread (MTVU) instead of in lockstep with the EE
+void     ps2core_setMtvu(bool threaded);
+
+// Drain GIF transfers on a GS thread instead of on the EE thread (default)
+void     ps2core_setGsThread(bool threaded);
+
+// Serve compiled loads from a reserved 4 GB host window (falls back to the
+// page tables where the host can't reserve one)
+void     ps2core_setFastmem(bool enabled);
@@ -1,9 +1,76 @@
 #include "scheduler.h"
+#include <algorithm>
+
+// std heap functions build a max-heap; invert the order for earliest-first
+static inline bool schedLater(const SchedEntry& a, const SchedEntry& b) {
+    return a.when > b.when;
+}
+
+static inline bool schedStale(const Scheduler& s, const SchedEntry& e) {
+    return s.deadline[e.event] != e.when;
+}
+
+// Drop dead entries off the top and cache the earliest live deadline
+static void schedRefresh(Scheduler& s) {
+    while (!s.heap.empty() && schedStale(s, s.heap.front())) {
+        std::pop_heap(s.heap.begin(), s.heap.end(), schedLater);
+        s.heap.pop_back();
+    }
+    s.next = s.heap.empty() ? SCHED_NEVER : s.heap.front().when;
+}
 
 void schedInit(Scheduler& s) {
-    s.ticks = 0;
+    s.now = 0;
+    s.next = SCHED_NEVER;
+    std::fill(std::begin(s.deadline), std::end(s.deadline), SCHED_NEVER);
+    std::fill(std::begin(s.handler), std::end(s.handler), nullptr);
+    std::fill(std::begin(s.user), std::end(s.user), nullptr);
+    s.heap.clear();
+    s.heap.reserve(4 * SCHED_EVENT_COUNT);
+    s.fired = 0;
+    s.sliceCycles = nullptr;
+    s.sliceUser = nullptr;
+}
+
+void schedSetHandler(Scheduler& s, SchedEvent ev, SchedHandler fn, void* user) {
+    s.handler[ev] = fn;
+    s.user[ev] = user;
+}
+
+void schedAt(Scheduler& s, SchedEvent ev, uint64_t when) {
+    s.deadline[ev] = when;
+    // Events that keep moving leave stale entries; rebuild from the live set
+    // before they pile up
+    if (s.heap.size() >= 4 * SCHED_EVENT_COUNT) {
+        s.heap.clear();
+        for (uint32_t i = 0; i < SCHED_EVENT_COUNT; ++i) {
+            if (s.deadline[i] != SCHED_NEVER && i != ev) s.heap.push_back(SchedEntry{s.deadline[i], i});
+        }
+        std::make_heap(s.heap.begin(), s.heap.end(), schedLater);
+    }
+    s.heap.push_back(SchedEntry{when, ev});
+    std::push_heap(s.heap.begin(), s.heap.end(), schedLater);
+    schedRefresh(s);
+}
+
+void schedIn(Scheduler& s, SchedEvent ev, uint64_t cycles) {
+    schedAt(s, ev, s.now + cycles);
+}
+
+void schedCancel(Scheduler& s, SchedEvent ev) {
+    s.deadline[ev] = SCHED_NEVER;
+    schedRefresh(s);
 }
 
-void schedTick(Scheduler& s) {
-    s.ticks++;
+void schedAdvanceSlow(Scheduler& s) {
+    while (s.next <= s.now) {
+        const SchedEntry e = s.heap.front();
+        std::pop_heap(s.heap.begin(), s.heap.end(), schedLater);
+        s.heap.pop_back();
+        // A handler may post its own event again (periodic sources)
+        s.deadline[e.event] = SCHED_NEVER;
+        s.fired++;
+        if (s.handler[e.event]) s.handler[e.event](s.user[e.event], e.when);
+        schedRefresh(s);
+    }
 }
@@ -1,9 +1,80 @@
 #pragma once
 #include <cstdint>
+#include <vector>
+
+// Timed events on the EE clock. Each source owns one event id with at most
+// one deadline pending; posting it again moves the deadline. The CPU runs
+// in slices no longer than schedCyclesToNext() and reports each slice to
+// schedAdvance(), which fires whatever came due in deadline order. Nothing
+// is checked per instruction.
+enum SchedEvent : uint32_t {
+    SCHED_TIMER0, SCHED_TIMER1, SCHED_TIMER2, SCHED_TIMER3,
+    SCHED_HBLANK,
+    SCHED_VBLANK,
+    SCHED_DMA,
+    SCHED_SIF,
+    SCHED_EVENT_COUNT
+};
+
+static constexpr uint64_t SCHED_NEVER = UINT64_MAX;
+
+// The clock every deadline is counted in
+static constexpr uint32_t EE_CLOCK_HZ = 294912000;
+
+// when is the deadline the event was posted for; the clock may be past it
+// by the end of the slice that reached it
+using SchedHandler = void (*)(void* user, uint64_t when);
+
+struct SchedEntry {
+    uint64_t when;
+    uint32_t event;
+};
 
 struct Scheduler {
-    [[maybe_unused]]    uint64_t ticks = 0;
+    uint64_t now  = 0;              // EE cycles so far
+    uint64_t next = SCHED_NEVER;    // earliest pending deadline
+    uint64_t deadline[SCHED_EVENT_COUNT];
+    SchedHandler handler[SCHED_EVENT_COUNT] = {};
+    void*        user[SCHED_EVENT_COUNT] = {};
+
+    // Min-heap on when. Moving or cancelling an event leaves its old entry
+    // behind; entries that no longer match deadline[] are dropped when they
+    // reach the top.
+    std::vector<SchedEntry> heap;
+    uint64_t fired = 0;
+
+    // How far the CPU is into the slice it is running, which now does not
+    // include until schedAdvance. Lets register reads mid-slice (timer
+    // COUNT) see the current cycle; none means now is exact.
+    uint32_t (*sliceCycles)(void* user) = nullptr;
+    void*    sliceUser = nullptr;
 };
 
-void schedInit(Scheduler& s);
-void schedTick(Scheduler& s);
\ No newline at end of file
+// Clears the clock, pending events, handlers and the slice hook
+void     schedInit(Scheduler& s);
+void     schedSetHandler(Scheduler& s, SchedEvent ev, SchedHandler fn, void* user);
+
+// The current cycle, including the slice in progress
+inline uint64_t schedNowInSlice(const Scheduler& s) {
+    return s.now + (s.sliceCycles ? s.sliceCycles(s.sliceUser) : 0);
+}
+
+// Post ev for an absolute cycle / cycles from now, replacing any pending one
+void     schedAt(Scheduler& s, SchedEvent ev, uint64_t when);
+void     schedIn(Scheduler& s, SchedEvent ev, uint64_t cycles);
+void     schedCancel(Scheduler& s, SchedEvent ev);
+inline bool schedPending(const Scheduler& s, SchedEvent ev) { return s.deadline[ev] != SCHED_NEVER; }
+
+// Cycles until the next deadline, at most limit (0 when one is already due)
+inline uint32_t schedCyclesToNext(const Scheduler& s, uint32_t limit) {
+    if (s.next <= s.now) return 0;
+    const uint64_t left = s.next - s.now;
+    return left < limit ? static_cast<uint32_t>(left) : limit;
+}
+
+// Move the clock forward and fire every event due by then
+void     schedAdvanceSlow(Scheduler& s);
+inline void schedAdvance(Scheduler& s, uint32_t cycles) {
+    s.now += cycles;
+    if (s.next <= s.now) schedAdvanceSlow(s);
+}
@@ -1,25 +1,32 @@
 #include "sif_stub.h"
+#include "mem_map.h"
 
 void sifInit(SIF& s) {
     s = SIF{};
 }
 
-uint32_t sifReadReg(SIF& s, uint32_t addr) {
-    switch (addr) {
-        case 0x1000F230: return s.main_ctrl | 0x10001; // Force 'IOP Ready' bits
-        case 0x1D000010: return s.sub_ctrl;
-        case 0x1000F210: return s.ms_com; // EE to IOP
-        case 0x1000F220: return s.sm_com; // IOP to EE
-        default: return 0;
-    }
+// The EE sets MSFLAG bits and clears SMFLAG bits by writing 1s
+static void sifWriteMsFlag(void* flag, uint32_t, uint64_t value, uint32_t) {
+    *static_cast<uint32_t*>(flag) |= static_cast<uint32_t>(value);
 }
 
-void sifWriteReg(SIF& s, uint32_t addr, uint32_t val) {
-    switch (addr) {
-        case 0x1000F230: s.main_ctrl = val; break;
-        case 0x1D000010: s.sub_ctrl = val; break;
-        case 0x1000F210: s.ms_com = val; break;
-        case 0x1000F220: s.sm_com = val; break;
-        default: break;
-    }
+static void sifWriteSmFlag(void* dev, uint32_t, uint64_t value, uint32_t) {
+    static_cast<SIF*>(dev)->sm_flag &= ~static_cast<uint32_t>(value);
+}
+
+static uint64_t sifReadSmFlag(void* dev, uint32_t, uint32_t) {
+    return static_cast<SIF*>(dev)->sm_flag | 0x10001; // Force 'IOP Ready' bits
+}
+
+void sifMapMmio(SIF& s, Mem& mem) {
+    MemMmioSlot msflag = memMmioReg(&s.ms_flag);
+    msflag.write = sifWriteMsFlag;
+    const MemMmioSlot smflag{sifReadSmFlag, sifWriteSmFlag, nullptr, nullptr, &s};
+
+    memMapMmio(mem, 0x1000F200, 16, memMmioReg(&s.ms_com));
+    memMapMmio(mem, 0x1000F210, 16, memMmioReg(&s.sm_com));
+    memMapMmio(mem, 0x1000F220, 16, msflag);
+    memMapMmio(mem, 0x1000F230, 16, smflag);
+    memMapMmio(mem, 0x1000F240, 16, memMmioReg(&s.ctrl));
+    memMapMmio(mem, 0x1000F260, 16, memMmioReg(&s.bd6));
 }
@@ -1,14 +1,18 @@
 #pragma once
 #include <cstdint>
 
+struct Mem; // forward declaration
+
 struct SIF {
-    uint32_t main_ctrl = 0;
-    uint32_t sub_ctrl = 0;
-    uint32_t ms_com = 0;
-    uint32_t sm_com = 0;
+    uint32_t ms_com = 0;  // EE to IOP
+    uint32_t sm_com = 0;  // IOP to EE
+    uint32_t ms_flag = 0;
+    uint32_t sm_flag = 0;
+    uint32_t ctrl = 0;
+    uint32_t bd6 = 0;
     // SIF DMA would go here
 };
 
 void sifInit(SIF& s);
-uint32_t sifReadReg(SIF& s, uint32_t addr);
-void sifWriteReg(SIF& s, uint32_t addr, uint32_t val);
+// EE side of the SIF registers, 0x1000F200..0x1000F260
+void sifMapMmio(SIF& s, Mem& mem);
@@ -0,0 +1,139 @@
+#include "spsc_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// The producer never lets head catch up with tail, so head == tail means
+// empty and the ring holds one quadword less than its size.
+
+static inline uint64_t spscNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// -----------------------------------------------------------------------------
+// Consumer (worker thread)
+// -----------------------------------------------------------------------------
+
+static void spscWorker(SPSCRing* rp) {
+    SPSCRing& r = *rp;
+    for (;;) {
+        uint32_t t = r.tail.load(std::memory_order_relaxed);
+        if (t == r.head.load()) {
+            std::unique_lock<std::mutex> lk(r.lock);
+            r.cv.wait(lk, [&] {
+                return r.quit.load(std::memory_order_acquire) ||
+                       r.tail.load(std::memory_order_relaxed) != r.head.load(std::memory_order_acquire);
+            });
+            if (r.tail.load(std::memory_order_relaxed) == r.head.load(std::memory_order_acquire)) return;
+            continue;
+        }
+        r.busy.store(true, std::memory_order_relaxed);
+        t += r.consume(r.user, t);
+        r.tail.store(t, std::memory_order_release);
+        r.busy.store(false);    // seq_cst: pairs with the producer's head/busy check
+    }
+}
+
+void spscInit(SPSCRing& r, uint32_t qwords, uint32_t (*consume)(void* user, uint32_t pos), void* user) {
+    spscStopWorker(r);
+    r.words.assign(size_t(qwords) * 4, 0u);
+    r.mask = qwords - 1;
+    r.head.store(0);
+    r.tail.store(0);
+    r.busy.store(false);
+    r.consume = consume;
+    r.user = user;
+}
+
+void spscStartWorker(SPSCRing& r) {
+    r.quit.store(false);
+    r.worker = std::thread(spscWorker, &r);
+}
+
+void spscStopWorker(SPSCRing& r) {
+    if (!r.worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(r.lock);
+        r.quit.store(true, std::memory_order_release);
+    }
+    r.cv.notify_one();
+    r.worker.join();
+}
+
+void spscCopyIn(SPSCRing& r, uint32_t pos, const void* src, uint32_t count) {
+    const uint32_t* in = static_cast<const uint32_t*>(src);
+    const uint32_t first = std::min(count, spscRoomToEnd(r, pos) * 4);
+    std::memcpy(spscSlot(r, pos), in, size_t(first) * 4);
+    std::memcpy(r.words.data(), in + first, size_t(count - first) * 4);
+}
+
+void spscCopyOut(const SPSCRing& r, uint32_t pos, void* dst, uint32_t count) {
+    uint32_t* out = static_cast<uint32_t*>(dst);
+    const uint32_t first = std::min(count, spscRoomToEnd(r, pos) * 4);
+    std::memcpy(out, spscSlot(r, pos), size_t(first) * 4);
+    std::memcpy(out + first, r.words.data(), size_t(count - first) * 4);
+}
+
+// -----------------------------------------------------------------------------
+// Producer
+// -----------------------------------------------------------------------------
+
+uint64_t spscReserve(SPSCRing& r, uint32_t qwords) {
+    const uint32_t h = r.head.load(std::memory_order_relaxed);
+    if (h - r.tail.load(std::memory_order_acquire) + qwords <= r.mask) return 0;
+
+    const uint64_t start = spscNow();
+    while (h - r.tail.load(std::memory_order_acquire) + qwords > r.mask) {
+        if (r.onWait) r.onWait(r.waitUser);
+        std::this_thread::yield();
+    }
+    return std::max<uint64_t>(spscNow() - start, 1);
+}
+
+uint32_t spscReserveEntry(SPSCRing& r, uint32_t qwords, uint64_t& waitedNs) {
+    uint32_t h = r.head.load(std::memory_order_relaxed);
+    const uint32_t room = spscRoomToEnd(r, h);
+    const uint32_t pad = room < qwords ? room : 0;
+    waitedNs += spscReserve(r, pad + qwords);
+    if (pad) {
+        spscSlot(r, h)[0] = 0;
+        h += pad;
+    }
+    return h;
+}
+
+// A busy worker rechecks head before sleeping, so it needs no notification
+void spscCommit(SPSCRing& r, uint32_t newHead) {
+    r.head.store(newHead);
+    if (!r.busy.load()) {
+        std::lock_guard<std::mutex> lk(r.lock);
+        r.cv.notify_one();
+    }
+}
+
+uint64_t spscDrain(SPSCRing& r) {
+    if (!spscBusy(r)) return 0;
+    const uint64_t start = spscNow();
+    while (spscBusy(r)) {
+        if (r.onWait) r.onWait(r.waitUser);
+        std::this_thread::yield();
+    }
+    return std::max<uint64_t>(spscNow() - start, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Consumer without a worker
+// -----------------------------------------------------------------------------
+
+// tail moves after each entry so a waiting producer gets room early
+bool spscPoll(SPSCRing& r) {
+    uint32_t t = r.tail.load(std::memory_order_relaxed);
+    const uint32_t h = r.head.load(std::memory_order_acquire);
+    if (t == h) return false;
+    while (t != h) {
+        t += r.consume(r.user, t);
+        r.tail.store(t, std::memory_order_release);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Single-producer/single-consumer ring of quadwords with the worker thread
+// that drains it (MTVU, the GIF FIFO). The owner lays out its own entries;
+// the worker hands each one to `consume`, which returns how many quadwords
+// it used. head is written by the producer, tail by the worker; both count
+// quadwords and wrap at 2^32.
+
+struct SPSCRing {
+    // Quadwords as four words each; the size is a power of two
+    std::vector<uint32_t> words;
+    uint32_t mask = 0;
+
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<bool>     busy{false};   // worker is running `consume`
+    std::atomic<bool>     quit{false};
+
+    std::thread worker;
+    std::mutex  lock;                    // only for sleeping on cv
+    std::condition_variable cv;
+
+    uint32_t (*consume)(void* user, uint32_t pos) = nullptr;
+    void*    user = nullptr;
+
+    // Called on every spin of a producer-side wait (spscReserve, spscDrain),
+    // for a producer that must keep draining a ring flowing back from the
+    // worker while it waits on it
+    void (*onWait)(void* user) = nullptr;
+    void*  waitUser = nullptr;
+};
+
+// Empty ring of `qwords` (a power of two); stops the worker first
+void     spscInit(SPSCRing& r, uint32_t qwords, uint32_t (*consume)(void* user, uint32_t pos), void* user);
+
+void     spscStartWorker(SPSCRing& r);
+// Lets the worker finish what is queued, then joins it
+void     spscStopWorker(SPSCRing& r);
+
+inline uint32_t  spscCapacity(const SPSCRing& r) { return r.mask; }
+inline uint32_t* spscSlot(SPSCRing& r, uint32_t pos) { return &r.words[(pos & r.mask) * 4]; }
+inline const uint32_t* spscSlot(const SPSCRing& r, uint32_t pos) { return &r.words[(pos & r.mask) * 4]; }
+
+// Quadwords from pos to the ring end
+inline uint32_t  spscRoomToEnd(const SPSCRing& r, uint32_t pos) { return r.mask + 1 - (pos & r.mask); }
+
+// Copy `count` words to/from the ring starting at quadword pos, wrapping
+// at the end
+void     spscCopyIn(SPSCRing& r, uint32_t pos, const void* src, uint32_t count);
+void     spscCopyOut(const SPSCRing& r, uint32_t pos, void* dst, uint32_t count);
+
+// Producer: wait until `qwords` more fit. Returns the nanoseconds spent
+// waiting, 0 when there was room.
+uint64_t spscReserve(SPSCRing& r, uint32_t qwords);
+
+// Producer: room for one contiguous entry of `qwords` (header included),
+// which must be less than the ring size. An entry that would cross the ring
+// end is preceded by a skip entry (first word 0) padding out to the start;
+// consume returns spscRoomToEnd for it. Returns where the entry goes and
+// adds any time spent waiting to waitedNs.
+uint32_t spscReserveEntry(SPSCRing& r, uint32_t qwords, uint64_t& waitedNs);
+
+// Producer: publish everything written up to newHead and wake the worker
+void     spscCommit(SPSCRing& r, uint32_t newHead);
+
+// Entries queued or being consumed. Never waits.
+inline bool spscBusy(const SPSCRing& r) {
+    return r.head.load(std::memory_order_relaxed) != r.tail.load(std::memory_order_acquire) ||
+           r.busy.load(std::memory_order_acquire);
+}
+
+// Producer: wait until the worker has consumed everything queued. Returns
+// the nanoseconds spent waiting, 0 when it was already idle.
+uint64_t spscDrain(SPSCRing& r);
+
+// Consumer for a ring without a worker: consume everything queued, on the
+// calling thread. Returns false when there was nothing.
+bool     spscPoll(SPSCRing& r);
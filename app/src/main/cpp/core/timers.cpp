@@ -1,128 +1,189 @@
 #include "timers.h"
-#include <cstring>
+#include "mem_map.h"
+#include "scheduler.h"
 
 // Timer Register Offsets
 // 0x10000000 + (id * 0x800)
 // +00: COUNT
 // +10: MODE
 // +20: COMP (Target)
-// +30: HOLD
+// +30: HOLD (T0/T1)
 
-void timersInit(Timers& tm) {
-    tm = Timers{};
+// MODE bits
+static constexpr uint32_t MODE_CLKS = 3u << 0;   // BUSCLK, /16, /256, HBLANK
+static constexpr uint32_t MODE_ZRET = 1u << 6;   // clear COUNT on reaching COMP
+static constexpr uint32_t MODE_CUE  = 1u << 7;   // count enable
+static constexpr uint32_t MODE_CMPE = 1u << 8;   // IRQ on compare
+static constexpr uint32_t MODE_OVFE = 1u << 9;   // IRQ on overflow
+static constexpr uint32_t MODE_EQUF = 1u << 10;  // compare flag, write 1 to clear
+static constexpr uint32_t MODE_OVFF = 1u << 11;  // overflow flag, write 1 to clear
+static constexpr uint32_t MODE_FLAGS = MODE_EQUF | MODE_OVFF;
+
+// Gating (GATE/GATS/GATM) isn't modelled; gated timers count freely.
+// BUSCLK is half the EE clock; HBLANK follows the CRTC's line rate.
+static constexpr uint32_t TIMER_PERIOD = 0x10000; // COUNT is 16 bits
+
+static inline uint32_t timerDivider(const Timers& tm, const Ps2Timer& t) {
+    switch (t.mode & MODE_CLKS) {
+    case 0:  return 2;
+    case 1:  return 2 * 16;
+    case 2:  return 2 * 256;
+    default: return tm.hblankCycles;
+    }
+}
+
+static inline bool timerZret(const Ps2Timer& t) {
+    return (t.mode & MODE_ZRET) && t.target != 0;
+}
+
+// Ticks from count until COUNT next equals v (1..0x10000)
+static inline uint32_t timerTicksTo(const Ps2Timer& t, uint32_t v) {
+    return ((v - t.count - 1) & (TIMER_PERIOD - 1)) + 1;
+}
+
+// Ticks to the next compare / overflow; 0 when it can't happen. With ZRET,
+// a count below COMP wraps there and never overflows.
+static inline uint32_t timerTicksToCompare(const Ps2Timer& t) { return timerTicksTo(t, t.target); }
+static inline uint32_t timerTicksToOverflow(const Ps2Timer& t) {
+    return timerZret(t) && t.count < t.target ? 0 : TIMER_PERIOD - t.count;
+}
+
+// COUNT after ticks more clock edges
+static uint32_t timerCountAfter(const Ps2Timer& t, uint64_t ticks) {
+    if (timerZret(t)) {
+        const uint32_t first = timerTicksToCompare(t);
+        if (ticks >= first) return static_cast<uint32_t>((ticks - first) % t.target);
+    }
+    return static_cast<uint32_t>((t.count + ticks) & (TIMER_PERIOD - 1));
+}
+
+static inline uint64_t timerTicks(const Timers& tm, const Ps2Timer& t, uint64_t now) {
+    return (t.mode & MODE_CUE) ? (now - t.stamp) / timerDivider(tm, t) : 0;
+}
+
+// Fold the ticks so far into count, keeping the phase of the clock
+static void timerSync(const Timers& tm, Ps2Timer& t, uint64_t now) {
+    if (!(t.mode & MODE_CUE)) {
+        t.stamp = now;
+        return;
+    }
+    const uint64_t ticks = timerTicks(tm, t, now);
+    t.count = timerCountAfter(t, ticks);
+    t.stamp += ticks * timerDivider(tm, t);
 }
 
-void timersStep(Timers& tm, uint32_t cycles, uint32_t& intc_stat) {
-    for (int i = 0; i < 4; ++i) {
-        auto& t = tm.t[i];
-        if (!t.running) continue;
-
-        // Simple emulation: Increment by cycles (assuming 1/1 clock for now for simplicity)
-        // Real hardware has specific bus clock dividers (BUSCLK/16, BUSCLK/256 etc) defined in MODE
-        // For BIOS boot, simple counting is usually enough.
-        
-        uint32_t old_count = t.count;
-        t.count += cycles;
-
-        // Check Target
-        if (t.count >= t.target && t.target > 0) {
-            // Target Reached
-            if (t.mode & (1 << 6)) { // Bit 6: Clear on Compare
-                t.count = 0; // or t.count - t.target
-            }
-            
-            // Check Interrupt Enable (Bit 8? Need to check specific timer spec. Usually bit 10 of Mode is IRQ enable?)
-            // PS2 Timer Mode: 
-            // Bit 0: Clock Source
-            // Bit 1: Gate Enable
-            // Bit 2: Gate Mode
-            // Bit 3: Gate Level
-            // Bit 4: ZRET (Zero Return) - Reset on non-target?
-            // Bit 6: CUE (Compare Update Enable) ? -> Reset on Compare
-            // Bit 7: IE (Interrupt Enable)
-            // Bit 8: OF (Overflow Flag)
-            // Bit 9: EQF (Equal Flag)
-            
-            // Let's assume Bit 10 (0x400) or Bit 7 based on common usage.
-            // Documentation says: 
-            // Tn_MODE(10000010 + n*0x800)
-            // Bit 7: ZRET (Zero Return)
-            // Bit 8: CUE (Compare Update Enable) ?
-            // Incorrect.
-            
-            // Let's stick to observed behavior: Bit 7 or 8 enable IRQ.
-            // Using a loose logic: If target reached, signal IRQ.
-            
-            int irq_bit = 9 + i; // T0=9, T1=10, T2=11, T3=12
-            intc_stat |= (1u << irq_bit);
-        }
-        
-        // Overflow check (16-bit timers? PS2 timers are 32-bit generally, T0/T1 are 16bit?)
-        // EE Timers: T0/T1 hold 16 bit count. T2/T3 hold 16 bit? 
-        // EE Core Timers are different. 
-        // These are Peripherals 0x1000xxxx.
-        // T0, T1, T2, T3.
-        // T0/T1 are 16-bit. T2/T3 are 32-bit? No, all 16-bit?
-        // Let's safe-wrap at 32-bit for now, BIOS will set Target if it wants less.
+// Post the next edge that sets a flag still clear; nothing while stopped
+static void timerPost(Timers& tm, uint32_t i) {
+    const Ps2Timer& t = tm.t[i];
+    const SchedEvent ev = static_cast<SchedEvent>(SCHED_TIMER0 + i);
+    uint32_t ticks = 0;
+    if (t.mode & MODE_CUE) {
+        if (!(t.mode & MODE_EQUF)) ticks = timerTicksToCompare(t);
+        const uint32_t ovf = (t.mode & MODE_OVFF) ? 0 : timerTicksToOverflow(t);
+        if (ovf && (!ticks || ovf < ticks)) ticks = ovf;
     }
+    if (ticks) schedAt(*tm.sched, ev, t.stamp + uint64_t(ticks) * timerDivider(tm, t));
+    else       schedCancel(*tm.sched, ev);
 }
 
-uint32_t timerRead(Timers& tm, uint32_t addr) {
-    // Address format: 1000 0000 ... 1000 1800
-    // ID = (addr & 0x1800) >> 11 ? 
-    // T0: 0x1000 00xx
-    // T1: 0x1000 08xx
-    // T2: 0x1000 10xx
-    // T3: 0x1000 18xx
-    
-    int id = -1;
-    if ((addr & 0xFFFF800) == 0) id = 0; // 0000
-    else if ((addr & 0xFFFF800) == 0x800) id = 1; // 0800
-    else if ((addr & 0xFFFF800) == 0x1000) id = 2; // 1000
-    else if ((addr & 0xFFFF800) == 0x1800) id = 3; // 1800
-    
-    // Easier masking
-    uint32_t offset = addr & 0x1FFF;
-    if (offset < 0x800) id = 0;
-    else if (offset < 0x1000) id = 1;
-    else if (offset < 0x1800) id = 2;
-    else id = 3;
-
-    uint32_t reg = addr & 0x30; // 00, 10, 20, 30
-    
-    auto& t = tm.t[id];
-    
-    switch (reg) {
-        case 0x00: return t.count;
-        case 0x10: return t.mode;
-        case 0x20: return t.target;
-        default: return 0;
+// Raise the flags whose edge is at or before when, then catch up to now
+template <uint32_t I>
+static void timerEvent(void* dev, uint64_t when) {
+    Timers& tm = *static_cast<Timers*>(dev);
+    Ps2Timer& t = tm.t[I];
+    const uint64_t ticks = timerTicks(tm, t, when);
+    uint32_t raised = 0;
+    const uint32_t cmp = timerTicksToCompare(t);
+    const uint32_t ovf = timerTicksToOverflow(t);
+    if (!(t.mode & MODE_EQUF) && ticks >= cmp) raised |= MODE_EQUF;
+    if (!(t.mode & MODE_OVFF) && ovf && ticks >= ovf) raised |= MODE_OVFF;
+    t.mode |= raised;
+    // The INTC sees the flag's rising edge
+    if (((raised & MODE_EQUF) && (t.mode & MODE_CMPE)) ||
+        ((raised & MODE_OVFF) && (t.mode & MODE_OVFE))) {
+        *tm.intcStat |= 1u << (9 + I); // T0=9, T1=10, T2=11, T3=12
     }
+    timerSync(tm, t, tm.sched->now);
+    timerPost(tm, I);
+}
+
+void timersInit(Timers& tm, Scheduler& sched, uint32_t& intc_stat, uint32_t hblankCycles) {
+    tm = Timers{};
+    tm.hblankCycles = hblankCycles;
+    tm.sched = &sched;
+    tm.intcStat = &intc_stat;
+    schedSetHandler(sched, SCHED_TIMER0, timerEvent<0>, &tm);
+    schedSetHandler(sched, SCHED_TIMER1, timerEvent<1>, &tm);
+    schedSetHandler(sched, SCHED_TIMER2, timerEvent<2>, &tm);
+    schedSetHandler(sched, SCHED_TIMER3, timerEvent<3>, &tm);
+    for (uint32_t i = 0; i < 4; ++i) {
+        tm.t[i].stamp = sched.now;
+        schedCancel(sched, static_cast<SchedEvent>(SCHED_TIMER0 + i));
+    }
+}
+
+// Register accesses happen mid-slice, at schedNowInSlice; events fire
+// between slices, at sched.now.
+
+// Every mirror of a timer block keeps the timer number in address bits 11-12
+static inline uint32_t timerIndex(uint32_t addr) { return (addr >> 11) & 3; }
+
+static uint64_t timerReadCount(void* dev, uint32_t addr, uint32_t) {
+    const Timers& tm = *static_cast<Timers*>(dev);
+    const Ps2Timer& t = tm.t[timerIndex(addr)];
+    return timerCountAfter(t, timerTicks(tm, t, schedNowInSlice(*tm.sched)));
+}
+
+static void timerWriteCount(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    Timers& tm = *static_cast<Timers*>(dev);
+    const uint32_t i = timerIndex(addr);
+    Ps2Timer& t = tm.t[i];
+    const uint64_t now = schedNowInSlice(*tm.sched);
+    timerSync(tm, t, now);
+    t.count = static_cast<uint32_t>(value) & (TIMER_PERIOD - 1);
+    t.stamp = now;
+    timerPost(tm, i);
+}
+
+static uint64_t timerReadMode(void* dev, uint32_t addr, uint32_t) {
+    return static_cast<Timers*>(dev)->t[timerIndex(addr)].mode;
+}
+
+static void timerWriteMode(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    Timers& tm = *static_cast<Timers*>(dev);
+    const uint32_t i = timerIndex(addr);
+    Ps2Timer& t = tm.t[i];
+    const uint32_t v = static_cast<uint32_t>(value);
+    const uint64_t now = schedNowInSlice(*tm.sched);
+    timerSync(tm, t, now);
+    // Flags stay set unless written with 1; a new clock starts on this cycle
+    if ((v ^ t.mode) & MODE_CLKS) t.stamp = now;
+    t.mode = (v & 0x3FF) | (t.mode & MODE_FLAGS & ~v);
+    timerPost(tm, i);
+}
+
+static void timerWriteTarget(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    Timers& tm = *static_cast<Timers*>(dev);
+    const uint32_t i = timerIndex(addr);
+    Ps2Timer& t = tm.t[i];
+    timerSync(tm, t, schedNowInSlice(*tm.sched));
+    t.target = static_cast<uint32_t>(value) & (TIMER_PERIOD - 1);
+    timerPost(tm, i);
+}
+
+static uint64_t timerReadTarget(void* dev, uint32_t addr, uint32_t) {
+    return static_cast<Timers*>(dev)->t[timerIndex(addr)].target;
 }
 
-void timerWrite(Timers& tm, uint32_t addr, uint32_t val) {
-    uint32_t offset = addr & 0x1FFF;
-    int id = 0;
-    if (offset < 0x800) id = 0;
-    else if (offset < 0x1000) id = 1;
-    else if (offset < 0x1800) id = 2;
-    else id = 3;
-
-    uint32_t reg = addr & 0x30;
-    auto& t = tm.t[id];
-
-    switch (reg) {
-        case 0x00: t.count = val; break;
-        case 0x10: 
-            t.mode = val; 
-            // Bit 7: Clock Enable / Start
-            // (Assuming simplified bit layout for stub)
-            // Code usually writes 0x80 or similar to start.
-            // If bit 7 is set, run. If 0, stop.
-            t.running = (val & 0x80) != 0; 
-            if (!t.running) t.count = 0; // Optional reset on stop
-            break;
-        case 0x20: t.target = val; break;
-        default: break;
+void timersMapMmio(Timers& tm, Mem& m) {
+    for (uint32_t i = 0; i < 4; ++i) {
+        const uint32_t base = 0x10000000 + i * 0x800;
+        memMapMmio(m, base + 0x00, 16, MemMmioSlot{timerReadCount, timerWriteCount, nullptr, nullptr, &tm});
+        memMapMmio(m, base + 0x10, 16, MemMmioSlot{timerReadMode, timerWriteMode, nullptr, nullptr, &tm});
+        memMapMmio(m, base + 0x20, 16, MemMmioSlot{timerReadTarget, timerWriteTarget, nullptr, nullptr, &tm});
+        if (i < 2) memMapMmio(m, base + 0x30, 16, memMmioReg(&tm.t[i].hold));
+        // COUNT is computed from the scheduler clock, and the rest only
+        // changes on the timer's own events
+        memMmioEventDriven(m, base, 0x40);
     }
 }
@@ -1,19 +1,31 @@
 #pragma once
 #include <cstdint>
 
-// PS2 Hardware Timer (T0..T3)
+struct Mem; // forward declaration
+struct Scheduler;
+
+// PS2 Hardware Timer (T0..T3). COUNT isn't stepped: it is count plus the
+// ticks of the selected clock since stamp, worked out when read. Each timer
+// keeps one scheduler event for the next compare or overflow that sets a
+// flag that is still clear.
 struct Ps2Timer {
-    uint32_t count = 0;
+    uint32_t count = 0;   // COUNT at stamp
     uint32_t mode = 0;
     uint32_t target = 0;
-    [[maybe_unused]] bool running = false;
+    uint32_t hold = 0;    // T0/T1 only, latched by SBUS interrupts (not modelled)
+    uint64_t stamp = 0;   // EE cycle count was taken at, on a clock edge
 };
 
 struct Timers {
     Ps2Timer t[4]; // T0, T1, T2, T3
+    uint32_t   hblankCycles = 0; // EE cycles per HBLANK clock, the CRTC line period
+    Scheduler* sched = nullptr;
+    uint32_t*  intcStat = nullptr;
 };
 
-void timersInit(Timers& timers);
-void timersStep(Timers& timers, uint32_t cycles, uint32_t& intc_stat); // Updates INTC directly
-uint32_t timerRead(Timers& timers, uint32_t addr);
-void timerWrite(Timers& timers, uint32_t addr, uint32_t val);
+// Resets the timers and registers their events; flags raise INTC bits 9..12.
+// The HBLANK clock ticks every hblankCycles (gsCrtcLineCycles of the video
+// mode).
+void timersInit(Timers& timers, Scheduler& sched, uint32_t& intc_stat, uint32_t hblankCycles);
+// COUNT/MODE/COMP(/HOLD) of T0..T3 at 0x10000000 + id * 0x800
+void timersMapMmio(Timers& timers, Mem& mem);
@@ -0,0 +1,552 @@
+#include "vif.h"
+#include "mtvu.h"
+#include "gif_fifo.h"
+#include "mem_map.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// UNPACK runs in two passes over host SIMD registers: a per-format kernel
+// widens packed elements into 4x32-bit qwords, then the write pass applies
+// the mask (data/ROW/COL/protect), the offset/difference mode and the
+// CL/WL skipping or filling. Kernels come from a table indexed by
+// vn << 2 | vl and the usn bit.
+
+// -----------------------------------------------------------------------------
+// 4x32 integer layer
+// -----------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+using I4 = __m128i;
+
+static inline I4   i4Load(const VUVec& v)        { return _mm_load_si128(reinterpret_cast<const __m128i*>(v.UL)); }
+static inline I4   i4Load(const uint32_t* p)     { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+static inline void i4Store(VUVec& v, I4 x)       { _mm_store_si128(reinterpret_cast<__m128i*>(v.UL), x); }
+static inline I4   i4Zero()                      { return _mm_setzero_si128(); }
+static inline I4   i4Splat(uint32_t x)           { return _mm_set1_epi32(static_cast<int>(x)); }
+static inline I4   i4And(I4 a, I4 b)             { return _mm_and_si128(a, b); }
+static inline I4   i4Or(I4 a, I4 b)              { return _mm_or_si128(a, b); }
+static inline I4   i4Add(I4 a, I4 b)             { return _mm_add_epi32(a, b); }
+static inline I4   i4Select(I4 m, I4 a, I4 b)    { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+template <int L> static inline I4 i4Bcast(I4 x)  { return _mm_shuffle_epi32(x, L * 0x55); }
+static inline I4   i4Xyxy(I4 x)                  { return _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 1, 0)); }
+
+// Widen the first four components at p (32, 16 or 8 bits) to 32 bits
+template <int VL, bool USN>
+static inline I4 i4Widen(const uint8_t* p) {
+    if (VL == 0) return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i x;
+    if (VL == 1) {
+        x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    } else {
+        uint32_t w;
+        std::memcpy(&w, p, 4);
+        x = _mm_cvtsi32_si128(static_cast<int>(w));
+        x = USN ? _mm_unpacklo_epi8(x, _mm_setzero_si128()) : _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+    }
+    return USN ? _mm_unpacklo_epi16(x, _mm_setzero_si128()) : _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+#elif defined(__ARM_NEON)
+
+using I4 = uint32x4_t;
+
+static inline I4   i4Load(const VUVec& v)        { return vld1q_u32(v.UL); }
+static inline I4   i4Load(const uint32_t* p)     { return vld1q_u32(p); }
+static inline void i4Store(VUVec& v, I4 x)       { vst1q_u32(v.UL, x); }
+static inline I4   i4Zero()                      { return vdupq_n_u32(0); }
+static inline I4   i4Splat(uint32_t x)           { return vdupq_n_u32(x); }
+static inline I4   i4And(I4 a, I4 b)             { return vandq_u32(a, b); }
+static inline I4   i4Or(I4 a, I4 b)              { return vorrq_u32(a, b); }
+static inline I4   i4Add(I4 a, I4 b)             { return vaddq_u32(a, b); }
+static inline I4   i4Select(I4 m, I4 a, I4 b)    { return vbslq_u32(m, a, b); }
+template <int L> static inline I4 i4Bcast(I4 x)  { return vdupq_n_u32(vgetq_lane_u32(x, L)); }
+static inline I4   i4Xyxy(I4 x)                  { return vcombine_u32(vget_low_u32(x), vget_low_u32(x)); }
+
+template <int VL, bool USN>
+static inline I4 i4Widen(const uint8_t* p) {
+    if (VL == 0) return vreinterpretq_u32_u8(vld1q_u8(p));
+    if (VL == 1) {
+        return USN ? vmovl_u16(vld1_u16(reinterpret_cast<const uint16_t*>(p)))
+                   : vreinterpretq_u32_s32(vmovl_s16(vld1_s16(reinterpret_cast<const int16_t*>(p))));
+    }
+    return USN ? vmovl_u16(vget_low_u16(vmovl_u8(vld1_u8(p))))
+               : vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(vmovl_s8(vld1_s8(reinterpret_cast<const int8_t*>(p))))));
+}
+
+#else
+
+struct I4 { uint32_t v[4]; };
+
+static inline I4   i4Load(const VUVec& v)        { I4 r; std::memcpy(r.v, v.UL, 16); return r; }
+static inline I4   i4Load(const uint32_t* p)     { I4 r; std::memcpy(r.v, p, 16); return r; }
+static inline void i4Store(VUVec& v, I4 x)       { std::memcpy(v.UL, x.v, 16); }
+static inline I4   i4Zero()                      { return I4{{0, 0, 0, 0}}; }
+static inline I4   i4Splat(uint32_t x)           { return I4{{x, x, x, x}}; }
+static inline I4   i4And(I4 a, I4 b)             { for (int l = 0; l < 4; ++l) a.v[l] &= b.v[l]; return a; }
+static inline I4   i4Or(I4 a, I4 b)              { for (int l = 0; l < 4; ++l) a.v[l] |= b.v[l]; return a; }
+static inline I4   i4Add(I4 a, I4 b)             { for (int l = 0; l < 4; ++l) a.v[l] += b.v[l]; return a; }
+static inline I4   i4Select(I4 m, I4 a, I4 b)    { for (int l = 0; l < 4; ++l) a.v[l] = (a.v[l] & m.v[l]) | (b.v[l] & ~m.v[l]); return a; }
+template <int L> static inline I4 i4Bcast(I4 x)  { return i4Splat(x.v[L]); }
+static inline I4   i4Xyxy(I4 x)                  { return I4{{x.v[0], x.v[1], x.v[0], x.v[1]}}; }
+
+template <int VL, bool USN>
+static inline I4 i4Widen(const uint8_t* p) {
+    I4 r;
+    for (int l = 0; l < 4; ++l) {
+        if (VL == 0)      std::memcpy(&r.v[l], p + l * 4, 4);
+        else if (VL == 1) { uint16_t h; std::memcpy(&h, p + l * 2, 2); r.v[l] = USN ? h : static_cast<uint32_t>(static_cast<int16_t>(h)); }
+        else              r.v[l] = USN ? p[l] : static_cast<uint32_t>(static_cast<int8_t>(p[l]));
+    }
+    return r;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// UNPACK kernels
+// -----------------------------------------------------------------------------
+
+using VifUnpackFn = void (*)(VUVec* dst, const uint8_t* src, const uint8_t* end, uint32_t count);
+
+// Loads near the end of the payload go through a zero-padded copy
+template <int VL, bool USN>
+static inline I4 vifLoad(const uint8_t* p, const uint8_t* end) {
+    if (end - p >= 16) return i4Widen<VL, USN>(p);
+    alignas(16) uint8_t tmp[16] = {0};
+    std::memcpy(tmp, p, static_cast<size_t>(std::max<ptrdiff_t>(end - p, 0)));
+    return i4Widen<VL, USN>(tmp);
+}
+
+// S-n broadcasts one component; V2-n writes xyxy; V3-n leaves the next
+// element's x in w, like the hardware; V4-n is a straight widen
+template <int VN, int VL, bool USN>
+static void vifUnpackKernel(VUVec* dst, const uint8_t* src, const uint8_t* end, uint32_t count) {
+    constexpr uint32_t comp = 4u >> VL;
+    if (VN == 0) {
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const I4 x = vifLoad<VL, USN>(src + i * comp, end);
+            i4Store(dst[i + 0], i4Bcast<0>(x));
+            i4Store(dst[i + 1], i4Bcast<1>(x));
+            i4Store(dst[i + 2], i4Bcast<2>(x));
+            i4Store(dst[i + 3], i4Bcast<3>(x));
+        }
+        for (; i < count; ++i) i4Store(dst[i], i4Bcast<0>(vifLoad<VL, USN>(src + i * comp, end)));
+        return;
+    }
+    constexpr uint32_t stride = comp * (VN + 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        const I4 x = vifLoad<VL, USN>(src + i * stride, end);
+        i4Store(dst[i], VN == 1 ? i4Xyxy(x) : x);
+    }
+}
+
+// V4-5: RGBA 5:5:5:1 into 8 bits per channel
+static void vifUnpackV45(VUVec* dst, const uint8_t* src, const uint8_t*, uint32_t count) {
+    alignas(16) static const uint32_t mask[4] = {0xF8, 0xF8, 0xF8, 0x80};
+    const I4 m = i4Load(mask);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t h;
+        std::memcpy(&h, src + i * 2, 2);
+        const uint32_t v = h;
+        alignas(16) const uint32_t lanes[4] = {v << 3, v >> 2, v >> 7, v >> 8};
+        i4Store(dst[i], i4And(i4Load(lanes), m));
+    }
+}
+
+static void vifUnpackInvalid(VUVec* dst, const uint8_t*, const uint8_t*, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) i4Store(dst[i], i4Zero());
+}
+
+template <bool USN>
+static constexpr std::array<VifUnpackFn, 16> vifMakeUnpack() {
+    return {{
+        vifUnpackKernel<0, 0, USN>, vifUnpackKernel<0, 1, USN>, vifUnpackKernel<0, 2, USN>, vifUnpackInvalid,
+        vifUnpackKernel<1, 0, USN>, vifUnpackKernel<1, 1, USN>, vifUnpackKernel<1, 2, USN>, vifUnpackInvalid,
+        vifUnpackKernel<2, 0, USN>, vifUnpackKernel<2, 1, USN>, vifUnpackKernel<2, 2, USN>, vifUnpackInvalid,
+        vifUnpackKernel<3, 0, USN>, vifUnpackKernel<3, 1, USN>, vifUnpackKernel<3, 2, USN>, vifUnpackV45,
+    }};
+}
+static constexpr std::array<VifUnpackFn, 16> kUnpack[2] = {vifMakeUnpack<false>(), vifMakeUnpack<true>()};
+
+// Bits per element by vn << 2 | vl (V4-5 packs into 16)
+static constexpr uint8_t kUnpackBits[16] = {32, 16, 8, 0, 64, 32, 16, 0, 96, 48, 24, 0, 128, 64, 32, 16};
+
+// -----------------------------------------------------------------------------
+// VU targets
+// -----------------------------------------------------------------------------
+
+static inline VU& vifVu(const VIF& v) {
+    return v.index == 0 ? *v.vu : *v.mtvu->vu;
+}
+
+// The VU still runs a microprogram the next command would disturb. A
+// threaded VU1 queues everything in order, so it never blocks the VIF.
+static inline bool vifVuBusy(const VIF& v) {
+    if (v.index == 0) return v.vu->running;
+    return !v.mtvu->threaded && v.mtvu->vu->running;
+}
+
+static void vifVuRead(VIF& v, uint32_t qaddr, VUVec* out, uint32_t n) {
+    if (v.index == 1) mtvuSync(*v.mtvu);
+    const VU& vu = vifVu(v);
+    for (uint32_t i = 0; i < n; ++i) out[i] = vu.data[(qaddr + i) & vu.dataMask];
+}
+
+// Split at the end of data memory
+static void vifVuWrite(VIF& v, uint32_t qaddr, const VUVec* in, uint32_t n) {
+    VU& vu = vifVu(v);
+    while (n) {
+        const uint32_t at = qaddr & vu.dataMask;
+        const uint32_t run = std::min<uint32_t>(n, static_cast<uint32_t>(vu.data.size()) - at);
+        if (v.index == 0) std::memcpy(&vu.data[at], in, run * sizeof(VUVec));
+        else              mtvuWriteData(*v.mtvu, at, in, run);
+        qaddr += run; in += run; n -= run;
+    }
+}
+
+static void vifKick(VIF& v, uint32_t addr, bool resume) {
+    if (v.index == 0) {
+        VU& vu = *v.vu;
+        vu.itop = v.itops;
+        vuStart(vu, resume ? vu.tpc : addr);
+        vuFinish(vu);
+        return;
+    }
+    // VU1 sees TOPS/ITOPS; then the double buffer flips
+    v.top = v.tops;
+    v.itop = v.itops;
+    mtvuSetTops(*v.mtvu, v.top, v.itop);
+    v.stat ^= VIF_STAT_DBF;
+    v.tops = v.base + ((v.stat & VIF_STAT_DBF) ? v.ofst : 0);
+    if (resume) {
+        mtvuSync(*v.mtvu);
+        addr = v.mtvu->vu->tpc;
+    }
+    mtvuKick(*v.mtvu, addr);
+}
+
+// -----------------------------------------------------------------------------
+// UNPACK
+// -----------------------------------------------------------------------------
+
+static inline void vifCycle(const VIF& v, uint32_t& cl, uint32_t& wl) {
+    cl = v.cycle & 0xFF;
+    wl = (v.cycle >> 8) & 0xFF;
+    if (!cl) cl = 256;
+    if (!wl) wl = 256;
+}
+
+static inline uint32_t vifUnpackNum(uint32_t code) {
+    const uint32_t n = (code >> 16) & 0xFF;
+    return n ? n : 256;
+}
+
+// Elements read from the stream for `num` writes; filling writes need fewer
+static uint32_t vifUnpackElements(const VIF& v, uint32_t num) {
+    uint32_t cl, wl;
+    vifCycle(v, cl, wl);
+    if (wl <= cl) return num;
+    return cl * (num / wl) + std::min(num % wl, cl);
+}
+
+static uint32_t vifUnpackWords(const VIF& v, uint32_t code) {
+    const uint32_t bits = kUnpackBits[(code >> 24) & 0xF];
+    return (vifUnpackElements(v, vifUnpackNum(code)) * bits + 31) / 32;
+}
+
+static void vifUnpack(VIF& v, uint32_t code, const uint32_t* payload, uint32_t words) {
+    const uint32_t fmt = (code >> 24) & 0xF;
+    const bool usn = (code >> 14) & 1, masked = (code >> 28) & 1;
+    const uint32_t num = vifUnpackNum(code), elems = vifUnpackElements(v, num);
+    uint32_t addr = code & 0x3FF;
+    if (v.index == 1 && (code & 0x8000)) addr += v.tops;
+
+    std::vector<VUVec>& buf = v.unpackBuf;
+    if (buf.size() < elems) buf.resize(elems);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(payload);
+    kUnpack[usn][fmt](buf.data(), src, src + words * 4, elems);
+    v.unpacked[fmt] += num;
+
+    uint32_t cl, wl;
+    vifCycle(v, cl, wl);
+
+    // Plain contiguous unpack: straight into VU memory
+    if (!masked && v.mode == 0 && cl == wl) {
+        vifVuWrite(v, addr, buf.data(), num);
+        return;
+    }
+
+    // Lane roles per write-cycle row: 0 data, 1 ROW, 2 COL, 3 write-protect
+    I4 mData[4], mRow[4], mCol[4], mProt[4], colv[4];
+    bool protect = false;
+    for (uint32_t r = 0; r < 4; ++r) {
+        alignas(16) uint32_t d[4], rw[4], c[4], p[4];
+        for (uint32_t l = 0; l < 4; ++l) {
+            const uint32_t m = masked ? (v.mask >> (r * 8 + l * 2)) & 3 : 0;
+            d[l] = m == 0 ? ~0u : 0; rw[l] = m == 1 ? ~0u : 0; c[l] = m == 2 ? ~0u : 0; p[l] = m == 3 ? ~0u : 0;
+            protect |= m == 3;
+        }
+        mData[r] = i4Load(d); mRow[r] = i4Load(rw); mCol[r] = i4Load(c); mProt[r] = i4Load(p);
+        colv[r] = i4Splat(v.col[r]);
+    }
+
+    // Span of VU memory touched; gaps (skipping) and protected lanes keep old data
+    const bool skipping = wl < cl;
+    const uint32_t last = skipping ? ((num - 1) / wl) * cl + (num - 1) % wl : num - 1;
+    const uint32_t size = static_cast<uint32_t>(vifVu(v).data.size());
+    const uint32_t span = std::min(last + 1, size);
+    std::vector<VUVec>& out = v.stageBuf;
+    if (out.size() < span) out.resize(span);
+    if (skipping || protect) vifVuRead(v, addr, out.data(), span);
+
+    I4 row = i4Load(v.row);
+    uint32_t di = 0;
+    for (uint32_t j = 0; j < num; ++j) {
+        const uint32_t pos = j % wl;
+        const uint32_t at = skipping ? (j / wl) * cl + pos : j;
+        const uint32_t r = std::min<uint32_t>(pos, 3);
+        I4 d = (wl <= cl || pos < cl) ? i4Load(buf[di++]) : i4Zero();
+        if (v.mode == 1) {
+            d = i4Add(d, row);
+        } else if (v.mode == 2) {
+            d = i4Add(d, row);
+            row = i4Select(mData[r], d, row);
+        }
+        VUVec& o = out[at % span];
+        const I4 w = i4Or(i4Or(i4And(d, mData[r]), i4And(row, mRow[r])),
+                          i4Or(i4And(colv[r], mCol[r]), i4And(i4Load(o), mProt[r])));
+        i4Store(o, w);
+    }
+    if (v.mode == 2) {
+        VUVec rv;
+        i4Store(rv, row);
+        std::memcpy(v.row, rv.UL, 16);
+    }
+    vifVuWrite(v, addr, out.data(), span);
+}
+
+// -----------------------------------------------------------------------------
+// Command stream
+// -----------------------------------------------------------------------------
+
+// Words a command occupies, code included
+static uint32_t vifCmdWords(const VIF& v, uint32_t code) {
+    const uint32_t cmd = (code >> 24) & 0x7F, imm = code & 0xFFFF;
+    if (cmd >= 0x60) return 1 + vifUnpackWords(v, code);
+    switch (cmd) {
+        case 0x20: return 2;                                  // STMASK
+        case 0x30: case 0x31: return 5;                       // STROW, STCOL
+        case 0x4A: return 1 + vifUnpackNum(code) * 2;         // MPG
+        case 0x50: case 0x51: return 1 + (imm ? imm : 0x10000) * 4; // DIRECT(HL)
+        default:   return 1;
+    }
+}
+
+// Runs the command at w; false leaves it queued until the VU is free
+static bool vifExecute(VIF& v, const uint32_t* w, uint32_t words) {
+    const uint32_t code = w[0], cmd = (code >> 24) & 0x7F, imm = code & 0xFFFF;
+    if (cmd >= 0x60) {
+        vifUnpack(v, code, w + 1, words - 1);
+        v.code = code;
+        return true;
+    }
+    switch (cmd) {
+        case 0x00: break;                                               // NOP
+        case 0x01: v.cycle = imm; break;                                // STCYCL
+        case 0x02:                                                      // OFFSET
+            v.ofst = imm & 0x3FF;
+            v.stat &= ~VIF_STAT_DBF;
+            v.tops = v.base;
+            break;
+        case 0x03: v.base = imm & 0x3FF; break;                         // BASE
+        case 0x04: v.itops = imm & 0x3FF; break;                        // ITOP
+        case 0x05: v.mode = imm & 3; break;                             // STMOD
+        case 0x06: break;                                               // MSKPATH3: no GIF arbitration yet
+        case 0x07: v.mark = imm; v.stat |= VIF_STAT_MRK; break;         // MARK
+        case 0x10: case 0x11: case 0x13:                                // FLUSHE, FLUSH, FLUSHA
+            if (vifVuBusy(v)) return false;
+            break;
+        case 0x14: case 0x15:                                           // MSCAL, MSCALF
+            if (vifVuBusy(v)) return false;
+            vifKick(v, imm * 8, false);
+            break;
+        case 0x17:                                                      // MSCNT
+            if (vifVuBusy(v)) return false;
+            vifKick(v, 0, true);
+            break;
+        case 0x20: v.mask = w[1]; break;                                // STMASK
+        case 0x30: std::memcpy(v.row, w + 1, 16); break;                // STROW
+        case 0x31: std::memcpy(v.col, w + 1, 16); break;                // STCOL
+        case 0x4A:                                                      // MPG
+            if (vifVuBusy(v)) return false;
+            if (v.index == 0) {
+                VU& vu = *v.vu;
+                const uint32_t at = (imm * 8u & vu.microMask) / 4;
+                const uint32_t n = std::min<uint32_t>(words - 1, static_cast<uint32_t>(vu.micro.size()) - at);
+                std::memcpy(&vu.micro[at], w + 1, n * 4);
+            } else {
+                mtvuWriteMicro(*v.mtvu, imm * 8u, w + 1, words - 1);
+            }
+            break;
+        case 0x50: case 0x51:                                           // DIRECT, DIRECTHL
+            if (v.index == 1 && v.gif) gifFifoPush(*v.gif, w + 1, (words - 1) / 4);
+            break;
+        default:
+            v.stat |= VIF_STAT_ER1;
+            break;
+    }
+    v.code = code;
+    return true;
+}
+
+// Run every complete command in the FIFO; false while the VIF is stalled
+static bool vifDrain(VIF& v) {
+    bool ok = true;
+    while (!(v.stat & (VIF_STAT_VIS | VIF_STAT_VSS | VIF_STAT_VFS))) {
+        const size_t avail = v.fifo.size() - v.head;
+        if (!avail) break;
+        const uint32_t code = v.fifo[v.head];
+        const uint32_t need = vifCmdWords(v, code);
+        if (avail < need) { v.stat |= VIF_STAT_VPS_WAIT; break; }
+        if (!vifExecute(v, &v.fifo[v.head], need)) {
+            v.stat |= VIF_STAT_VEW;
+            ok = false;
+            break;
+        }
+        v.stat &= ~(VIF_STAT_VEW | VIF_STAT_VPS_WAIT);
+        v.head += need;
+        ++v.commands;
+        // i bit: interrupt and stall after the command unless masked (ERR.MII)
+        if ((code & 0x80000000u) && !(v.err & 1)) v.stat |= VIF_STAT_VIS | VIF_STAT_INT;
+    }
+    if (v.head == v.fifo.size()) {
+        v.fifo.clear();
+        v.head = 0;
+    } else if (v.head >= 4096) {
+        v.fifo.erase(v.fifo.begin(), v.fifo.begin() + static_cast<ptrdiff_t>(v.head));
+        v.head = 0;
+    }
+    return ok && !(v.stat & (VIF_STAT_VIS | VIF_STAT_VSS | VIF_STAT_VFS));
+}
+
+uint32_t vifTransfer(VIF& v, const uint32_t* data, uint32_t qwc) {
+    if (!vifDrain(v)) return 0;
+    uint32_t done = 0;
+    while (done < qwc) {
+        // Take just enough qwords to complete the pending command
+        uint32_t want = 1;
+        const size_t have = v.fifo.size() - v.head;
+        if (have) {
+            const uint32_t need = vifCmdWords(v, v.fifo[v.head]);
+            if (need > have) want = static_cast<uint32_t>((need - have + 3) / 4);
+        }
+        want = std::min(want, qwc - done);
+        v.fifo.insert(v.fifo.end(), data + done * 4, data + (done + want) * 4);
+        done += want;
+        if (!vifDrain(v)) break;
+    }
+    return done;
+}
+
+bool vifUpdate(VIF& v) {
+    if (v.head != v.fifo.size()) vifDrain(v);
+    return v.head == v.fifo.size();
+}
+
+// -----------------------------------------------------------------------------
+// Registers
+// -----------------------------------------------------------------------------
+
+void vifReset(VIF& v) {
+    v.stat = v.err = v.mark = 0;
+    v.cycle = v.mode = v.num = v.mask = v.code = 0;
+    v.itops = v.itop = v.base = v.ofst = v.tops = v.top = 0;
+    std::memset(v.row, 0, sizeof(v.row));
+    std::memset(v.col, 0, sizeof(v.col));
+    v.fifo.clear();
+    v.head = 0;
+}
+
+void vifInit(VIF& v, int index, VU* vu, MTVU* mtvu, GIFFifo* gif) {
+    v.index = index;
+    v.vu = vu;
+    v.mtvu = mtvu;
+    v.gif = gif;
+    vifReset(v);
+    std::fill(std::begin(v.unpacked), std::end(v.unpacked), 0);
+    v.commands = 0;
+}
+
+uint32_t vifReadReg(const VIF& v, uint32_t offset) {
+    switch (offset) {
+        case 0x000: {
+            // FQC: qwords waiting in the FIFO
+            const uint32_t fqc = std::min<uint32_t>(static_cast<uint32_t>((v.fifo.size() - v.head + 3) / 4), 16);
+            return v.stat | fqc << 24;
+        }
+        case 0x020: return v.err;
+        case 0x030: return v.mark;
+        case 0x040: return v.cycle;
+        case 0x050: return v.mode;
+        case 0x060: return v.num;
+        case 0x070: return v.mask;
+        case 0x080: return v.code;
+        case 0x090: return v.itops;
+        case 0x0A0: return v.base;
+        case 0x0B0: return v.ofst;
+        case 0x0C0: return v.tops;
+        case 0x0D0: return v.itop;
+        case 0x0E0: return v.top;
+        case 0x100: case 0x110: case 0x120: case 0x130: return v.row[(offset - 0x100) / 0x10];
+        case 0x140: case 0x150: case 0x160: case 0x170: return v.col[(offset - 0x140) / 0x10];
+        default:    return 0;
+    }
+}
+
+void vifWriteReg(VIF& v, uint32_t offset, uint32_t value) {
+    switch (offset) {
+        case 0x010:                                                     // FBRST
+            if (value & VIF_FBRST_RST) vifReset(v);
+            if (value & VIF_FBRST_FBK) v.stat |= VIF_STAT_VFS;
+            if (value & VIF_FBRST_STP) v.stat |= VIF_STAT_VSS;
+            if (value & VIF_FBRST_STC) v.stat &= ~(VIF_STAT_VSS | VIF_STAT_VFS | VIF_STAT_VIS | VIF_STAT_INT | VIF_STAT_ER1);
+            break;
+        case 0x020: v.err = value & 7; break;
+        case 0x030: v.mark = value & 0xFFFF; v.stat &= ~VIF_STAT_MRK; break;
+        case 0x100: case 0x110: case 0x120: case 0x130: v.row[(offset - 0x100) / 0x10] = value; break;
+        case 0x140: case 0x150: case 0x160: case 0x170: v.col[(offset - 0x140) / 0x10] = value; break;
+        default: break;
+    }
+}
+
+static uint64_t vifMmioRead(void* dev, uint32_t addr, uint32_t) {
+    return (addr & 0xF) ? 0 : vifReadReg(*static_cast<VIF*>(dev), addr & 0x3F0);
+}
+
+static void vifMmioWrite(void* dev, uint32_t addr, uint64_t value, uint32_t) {
+    if (!(addr & 0xF)) vifWriteReg(*static_cast<VIF*>(dev), addr & 0x3F0, static_cast<uint32_t>(value));
+}
+
+static void vifFifoWrite(void* dev, uint32_t, const MemQword& value) {
+    VIF& v = *static_cast<VIF*>(dev);
+    uint32_t words[4];
+    std::memcpy(words, &value, sizeof(words));
+    v.fifo.insert(v.fifo.end(), words, words + 4);
+    vifDrain(v);
+}
+
+void vifMapMmio(VIF& v, int index, Mem& mem) {
+    const uint32_t regs = index ? 0x10003C00 : 0x10003800;
+    const uint32_t fifo = index ? 0x10005000 : 0x10004000;
+    memMapMmio(mem, regs, 0x180, MemMmioSlot{vifMmioRead, vifMmioWrite, nullptr, nullptr, &v});
+    memMapMmio(mem, fifo, 16, MemMmioSlot{nullptr, nullptr, nullptr, vifFifoWrite, &v});
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vu.h"
+
+struct Mem;     // forward declaration
+struct MTVU;    // forward declaration
+struct GIFFifo; // forward declaration
+
+// VIF0/VIF1: unpack DMA data into VU memory, upload microprograms and kick
+// them. VIF0 feeds VU0 directly; VIF1 goes through the VU1 front end (MTVU)
+// and forwards DIRECT/DIRECTHL to the GIF (path 2).
+
+// STAT bits
+static constexpr uint32_t VIF_STAT_VPS_WAIT = 1u << 0;  // waiting for data
+static constexpr uint32_t VIF_STAT_VEW = 1u << 2;       // waiting for the VU
+static constexpr uint32_t VIF_STAT_MRK = 1u << 6;
+static constexpr uint32_t VIF_STAT_DBF = 1u << 7;
+static constexpr uint32_t VIF_STAT_VSS = 1u << 8;       // stopped (FBRST STP)
+static constexpr uint32_t VIF_STAT_VFS = 1u << 9;       // force break
+static constexpr uint32_t VIF_STAT_VIS = 1u << 10;      // stalled on an i-bit command
+static constexpr uint32_t VIF_STAT_INT = 1u << 11;
+static constexpr uint32_t VIF_STAT_ER1 = 1u << 13;      // unknown command
+
+// FBRST bits
+static constexpr uint32_t VIF_FBRST_RST = 1u << 0;
+static constexpr uint32_t VIF_FBRST_FBK = 1u << 1;
+static constexpr uint32_t VIF_FBRST_STP = 1u << 2;
+static constexpr uint32_t VIF_FBRST_STC = 1u << 3;
+
+struct VIF {
+    int   index = 0;
+    VU*   vu = nullptr;      // VIF0 target
+    MTVU* mtvu = nullptr;    // VIF1 target
+    GIFFifo* gif = nullptr;  // VIF1 DIRECT/DIRECTHL
+
+    // Registers
+    uint32_t stat = 0, err = 0, mark = 0;
+    uint32_t cycle = 0;      // CL (bits 0-7), WL (bits 8-15)
+    uint32_t mode = 0;       // 0 none, 1 offset, 2 difference
+    uint32_t num = 0, mask = 0, code = 0;
+    uint32_t itops = 0, itop = 0;
+    uint32_t base = 0, ofst = 0, tops = 0, top = 0;   // VIF1 double buffering
+    alignas(16) uint32_t row[4] = {0};
+    alignas(16) uint32_t col[4] = {0};
+
+    // Words received but not yet consumed; a command runs once all of its
+    // payload is here
+    std::vector<uint32_t> fifo;
+    size_t   head = 0;
+
+    // UNPACK scratch: widened elements and the masked write image
+    std::vector<VUVec> unpackBuf, stageBuf;
+
+    // Qwords unpacked per format (vn << 2 | vl)
+    uint64_t unpacked[16] = {0};
+    uint64_t commands = 0;
+};
+
+void     vifInit(VIF& vif, int index, VU* vu, MTVU* mtvu, GIFFifo* gif);
+void     vifReset(VIF& vif);
+
+// Feed qwc quadwords of DMA data; returns how many were accepted. Fewer
+// than qwc means the VIF stalled (VU busy, i-bit interrupt, STP).
+uint32_t vifTransfer(VIF& vif, const uint32_t* data, uint32_t qwc);
+
+// Retry commands left in the FIFO once the VU or an interrupt let go;
+// returns true when the FIFO is empty
+bool     vifUpdate(VIF& vif);
+
+// Register access by offset within the VIF's register block (0x10000000 + 0x3800/0x3C00)
+uint32_t vifReadReg(const VIF& vif, uint32_t offset);
+void     vifWriteReg(VIF& vif, uint32_t offset, uint32_t value);
+
+// VIF0/VIF1 (index 0/1) registers at 0x10003800/0x10003C00 and FIFO at
+// 0x10004000/0x10005000. EE writes to the FIFO are never refused: a stalled
+// VIF keeps them queued and runs them once it is released.
+void     vifMapMmio(VIF& vif, int index, Mem& mem);
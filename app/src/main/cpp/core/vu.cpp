@@ -0,0 +1,834 @@
+#include "vu.h"
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// VU_SCALAR builds only the scalar vec4 layer, whatever the host
+#if defined(__SSE2__) && !defined(VU_SCALAR)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__ARM_NEON) && !defined(VU_SCALAR)
+#include <arm_neon.h>
+#endif
+
+// VU interpreter. FMAC ops work on whole VF registers through a vec4 layer
+// that maps one-to-one onto an SSE or NEON register (scalar fallback
+// elsewhere). The PS2 has no NaN/Inf, so results clamp to +/-FLT_MAX.
+
+static inline float    flt(uint32_t v) { float f; std::memcpy(&f, &v, 4); return f; }
+static inline uint32_t bits(float f)   { uint32_t v; std::memcpy(&v, &f, 4); return v; }
+
+// Lane masks per dest field (bit 3 = x ... bit 0 = w)
+struct VUDestMasks {
+    alignas(16) uint32_t m[16][4];
+    constexpr VUDestMasks() : m{} {
+        for (int d = 0; d < 16; ++d)
+            for (int l = 0; l < 4; ++l) m[d][l] = (d & (8 >> l)) ? 0xFFFFFFFFu : 0u;
+    }
+};
+static constexpr VUDestMasks kDest;
+
+// -----------------------------------------------------------------------------
+// vec4 layer. Lane masks come back as a dest-ordered nibble (bit 3 = x).
+// -----------------------------------------------------------------------------
+
+#if defined(__SSE2__) && !defined(VU_SCALAR)
+
+using Vec4 = __m128;
+
+static constexpr uint8_t kRev4[16] = {0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+static inline Vec4 vLoad(const VUVec& v)      { return _mm_load_ps(v.F); }
+static inline void vStore(VUVec& v, Vec4 x)   { _mm_store_ps(v.F, x); }
+static inline Vec4 vSplat(float f)            { return _mm_set1_ps(f); }
+static inline Vec4 vAdd(Vec4 a, Vec4 b)       { return _mm_add_ps(a, b); }
+static inline Vec4 vSub(Vec4 a, Vec4 b)       { return _mm_sub_ps(a, b); }
+static inline Vec4 vMul(Vec4 a, Vec4 b)       { return _mm_mul_ps(a, b); }
+static inline Vec4 vMax(Vec4 a, Vec4 b)       { return _mm_max_ps(a, b); }
+static inline Vec4 vMin(Vec4 a, Vec4 b)       { return _mm_min_ps(a, b); }
+static inline Vec4 vAbs(Vec4 a)               { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+template <int L> static inline Vec4 vBroadcast(Vec4 a) { return _mm_shuffle_ps(a, a, L * 0x55); }
+template <int X, int Y, int Z, int W>
+static inline Vec4 vPermute(Vec4 a)           { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(W, Z, Y, X)); }
+
+// Lanes of dest take n, the rest keep o
+static inline Vec4 vSelect(uint32_t dest, Vec4 n, Vec4 o) {
+    const Vec4 m = _mm_load_ps(reinterpret_cast<const float*>(kDest.m[dest]));
+#if defined(__SSE4_1__)
+    return _mm_blendv_ps(o, n, m);
+#else
+    return _mm_or_ps(_mm_and_ps(m, n), _mm_andnot_ps(m, o));
+#endif
+}
+
+// NaN and Inf encodings (exponent 255) fall to FLT_MAX of their sign
+static inline Vec4 vClamp(Vec4 a) {
+    const __m128i x = _mm_castps_si128(a), exp = _mm_set1_epi32(0x7F800000);
+    const __m128i big = _mm_cmpeq_epi32(_mm_and_si128(x, exp), exp);
+    const __m128i sat = _mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(INT32_MIN)), _mm_set1_epi32(0x7F7FFFFF));
+    return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(big, sat), _mm_andnot_si128(big, x)));
+}
+
+static inline uint32_t vZeroMask(Vec4 a) { return kRev4[_mm_movemask_ps(_mm_cmpeq_ps(a, _mm_setzero_ps()))]; }
+static inline uint32_t vSignMask(Vec4 a) { return kRev4[_mm_movemask_ps(a)]; }
+static inline uint32_t vOverMask(Vec4 a) { return kRev4[_mm_movemask_ps(_mm_cmpnle_ps(vAbs(a), _mm_set1_ps(FLT_MAX)))]; }
+static inline uint32_t vGtMask(Vec4 a, Vec4 b) { return kRev4[_mm_movemask_ps(_mm_cmpgt_ps(a, b))]; }
+static inline uint32_t vLtMask(Vec4 a, Vec4 b) { return kRev4[_mm_movemask_ps(_mm_cmplt_ps(a, b))]; }
+
+template <int N> static inline Vec4 vItof(Vec4 a) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_castps_si128(a)), _mm_set1_ps(1.0f / (1 << N)));
+}
+// Positive overflow saturates to 0x7FFFFFFF (cvttps gives 0x80000000)
+template <int N> static inline Vec4 vFtoi(Vec4 a) {
+    const Vec4 s = _mm_mul_ps(a, _mm_set1_ps(static_cast<float>(1 << N)));
+    const __m128i r = _mm_cvttps_epi32(s);
+    const Vec4 over = _mm_cmpge_ps(s, _mm_set1_ps(2147483648.0f));
+    return _mm_castsi128_ps(_mm_xor_si128(r, _mm_castps_si128(over)));
+}
+
+#elif defined(__ARM_NEON) && !defined(VU_SCALAR)
+
+using Vec4 = float32x4_t;
+
+static inline uint32_t vNibble(uint32x4_t m) {
+    static const uint32_t w[4] = {8, 4, 2, 1};
+    const uint32x4_t b = vandq_u32(m, vld1q_u32(w));
+#if defined(__aarch64__)
+    return vaddvq_u32(b);
+#else
+    const uint32x2_t s = vadd_u32(vget_low_u32(b), vget_high_u32(b));
+    return vget_lane_u32(vpadd_u32(s, s), 0);
+#endif
+}
+
+static inline Vec4 vLoad(const VUVec& v)      { return vld1q_f32(v.F); }
+static inline void vStore(VUVec& v, Vec4 x)   { vst1q_f32(v.F, x); }
+static inline Vec4 vSplat(float f)            { return vdupq_n_f32(f); }
+static inline Vec4 vAdd(Vec4 a, Vec4 b)       { return vaddq_f32(a, b); }
+static inline Vec4 vSub(Vec4 a, Vec4 b)       { return vsubq_f32(a, b); }
+static inline Vec4 vMul(Vec4 a, Vec4 b)       { return vmulq_f32(a, b); }
+// Like maxps/minps and the scalar path: b unless a compares greater (less),
+// where vmaxq/vminq would propagate NaN and order the signed zeros
+static inline Vec4 vMax(Vec4 a, Vec4 b)       { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+static inline Vec4 vMin(Vec4 a, Vec4 b)       { return vbslq_f32(vcltq_f32(a, b), a, b); }
+static inline Vec4 vAbs(Vec4 a)               { return vabsq_f32(a); }
+template <int L> static inline Vec4 vBroadcast(Vec4 a) { return vdupq_n_f32(vgetq_lane_f32(a, L)); }
+// Lane moves in registers; the orders the ops use get a shuffle of their own
+template <int X, int Y, int Z, int W>
+static inline Vec4 vPermute(Vec4 a) {
+    Vec4 r = vdupq_n_f32(vgetq_lane_f32(a, X));
+    r = vsetq_lane_f32(vgetq_lane_f32(a, Y), r, 1);
+    r = vsetq_lane_f32(vgetq_lane_f32(a, Z), r, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(a, W), r, 3);
+}
+// yzwx (MR32)
+template <> inline Vec4 vPermute<1, 2, 3, 0>(Vec4 a) { return vextq_f32(a, a, 1); }
+// yzxw: yz of yzwx, then wx swapped
+template <> inline Vec4 vPermute<1, 2, 0, 3>(Vec4 a) {
+    const Vec4 r = vextq_f32(a, a, 1);
+    return vcombine_f32(vget_low_f32(r), vrev64_f32(vget_high_f32(r)));
+}
+// zxyw: zip zw with xy gives zx and wy
+template <> inline Vec4 vPermute<2, 0, 1, 3>(Vec4 a) {
+    const float32x2x2_t z = vzip_f32(vget_high_f32(a), vget_low_f32(a));
+    return vcombine_f32(z.val[0], vrev64_f32(z.val[1]));
+}
+
+static inline Vec4 vSelect(uint32_t dest, Vec4 n, Vec4 o) { return vbslq_f32(vld1q_u32(kDest.m[dest]), n, o); }
+
+static inline Vec4 vClamp(Vec4 a) {
+    const uint32x4_t ok = vcleq_f32(vabsq_f32(a), vdupq_n_f32(FLT_MAX));
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x80000000u));
+    const Vec4 sat = vreinterpretq_f32_u32(vorrq_u32(sign, vdupq_n_u32(0x7F7FFFFFu)));
+    return vbslq_f32(ok, a, sat);
+}
+
+static inline uint32_t vZeroMask(Vec4 a) { return vNibble(vceqq_f32(a, vdupq_n_f32(0.0f))); }
+static inline uint32_t vSignMask(Vec4 a) { return vNibble(vcltq_s32(vreinterpretq_s32_f32(a), vdupq_n_s32(0))); }
+static inline uint32_t vOverMask(Vec4 a) { return vNibble(vmvnq_u32(vcleq_f32(vabsq_f32(a), vdupq_n_f32(FLT_MAX)))); }
+static inline uint32_t vGtMask(Vec4 a, Vec4 b) { return vNibble(vcgtq_f32(a, b)); }
+static inline uint32_t vLtMask(Vec4 a, Vec4 b) { return vNibble(vcltq_f32(a, b)); }
+
+template <int N> static inline Vec4 vItof(Vec4 a) {
+    return vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_f32(a)), vdupq_n_f32(1.0f / (1 << N)));
+}
+// vcvtq saturates both ways already but turns NaN encodings into 0
+template <int N> static inline Vec4 vFtoi(Vec4 a) {
+    const Vec4 s = vmulq_f32(a, vdupq_n_f32(static_cast<float>(1 << N)));
+    return vreinterpretq_f32_s32(vbslq_s32(vceqq_f32(s, s), vcvtq_s32_f32(s), vdupq_n_s32(INT32_MIN)));
+}
+
+#else
+
+struct Vec4 { float f[4]; };
+
+template <typename F> static inline Vec4 vMap(Vec4 a, Vec4 b, F fn) {
+    Vec4 r;
+    for (int l = 0; l < 4; ++l) r.f[l] = fn(a.f[l], b.f[l]);
+    return r;
+}
+template <typename F> static inline uint32_t vMask(Vec4 a, Vec4 b, F fn) {
+    uint32_t m = 0;
+    for (int l = 0; l < 4; ++l) m |= fn(a.f[l], b.f[l]) ? 8u >> l : 0u;
+    return m;
+}
+
+static inline Vec4 vLoad(const VUVec& v)      { Vec4 r; std::memcpy(r.f, v.F, 16); return r; }
+static inline void vStore(VUVec& v, Vec4 x)   { std::memcpy(v.F, x.f, 16); }
+static inline Vec4 vSplat(float f)            { return Vec4{{f, f, f, f}}; }
+static inline Vec4 vAdd(Vec4 a, Vec4 b)       { return vMap(a, b, [](float x, float y) { return x + y; }); }
+static inline Vec4 vSub(Vec4 a, Vec4 b)       { return vMap(a, b, [](float x, float y) { return x - y; }); }
+static inline Vec4 vMul(Vec4 a, Vec4 b)       { return vMap(a, b, [](float x, float y) { return x * y; }); }
+static inline Vec4 vMax(Vec4 a, Vec4 b)       { return vMap(a, b, [](float x, float y) { return x > y ? x : y; }); }
+static inline Vec4 vMin(Vec4 a, Vec4 b)       { return vMap(a, b, [](float x, float y) { return x < y ? x : y; }); }
+static inline Vec4 vAbs(Vec4 a)               { return vMap(a, a, [](float x, float) { return std::fabs(x); }); }
+template <int L> static inline Vec4 vBroadcast(Vec4 a) { return vSplat(a.f[L]); }
+template <int X, int Y, int Z, int W>
+static inline Vec4 vPermute(Vec4 a)           { return Vec4{{a.f[X], a.f[Y], a.f[Z], a.f[W]}}; }
+
+static inline Vec4 vSelect(uint32_t dest, Vec4 n, Vec4 o) {
+    for (int l = 0; l < 4; ++l) if (dest & (8 >> l)) o.f[l] = n.f[l];
+    return o;
+}
+
+static inline Vec4 vClamp(Vec4 a) {
+    return vMap(a, a, [](float x, float) {
+        return std::fabs(x) <= FLT_MAX ? x : std::signbit(x) ? -FLT_MAX : FLT_MAX;
+    });
+}
+
+static inline uint32_t vZeroMask(Vec4 a) { return vMask(a, a, [](float x, float) { return x == 0.0f; }); }
+static inline uint32_t vSignMask(Vec4 a) { return vMask(a, a, [](float x, float) { return std::signbit(x); }); }
+static inline uint32_t vOverMask(Vec4 a) { return vMask(a, a, [](float x, float) { return !(std::fabs(x) <= FLT_MAX); }); }
+static inline uint32_t vGtMask(Vec4 a, Vec4 b) { return vMask(a, b, [](float x, float y) { return x > y; }); }
+static inline uint32_t vLtMask(Vec4 a, Vec4 b) { return vMask(a, b, [](float x, float y) { return x < y; }); }
+
+template <int N> static inline Vec4 vItof(Vec4 a) {
+    Vec4 r;
+    for (int l = 0; l < 4; ++l) r.f[l] = static_cast<float>(static_cast<int32_t>(bits(a.f[l]))) / (1 << N);
+    return r;
+}
+template <int N> static inline Vec4 vFtoi(Vec4 a) {
+    Vec4 r;
+    for (int l = 0; l < 4; ++l) {
+        const float s = a.f[l] * (1 << N);
+        const int32_t i = s >= 2147483648.0f ? 0x7FFFFFFF : !(s > -2147483648.0f) ? INT32_MIN : static_cast<int32_t>(s);
+        r.f[l] = flt(static_cast<uint32_t>(i));
+    }
+    return r;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// Instruction fields
+// -----------------------------------------------------------------------------
+
+static inline uint32_t fDest(uint32_t i) { return (i >> 21) & 0xF; }
+static inline uint32_t fFt(uint32_t i)   { return (i >> 16) & 0x1F; }
+static inline uint32_t fFs(uint32_t i)   { return (i >> 11) & 0x1F; }
+static inline uint32_t fFd(uint32_t i)   { return (i >> 6) & 0x1F; }
+static inline uint32_t fFsf(uint32_t i)  { return (i >> 21) & 3; }
+static inline uint32_t fFtf(uint32_t i)  { return (i >> 23) & 3; }
+static inline int32_t  fImm5(uint32_t i)  { return static_cast<int32_t>(i << 21) >> 27; }
+static inline int32_t  fImm11(uint32_t i) { return static_cast<int32_t>(i << 21) >> 21; }
+static inline uint32_t fImm12(uint32_t i) { return ((i >> 10) & 0x800) | (i & 0x7FF); }
+static inline uint32_t fImm15(uint32_t i) { return ((i >> 10) & 0x7800) | (i & 0x7FF); }
+
+static constexpr uint32_t VU_UPPER_I = 1u << 31;
+static constexpr uint32_t VU_UPPER_E = 1u << 30;
+
+// -----------------------------------------------------------------------------
+// Register and memory access
+// -----------------------------------------------------------------------------
+
+static inline void viSet(VU& vu, uint32_t r, uint32_t v) {
+    if (r & 15) vu.VI[r & 15] = static_cast<uint16_t>(v);
+}
+
+static inline void vfSet(VU& vu, uint32_t r, uint32_t dest, Vec4 v) {
+    if (r) vStore(vu.VF[r], vSelect(dest, v, vLoad(vu.VF[r])));
+}
+
+// Upper results land after the paired lower op has read its operands
+static inline void vfSetUpper(VU& vu, uint32_t r, uint32_t dest, Vec4 v) {
+    vStore(vu.upperOut, v);
+    vu.upperReg = static_cast<int8_t>(r);
+    vu.upperDest = static_cast<uint8_t>(dest);
+}
+
+static inline void vuCommitUpper(VU& vu) {
+    if (vu.upperReg > 0) vfSet(vu, static_cast<uint32_t>(vu.upperReg), vu.upperDest, vLoad(vu.upperOut));
+    vu.upperReg = -1;
+}
+
+static inline VUVec& vuMem(VU& vu, uint32_t qaddr) {
+    return vu.data[qaddr & vu.dataMask];
+}
+
+// MAC and status Z/S/O for the lanes in dest; sticky copies sit 6 bits up
+static inline void vuSetFlags(VU& vu, uint32_t dest, Vec4 raw, Vec4 r) {
+    const uint32_t z = vZeroMask(r) & dest, s = vSignMask(r) & dest, o = vOverMask(raw) & dest;
+    vu.mac = z | s << 4 | o << 12;
+    uint32_t st = (z ? VU_STATUS_Z : 0) | (s ? VU_STATUS_S : 0) | (o ? VU_STATUS_O : 0);
+    vu.status = (vu.status & ~0xFu) | st | st << 6;
+}
+
+static inline void vuSetQPFlags(VU& vu, uint32_t flags) {
+    vu.status = (vu.status & ~(VU_STATUS_I | VU_STATUS_D)) | flags | flags << 6;
+}
+
+// Q and P results become visible once their latency has elapsed
+static inline void vuSyncPipes(VU& vu) {
+    if (vu.qReady && vu.cycle >= vu.qReady) { vu.Q = vu.qPending; vu.qReady = 0; }
+    if (vu.pReady && vu.cycle >= vu.pReady) { vu.P = vu.pPending; vu.pReady = 0; }
+}
+
+static inline void vuFlushPipes(VU& vu) {
+    if (vu.qReady) { vu.Q = vu.qPending; vu.qReady = 0; }
+    if (vu.pReady) { vu.P = vu.pPending; vu.pReady = 0; }
+}
+
+// -----------------------------------------------------------------------------
+// Upper pipe (FMAC)
+// -----------------------------------------------------------------------------
+
+using VUOp = void (*)(VU& vu, uint32_t insn);
+
+struct VAdd { static Vec4 f(Vec4 a, Vec4 b) { return vAdd(a, b); } };
+struct VSub { static Vec4 f(Vec4 a, Vec4 b) { return vSub(a, b); } };
+struct VMul { static Vec4 f(Vec4 a, Vec4 b) { return vMul(a, b); } };
+struct VMax { static Vec4 f(Vec4 a, Vec4 b) { return vMax(a, b); } };
+struct VMin { static Vec4 f(Vec4 a, Vec4 b) { return vMin(a, b); } };
+
+// Second operand: ft, one broadcast lane of ft, I or Q
+enum class VUSrc : uint8_t { Ft, X, Y, Z, W, I, Q };
+// MADD/MSUB accumulate the product into ACC
+enum class VUAcc : uint8_t { None, Add, Sub };
+
+template <VUSrc S>
+static inline Vec4 vuOperand(const VU& vu, uint32_t i) {
+    switch (S) {
+        case VUSrc::Ft: return vLoad(vu.VF[fFt(i)]);
+        case VUSrc::X:  return vBroadcast<0>(vLoad(vu.VF[fFt(i)]));
+        case VUSrc::Y:  return vBroadcast<1>(vLoad(vu.VF[fFt(i)]));
+        case VUSrc::Z:  return vBroadcast<2>(vLoad(vu.VF[fFt(i)]));
+        case VUSrc::W:  return vBroadcast<3>(vLoad(vu.VF[fFt(i)]));
+        case VUSrc::I:  return vSplat(flt(vu.I));
+        case VUSrc::Q:  return vSplat(flt(vu.Q));
+    }
+    return vSplat(0.0f);
+}
+
+// One template covers ADD/SUB/MUL/MAX/MINI/MADD/MSUB in every operand form,
+// writing fd or (ToAcc) ACC. MAX/MINI leave the flags alone.
+template <typename Op, VUSrc S, VUAcc A, bool ToAcc, bool Flags = true>
+static void upFmac(VU& vu, uint32_t i) {
+    const uint32_t dest = fDest(i);
+    Vec4 raw = Op::f(vLoad(vu.VF[fFs(i)]), vuOperand<S>(vu, i));
+    if (A == VUAcc::Add) raw = vAdd(vLoad(vu.ACC), vClamp(raw));
+    if (A == VUAcc::Sub) raw = vSub(vLoad(vu.ACC), vClamp(raw));
+    const Vec4 r = vClamp(raw);
+    if (Flags) vuSetFlags(vu, dest, raw, r);
+    if (ToAcc) vStore(vu.ACC, vSelect(dest, r, vLoad(vu.ACC)));
+    else       vfSetUpper(vu, fFd(i), dest, r);
+}
+
+// OPMULA/OPMSUB: the cross product terms fs.yzx * ft.zxy
+template <bool ToAcc>
+static void upOuter(VU& vu, uint32_t i) {
+    const uint32_t dest = fDest(i);
+    const Vec4 p = vClamp(vMul(vPermute<1, 2, 0, 3>(vLoad(vu.VF[fFs(i)])), vPermute<2, 0, 1, 3>(vLoad(vu.VF[fFt(i)]))));
+    const Vec4 raw = ToAcc ? p : vSub(vLoad(vu.ACC), p);
+    const Vec4 r = vClamp(raw);
+    vuSetFlags(vu, dest, raw, r);
+    if (ToAcc) vStore(vu.ACC, vSelect(dest, r, vLoad(vu.ACC)));
+    else       vfSetUpper(vu, fFd(i), dest, r);
+}
+
+template <int N> static void upItof(VU& vu, uint32_t i) { vfSetUpper(vu, fFt(i), fDest(i), vItof<N>(vLoad(vu.VF[fFs(i)]))); }
+template <int N> static void upFtoi(VU& vu, uint32_t i) { vfSetUpper(vu, fFt(i), fDest(i), vFtoi<N>(vLoad(vu.VF[fFs(i)]))); }
+static void upAbs(VU& vu, uint32_t i) { vfSetUpper(vu, fFt(i), fDest(i), vAbs(vLoad(vu.VF[fFs(i)]))); }
+
+// Shift the previous judgements up and add +x -x +y -y +z -z against |ft.w|
+static void upClip(VU& vu, uint32_t i) {
+    const Vec4 fs = vLoad(vu.VF[fFs(i)]);
+    const Vec4 w = vAbs(vBroadcast<3>(vLoad(vu.VF[fFt(i)])));
+    const uint32_t gt = vGtMask(fs, w), lt = vLtMask(fs, vSub(vSplat(0.0f), w));
+    const uint32_t j = (gt >> 3 & 1) | (lt >> 3 & 1) << 1 | (gt >> 2 & 1) << 2 |
+                       (lt >> 2 & 1) << 3 | (gt >> 1 & 1) << 4 | (lt >> 1 & 1) << 5;
+    vu.clip = ((vu.clip << 6) | j) & 0xFFFFFF;
+}
+
+static void vuNop(VU&, uint32_t) {}
+
+template <size_t N>
+struct VUTable {
+    std::array<VUOp, N> t{};
+    constexpr VUTable() { for (auto& e : t) e = vuNop; }
+    // Four broadcast forms starting at slot i
+    template <typename Op, VUAcc A, bool ToAcc, bool Flags = true>
+    constexpr void bc(size_t i) {
+        t[i + 0] = upFmac<Op, VUSrc::X, A, ToAcc, Flags>;
+        t[i + 1] = upFmac<Op, VUSrc::Y, A, ToAcc, Flags>;
+        t[i + 2] = upFmac<Op, VUSrc::Z, A, ToAcc, Flags>;
+        t[i + 3] = upFmac<Op, VUSrc::W, A, ToAcc, Flags>;
+    }
+};
+
+// Slots 0x3C-0x3F: (fd << 2 | funct & 3)
+static constexpr std::array<VUOp, 128> vuMakeUpperSpecial() {
+    VUTable<128> b;
+    b.bc<VAdd, VUAcc::None, true>(0x00);                          // ADDAbc
+    b.bc<VSub, VUAcc::None, true>(0x04);                          // SUBAbc
+    b.bc<VMul, VUAcc::Add, true>(0x08);                           // MADDAbc
+    b.bc<VMul, VUAcc::Sub, true>(0x0C);                           // MSUBAbc
+    b.t[0x10] = upItof<0>;  b.t[0x11] = upItof<4>;  b.t[0x12] = upItof<12>; b.t[0x13] = upItof<15>;
+    b.t[0x14] = upFtoi<0>;  b.t[0x15] = upFtoi<4>;  b.t[0x16] = upFtoi<12>; b.t[0x17] = upFtoi<15>;
+    b.bc<VMul, VUAcc::None, true>(0x18);                          // MULAbc
+    b.t[0x1C] = upFmac<VMul, VUSrc::Q, VUAcc::None, true>;        // MULAq
+    b.t[0x1D] = upAbs;
+    b.t[0x1E] = upFmac<VMul, VUSrc::I, VUAcc::None, true>;        // MULAi
+    b.t[0x1F] = upClip;
+    b.t[0x20] = upFmac<VAdd, VUSrc::Q, VUAcc::None, true>;        // ADDAq
+    b.t[0x21] = upFmac<VMul, VUSrc::Q, VUAcc::Add, true>;         // MADDAq
+    b.t[0x22] = upFmac<VAdd, VUSrc::I, VUAcc::None, true>;        // ADDAi
+    b.t[0x23] = upFmac<VMul, VUSrc::I, VUAcc::Add, true>;         // MADDAi
+    b.t[0x24] = upFmac<VSub, VUSrc::Q, VUAcc::None, true>;        // SUBAq
+    b.t[0x25] = upFmac<VMul, VUSrc::Q, VUAcc::Sub, true>;         // MSUBAq
+    b.t[0x26] = upFmac<VSub, VUSrc::I, VUAcc::None, true>;        // SUBAi
+    b.t[0x27] = upFmac<VMul, VUSrc::I, VUAcc::Sub, true>;         // MSUBAi
+    b.t[0x28] = upFmac<VAdd, VUSrc::Ft, VUAcc::None, true>;       // ADDA
+    b.t[0x29] = upFmac<VMul, VUSrc::Ft, VUAcc::Add, true>;        // MADDA
+    b.t[0x2A] = upFmac<VMul, VUSrc::Ft, VUAcc::None, true>;       // MULA
+    b.t[0x2C] = upFmac<VSub, VUSrc::Ft, VUAcc::None, true>;       // SUBA
+    b.t[0x2D] = upFmac<VMul, VUSrc::Ft, VUAcc::Sub, true>;        // MSUBA
+    b.t[0x2E] = upOuter<true>;                                    // OPMULA
+    return b.t;                                                   // 0x2F NOP
+}
+static constexpr std::array<VUOp, 128> kUpperSpecial = vuMakeUpperSpecial();
+
+static inline uint32_t vuSpecialIndex(uint32_t i) { return ((i >> 4) & 0x7C) | (i & 3); }
+
+static void upSpecial(VU& vu, uint32_t i) { kUpperSpecial[vuSpecialIndex(i)](vu, i); }
+
+// Upper ops by funct
+static constexpr std::array<VUOp, 64> vuMakeUpper() {
+    VUTable<64> b;
+    b.bc<VAdd, VUAcc::None, false>(0x00);                         // ADDbc
+    b.bc<VSub, VUAcc::None, false>(0x04);                         // SUBbc
+    b.bc<VMul, VUAcc::Add, false>(0x08);                          // MADDbc
+    b.bc<VMul, VUAcc::Sub, false>(0x0C);                          // MSUBbc
+    b.bc<VMax, VUAcc::None, false, false>(0x10);                  // MAXbc
+    b.bc<VMin, VUAcc::None, false, false>(0x14);                  // MINIbc
+    b.bc<VMul, VUAcc::None, false>(0x18);                         // MULbc
+    b.t[0x1C] = upFmac<VMul, VUSrc::Q, VUAcc::None, false>;       // MULq
+    b.t[0x1D] = upFmac<VMax, VUSrc::I, VUAcc::None, false, false>; // MAXi
+    b.t[0x1E] = upFmac<VMul, VUSrc::I, VUAcc::None, false>;       // MULi
+    b.t[0x1F] = upFmac<VMin, VUSrc::I, VUAcc::None, false, false>; // MINIi
+    b.t[0x20] = upFmac<VAdd, VUSrc::Q, VUAcc::None, false>;       // ADDq
+    b.t[0x21] = upFmac<VMul, VUSrc::Q, VUAcc::Add, false>;        // MADDq
+    b.t[0x22] = upFmac<VAdd, VUSrc::I, VUAcc::None, false>;       // ADDi
+    b.t[0x23] = upFmac<VMul, VUSrc::I, VUAcc::Add, false>;        // MADDi
+    b.t[0x24] = upFmac<VSub, VUSrc::Q, VUAcc::None, false>;       // SUBq
+    b.t[0x25] = upFmac<VMul, VUSrc::Q, VUAcc::Sub, false>;        // MSUBq
+    b.t[0x26] = upFmac<VSub, VUSrc::I, VUAcc::None, false>;       // SUBi
+    b.t[0x27] = upFmac<VMul, VUSrc::I, VUAcc::Sub, false>;        // MSUBi
+    b.t[0x28] = upFmac<VAdd, VUSrc::Ft, VUAcc::None, false>;      // ADD
+    b.t[0x29] = upFmac<VMul, VUSrc::Ft, VUAcc::Add, false>;       // MADD
+    b.t[0x2A] = upFmac<VMul, VUSrc::Ft, VUAcc::None, false>;      // MUL
+    b.t[0x2B] = upFmac<VMax, VUSrc::Ft, VUAcc::None, false, false>; // MAX
+    b.t[0x2C] = upFmac<VSub, VUSrc::Ft, VUAcc::None, false>;      // SUB
+    b.t[0x2D] = upFmac<VMul, VUSrc::Ft, VUAcc::Sub, false>;       // MSUB
+    b.t[0x2E] = upOuter<false>;                                   // OPMSUB
+    b.t[0x2F] = upFmac<VMin, VUSrc::Ft, VUAcc::None, false, false>; // MINI
+    for (size_t i = 0x3C; i < 0x40; ++i) b.t[i] = upSpecial;
+    return b.t;
+}
+static constexpr std::array<VUOp, 64> kUpper = vuMakeUpper();
+
+// -----------------------------------------------------------------------------
+// Lower pipe
+// -----------------------------------------------------------------------------
+
+// First lane of dest (ILW picks one word)
+static inline uint32_t vuFirstLane(uint32_t dest) {
+    return (dest & 8) ? 0 : (dest & 4) ? 1 : (dest & 2) ? 2 : 3;
+}
+
+static void loLQ(VU& vu, uint32_t i) {
+    vfSet(vu, fFt(i), fDest(i), vLoad(vuMem(vu, vu.VI[fFs(i) & 15] + fImm11(i))));
+}
+static void loSQ(VU& vu, uint32_t i) {
+    VUVec& q = vuMem(vu, vu.VI[fFt(i) & 15] + fImm11(i));
+    vStore(q, vSelect(fDest(i), vLoad(vu.VF[fFs(i)]), vLoad(q)));
+}
+static void loILW(VU& vu, uint32_t i) {
+    viSet(vu, fFt(i), vuMem(vu, vu.VI[fFs(i) & 15] + fImm11(i)).UL[vuFirstLane(fDest(i))]);
+}
+static void loISW(VU& vu, uint32_t i) {
+    VUVec& q = vuMem(vu, vu.VI[fFs(i) & 15] + fImm11(i));
+    for (uint32_t l = 0; l < 4; ++l) if (fDest(i) & (8 >> l)) q.UL[l] = vu.VI[fFt(i) & 15];
+}
+static void loILWR(VU& vu, uint32_t i) {
+    viSet(vu, fFt(i), vuMem(vu, vu.VI[fFs(i) & 15]).UL[vuFirstLane(fDest(i))]);
+}
+static void loISWR(VU& vu, uint32_t i) {
+    VUVec& q = vuMem(vu, vu.VI[fFs(i) & 15]);
+    for (uint32_t l = 0; l < 4; ++l) if (fDest(i) & (8 >> l)) q.UL[l] = vu.VI[fFt(i) & 15];
+}
+// LQI/SQI post-increment, LQD/SQD pre-decrement the address register
+static void loLQI(VU& vu, uint32_t i) {
+    const uint32_t is = fFs(i) & 15;
+    vfSet(vu, fFt(i), fDest(i), vLoad(vuMem(vu, vu.VI[is])));
+    viSet(vu, is, vu.VI[is] + 1u);
+}
+static void loLQD(VU& vu, uint32_t i) {
+    const uint32_t is = fFs(i) & 15;
+    viSet(vu, is, vu.VI[is] - 1u);
+    vfSet(vu, fFt(i), fDest(i), vLoad(vuMem(vu, vu.VI[is])));
+}
+static void loSQI(VU& vu, uint32_t i) {
+    const uint32_t it = fFt(i) & 15;
+    VUVec& q = vuMem(vu, vu.VI[it]);
+    vStore(q, vSelect(fDest(i), vLoad(vu.VF[fFs(i)]), vLoad(q)));
+    viSet(vu, it, vu.VI[it] + 1u);
+}
+static void loSQD(VU& vu, uint32_t i) {
+    const uint32_t it = fFt(i) & 15;
+    viSet(vu, it, vu.VI[it] - 1u);
+    VUVec& q = vuMem(vu, vu.VI[it]);
+    vStore(q, vSelect(fDest(i), vLoad(vu.VF[fFs(i)]), vLoad(q)));
+}
+
+// Integer ALU on the 16-bit VI registers
+static void loIADD(VU& vu, uint32_t i)  { viSet(vu, fFd(i), vu.VI[fFs(i) & 15] + vu.VI[fFt(i) & 15]); }
+static void loISUB(VU& vu, uint32_t i)  { viSet(vu, fFd(i), vu.VI[fFs(i) & 15] - vu.VI[fFt(i) & 15]); }
+static void loIAND(VU& vu, uint32_t i)  { viSet(vu, fFd(i), vu.VI[fFs(i) & 15] & vu.VI[fFt(i) & 15]); }
+static void loIOR(VU& vu, uint32_t i)   { viSet(vu, fFd(i), vu.VI[fFs(i) & 15] | vu.VI[fFt(i) & 15]); }
+static void loIADDI(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.VI[fFs(i) & 15] + static_cast<uint32_t>(fImm5(i))); }
+static void loIADDIU(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.VI[fFs(i) & 15] + fImm15(i)); }
+static void loISUBIU(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.VI[fFs(i) & 15] - fImm15(i)); }
+
+// Register moves
+static void loMOVE(VU& vu, uint32_t i) { vfSet(vu, fFt(i), fDest(i), vLoad(vu.VF[fFs(i)])); }
+static void loMR32(VU& vu, uint32_t i) { vfSet(vu, fFt(i), fDest(i), vPermute<1, 2, 3, 0>(vLoad(vu.VF[fFs(i)]))); }
+static void loMTIR(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.VF[fFs(i)].UL[fFsf(i)]); }
+static void loMFIR(VU& vu, uint32_t i) {
+    const int32_t v = static_cast<int16_t>(vu.VI[fFs(i) & 15]);
+    vfSet(vu, fFt(i), fDest(i), vSplat(flt(static_cast<uint32_t>(v))));
+}
+static void loMFP(VU& vu, uint32_t i) { vfSet(vu, fFt(i), fDest(i), vSplat(flt(vu.P))); }
+
+// Q pipeline: DIV/SQRT/RSQRT, result visible after 7/7/13 cycles
+static inline void vuIssueQ(VU& vu, float q, uint32_t latency) {
+    vuFlushPipes(vu);
+    vu.qPending = bits(q);
+    vu.qReady = vu.cycle + latency;
+}
+static void loDIV(VU& vu, uint32_t i) {
+    const float fs = vu.VF[fFs(i)].F[fFsf(i)], ft = vu.VF[fFt(i)].F[fFtf(i)];
+    uint32_t flags = 0;
+    float q;
+    if (ft == 0.0f) {
+        flags = fs == 0.0f ? VU_STATUS_I : VU_STATUS_D;
+        q = (std::signbit(fs) != std::signbit(ft)) ? -FLT_MAX : FLT_MAX;
+    } else {
+        q = fs / ft;
+        if (!(std::fabs(q) <= FLT_MAX)) q = std::signbit(q) ? -FLT_MAX : FLT_MAX;
+    }
+    vuSetQPFlags(vu, flags);
+    vuIssueQ(vu, q, 7);
+}
+static void loSQRT(VU& vu, uint32_t i) {
+    const float ft = vu.VF[fFt(i)].F[fFtf(i)];
+    vuSetQPFlags(vu, ft < 0.0f ? VU_STATUS_I : 0);
+    vuIssueQ(vu, std::sqrt(std::fabs(ft)), 7);
+}
+static void loRSQRT(VU& vu, uint32_t i) {
+    const float fs = vu.VF[fFs(i)].F[fFsf(i)], ft = vu.VF[fFt(i)].F[fFtf(i)];
+    uint32_t flags = ft < 0.0f ? VU_STATUS_I : 0;
+    float q;
+    if (ft == 0.0f) {
+        flags = fs == 0.0f ? VU_STATUS_I : VU_STATUS_D;
+        q = std::signbit(fs) ? -FLT_MAX : FLT_MAX;
+    } else {
+        q = fs / std::sqrt(std::fabs(ft));
+        if (!(std::fabs(q) <= FLT_MAX)) q = std::signbit(q) ? -FLT_MAX : FLT_MAX;
+    }
+    vuSetQPFlags(vu, flags);
+    vuIssueQ(vu, q, 13);
+}
+static void loWAITQ(VU& vu, uint32_t) {
+    if (vu.qReady && vu.qReady > vu.cycle) vu.cycle = vu.qReady;
+    vuSyncPipes(vu);
+}
+
+// EFU ops write P
+static inline void vuIssueP(VU& vu, float p, uint32_t latency) {
+    if (vu.pReady) { vu.P = vu.pPending; vu.pReady = 0; }
+    if (!(std::fabs(p) <= FLT_MAX)) p = std::signbit(p) ? -FLT_MAX : FLT_MAX;
+    vu.pPending = bits(p);
+    vu.pReady = vu.cycle + latency;
+}
+static inline float vuDot3(const VUVec& v) { return v.F[0] * v.F[0] + v.F[1] * v.F[1] + v.F[2] * v.F[2]; }
+static inline float vuFsf(const VU& vu, uint32_t i) { return vu.VF[fFs(i)].F[fFsf(i)]; }
+
+static void loESADD(VU& vu, uint32_t i)  { vuIssueP(vu, vuDot3(vu.VF[fFs(i)]), 11); }
+static void loERSADD(VU& vu, uint32_t i) { vuIssueP(vu, 1.0f / vuDot3(vu.VF[fFs(i)]), 18); }
+static void loELENG(VU& vu, uint32_t i)  { vuIssueP(vu, std::sqrt(vuDot3(vu.VF[fFs(i)])), 18); }
+static void loERLENG(VU& vu, uint32_t i) { vuIssueP(vu, 1.0f / std::sqrt(vuDot3(vu.VF[fFs(i)])), 24); }
+static void loEATANxy(VU& vu, uint32_t i) { const VUVec& v = vu.VF[fFs(i)]; vuIssueP(vu, std::atan2(v.F[1], v.F[0]), 54); }
+static void loEATANxz(VU& vu, uint32_t i) { const VUVec& v = vu.VF[fFs(i)]; vuIssueP(vu, std::atan2(v.F[2], v.F[0]), 54); }
+static void loESUM(VU& vu, uint32_t i) {
+    const VUVec& v = vu.VF[fFs(i)];
+    vuIssueP(vu, v.F[0] + v.F[1] + v.F[2] + v.F[3], 12);
+}
+static void loESQRT(VU& vu, uint32_t i)  { vuIssueP(vu, std::sqrt(std::fabs(vuFsf(vu, i))), 12); }
+static void loERSQRT(VU& vu, uint32_t i) { vuIssueP(vu, 1.0f / std::sqrt(std::fabs(vuFsf(vu, i))), 18); }
+static void loERCPR(VU& vu, uint32_t i)  { vuIssueP(vu, 1.0f / vuFsf(vu, i), 12); }
+static void loESIN(VU& vu, uint32_t i)   { vuIssueP(vu, std::sin(vuFsf(vu, i)), 29); }
+static void loEATAN(VU& vu, uint32_t i)  { vuIssueP(vu, std::atan(vuFsf(vu, i)), 54); }
+static void loEEXP(VU& vu, uint32_t i)   { vuIssueP(vu, std::exp(-vuFsf(vu, i)), 44); }
+static void loWAITP(VU& vu, uint32_t) {
+    if (vu.pReady && vu.pReady > vu.cycle) vu.cycle = vu.pReady;
+    vuSyncPipes(vu);
+}
+
+// Random number register: 23-bit LFSR under a fixed 1.0 exponent
+static inline uint32_t vuRandom(uint32_t m) { return 0x3F800000u | (m & 0x7FFFFF); }
+static void loRINIT(VU& vu, uint32_t i) { vu.R = vuRandom(vu.VF[fFs(i)].UL[fFsf(i)]); }
+static void loRXOR(VU& vu, uint32_t i)  { vu.R = vuRandom(vu.R ^ vu.VF[fFs(i)].UL[fFsf(i)]); }
+static void loRGET(VU& vu, uint32_t i)  { vfSet(vu, fFt(i), fDest(i), vSplat(flt(vu.R))); }
+static void loRNEXT(VU& vu, uint32_t i) {
+    const uint32_t x = (vu.R >> 4) & 1, y = (vu.R >> 22) & 1;
+    vu.R = vuRandom((vu.R << 1) ^ x ^ y);
+    loRGET(vu, i);
+}
+
+// Flag tests and updates; results go to VI[it] (FC* results to VI1)
+static void loFSAND(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.status & fImm12(i)); }
+static void loFSEQ(VU& vu, uint32_t i)  { viSet(vu, fFt(i), (vu.status & 0xFFF) == fImm12(i)); }
+static void loFSOR(VU& vu, uint32_t i)  { viSet(vu, fFt(i), (vu.status & 0xFFF) | fImm12(i)); }
+static void loFSSET(VU& vu, uint32_t i) { vu.status = (vu.status & 0x3F) | (fImm12(i) & 0xFC0); }
+static void loFMAND(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.mac & vu.VI[fFs(i) & 15]); }
+static void loFMEQ(VU& vu, uint32_t i)  { viSet(vu, fFt(i), vu.mac == vu.VI[fFs(i) & 15]); }
+static void loFMOR(VU& vu, uint32_t i)  { viSet(vu, fFt(i), vu.mac | vu.VI[fFs(i) & 15]); }
+static void loFCAND(VU& vu, uint32_t i) { viSet(vu, 1, (vu.clip & i & 0xFFFFFF) != 0); }
+static void loFCEQ(VU& vu, uint32_t i)  { viSet(vu, 1, vu.clip == (i & 0xFFFFFF)); }
+static void loFCOR(VU& vu, uint32_t i)  { viSet(vu, 1, ((vu.clip | i) & 0xFFFFFF) == 0xFFFFFF); }
+static void loFCSET(VU& vu, uint32_t i) { vu.clip = i & 0xFFFFFF; }
+static void loFCGET(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.clip & 0xFFF); }
+
+// Branches take effect after the next pair; vu.tpc already points at it
+static inline void vuBranch(VU& vu, uint32_t target) {
+    vu.branchTarget = target & vu.microMask;
+    vu.branchDelay = 2;
+}
+static inline uint32_t vuBranchTarget(const VU& vu, uint32_t i) {
+    return vu.tpc + static_cast<uint32_t>(fImm11(i) * 8);
+}
+static void loB(VU& vu, uint32_t i) { vuBranch(vu, vuBranchTarget(vu, i)); }
+static void loBAL(VU& vu, uint32_t i) {
+    viSet(vu, fFt(i), (vu.tpc + 8) / 8);
+    vuBranch(vu, vuBranchTarget(vu, i));
+}
+static void loJR(VU& vu, uint32_t i) { vuBranch(vu, vu.VI[fFs(i) & 15] * 8u); }
+static void loJALR(VU& vu, uint32_t i) {
+    const uint32_t target = vu.VI[fFs(i) & 15] * 8u;
+    viSet(vu, fFt(i), (vu.tpc + 8) / 8);
+    vuBranch(vu, target);
+}
+enum class VUCmp : uint8_t { Eq, Ne, Ltz, Gtz, Lez, Gez };
+template <VUCmp C>
+static void loIB(VU& vu, uint32_t i) {
+    const int16_t s = static_cast<int16_t>(vu.VI[fFs(i) & 15]);
+    const uint16_t t = vu.VI[fFt(i) & 15];
+    bool taken = false;
+    switch (C) {
+        case VUCmp::Eq:  taken = static_cast<uint16_t>(s) == t; break;
+        case VUCmp::Ne:  taken = static_cast<uint16_t>(s) != t; break;
+        case VUCmp::Ltz: taken = s < 0;  break;
+        case VUCmp::Gtz: taken = s > 0;  break;
+        case VUCmp::Lez: taken = s <= 0; break;
+        case VUCmp::Gez: taken = s >= 0; break;
+    }
+    if (taken) vuBranch(vu, vuBranchTarget(vu, i));
+}
+
+// VU1: VIF double-buffer pointers and GIF path 1
+static void loXTOP(VU& vu, uint32_t i)  { viSet(vu, fFt(i), vu.top & 0x3FF); }
+static void loXITOP(VU& vu, uint32_t i) { viSet(vu, fFt(i), vu.itop & 0x3FF); }
+static void loXGKICK(VU& vu, uint32_t i) {
+    if (vu.onXgkick) vu.onXgkick(vu.xgkickUser, vu, (vu.VI[fFs(i) & 15] * 16u) & (vu.dataMask * 16u + 15u));
+}
+
+// Lower 0x40 group, slots 0x3C-0x3F: (fd << 2 | funct & 3)
+static constexpr std::array<VUOp, 128> vuMakeLowerSpecial() {
+    VUTable<128> b;
+    b.t[0x30] = loMOVE;   b.t[0x31] = loMR32;
+    b.t[0x34] = loLQI;    b.t[0x35] = loSQI;    b.t[0x36] = loLQD;    b.t[0x37] = loSQD;
+    b.t[0x38] = loDIV;    b.t[0x39] = loSQRT;   b.t[0x3A] = loRSQRT;  b.t[0x3B] = loWAITQ;
+    b.t[0x3C] = loMTIR;   b.t[0x3D] = loMFIR;   b.t[0x3E] = loILWR;   b.t[0x3F] = loISWR;
+    b.t[0x40] = loRNEXT;  b.t[0x41] = loRGET;   b.t[0x42] = loRINIT;  b.t[0x43] = loRXOR;
+    b.t[0x64] = loMFP;
+    b.t[0x68] = loXTOP;   b.t[0x69] = loXITOP;  b.t[0x6C] = loXGKICK;
+    b.t[0x70] = loESADD;  b.t[0x71] = loERSADD; b.t[0x72] = loELENG;  b.t[0x73] = loERLENG;
+    b.t[0x74] = loEATANxy; b.t[0x75] = loEATANxz; b.t[0x76] = loESUM;
+    b.t[0x78] = loESQRT;  b.t[0x79] = loERSQRT; b.t[0x7A] = loERCPR;  b.t[0x7B] = loWAITP;
+    b.t[0x7C] = loESIN;   b.t[0x7D] = loEATAN;  b.t[0x7E] = loEEXP;
+    return b.t;
+}
+static constexpr std::array<VUOp, 128> kLowerSpecial = vuMakeLowerSpecial();
+
+static void loSpecial(VU& vu, uint32_t i) { kLowerSpecial[vuSpecialIndex(i)](vu, i); }
+
+static constexpr std::array<VUOp, 64> vuMakeLowerOp() {
+    VUTable<64> b;
+    b.t[0x30] = loIADD;   b.t[0x31] = loISUB;   b.t[0x32] = loIADDI;
+    b.t[0x34] = loIAND;   b.t[0x35] = loIOR;
+    for (size_t i = 0x3C; i < 0x40; ++i) b.t[i] = loSpecial;
+    return b.t;
+}
+static constexpr std::array<VUOp, 64> kLowerOp = vuMakeLowerOp();
+
+static void loGroup(VU& vu, uint32_t i) { kLowerOp[i & 0x3F](vu, i); }
+
+// Lower ops by bits 31-25
+static constexpr std::array<VUOp, 128> vuMakeLower() {
+    VUTable<128> b;
+    b.t[0x00] = loLQ;     b.t[0x01] = loSQ;     b.t[0x04] = loILW;    b.t[0x05] = loISW;
+    b.t[0x08] = loIADDIU; b.t[0x09] = loISUBIU;
+    b.t[0x10] = loFCEQ;   b.t[0x11] = loFCSET;  b.t[0x12] = loFCAND;  b.t[0x13] = loFCOR;
+    b.t[0x14] = loFSEQ;   b.t[0x15] = loFSSET;  b.t[0x16] = loFSAND;  b.t[0x17] = loFSOR;
+    b.t[0x18] = loFMEQ;   b.t[0x1A] = loFMAND;  b.t[0x1B] = loFMOR;   b.t[0x1C] = loFCGET;
+    b.t[0x20] = loB;      b.t[0x21] = loBAL;    b.t[0x24] = loJR;     b.t[0x25] = loJALR;
+    b.t[0x28] = loIB<VUCmp::Eq>;  b.t[0x29] = loIB<VUCmp::Ne>;
+    b.t[0x2C] = loIB<VUCmp::Ltz>; b.t[0x2D] = loIB<VUCmp::Gtz>;
+    b.t[0x2E] = loIB<VUCmp::Lez>; b.t[0x2F] = loIB<VUCmp::Gez>;
+    b.t[0x40] = loGroup;
+    return b.t;
+}
+static constexpr std::array<VUOp, 128> kLower = vuMakeLower();
+
+// -----------------------------------------------------------------------------
+// Execution
+// -----------------------------------------------------------------------------
+
+// Registers and execution state; micro and data memory survive (FBRST reset)
+void vuReset(VU& vu) {
+    for (auto& r : vu.VF) r = VUVec{};
+    vu.VF[0].F[3] = 1.0f;
+    for (auto& r : vu.VI) r = 0;
+    vu.ACC = VUVec{};
+    vu.I = vu.Q = vu.P = 0;
+    vu.R = 0x3F800000u;
+    vu.status = vu.mac = vu.clip = 0;
+    vu.qPending = vu.pPending = 0;
+    vu.qReady = vu.pReady = 0;
+    vu.tpc = 0;
+    vu.running = false;
+    vu.branchDelay = vu.endDelay = 0;
+    vu.branchTarget = 0;
+    vu.cycle = vu.executed = 0;
+    vu.upperReg = -1;
+    vu.top = vu.itop = 0;
+    vu.cmsar = 0;
+}
+
+void vuInit(VU& vu, int index) {
+    const size_t bytes = index == 0 ? 4 * 1024 : 16 * 1024;
+    vu.index = index;
+    vu.micro.assign(bytes / 4, 0u);
+    vu.data.assign(bytes / 16, VUVec{});
+    vu.microMask = static_cast<uint32_t>(bytes - 1) & ~7u;
+    vu.dataMask = static_cast<uint32_t>(bytes / 16 - 1);
+    vuReset(vu);
+}
+
+void vuStart(VU& vu, uint32_t addr) {
+    vu.tpc = addr & vu.microMask;
+    vu.branchDelay = vu.endDelay = 0;
+    vu.running = true;
+}
+
+// One instruction pair: upper and lower issue together, upper writes last
+static inline void vuStep(VU& vu) {
+    const uint32_t lo = vu.micro[vu.tpc / 4], hi = vu.micro[vu.tpc / 4 + 1];
+    vu.tpc = (vu.tpc + 8) & vu.microMask;
+    vuSyncPipes(vu);
+
+    kUpper[hi & 0x3F](vu, hi);
+    if (hi & VU_UPPER_I) vu.I = lo;
+    else                 kLower[lo >> 25](vu, lo);
+    vuCommitUpper(vu);
+
+    ++vu.cycle;
+    ++vu.executed;
+    if (vu.branchDelay && --vu.branchDelay == 0) vu.tpc = vu.branchTarget;
+    if (vu.endDelay) {
+        vu.endDelay = 0;
+        vu.running = false;
+    } else if (hi & VU_UPPER_E) {
+        vu.endDelay = 1;
+    }
+}
+
+uint32_t vuRun(VU& vu, uint32_t cycles) {
+    uint32_t n = 0;
+    while (vu.running && n < cycles) {
+        vuStep(vu);
+        ++n;
+    }
+    return n;
+}
+
+void vuFinish(VU& vu) {
+    // A microprogram without an E bit would spin forever; give up eventually
+    vuRun(vu, 1u << 22);
+    vu.running = false;
+}
+
+void vuExecUpper(VU& vu, uint32_t insn) {
+    kUpper[insn & 0x3F](vu, insn);
+    vuCommitUpper(vu);
+}
+
+// Macro-mode lower ops complete before the EE moves on
+void vuExecLower(VU& vu, uint32_t insn) {
+    kLower[insn >> 25](vu, insn);
+    vuFlushPipes(vu);
+}
+
+uint32_t vuReadReg(VU& vu, uint32_t reg) {
+    if (reg < 16) return vu.VI[reg];
+    switch (reg) {
+        case VU_REG_STATUS: return vu.status & 0xFFF;
+        case VU_REG_MAC:    return vu.mac;
+        case VU_REG_CLIP:   return vu.clip;
+        case VU_REG_R:      return vu.R;
+        case VU_REG_I:      return vu.I;
+        case VU_REG_Q:      vuFlushPipes(vu); return vu.Q;
+        case VU_REG_P:      vuFlushPipes(vu); return vu.P;
+        case VU_REG_TPC:    return vu.tpc / 8;
+        case VU_REG_CMSAR0: return vu.cmsar;
+        default:            return 0;
+    }
+}
+
+void vuWriteReg(VU& vu, uint32_t reg, uint32_t value) {
+    if (reg < 16) { viSet(vu, reg, value); return; }
+    switch (reg) {
+        case VU_REG_STATUS: vu.status = (vu.status & 0x3F) | (value & 0xFC0); break;
+        case VU_REG_CLIP:   vu.clip = value & 0xFFFFFF; break;
+        case VU_REG_R:      vu.R = vuRandom(value); break;
+        case VU_REG_I:      vu.I = value; break;
+        case VU_REG_Q:      vu.Q = value; vu.qReady = 0; break;
+        case VU_REG_P:      vu.P = value; vu.pReady = 0; break;
+        case VU_REG_CMSAR0: vu.cmsar = value & 0xFFFF; break;
+        default: break;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Vector units. VU0 (4 KB micro / 4 KB data) doubles as the EE's COP2
+// (macro mode); VU1 (16 KB / 16 KB) runs microprograms kicked by the EE or
+// VIF1. Each instruction pair is an upper FMAC op and a lower op (integer,
+// load/store, branch, Q/P pipelines).
+
+// 128-bit VF register / VU data memory quadword
+union alignas(16) VUVec {
+    float    F[4];
+    uint32_t UL[4];
+    int32_t  SL[4];
+};
+
+// Special VI registers as seen through CFC2/CTC2
+enum : uint32_t {
+    VU_REG_STATUS = 16,
+    VU_REG_MAC    = 17,
+    VU_REG_CLIP   = 18,
+    VU_REG_R      = 20,
+    VU_REG_I      = 21,
+    VU_REG_Q      = 22,
+    VU_REG_P      = 23,
+    VU_REG_TPC    = 26,
+    VU_REG_CMSAR0 = 27,
+    VU_REG_FBRST  = 28,
+    VU_REG_VPU_STAT = 29,
+    VU_REG_CMSAR1 = 31,
+};
+
+// Status flag bits (sticky copies sit 6 bits higher)
+static constexpr uint32_t VU_STATUS_Z = 1u << 0;
+static constexpr uint32_t VU_STATUS_S = 1u << 1;
+static constexpr uint32_t VU_STATUS_U = 1u << 2;
+static constexpr uint32_t VU_STATUS_O = 1u << 3;
+static constexpr uint32_t VU_STATUS_I = 1u << 4;
+static constexpr uint32_t VU_STATUS_D = 1u << 5;
+
+struct VU {
+    int index = 0;
+
+    VUVec    VF[32] = {};   // VF0 reads as (0, 0, 0, 1)
+    uint16_t VI[16] = {0};  // VI0 reads as 0
+    VUVec    ACC = {};
+    uint32_t I = 0, Q = 0, P = 0, R = 0;
+    uint32_t status = 0, mac = 0, clip = 0;
+
+    // Q (DIV/SQRT/RSQRT) and P (EFU) results become visible after a latency
+    uint32_t qPending = 0, pPending = 0;
+    uint64_t qReady = 0, pReady = 0;
+
+    // Microprogram execution
+    uint32_t tpc = 0;           // byte address in micro memory
+    bool     running = false;
+    uint8_t  branchDelay = 0;   // branch taken after the next pair when it reaches 0
+    uint32_t branchTarget = 0;
+    uint8_t  endDelay = 0;      // E bit: stop after the next pair
+    uint64_t cycle = 0;         // one per instruction pair
+    uint64_t executed = 0;
+
+    // Upper-pipe result, written back after the lower op has read its inputs
+    VUVec    upperOut = {};
+    int8_t   upperReg = -1;
+    uint8_t  upperDest = 0;
+
+    // VU1 only: double-buffer pointers set by VIF1, XGKICK to GIF path 1
+    uint32_t top = 0, itop = 0;
+    void (*onXgkick)(void* user, VU& vu, uint32_t addr) = nullptr;
+    void* xgkickUser = nullptr;
+
+    uint32_t cmsar = 0;         // CMSAR0 (VU0): VCALLMSR start address / 8
+
+    std::vector<uint32_t> micro; // instruction pairs: lower word, upper word
+    std::vector<VUVec>    data;
+    uint32_t microMask = 0;      // byte address mask
+    uint32_t dataMask = 0;       // quadword index mask
+};
+
+// Allocate zeroed micro/data memory for VU0 or VU1 and reset the registers
+void     vuInit(VU& vu, int index);
+void     vuReset(VU& vu);
+
+// Start the microprogram at byte address addr (VCALLMS, CMSAR1, MSCAL)
+void     vuStart(VU& vu, uint32_t addr);
+
+// Run up to `cycles` instruction pairs; returns the number executed
+uint32_t vuRun(VU& vu, uint32_t cycles);
+
+// Run the current microprogram to its end (bounded)
+void     vuFinish(VU& vu);
+
+// Macro mode: execute one upper or lower op immediately (the EE's COP2)
+void     vuExecUpper(VU& vu, uint32_t insn);
+void     vuExecLower(VU& vu, uint32_t insn);
+
+// CFC2/CTC2 view of VI0-15 and the VU0 control registers
+uint32_t vuReadReg(VU& vu, uint32_t reg);
+void     vuWriteReg(VU& vu, uint32_t reg, uint32_t value);
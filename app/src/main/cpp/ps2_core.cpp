@@ -5,7 +5,9 @@
 #include <sstream>
 #include <iomanip>
 #include <cstring> // std::memcpy
-#include <algorithm> // std::fill
+#include <algorithm> // std::min
+#include <sys/mman.h>
+#include <unistd.h>
 #include "ps2_core.h"
 
 // -----------------------------
@@ -38,10 +40,42 @@ static std::vector<uint8_t> biosEROM;      // Extended ROM
 static std::vector<uint8_t> biosNVM;       // NVM (not executable)
 static std::vector<uint8_t> biosMEC;       // MEC (not executable)
 
+// Guest memory: reserved up front, committed lazily. Pages read as zero and
+// only cost resident memory once the guest writes them.
+struct GuestMemory {
+    uint8_t* ptr = nullptr;
+    size_t   len = 0;
+
+    uint8_t* data() const { return ptr; }
+    size_t   size() const { return len; }
+};
+
+static GuestMemory reserveGuest(size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? GuestMemory{} : GuestMemory{static_cast<uint8_t*>(p), size};
+}
+
+// Zero a region by dropping its pages rather than writing 0 over them
+static void releaseGuest(const GuestMemory& g) {
+    if (!g.ptr) return;
+    if (madvise(g.ptr, g.len, MADV_DONTNEED) != 0) std::memset(g.ptr, 0, g.len);
+}
+
+// Bytes of a region currently backed by host memory
+static size_t residentBytes(const GuestMemory& g) {
+    if (!g.ptr) return 0;
+    const size_t hostPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> pages((g.len + hostPage - 1) / hostPage);
+    if (mincore(g.ptr, g.len, pages.data()) != 0) return 0;
+    size_t n = 0;
+    for (unsigned char v : pages) n += v & 1;
+    return std::min(n * hostPage, g.len);
+}
+
 // EE memory buffers (v0.3)
-static std::vector<uint8_t> eeRAM(EERAM_SIZE, 0);
-static std::vector<uint8_t> scratchpad(SCRATCH_SIZE, 0);
-static std::vector<uint8_t> iopRAM(IOPRAM_SIZE, 0);
+static GuestMemory eeRAM      = reserveGuest(EERAM_SIZE);
+static GuestMemory scratchpad = reserveGuest(SCRATCH_SIZE);
+static GuestMemory iopRAM     = reserveGuest(IOPRAM_SIZE);
 
 // -----------------------------
 // Utilities
@@ -58,11 +92,60 @@ static std::string hex16(uint16_t v) {
     return oss.str();
 }
 
-static inline bool inRange(uint32_t addr, uint32_t base, uint32_t size) {
-    return addr >= base && addr < (base + size);
+// -----------------------------
+// Page tables (4 KB pages over the 32-bit space)
+// -----------------------------
+// Host base of each guest page, or nullptr if unmapped. ROM pages are
+// readable only; RAM, scratchpad and IOP RAM also appear in KSEG0/KSEG1.
+// The tables are guest memory too: only the parts that map something
+// become resident.
+static const uint32_t PAGE_SHIFT = 12;
+static const uint32_t PAGE_MASK  = (1u << PAGE_SHIFT) - 1;
+static const GuestMemory readTable  = reserveGuest(sizeof(uint8_t*) << (32 - PAGE_SHIFT));
+static const GuestMemory writeTable = reserveGuest(sizeof(uint8_t*) << (32 - PAGE_SHIFT));
+static uint8_t** const readPages  = reinterpret_cast<uint8_t**>(readTable.data());
+static uint8_t** const writePages = reinterpret_cast<uint8_t**>(writeTable.data());
+
+static void mapPages(uint32_t base, uint8_t* host, size_t size, bool writable) {
+    for (size_t off = 0; off + PAGE_MASK < size; off += PAGE_MASK + 1) {
+        const uint32_t page = (base + static_cast<uint32_t>(off)) >> PAGE_SHIFT;
+        readPages[page]  = host + off;
+        writePages[page] = writable ? host + off : nullptr;
+    }
+}
+
+static void unmapPages(uint32_t base, size_t size) {
+    for (size_t off = 0; off < size; off += PAGE_MASK + 1) {
+        const uint32_t page = (base + static_cast<uint32_t>(off)) >> PAGE_SHIFT;
+        readPages[page] = writePages[page] = nullptr;
+    }
+}
+
+static void mapMemory() {
+    for (uint32_t seg : {0x00000000u, 0x80000000u, 0xA0000000u}) {
+        mapPages(seg | EERAM_BASE, eeRAM.data(), eeRAM.size(), true);
+        mapPages(seg | IOPRAM_BASE, iopRAM.data(), iopRAM.size(), true);
+        // biosROM may have been reallocated by a reload
+        unmapPages(seg | 0x1FC00000, 4 * 1024 * 1024);
+        mapPages(seg | 0x1FC00000, biosROM.data(), biosROM.size(), false);
+    }
+    mapPages(SCRATCH_BASE, scratchpad.data(), scratchpad.size(), true);
+}
+
+// Guest values are stored big-endian; each access width swaps its own bytes
+template <typename T> static inline T swapBE(T v);
+template <> inline uint8_t  swapBE(uint8_t v)  { return v; }
+template <> inline uint16_t swapBE(uint16_t v) { return __builtin_bswap16(v); }
+template <> inline uint32_t swapBE(uint32_t v) { return __builtin_bswap32(v); }
+
+template <typename T>
+static inline T readBE(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return swapBE(v);
 }
 
-// Fetch 32-bit instruction from BIOS ROM region (big-endian in ROM storage)
+// Fetch 32-bit instruction through the read page table
 static bool fetch32(uint32_t addr, uint32_t& out) {
     if (!biosLoaded) {
         lastError = "Fetch without BIOS loaded";
@@ -74,102 +157,58 @@ static bool fetch32(uint32_t addr, uint32_t& out) {
         halted = true;
         return false;
     }
-    if (addr < BIOS_BASE) {
-        lastError = "Fetch below BIOS base at " + hex32(addr);
-        halted = true;
-        return false;
-    }
-    const uint32_t offset = addr - BIOS_BASE;
-    if (offset + 4 > biosROM.size()) {
-        lastError = "Fetch out of range (ROM size=" + std::to_string(biosROM.size()) + ") at " + hex32(addr);
+    const uint8_t* page = readPages[addr >> PAGE_SHIFT];
+    if (!page) {
+        lastError = "Fetch from unmapped addr " + hex32(addr) + " (ROM size=" + std::to_string(biosROM.size()) + ")";
         halted = true;
         return false;
     }
-    out = (static_cast<uint32_t>(biosROM[offset]) << 24) |
-          (static_cast<uint32_t>(biosROM[offset + 1]) << 16) |
-          (static_cast<uint32_t>(biosROM[offset + 2]) << 8) |
-          (static_cast<uint32_t>(biosROM[offset + 3]));
+    out = readBE<uint32_t>(page + (addr & PAGE_MASK));
     return true;
 }
 
 // -----------------------------
 // Memory access helpers (v0.3)
 // -----------------------------
-static bool load32(uint32_t addr, uint32_t& out) {
-    if (addr % 4 != 0) {
-        lastError = "Misaligned load32 at " + hex32(addr);
+static std::string accessName(const char* kind, size_t bytes) {
+    return kind + std::to_string(bytes * 8);
+}
+
+template <typename T>
+static bool load(uint32_t addr, T& out) {
+    if (addr % sizeof(T) != 0) {
+        lastError = "Misaligned " + accessName("load", sizeof(T)) + " at " + hex32(addr);
         halted = true;
         return false;
     }
 
-    if (inRange(addr, EERAM_BASE, EERAM_SIZE)) {
-        const uint32_t off = addr - EERAM_BASE;
-        out = (static_cast<uint32_t>(eeRAM[off]) << 24) |
-              (static_cast<uint32_t>(eeRAM[off + 1]) << 16) |
-              (static_cast<uint32_t>(eeRAM[off + 2]) << 8) |
-              (static_cast<uint32_t>(eeRAM[off + 3]));
-        return true;
-    }
-    if (inRange(addr, SCRATCH_BASE, SCRATCH_SIZE)) {
-        const uint32_t off = addr - SCRATCH_BASE;
-        out = (static_cast<uint32_t>(scratchpad[off]) << 24) |
-              (static_cast<uint32_t>(scratchpad[off + 1]) << 16) |
-              (static_cast<uint32_t>(scratchpad[off + 2]) << 8) |
-              (static_cast<uint32_t>(scratchpad[off + 3]));
-        return true;
-    }
-    if (inRange(addr, IOPRAM_BASE, IOPRAM_SIZE)) {
-        const uint32_t off = addr - IOPRAM_BASE;
-        out = (static_cast<uint32_t>(iopRAM[off]) << 24) |
-              (static_cast<uint32_t>(iopRAM[off + 1]) << 16) |
-              (static_cast<uint32_t>(iopRAM[off + 2]) << 8) |
-              (static_cast<uint32_t>(iopRAM[off + 3]));
+    const uint8_t* page = readPages[addr >> PAGE_SHIFT];
+    if (page) {
+        out = readBE<T>(page + (addr & PAGE_MASK));
         return true;
     }
 
-    lastError = "load32 unmapped addr " + hex32(addr);
+    lastError = accessName("load", sizeof(T)) + " unmapped addr " + hex32(addr);
     halted = true;
     return false;
 }
 
-static bool store32(uint32_t addr, uint32_t value) {
-    if (addr % 4 != 0) {
-        lastError = "Misaligned store32 at " + hex32(addr);
+template <typename T>
+static bool store(uint32_t addr, T value) {
+    if (addr % sizeof(T) != 0) {
+        lastError = "Misaligned " + accessName("store", sizeof(T)) + " at " + hex32(addr);
         halted = true;
         return false;
     }
 
-    auto b0 = static_cast<uint8_t>(value >> 24);
-    auto b1 = static_cast<uint8_t>(value >> 16);
-    auto b2 = static_cast<uint8_t>(value >> 8);
-    auto b3 = static_cast<uint8_t>(value);
-
-    if (inRange(addr, EERAM_BASE, EERAM_SIZE)) {
-        const uint32_t off = addr - EERAM_BASE;
-        eeRAM[off]     = b0;
-        eeRAM[off + 1] = b1;
-        eeRAM[off + 2] = b2;
-        eeRAM[off + 3] = b3;
-        return true;
-    }
-    if (inRange(addr, SCRATCH_BASE, SCRATCH_SIZE)) {
-        const uint32_t off = addr - SCRATCH_BASE;
-        scratchpad[off]     = b0;
-        scratchpad[off + 1] = b1;
-        scratchpad[off + 2] = b2;
-        scratchpad[off + 3] = b3;
-        return true;
-    }
-    if (inRange(addr, IOPRAM_BASE, IOPRAM_SIZE)) {
-        const uint32_t off = addr - IOPRAM_BASE;
-        iopRAM[off]     = b0;
-        iopRAM[off + 1] = b1;
-        iopRAM[off + 2] = b2;
-        iopRAM[off + 3] = b3;
+    uint8_t* page = writePages[addr >> PAGE_SHIFT];
+    if (page) {
+        const T be = swapBE(value);
+        std::memcpy(page + (addr & PAGE_MASK), &be, sizeof(T));
         return true;
     }
 
-    lastError = "store32 unmapped addr " + hex32(addr);
+    lastError = accessName("store", sizeof(T)) + " unmapped addr " + hex32(addr);
     halted = true;
     return false;
 }
@@ -201,7 +240,13 @@ static std::string decode(uint32_t instr) {
         case 0x0F: return "LUI " + regN(rt) + ", " + hex16(imm);
         case 0x08: return "ADDI " + regN(rt) + ", " + regN(rs) + ", " + hex16(imm);
         case 0x04: return "BEQ " + regN(rs) + ", " + regN(rt) + ", offset=" + hex16(imm);
+        case 0x20: return "LB " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
+        case 0x21: return "LH " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
         case 0x23: return "LW " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
+        case 0x24: return "LBU " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
+        case 0x25: return "LHU " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
+        case 0x28: return "SB " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
+        case 0x29: return "SH " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
         case 0x2B: return "SW " + regN(rt) + ", " + hex16(imm) + "(" + regN(rs) + ")";
         case 0x02: {
             const uint32_t absTarget = ((PC + 4) & 0xF0000000) | (target << 2);
@@ -270,17 +315,61 @@ static bool execute(uint32_t instr) {
             }
             break;
         }
+        case 0x20: { // LB
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            uint8_t val = 0;
+            if (!load(addr, val)) return false;
+            regs[rt] = static_cast<uint32_t>(static_cast<int8_t>(val));
+            PC = nextPC;
+            break;
+        }
+        case 0x21: { // LH
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            uint16_t val = 0;
+            if (!load(addr, val)) return false;
+            regs[rt] = static_cast<uint32_t>(static_cast<int16_t>(val));
+            PC = nextPC;
+            break;
+        }
         case 0x23: { // LW
             const auto addr = static_cast<uint32_t>(regs[rs] + imm);
             uint32_t val = 0;
-            if (!load32(addr, val)) return false;
+            if (!load(addr, val)) return false;
+            regs[rt] = val;
+            PC = nextPC;
+            break;
+        }
+        case 0x24: { // LBU
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            uint8_t val = 0;
+            if (!load(addr, val)) return false;
+            regs[rt] = val;
+            PC = nextPC;
+            break;
+        }
+        case 0x25: { // LHU
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            uint16_t val = 0;
+            if (!load(addr, val)) return false;
             regs[rt] = val;
             PC = nextPC;
             break;
         }
+        case 0x28: { // SB
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            if (!store(addr, static_cast<uint8_t>(regs[rt]))) return false;
+            PC = nextPC;
+            break;
+        }
+        case 0x29: { // SH
+            const auto addr = static_cast<uint32_t>(regs[rs] + imm);
+            if (!store(addr, static_cast<uint16_t>(regs[rt]))) return false;
+            PC = nextPC;
+            break;
+        }
         case 0x2B: { // SW
             const auto addr = static_cast<uint32_t>(regs[rs] + imm);
-            if (!store32(addr, regs[rt])) return false;
+            if (!store(addr, regs[rt])) return false;
             PC = nextPC;
             break;
         }
@@ -316,9 +405,10 @@ void initCore() {
     for (auto &reg : regs) reg = 0;
 
     // Clear EE memory (keep BIOS buffers as-is)
-    std::fill(eeRAM.begin(), eeRAM.end(), 0);
-    std::fill(scratchpad.begin(), scratchpad.end(), 0);
-    std::fill(iopRAM.begin(), iopRAM.end(), 0);
+    releaseGuest(eeRAM);
+    releaseGuest(scratchpad);
+    releaseGuest(iopRAM);
+    mapMemory();
 
     // Core becomes initialized only if ROM is already loaded
     if (!biosROM.empty()) {
@@ -339,6 +429,7 @@ bool loadBiosPart(const char* kind, const uint8_t* data, int length) {
         if (k == "ROM" || k == "BIN") {
             biosROM.assign(data, data + length);
             biosLoaded = !biosROM.empty();
+            mapMemory();
             // If core was previously initialized, keep it initialized
             // Otherwise, leave initCore to set flags properly.
         } else if (k == "ROM1") {
@@ -426,6 +517,10 @@ const char* getDebugState() {
     oss << "Mem: EE=" << eeRAM.size()
         << "  Scratch=" << scratchpad.size()
         << "  IOP=" << iopRAM.size() << "\n";
+    oss << "Resident: EE=" << residentBytes(eeRAM)
+        << "  Scratch=" << residentBytes(scratchpad)
+        << "  IOP=" << residentBytes(iopRAM)
+        << "  Pages=" << residentBytes(readTable) + residentBytes(writeTable) << "\n";
 
     if (halted && !lastError.empty()) {
         oss << "Status: HALTED (" << lastError << ")\n";
@@ -446,6 +541,26 @@ const char* getDebugState() {
     return cstr;
 }
 
+// Reserved and resident bytes of one guest memory region
+bool getMemoryUsage(const char* region, uint64_t* reserved, uint64_t* resident) {
+    if (!region || !reserved || !resident) return false;
+    const std::string r(region);
+    const GuestMemory* regions[2] = {nullptr, nullptr};
+    if (r == "EE")           regions[0] = &eeRAM;
+    else if (r == "Scratch") regions[0] = &scratchpad;
+    else if (r == "IOP")     regions[0] = &iopRAM;
+    else if (r == "Pages")   { regions[0] = &readTable; regions[1] = &writeTable; }
+    else return false;
+
+    *reserved = *resident = 0;
+    for (const GuestMemory* g : regions) {
+        if (!g) continue;
+        *reserved += g->size();
+        *resident += residentBytes(*g);
+    }
+    return true;
+}
+
 // UI readiness: require ROM loaded, core initialized, and not halted
 bool isDebugReady() {
     return biosLoaded && coreInitialized && !halted;
@@ -8,4 +8,8 @@ bool loadBiosPart(const char* kind, const uint8_t* data, int length);
 void step();
 const char* getDebugState();
 bool isDebugReady();
+
+// Reserved and resident bytes of a guest memory region: "EE", "Scratch",
+// "IOP" or "Pages" (the page tables). False for an unknown region.
+bool getMemoryUsage(const char* region, uint64_t* reserved, uint64_t* resident);
 }
\ No newline at end of file
@@ -1,8 +1,7 @@
 // ps2_jni.cpp
 #include <jni.h>
-<<<<<<< HEAD
 #include <cstdint>
-#include "ps2_core.h"
+#include "core/ps2_core.h"
 
 // Optional local GS register stub (replace with gs_stub.cpp calls later)
 namespace {
@@ -21,7 +20,54 @@ extern "C" {
 
 JNIEXPORT jboolean JNICALL
 Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeLoadBiosPart(JNIEnv* env, jobject thiz, jstring part, jbyteArray bytes) {
-    return ps2core_loadBiosPart(env, part, bytes);
+    const char* partStr = env->GetStringUTFChars(part, nullptr);
+    const jsize length = env->GetArrayLength(bytes);
+    jbyte* data = env->GetByteArrayElements(bytes, nullptr);
+
+    const bool ok = ps2core_loadBiosPart(partStr, reinterpret_cast<const uint8_t*>(data),
+                                         data ? static_cast<size_t>(length) : 0);
+
+    if (data) env->ReleaseByteArrayElements(bytes, data, JNI_ABORT);
+    env->ReleaseStringUTFChars(part, partStr);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeLoadBiosFile(JNIEnv* env, jobject thiz, jstring path) {
+    const char* pathStr = env->GetStringUTFChars(path, nullptr);
+    const bool ok = ps2core_loadBiosFile(pathStr);
+    env->ReleaseStringUTFChars(path, pathStr);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeLoadBiosFd(JNIEnv* env, jobject thiz, jint fd) {
+    return ps2core_loadBiosFd(fd) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeStart(JNIEnv* env, jobject thiz) {
+    ps2core_start();
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativePause(JNIEnv* env, jobject thiz) {
+    ps2core_pause();
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeResume(JNIEnv* env, jobject thiz) {
+    ps2core_resume();
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeStop(JNIEnv* env, jobject thiz) {
+    ps2core_stop();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeIsRunning(JNIEnv* env, jobject thiz) {
+    return ps2core_isRunning() ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT void JNICALL
@@ -29,6 +75,31 @@ Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeTick(JNIEnv* env, jobject thiz
     ps2core_tick();
 }
 
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeRunFrame(JNIEnv* env, jobject thiz) {
+    ps2core_runFrame();
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetTurbo(JNIEnv* env, jobject thiz, jboolean enabled) {
+    ps2core_setTurbo(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetVideoMode(JNIEnv* env, jobject thiz, jboolean pal) {
+    ps2core_setVideoMode(pal == JNI_TRUE);
+}
+
+JNIEXPORT jdouble JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeGetFps(JNIEnv* env, jobject thiz) {
+    return ps2core_getFps();
+}
+
+JNIEXPORT jdouble JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeGetSpeedPercent(JNIEnv* env, jobject thiz) {
+    return ps2core_getSpeedPercent();
+}
+
 JNIEXPORT jint JNICALL
 Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeGetPC(JNIEnv* env, jobject thiz) {
     return (jint)ps2core_getPC();
@@ -41,81 +112,73 @@ Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeGetTickCount(JNIEnv* env, jobj
 
 JNIEXPORT jstring JNICALL
 Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeGetDebugState(JNIEnv* env, jobject thiz) {
-    return ps2core_getDebugState(env);
+    return env->NewStringUTF(ps2core_getDebugState().c_str());
 }
 
-// ----------------------------- GS register stub -----------------------------
-
-// Kotlin/Java declaration should be:
-// external fun Native_setGsReg(index: Int, value: Int)
-//
-// JNI symbol mapping:
-// Java_com_maxrblx1_sandboxsx2_NativeEmulator_Native_1setGsReg
 JNIEXPORT void JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_Native_1setGsReg(JNIEnv* env, jobject thiz, jint index, jint value) {
-    // Bounds-check and store in local stub array
-    if (index >= 0 && index < (jint)(sizeof(g_gsRegs) / sizeof(g_gsRegs[0]))) {
-        g_gsRegs[index] = (uint32_t)value;
-    }
-    // If you later add real GS handling:
-    // gs_set_register((uint32_t)index, (uint32_t)value);
-=======
-#include <string>
-#include "ps2_core.h"   // include your core directly (or better: ps2_core.h if you split headers)
-
-// Helper: convert jstring -> std::string
-static std::string jstringToStdString(JNIEnv* env, jstring jStr) {
-    if (!jStr) return "";
-    const char* chars = env->GetStringUTFChars(jStr, nullptr);
-    std::string str(chars);
-    env->ReleaseStringUTFChars(jStr, chars);
-    return str;
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetCacheDir(JNIEnv* env, jobject thiz, jstring dir) {
+    const char* dirStr = env->GetStringUTFChars(dir, nullptr);
+    ps2core_setCacheDir(dirStr);
+    env->ReleaseStringUTFChars(dir, dirStr);
 }
 
-// -----------------------------
-// JNI exports
-// -----------------------------
+JNIEXPORT jboolean JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSaveCaches(JNIEnv* env, jobject thiz) {
+    return ps2core_saveCaches() ? JNI_TRUE : JNI_FALSE;
+}
 
-extern "C" {
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetRunPolicy(JNIEnv* env, jobject thiz, jboolean trace,
+                                                               jboolean cycleAccurate, jboolean breakpoints) {
+    ps2core_setRunPolicy(trace == JNI_TRUE, cycleAccurate == JNI_TRUE, breakpoints == JNI_TRUE);
+}
 
-// void initCore()
 JNIEXPORT void JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_initCore(JNIEnv* env, jobject thiz) {
-    initCore();
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetBreakpoint(JNIEnv* env, jobject thiz, jint pc, jboolean enabled) {
+    ps2core_setBreakpoint(static_cast<uint32_t>(pc), enabled == JNI_TRUE);
 }
 
-// boolean loadBiosPart(String kind, byte[] data)
-JNIEXPORT jboolean JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_loadBiosPart(JNIEnv* env, jobject thiz,
-                                                       jstring kind, jbyteArray data) {
-    std::string k = jstringToStdString(env, kind);
-    jsize len = env->GetArrayLength(data);
-    jbyte* buf = env->GetByteArrayElements(data, nullptr);
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetFpuMode(JNIEnv* env, jobject thiz, jboolean accurate) {
+    ps2core_setFpuMode(accurate == JNI_TRUE);
+}
 
-    bool ok = loadBiosPart(k.c_str(), reinterpret_cast<uint8_t*>(buf), len);
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetBlockFpuMode(JNIEnv* env, jobject thiz, jint pc,
+                                                                  jboolean accurate, jboolean pinned) {
+    ps2core_setBlockFpuMode(static_cast<uint32_t>(pc), accurate == JNI_TRUE, pinned == JNI_TRUE);
+}
 
-    env->ReleaseByteArrayElements(data, buf, JNI_ABORT);
-    return ok ? JNI_TRUE : JNI_FALSE;
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetMtvu(JNIEnv* env, jobject thiz, jboolean threaded) {
+    ps2core_setMtvu(threaded == JNI_TRUE);
 }
 
-// void step()
 JNIEXPORT void JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_step(JNIEnv* env, jobject thiz) {
-    step();
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetGsThread(JNIEnv* env, jobject thiz, jboolean threaded) {
+    ps2core_setGsThread(threaded == JNI_TRUE);
 }
 
-// String getDebugState()
-JNIEXPORT jstring JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_getDebugState(JNIEnv* env, jobject thiz) {
-    const char* state = getDebugState();
-    return env->NewStringUTF(state);
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_nativeSetFastmem(JNIEnv* env, jobject thiz, jboolean enabled) {
+    ps2core_setFastmem(enabled == JNI_TRUE);
 }
 
-// boolean isDebugReady()
-JNIEXPORT jboolean JNICALL
-Java_com_maxrblx1_sandboxsx2_NativeEmulator_isDebugReady(JNIEnv* env, jobject thiz) {
-    return isDebugReady() ? JNI_TRUE : JNI_FALSE;
->>>>>>> 98c30722c5cc4b68755cfb441b2bedf3dede0946
+// ----------------------------- GS register stub -----------------------------
+
+// Kotlin/Java declaration should be:
+// external fun Native_setGsReg(index: Int, value: Int)
+//
+// JNI symbol mapping:
+// Java_com_maxrblx1_sandboxsx2_NativeEmulator_Native_1setGsReg
+JNIEXPORT void JNICALL
+Java_com_maxrblx1_sandboxsx2_NativeEmulator_Native_1setGsReg(JNIEnv* env, jobject thiz, jint index, jint value) {
+    // Bounds-check and store in local stub array
+    if (index >= 0 && index < (jint)(sizeof(g_gsRegs) / sizeof(g_gsRegs[0]))) {
+        g_gsRegs[index] = (uint32_t)value;
+    }
+    // If you later add real GS handling:
+    // gs_set_register((uint32_t)index, (uint32_t)value);
 }
 
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,41 @@
+// BIOS images fit the 4 MB ROM window or are refused, from a file or a buffer
+#include "check.h"
+#include "bios_image.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// A file of `size` zero bytes, opened through both entry points
+static bool opens(const std::string& path, size_t size) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) return false;
+    BiosImage* byPath = biosImageOpen(path.c_str());
+    BiosImage* byFd = biosImageOpenFd(fd);
+    close(fd);
+    const bool ok = byPath && byFd && byPath->size == size && byFd->size == size;
+    if (!byPath != !byFd) return false;
+    biosImageFree(byPath);
+    biosImageFree(byFd);
+    unlink(path.c_str());
+    return ok;
+}
+
+int main() {
+    char dir[] = "/tmp/bios_image.XXXXXX";
+    CHECK(mkdtemp(dir));
+    const std::string path = std::string(dir) + "/rom.bin";
+    CHECK(opens(path, BIOS_MAX_SIZE));
+    CHECK(!opens(path, BIOS_MAX_SIZE + 1));
+    CHECK(!opens(path, 0));
+
+    const std::vector<uint8_t> bytes(BIOS_MAX_SIZE + 1, 0);
+    BiosImage* img = biosImageCopy(bytes.data(), BIOS_MAX_SIZE);
+    CHECK(img && img->size == BIOS_MAX_SIZE);
+    biosImageFree(img);
+    CHECK(!biosImageCopy(bytes.data(), bytes.size()));
+
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdio>
+
+// Host checks: each test is a program that returns non-zero on the first
+// failed CHECK
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                 \
+        }                                                                             \
+    } while (0)
@@ -0,0 +1,75 @@
+// Cached EE blocks are dropped when the RAM they were decoded from changes,
+// whichever view of it (kuseg, KSEG0/KSEG1, a TLB mapping, DMA) wrote it
+#include "check.h"
+#include "mem_map.h"
+#include "ee_block.h"
+#include "ee_tlb.h"
+#include <cstring>
+
+static constexpr uint32_t JR_RA = 0x03E00008;
+
+// ADDIU r1, r0, value; JR ra; NOP
+static void putProgram(Mem& mem, uint32_t addr, uint16_t value) {
+    memWrite32(mem, addr, 0x24010000u | value);
+    memWrite32(mem, addr + 4, JR_RA);
+    memWrite32(mem, addr + 8, 0);
+}
+
+static uint32_t runAt(EERegs& ee, Mem& mem, EEBlockCache& cache, uint32_t pc) {
+    ee.pc = pc;
+    uint32_t executed = 0;
+    eeRunBlock(ee, mem, cache, executed);
+    return ee.GPR[1].UL[0];
+}
+
+// Map the 4 KB page at vaddr to paddr through TLB entry 0 (global, even half)
+static void tlbMapPage(EERegs& ee, Mem& mem, uint32_t vaddr, uint32_t paddr) {
+    ee.cop0[COP0_PAGEMASK] = 0;
+    ee.cop0[COP0_ENTRYHI]  = vaddr;
+    ee.cop0[COP0_ENTRYLO0] = (paddr >> 12) << 6 | EE_TLB_V | EE_TLB_D | EE_TLB_G;
+    ee.cop0[COP0_ENTRYLO1] = EE_TLB_G;
+    eeTlbWrite(ee, mem, 0);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    EERegs ee;
+    eeInit(ee, 0);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+
+    // Code run through KSEG0 and rewritten through every other view
+    putProgram(mem, 0x1000, 5);
+    CHECK(runAt(ee, mem, cache, 0x80001000) == 5);
+    memWrite32(mem, 0x80001000, 0x24010007);
+    CHECK(runAt(ee, mem, cache, 0x80001000) == 7);
+    memWrite32(mem, 0x00001000, 0x24010009);
+    CHECK(runAt(ee, mem, cache, 0x80001000) == 9);
+    memWrite32(mem, 0xA0001000, 0x2401000B);
+    CHECK(runAt(ee, mem, cache, 0x80001000) == 11);
+    const uint32_t dmaWord = 0x2401000D;
+    std::memcpy(mem.ram.data() + 0x1000, &dmaWord, 4);
+    memRamWritten(mem, 0x1000, 16);
+    CHECK(runAt(ee, mem, cache, 0x80001000) == 13);
+
+    // Code run through a TLB alias above the end of RAM
+    putProgram(mem, 0x3000, 21);
+    putProgram(mem, 0x4000, 31);
+    tlbMapPage(ee, mem, 0x40000000, 0x3000);
+    CHECK(runAt(ee, mem, cache, 0x40000000) == 21);
+    memWrite32(mem, 0x40000000, 0x24010017);
+    CHECK(runAt(ee, mem, cache, 0x40000000) == 23);
+    memWrite32(mem, 0x80003000, 0x24010019);
+    CHECK(runAt(ee, mem, cache, 0x40000000) == 25);
+    std::memcpy(mem.ram.data() + 0x3000, &dmaWord, 4);
+    memRamWritten(mem, 0x3000, 16);
+    CHECK(runAt(ee, mem, cache, 0x40000000) == 13);
+
+    // Pointing the alias at another page drops what it ran before
+    tlbMapPage(ee, mem, 0x40000000, 0x4000);
+    CHECK(runAt(ee, mem, cache, 0x40000000) == 31);
+
+    memShutdown(mem);
+    return 0;
+}
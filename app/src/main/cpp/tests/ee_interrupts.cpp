@@ -0,0 +1,79 @@
+// INT0 (INTC) and INT1 (DMAC) reach COP0 Cause and enter the handler at
+// vector 0x200 only when Status lets them through; BC0T/BC0F see the
+// channels D_PCR selects finish
+#include "check.h"
+#include "mem_map.h"
+#include "scheduler.h"
+#include "dma_stub.h"
+#include "ee_cpu.h"
+
+static constexpr uint32_t ENABLED = STATUS_IE | STATUS_EIE | STATUS_IM2 | STATUS_IM3;
+
+static void resume(EERegs& ee, uint32_t pc) {
+    ee.cop0[COP0_STATUS] = ENABLED;
+    ee.pc = pc;
+    ee.nextPc = pc + 4;
+}
+
+int main() {
+    EERegs ee;
+    eeInit(ee, 0x80001000);
+
+    // Lines are latched even while masked
+    ee.cop0[COP0_STATUS] = STATUS_IE | STATUS_EIE;
+    CHECK(!eeCheckInterrupts(ee, true, true));
+    CHECK((ee.cop0[COP0_CAUSE] & (CAUSE_IP2 | CAUSE_IP3)) == (CAUSE_IP2 | CAUSE_IP3));
+    CHECK(ee.pc == 0x80001000);
+    ee.cop0[COP0_STATUS] = STATUS_IE | STATUS_IM2;      // DI
+    CHECK(!eeCheckInterrupts(ee, true, false));
+
+    // INT0 taken: EPC, EXL, ExcCode 0, vector 0x200
+    resume(ee, 0x80001000);
+    CHECK(eeCheckInterrupts(ee, true, false));
+    CHECK(ee.pc == 0x80000200 && ee.cop0[COP0_EPC] == 0x80001000);
+    CHECK((ee.cop0[COP0_STATUS] & STATUS_EXL) && (ee.cop0[COP0_CAUSE] & 0x7C) == 0);
+    CHECK(!eeCheckInterrupts(ee, true, false));         // EXL holds it off
+
+    // Not between a branch and its delay slot
+    resume(ee, 0x80001000);
+    ee.branchTaken = true;
+    CHECK(!eeCheckInterrupts(ee, true, false));
+    ee.branchTaken = false;
+    CHECK(eeCheckInterrupts(ee, true, false));
+
+    // INT1 from a finished DMA channel once its D_STAT mask bit is set
+    static Mem mem;
+    CHECK(memInit(mem));
+    Scheduler sched;
+    schedInit(sched);
+    DMAC dmac;
+    dmaInit(dmac, mem, sched);
+    dmaMapMmio(dmac, mem);
+    memWrite32(mem, 0x1000E000, 1);                     // D_CTRL DMAE
+    memWrite32(mem, 0x1000D410, 0x1000);                // toSPR MADR
+    memWrite32(mem, 0x1000D420, 1);                     // QWC
+    memWrite32(mem, 0x1000D400, 0x100);                 // CHCR STR
+    schedAdvance(sched, 100000);
+    resume(ee, 0x80001000);
+    CHECK(!eeCheckInterrupts(ee, false, dmaInterrupt(dmac)));
+    memWrite32(mem, 0x1000E010, 1u << (16 + DMA_TO_SPR)); // CIM9
+    CHECK(eeCheckInterrupts(ee, false, dmaInterrupt(dmac)));
+    CHECK(ee.cop0[COP0_CAUSE] & CAUSE_IP3);
+
+    // CPCOND0: true with no channel selected, then follows toSPR's D_STAT bit
+    static constexpr uint32_t BC0T = 0x41010003;        // bc0t +3
+    static constexpr uint32_t TAKEN = 0x80001010, NOT_TAKEN = 0x80001008;
+    ee.dmac = &dmac;
+    memWrite32(mem, 0x1000E010, 1u << DMA_TO_SPR);      // clear CIS9
+    resume(ee, 0x80001000);
+    CHECK(eeStep(ee, mem, BC0T) == ExecResult::Ok && ee.pc == TAKEN);
+    memWrite32(mem, 0x1000E020, 1u << DMA_TO_SPR);      // D_PCR CPC9
+    resume(ee, 0x80001000);
+    CHECK(eeStep(ee, mem, BC0T) == ExecResult::Ok && ee.pc == NOT_TAKEN);
+    memWrite32(mem, 0x1000D420, 1);                     // run toSPR again
+    memWrite32(mem, 0x1000D400, 0x100);
+    schedAdvance(sched, 100000);
+    resume(ee, 0x80001000);
+    CHECK(eeStep(ee, mem, BC0T) == ExecResult::Ok && ee.pc == TAKEN);
+    return 0;
+}
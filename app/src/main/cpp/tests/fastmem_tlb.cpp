@@ -0,0 +1,77 @@
+// The fastmem window follows TLB remaps: translated RAM stays readable
+// through it, and dropping the entry gives back the untranslated view
+#include "check.h"
+#include "mem_map.h"
+#include "ee_tlb.h"
+#include <cstring>
+
+static uint32_t windowRead32(const Mem& mem, uint32_t addr) {
+    uint32_t v;
+    std::memcpy(&v, mem.fastmem + addr, 4);
+    return v;
+}
+
+// Map the 4 KB pages at vaddr (even) and vaddr + 4 KB (odd) to paddr and
+// paddr + 4 KB through TLB entry 0, global
+static void tlbMapPair(EERegs& ee, Mem& mem, uint32_t vaddr, uint32_t paddr, bool valid) {
+    const uint32_t v = valid ? EE_TLB_V | EE_TLB_D : 0;
+    ee.cop0[COP0_PAGEMASK] = 0;
+    ee.cop0[COP0_ENTRYHI]  = vaddr;
+    ee.cop0[COP0_ENTRYLO0] = (paddr >> 12) << 6 | v | EE_TLB_G;
+    ee.cop0[COP0_ENTRYLO1] = ((paddr + 0x1000) >> 12) << 6 | v | EE_TLB_G;
+    eeTlbWrite(ee, mem, 0);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    if (!memFastmemEnable(mem)) {
+        std::printf("fastmem unavailable on this host, skipped\n");
+        memShutdown(mem);
+        return 0;
+    }
+    EERegs ee;
+    eeInit(ee, 0);
+
+    memWrite32(mem, 0x00100000, 0x11111111);
+    memWrite32(mem, 0x00101000, 0x22222222);
+    memWrite32(mem, 0x00180000, 0x33333333);
+    memWrite32(mem, 0x00181000, 0x44444444);
+    memWrite32(mem, 0x70000000, 0x55555555);
+
+    // Identity mapping: the window still shows RAM there and around it
+    tlbMapPair(ee, mem, 0x00100000, 0x00100000, true);
+    CHECK(windowRead32(mem, 0x00100000) == 0x11111111);
+    CHECK(windowRead32(mem, 0x00101000) == 0x22222222);
+    CHECK(windowRead32(mem, 0x00180000) == 0x33333333);
+
+    // A remap shows the new target, in kuseg and above the end of RAM
+    tlbMapPair(ee, mem, 0x00100000, 0x00180000, true);
+    CHECK(windowRead32(mem, 0x00100000) == 0x33333333);
+    CHECK(windowRead32(mem, 0x00101000) == 0x44444444);
+    tlbMapPair(ee, mem, 0x40000000, 0x00100000, true);
+    CHECK(windowRead32(mem, 0x40000000) == 0x11111111);
+    CHECK(windowRead32(mem, 0x00100000) == 0x11111111); // entry 0 moved on
+
+    // Stores through the page tables land in the viewed RAM
+    memWrite32(mem, 0x40001000, 0x66666666);
+    CHECK(windowRead32(mem, 0x40001000) == 0x66666666);
+    CHECK(windowRead32(mem, 0x80101000) == 0x66666666);
+
+    // Invalid halves unmap; a later entry there restores the view
+    tlbMapPair(ee, mem, 0x00100000, 0x00100000, false);
+    CHECK(memHostPtr(mem, 0x00100000) == nullptr);
+    tlbMapPair(ee, mem, 0x70000000 - 0x2000, 0x00180000, true);
+    CHECK(windowRead32(mem, 0x00100000) == 0x11111111);
+    CHECK(windowRead32(mem, 0x70000000) == 0x55555555);
+
+    // Enabling fastmem with entries already written shows them too
+    tlbMapPair(ee, mem, 0x40000000, 0x00180000, true);
+    memFastmemDisable(mem);
+    CHECK(memFastmemEnable(mem));
+    CHECK(windowRead32(mem, 0x40000000) == 0x33333333);
+    CHECK(windowRead32(mem, 0x00100000) == 0x11111111);
+
+    memShutdown(mem);
+    return 0;
+}
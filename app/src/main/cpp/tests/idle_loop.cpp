@@ -0,0 +1,62 @@
+// Idle loops are only fast-forwarded while what they poll can't change
+// without a scheduler event: memory and event-driven registers, not a
+// status register another thread moves
+#include "check.h"
+#include "mem_map.h"
+#include "ee_block.h"
+
+static constexpr uint32_t LOOP = 0x80002000;
+
+// lui t1, hi(addr); lw t0, lo(addr)(t1); beq t0, zero, LOOP; nop
+static void putPollLoop(Mem& mem, uint32_t addr) {
+    const uint32_t hi = (addr + 0x8000) >> 16, lo = addr & 0xFFFF;
+    memWrite32(mem, LOOP + 0x0, 0x3C090000u | hi);
+    memWrite32(mem, LOOP + 0x4, 0x8D280000u | lo);
+    memWrite32(mem, LOOP + 0x8, 0x1100FFFDu);
+    memWrite32(mem, LOOP + 0xC, 0);
+}
+
+static ExecResult spinOnce(EERegs& ee, Mem& mem, EEBlockCache& cache) {
+    ee.pc = LOOP;
+    uint32_t executed = 0;
+    return eeRunBlock(ee, mem, cache, executed);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    EERegs ee;
+    eeInit(ee, LOOP);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+
+    uint32_t intcStat = 0, vifStat = 0;
+    memMapMmio(mem, 0x1000F000, 16, memMmioReg(&intcStat));
+    memMmioEventDriven(mem, 0x1000F000, 16);
+    memMapMmio(mem, 0x10003C00, 16, memMmioReg(&vifStat));
+
+    // RAM
+    putPollLoop(mem, 0x80010000);
+    CHECK(spinOnce(ee, mem, cache) == ExecResult::Idle);
+    CHECK(cache.idleLoops == 1);
+
+    // An event-driven register, through KSEG1
+    putPollLoop(mem, 0xB000F000);
+    CHECK(spinOnce(ee, mem, cache) == ExecResult::Idle);
+
+    // A register that moves on its own (VIF1_STAT while VU1 runs)
+    putPollLoop(mem, 0xB0003C00);
+    CHECK(spinOnce(ee, mem, cache) == ExecResult::Ok);
+    CHECK(ee.pc == LOOP);
+
+    // Unmapped: the fallback hooks may answer anything
+    putPollLoop(mem, 0x40000000);
+    CHECK(spinOnce(ee, mem, cache) == ExecResult::Ok);
+
+    // A base register rewritten after the load isn't the address it used
+    memWrite32(mem, LOOP + 0xC, 0x3C090000u); // lui t1, 0 in the delay slot
+    CHECK(spinOnce(ee, mem, cache) == ExecResult::Ok);
+
+    memShutdown(mem);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// The IPU is reachable the way ps2_core wires it: registers and FIFOs on the
+// EE bus, and DMA channels 3 (fromIPU) and 4 (toIPU)
+#include "check.h"
+#include "mem_map.h"
+#include "scheduler.h"
+#include "dma_stub.h"
+#include "ipu.h"
+
+static constexpr uint32_t WHITE_RGB32 = 0x80FFFFFF;
+
+static void startNormal(Mem& mem, uint32_t chcrAddr, uint32_t madr, uint32_t qwc, bool fromMemory) {
+    memWrite32(mem, chcrAddr + 0x10, madr);
+    memWrite32(mem, chcrAddr + 0x20, qwc);
+    memWrite32(mem, chcrAddr, fromMemory ? 0x101 : 0x100);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    Scheduler sched;
+    schedInit(sched);
+    DMAC dmac;
+    dmaInit(dmac, mem, sched);
+    dmaMapMmio(dmac, mem);
+    IPU ipu;
+    ipuMapMmio(ipu, mem);
+    ipuInit(ipu);
+    dmaAttach(dmac, DMA_FROM_IPU, dmaIpuOutPort(ipu));
+    dmaAttach(dmac, DMA_TO_IPU, dmaIpuInPort(ipu));
+    memWrite32(mem, 0x1000E000, 1);      // D_CTRL DMAE
+
+    // Input FIFO store, then IPU_TOP/IPU_BP see the bits
+    memWrite128(mem, 0x10007010, MemQword{0x0000000078563412ull, 0});
+    CHECK(memRead32(mem, 0x10002030) == 0x12345678);
+    CHECK(memRead32(mem, 0x10002020) == 0x100);
+    memWrite32(mem, 0x10002010, IPU_CTRL_RST);
+    CHECK(memRead32(mem, 0x10002020) == 0);
+
+    // CSC of one white macroblock: input over channel 4, output over the
+    // FIFO and channel 3
+    for (uint32_t i = 0; i < 256; ++i) memWrite8(mem, 0x2000 + i, 235);
+    for (uint32_t i = 256; i < 384; ++i) memWrite8(mem, 0x2000 + i, 128);
+    memWrite32(mem, 0x10002000, uint32_t(IPU_CSC) << 28 | 1);
+    CHECK(memRead64(mem, 0x10002000) >> 63);
+    startNormal(mem, 0x1000B400, 0x2000, 24, true);
+    schedAdvance(sched, 100000);
+    CHECK(!(memRead64(mem, 0x10002000) >> 63));
+    CHECK(((memRead32(mem, 0x10002010) >> 4) & 0xF) == 8);
+
+    const MemQword first = memRead128(mem, 0x10007000);
+    CHECK(first.lo == (uint64_t(WHITE_RGB32) << 32 | WHITE_RGB32) && first.hi == first.lo);
+    startNormal(mem, 0x1000B000, 0x4000, 63, false);
+    schedAdvance(sched, 100000);
+    CHECK(!(dmac.channels[DMA_FROM_IPU].chcr & 0x100));
+    CHECK(memRead32(mem, 0x4000) == WHITE_RGB32 && memRead32(mem, 0x4000 + 63 * 16 - 4) == WHITE_RGB32);
+    CHECK(((memRead32(mem, 0x10002010) >> 4) & 0xF) == 0);
+    return 0;
+}
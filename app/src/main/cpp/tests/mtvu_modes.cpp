@@ -0,0 +1,102 @@
+// The same VIF1 uploads and microprogram kicks leave VU1 in the same state
+// whether the MTVU worker runs them or they run inline on the EE thread
+#include "check.h"
+#include "mtvu.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t LOWER_NOP = 0x8000033C;
+static constexpr uint32_t UPPER_NOP = 0x000002FF;
+static constexpr uint32_t UPPER_E   = 1u << 30;
+static constexpr uint32_t XTOP_VI1  = 0x800106BC;
+static constexpr uint32_t DEST_XYZW = 0xFu << 21;
+
+static uint32_t lq(uint32_t ft, uint32_t is, int32_t imm) { return 0x00u << 25 | DEST_XYZW | ft << 16 | is << 11 | (imm & 0x7FF); }
+static uint32_t sq(uint32_t fs, uint32_t it, int32_t imm) { return 0x01u << 25 | DEST_XYZW | it << 16 | fs << 11 | (imm & 0x7FF); }
+static uint32_t upper(uint32_t op, uint32_t fd, uint32_t fs, uint32_t ft) { return DEST_XYZW | ft << 16 | fs << 11 | fd << 6 | op; }
+
+// vi1 = TOP; four times: load TOP+i and TOP+8+i, combine with `op`
+// (ADD 0x28, MUL 0x2A), store at TOP+16+i. Pairs are lower, upper.
+static std::vector<uint32_t> program(uint32_t op) {
+    std::vector<uint32_t> p = {XTOP_VI1, UPPER_NOP};
+    for (int32_t i = 0; i < 4; ++i) {
+        const uint32_t body[8] = {
+            lq(1, 1, i), UPPER_NOP,
+            lq(2, 1, 8 + i), UPPER_NOP,
+            LOWER_NOP, upper(op, 3, 1, 2),
+            sq(3, 1, 16 + i), UPPER_NOP,
+        };
+        p.insert(p.end(), body, body + 8);
+    }
+    const uint32_t tail[4] = {LOWER_NOP, UPPER_NOP | UPPER_E, LOWER_NOP, UPPER_NOP};
+    p.insert(p.end(), tail, tail + 4);
+    return p;
+}
+
+static void kick(MTVU& m) {
+    mtvuKick(m, 0);
+    while (!m.threaded && mtvuBusy(m)) mtvuRun(m, 64);
+}
+
+int main() {
+    static VU vuT, vuI;
+    vuInit(vuT, 1);
+    vuInit(vuI, 1);
+    static MTVU threaded, inlined;
+    mtvuInit(threaded, vuT, nullptr);
+    mtvuInit(inlined, vuI, nullptr);
+    mtvuSetThreaded(threaded, true);
+    CHECK(threaded.threaded && !inlined.threaded);
+
+    const std::vector<uint32_t> progs[2] = {program(0x28), program(0x2A)};
+    const uint32_t qwords = static_cast<uint32_t>(vuT.data.size());
+    std::mt19937 rng(7);
+    std::vector<VUVec> buf(qwords);
+
+    // Small integers as floats, so every result is an ordinary number
+    auto fill = [&](uint32_t n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            for (float& f : buf[i].F) f = static_cast<float>(static_cast<int32_t>(rng() % 2001) - 1000);
+        }
+    };
+
+    uint32_t lastTop = 0;
+    for (uint32_t round = 0; round < 2000; ++round) {
+        if (round % 16 == 0) {
+            const std::vector<uint32_t>& p = progs[(round / 16) & 1];
+            for (MTVU* m : {&threaded, &inlined}) mtvuWriteMicro(*m, 0, p.data(), static_cast<uint32_t>(p.size()));
+        }
+        // Anything from a few quadwords to all of data memory
+        const uint32_t n = round % 100 == 0 ? qwords : 1 + rng() % 64;
+        const uint32_t at = rng() % (qwords - n + 1);
+        fill(n);
+        const uint32_t top = rng() % (qwords - 24), itop = rng() % qwords;
+        lastTop = top;
+        for (MTVU* m : {&threaded, &inlined}) {
+            mtvuWriteData(*m, at, buf.data(), n);
+            mtvuSetTops(*m, top, itop);
+            kick(*m);
+        }
+        if (rng() % 64 == 0) mtvuSync(threaded);
+    }
+    mtvuSync(threaded);
+
+    CHECK(!mtvuBusy(threaded) && !mtvuBusy(inlined));
+    CHECK(std::memcmp(vuT.data.data(), vuI.data.data(), size_t(qwords) * sizeof(VUVec)) == 0);
+    CHECK(std::memcmp(vuT.micro.data(), vuI.micro.data(), vuT.micro.size() * sizeof(vuT.micro[0])) == 0);
+    CHECK(std::memcmp(vuT.VF, vuI.VF, sizeof(vuT.VF)) == 0);
+    CHECK(vuT.VI[1] == vuI.VI[1] && vuT.top == vuI.top && vuT.itop == vuI.itop);
+    CHECK(mtvuStats(threaded).kicks == mtvuStats(inlined).kicks);
+
+    // The last kick ran the ADD program
+    for (uint32_t i = 0; i < 4; ++i) {
+        for (uint32_t k = 0; k < 4; ++k) {
+            CHECK(vuI.data[lastTop + 16 + i].F[k] == vuI.data[lastTop + i].F[k] + vuI.data[lastTop + 8 + i].F[k]);
+        }
+    }
+
+    mtvuShutdown(threaded);
+    mtvuShutdown(inlined);
+    return 0;
+}
@@ -0,0 +1,118 @@
+// The SPSC ring under load: transfers larger than the ring, entries padded
+// past the ring end, and drains racing the worker, first on a small ring
+// whose consumer checks every word, then through the GIF FIFO
+#include "check.h"
+#include "spsc_ring.h"
+#include "gif_fifo.h"
+#include "gs_stub.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t RING = 256;          // quadwords
+static constexpr uint32_t MAX_ENTRY = RING / 4; // payload quadwords per entry, like GIF_MAX_PACKET
+
+static inline uint32_t pattern(uint32_t seq, uint32_t i) { return seq * 0x9E3779B1u + i; }
+
+// Entries are a header quadword (payload quadwords, 0 = skip; sequence
+// number), then the payload
+struct Stream {
+    SPSCRing ring;
+    uint32_t seq = 0;        // next entry expected, worker side
+    uint64_t qwords = 0;
+    uint32_t skips = 0;
+    bool     bad = false;
+};
+
+static uint32_t streamConsume(void* user, uint32_t pos) {
+    Stream& s = *static_cast<Stream*>(user);
+    const uint32_t* hdr = spscSlot(s.ring, pos);
+    if (!hdr[0]) {
+        ++s.skips;
+        return spscRoomToEnd(s.ring, pos);
+    }
+    const uint32_t qwc = hdr[0];
+    if (hdr[1] != s.seq || qwc > spscRoomToEnd(s.ring, pos + 1)) s.bad = true;
+    const uint32_t* w = spscSlot(s.ring, pos + 1);
+    for (uint32_t i = 0; i < qwc * 4; ++i) {
+        if (w[i] != pattern(hdr[1], i)) s.bad = true;
+    }
+    ++s.seq;
+    s.qwords += qwc;
+    return 1 + qwc;
+}
+
+// One transfer of qwc quadwords, split into entries like gifFifoPush
+static void streamPush(Stream& s, uint32_t& seq, uint32_t qwc) {
+    while (qwc) {
+        const uint32_t n = std::min(qwc, MAX_ENTRY);
+        uint64_t ns = 0;
+        const uint32_t h = spscReserveEntry(s.ring, 1 + n, ns);
+        uint32_t* hdr = spscSlot(s.ring, h);
+        hdr[0] = n;
+        hdr[1] = seq;
+        hdr[2] = hdr[3] = 0;
+        uint32_t* w = spscSlot(s.ring, h + 1);
+        for (uint32_t i = 0; i < n * 4; ++i) w[i] = pattern(seq, i);
+        spscCommit(s.ring, h + 1 + n);
+        ++seq;
+        qwc -= n;
+    }
+}
+
+int main() {
+    std::mt19937 rng(1);
+
+    {
+        static Stream s;
+        spscInit(s.ring, RING, streamConsume, &s);
+        spscStartWorker(s.ring);
+        uint32_t seq = 0;
+        uint64_t total = 0;
+        for (uint32_t it = 0; it < 20000; ++it) {
+            // Mostly short, with transfers of several rings' worth
+            const uint32_t qwc = it % 50 == 0 ? 4 * RING + rng() % RING : 1 + rng() % (MAX_ENTRY + 8);
+            streamPush(s, seq, qwc);
+            total += qwc;
+            if (rng() % 8 == 0) {
+                spscDrain(s.ring);
+                CHECK(!spscBusy(s.ring));
+                CHECK(s.seq == seq && s.qwords == total);
+            }
+        }
+        spscDrain(s.ring);
+        CHECK(s.seq == seq && s.qwords == total);
+        CHECK(!s.bad);
+        CHECK(s.skips > 0);
+        spscStopWorker(s.ring);
+    }
+
+    // The same through the GIF FIFO, with transfers past its 1 MB ring
+    {
+        static GS gs;
+        static GIFFifo f;
+        gifFifoInit(f, gs);
+        gifFifoSetThreaded(f, true);
+        const uint32_t capacity = gifFifoStats(f).capacity;
+        std::vector<uint32_t> buf(size_t(capacity + 4096) * 4, 0);
+        uint64_t total = 0, packets = 0;
+        for (uint32_t it = 0; it < 4000; ++it) {
+            const uint32_t qwc = it % 500 == 0 ? capacity + 1 + rng() % 4096 : 1 + rng() % 5000;
+            gifFifoPush(f, buf.data(), qwc);
+            total += qwc;
+            ++packets;
+            if (rng() % 16 == 0) {
+                gifFifoSync(f);
+                CHECK(!gifFifoBusy(f));
+                CHECK(gifFifoStats(f).occupancy == 0);
+            }
+        }
+        gifFifoSync(f);
+        const GIFFifoStats st = gifFifoStats(f);
+        CHECK(st.packets == packets && st.qwords == total);
+        CHECK(st.occupancy == 0);
+        CHECK(st.maxOccupancy <= st.capacity);
+        gifFifoShutdown(f);
+    }
+    return 0;
+}
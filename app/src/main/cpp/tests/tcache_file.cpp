@@ -0,0 +1,111 @@
+// A translation cache file comes back as saved, and is rejected for another
+// image, another build or a damaged payload
+#include "check.h"
+#include "mem_map.h"
+#include "ee_tcache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+static constexpr uint32_t BASE = 0x80001000, SIZE = 0x1000;
+static constexpr uint32_t BLOCK_A = BASE, BLOCK_B = BASE + 0x100;
+static constexpr uint64_t IMAGE = 0x0123456789ABCDEFull, HOT = 32;
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    if (FILE* f = std::fopen(path.c_str(), "rb")) {
+        uint8_t buf[4096];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) bytes.insert(bytes.end(), buf, buf + n);
+        std::fclose(f);
+    }
+    return bytes;
+}
+
+static bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+static uint32_t loadInto(const std::string& path, Mem& mem, uint64_t image) {
+    EEBlockCache c;
+    eeBlockCacheInit(c);
+    return eeTcacheLoad(path, c, mem, image, BASE, SIZE, HOT);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    EERegs ee;
+    eeInit(ee, BLOCK_A);
+
+    // addiu t0, t0, 1 x3; jr ra; nop -- and a second block of the same
+    for (uint32_t pc : {BLOCK_A, BLOCK_B}) {
+        for (uint32_t i = 0; i < 3; ++i) memWrite32(mem, pc + i * 4, 0x25080001u);
+        memWrite32(mem, pc + 12, 0x03E00008u);
+        memWrite32(mem, pc + 16, 0);
+    }
+    EEBlockCache saved;
+    eeBlockCacheInit(saved);
+    ee.pc = BLOCK_A;
+    EEBlock* a = eeBlockLookup(saved, ee, mem);
+    ee.pc = BLOCK_B;
+    CHECK(a && eeBlockLookup(saved, ee, mem));
+    a->hits = HOT;
+
+    char dir[] = "/tmp/tcache_file.XXXXXX";
+    CHECK(mkdtemp(dir));
+    const std::string path = eeTcachePath(dir, IMAGE, BASE);
+    CHECK(eeTcacheSave(path, saved, IMAGE, BASE, SIZE, HOT));
+
+    // Round trip: same blocks, same ops, the hot one primed
+    {
+        EEBlockCache c;
+        eeBlockCacheInit(c);
+        CHECK(eeTcacheLoad(path, c, mem, IMAGE, BASE, SIZE, HOT) == 2);
+        const EEBlock& la = c.blocks.at(BLOCK_A);
+        const EEBlock& lb = c.blocks.at(BLOCK_B);
+        CHECK(la.endPc == a->endPc && la.branchIdx == a->branchIdx && la.ops.size() == a->ops.size());
+        CHECK(std::memcmp(&la.ops[0].d, &a->ops[0].d, sizeof(DecodedOp)) == 0);
+        CHECK(la.hits == HOT && lb.hits == 0);
+    }
+
+    // Another image, or the same image mapped elsewhere
+    CHECK(loadInto(path, mem, IMAGE ^ 1) == 0);
+    {
+        EEBlockCache c;
+        eeBlockCacheInit(c);
+        CHECK(eeTcacheLoad(path, c, mem, IMAGE, BASE + SIZE, SIZE, HOT) == 0);
+    }
+
+    // Another build: the id is stored right after magic and format
+    const std::vector<uint8_t> good = readFile(path);
+    const uint64_t id = eeTcacheBuildId();
+    CHECK(good.size() > 16 && std::memcmp(good.data() + 8, &id, 8) == 0);
+    std::vector<uint8_t> bad = good;
+    bad[8] ^= 1;
+    CHECK(writeFile(path, bad));
+    CHECK(loadInto(path, mem, IMAGE) == 0);
+
+    // A damaged payload, and a truncated one
+    bad = good;
+    bad.back() ^= 0x80;
+    CHECK(writeFile(path, bad));
+    CHECK(loadInto(path, mem, IMAGE) == 0);
+    bad = good;
+    bad.pop_back();
+    CHECK(writeFile(path, bad));
+    CHECK(loadInto(path, mem, IMAGE) == 0);
+
+    // Put back, it loads again
+    CHECK(writeFile(path, good));
+    CHECK(loadInto(path, mem, IMAGE) == 2);
+
+    std::remove(path.c_str());
+    rmdir(dir);
+    memShutdown(mem);
+    return 0;
+}
@@ -0,0 +1,34 @@
+// A timer clocked by HBLANK counts the lines of the CRTC's video mode
+#include "check.h"
+#include "mem_map.h"
+#include "scheduler.h"
+#include "timers.h"
+#include "gs_crtc.h"
+
+static constexpr uint32_t T0_COUNT = 0x10000000, T0_MODE = 0x10000010;
+static constexpr uint32_t CLKS_HBLANK = 3, CUE = 1u << 7;
+
+static uint32_t linesAfter(Mem& mem, Scheduler& sched, Timers& tm, GSVideoMode mode, uint32_t cycles) {
+    timersInit(tm, sched, mem.intc_stat, gsCrtcLineCycles(mode));
+    memWrite32(mem, T0_MODE, CLKS_HBLANK | CUE);
+    memWrite32(mem, T0_COUNT, 0);
+    schedAdvance(sched, cycles);
+    return memRead32(mem, T0_COUNT);
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    Scheduler sched;
+    schedInit(sched);
+    static Timers tm;
+    timersInit(tm, sched, mem.intc_stat, gsCrtcLineCycles(GSVideoMode::NTSC));
+    timersMapMmio(tm, mem);
+
+    // One field: 262.5 NTSC lines, 312.5 PAL lines
+    const uint32_t ntsc = linesAfter(mem, sched, tm, GSVideoMode::NTSC, gsCrtcFieldCycles(GSVideoMode::NTSC));
+    const uint32_t pal  = linesAfter(mem, sched, tm, GSVideoMode::PAL, gsCrtcFieldCycles(GSVideoMode::PAL));
+    CHECK(ntsc >= 262 && ntsc <= 263);
+    CHECK(pal >= 312 && pal <= 313);
+    return 0;
+}
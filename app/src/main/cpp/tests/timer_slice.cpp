@@ -0,0 +1,81 @@
+// Timer COUNT read by the EE mid-slice reflects the instructions retired so
+// far in it, interpreted, compiled and through a hooked run loop
+#include "check.h"
+#include "mem_map.h"
+#include "scheduler.h"
+#include "timers.h"
+#include "ee_jit.h"
+#include "ee_run.h"
+
+static constexpr uint32_t PROG = 0x80010000;
+static constexpr uint32_t T0_COUNT = 0x10000000, T0_MODE = 0x10000010;
+static constexpr uint32_t CUE = 1u << 7; // BUSCLK: one tick per two EE cycles
+static constexpr uint32_t GAP = 100;     // instructions between the two reads
+
+// lui t0, 0xB000; lw t1, 0(t0); GAP nops; lw t2, 0(t0); b .; nop
+static void putProgram(Mem& mem) {
+    uint32_t at = PROG;
+    memWrite32(mem, at, 0x3C08B000u); at += 4;
+    memWrite32(mem, at, 0x8D090000u); at += 4;
+    for (uint32_t i = 0; i < GAP; ++i, at += 4) memWrite32(mem, at, 0);
+    memWrite32(mem, at, 0x8D0A0000u); at += 4;
+    memWrite32(mem, at, 0x1000FFFFu); at += 4;
+    memWrite32(mem, at, 0);
+}
+
+static uint32_t eeSlice(void* ee) { return eeSliceCycles(*static_cast<const EERegs*>(ee)); }
+
+// Ticks between the two reads, run as one slice
+static uint32_t readGap(EERunFn run, EEJit& jit, EERegs& ee, Mem& mem, EERunHooks& hooks, Scheduler& sched) {
+    ee.pc = PROG;
+    ee.nextPc = PROG + 4;
+    uint32_t executed = 0;
+    run(jit, ee, mem, hooks, 1024, executed);
+    CHECK(!ee.budget);
+    CHECK(executed > GAP + 3);
+    schedAdvance(sched, executed);
+    return (eeGetReg(ee, 10) - eeGetReg(ee, 9)) & 0xFFFF;
+}
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    Scheduler sched;
+    schedInit(sched);
+    static Timers tm;
+    timersInit(tm, sched, mem.intc_stat, 9370);
+    timersMapMmio(tm, mem);
+    memWrite32(mem, T0_MODE, CUE);
+    memWrite32(mem, T0_COUNT, 0);
+
+    static EERegs ee;
+    eeInit(ee, PROG);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+    static EEJit jit;
+    const bool compiles = eeJitInit(jit, mem, cache);
+    static EERunHooks hooks;
+    putProgram(mem);
+
+    sched.sliceCycles = eeSlice;
+    sched.sliceUser = &ee;
+
+    // The second read is GAP + 1 cycles after the first: GAP / 2 ticks or
+    // one more, by phase. Enough runs for the blocks to be compiled.
+    const EERunFn fast = eeSelectRun(false, false, false);
+    for (uint32_t i = 0; i < 2 * EE_JIT_HOT_THRESHOLD; ++i) {
+        const uint32_t gap = readGap(fast, jit, ee, mem, hooks, sched);
+        CHECK(gap == GAP / 2 || gap == GAP / 2 + 1);
+    }
+    CHECK(!compiles || jit.compiled > 0);
+    const uint32_t gap = readGap(eeSelectRun(true, false, false), jit, ee, mem, hooks, sched);
+    CHECK(gap == GAP / 2 || gap == GAP / 2 + 1);
+
+    // Between slices the clock is exact
+    const uint32_t count = memRead32(mem, T0_COUNT);
+    CHECK(count == (sched.now / 2 & 0xFFFF));
+
+    eeJitShutdown(jit, mem);
+    memShutdown(mem);
+    return 0;
+}
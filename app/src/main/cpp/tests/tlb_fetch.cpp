@@ -0,0 +1,79 @@
+// Instruction fetch goes through the TLB: code on a page an invalid entry
+// covers (or no entry covers) raises TLBL with BadVAddr at the PC instead
+// of running the fallback value, and no block is cached for it
+#include "check.h"
+#include "mem_map.h"
+#include "ee_block.h"
+#include "ee_tlb.h"
+
+static constexpr uint32_t VPAGE = 0x00100000, PPAGE = 0x00180000;
+static constexpr uint32_t ADDIU_R1 = 0x24210001;   // ADDIU r1, r1, 1
+static constexpr uint32_t BEQ_BACK = 0x1000FFFE;   // BEQ r0, r0, back one word
+
+// Even page VPAGE -> PPAGE, odd page VPAGE + 4 KB present but invalid
+static void tlbMapHalfValid(EERegs& ee, Mem& mem) {
+    ee.cop0[COP0_PAGEMASK] = 0;
+    ee.cop0[COP0_ENTRYHI]  = VPAGE;
+    ee.cop0[COP0_ENTRYLO0] = (PPAGE >> 12) << 6 | EE_TLB_V | EE_TLB_D | EE_TLB_G;
+    ee.cop0[COP0_ENTRYLO1] = EE_TLB_G;
+    eeTlbWrite(ee, mem, 0);
+}
+
+static ExecResult runAt(EERegs& ee, Mem& mem, EEBlockCache& cache, uint32_t pc, uint32_t& executed) {
+    ee.cop0[COP0_STATUS] = 0;
+    ee.pc = pc;
+    ee.nextPc = pc + 4;
+    return eeRunBlock(ee, mem, cache, executed);
+}
+
+static uint32_t excCode(const EERegs& ee) { return (ee.cop0[COP0_CAUSE] >> 2) & 0x1F; }
+static bool inDelaySlot(const EERegs& ee) { return ee.cop0[COP0_CAUSE] & 0x80000000u; }
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    EERegs ee;
+    eeInit(ee, 0);
+    EEBlockCache cache;
+    eeBlockCacheInit(cache);
+    tlbMapHalfValid(ee, mem);
+
+    // The block stops at the end of the valid page and the fault is taken
+    // when execution gets there, with EPC and BadVAddr at the invalid page
+    memWrite32(mem, PPAGE + 0xFF8, ADDIU_R1);
+    memWrite32(mem, PPAGE + 0xFFC, ADDIU_R1);
+    uint32_t executed = 0;
+    CHECK(runAt(ee, mem, cache, VPAGE + 0xFF8, executed) == ExecResult::Ok);
+    CHECK(executed == 2 && ee.GPR[1].UL[0] == 2 && ee.pc == VPAGE + 0x1000);
+    CHECK(runAt(ee, mem, cache, VPAGE + 0x1000, executed) == ExecResult::Exception);
+    CHECK(executed == 0 && ee.GPR[1].UL[0] == 2);
+    CHECK(excCode(ee) == static_cast<uint32_t>(EEExc::TLBL) && !inDelaySlot(ee));
+    CHECK(ee.cop0[COP0_BADVADDR] == VPAGE + 0x1000 && ee.cop0[COP0_EPC] == VPAGE + 0x1000);
+    CHECK(ee.pc == 0x80000180);                        // entry found: general vector
+    CHECK(!cache.blocks.count(VPAGE + 0x1000));
+
+    // No entry at all: the refill vector while EXL is clear
+    CHECK(runAt(ee, mem, cache, 0x40000000, executed) == ExecResult::Exception);
+    CHECK(ee.cop0[COP0_BADVADDR] == 0x40000000 && ee.pc == 0x80000000);
+    CHECK(!cache.blocks.count(0x40000000));
+
+    // A branch whose delay slot is on the invalid page runs alone; the slot
+    // faults with EPC on the branch and BD set
+    memWrite32(mem, PPAGE + 0xFFC, BEQ_BACK);
+    eeBlockInvalidatePage(cache, PPAGE >> MEM_PAGE_SHIFT);
+    ee.GPR[1].UD[0] = 0;
+    CHECK(runAt(ee, mem, cache, VPAGE + 0xFF8, executed) == ExecResult::Ok);
+    CHECK(executed == 1 && ee.pc == VPAGE + 0xFFC);
+    CHECK(runAt(ee, mem, cache, VPAGE + 0xFFC, executed) == ExecResult::Exception);
+    CHECK(inDelaySlot(ee) && ee.cop0[COP0_EPC] == VPAGE + 0xFFC);
+    CHECK(ee.cop0[COP0_BADVADDR] == VPAGE + 0x1000);
+    CHECK(!cache.blocks.count(VPAGE + 0xFFC));
+
+    // Once the page is valid the same code runs
+    ee.cop0[COP0_ENTRYLO1] = ((PPAGE + 0x1000) >> 12) << 6 | EE_TLB_V | EE_TLB_D | EE_TLB_G;
+    eeTlbWrite(ee, mem, 0);
+    memWrite32(mem, PPAGE + 0x1000, ADDIU_R1);
+    CHECK(runAt(ee, mem, cache, VPAGE + 0xFFC, executed) == ExecResult::Ok);
+    CHECK(executed == 2 && ee.pc == VPAGE + 0xFF8 && ee.GPR[1].UL[0] == 2);
+    return 0;
+}
@@ -0,0 +1,50 @@
+// VIF0 is reachable the way ps2_core wires it: registers and FIFO on the EE
+// bus, and DMA channel 0
+#include "check.h"
+#include "mem_map.h"
+#include "scheduler.h"
+#include "dma_stub.h"
+#include "vif.h"
+
+static constexpr uint32_t STCYCL_1_1 = 0x01000101;
+static uint32_t unpackV4_32(uint32_t qaddr) { return 0x6C010000u | qaddr; }
+
+int main() {
+    static Mem mem;
+    CHECK(memInit(mem));
+    Scheduler sched;
+    schedInit(sched);
+    DMAC dmac;
+    dmaInit(dmac, mem, sched);
+    dmaMapMmio(dmac, mem);
+    VU vu0;
+    vuInit(vu0, 0);
+    VIF vif0;
+    vifMapMmio(vif0, 0, mem);
+    vifInit(vif0, 0, &vu0, nullptr, nullptr);
+    dmaAttach(dmac, DMA_VIF0, dmaVifPort(vif0));
+
+    // Registers: ROW0 written and read back through the bus
+    memWrite32(mem, 0x10003900, 0x1234);
+    CHECK(vif0.row[0] == 0x1234);
+    CHECK(memRead32(mem, 0x10003900) == 0x1234);
+
+    // FIFO: a quadword store runs the commands it completes
+    memWrite128(mem, 0x10004000, MemQword{uint64_t(unpackV4_32(2)) << 32 | STCYCL_1_1, 0x0000000B0000000Aull});
+    CHECK(memRead32(mem, 0x10003840) == 0x0101);
+    memWrite128(mem, 0x10004000, MemQword{0x0000000D0000000Cull, 0});
+    CHECK(vu0.data[2].UL[0] == 0xA && vu0.data[2].UL[3] == 0xD);
+    CHECK((memRead32(mem, 0x10003800) >> 24) == 0);
+
+    // DMA channel 0, normal mode from RAM
+    memWrite128(mem, 0x1000, MemQword{0, uint64_t(unpackV4_32(3)) << 32 | STCYCL_1_1});
+    memWrite128(mem, 0x1010, MemQword{0x0000002100000020ull, 0x0000002300000022ull});
+    memWrite32(mem, 0x1000E000, 1);          // D_CTRL DMAE
+    memWrite32(mem, 0x10008010, 0x1000);     // MADR
+    memWrite32(mem, 0x10008020, 2);          // QWC
+    memWrite32(mem, 0x10008000, 0x101);      // CHCR: STR, from memory
+    schedAdvance(sched, 100000);
+    CHECK(!(dmac.channels[DMA_VIF0].chcr & 0x100));
+    CHECK(vu0.data[3].UL[0] == 0x20 && vu0.data[3].UL[3] == 0x23);
+    return 0;
+}
@@ -0,0 +1,239 @@
+// VU upper pipe: every FMAC slot on random operands, run through the host's
+// vec4 layer and checked lane by lane against the plain float model below.
+// Also built with VU_SCALAR and per instruction set (see CMakeLists.txt).
+#include "check.h"
+#include "vu.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+static inline float    flt(uint32_t v) { float f; std::memcpy(&f, &v, 4); return f; }
+static inline uint32_t bits(float f)   { uint32_t v; std::memcpy(&v, &f, 4); return v; }
+
+static uint64_t g_seed = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd() {
+    g_seed ^= g_seed << 13; g_seed ^= g_seed >> 7; g_seed ^= g_seed << 17;
+    return static_cast<uint32_t>(g_seed >> 16);
+}
+
+// Edge cases the VU treats as plain numbers: signed zeros, FLT_MAX,
+// denormals and the Inf/NaN encodings (exponent 255)
+static constexpr uint32_t kEdge[] = {
+    0x00000000, 0x80000000, 0x3F800000, 0xBF800000, 0x7F7FFFFF, 0xFF7FFFFF, 0x00000001, 0x807FFFFF,
+    0x7F800000, 0xFF800000, 0x7FC00000, 0xFFC00000, 0x7F800001, 0x4F000000, 0xCF000000, 0x5F000000,
+};
+
+static bool isNan(uint32_t v) { return (v & 0x7FFFFFFFu) > 0x7F800000u; }
+
+static uint32_t rndValue() {
+    const uint32_t r = rnd();
+    switch (r & 7) {
+        case 0:  return kEdge[(r >> 3) & 15];
+        case 1:  return rnd();                                   // any encoding
+        default: return (r & 0x80000000u) | (0x30000000u + (rnd() & 0x1FFFFFFFu)); // about 2^-31 .. 2^32
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Model
+// -----------------------------------------------------------------------------
+
+enum class Op { Add, Sub, Mul, Max, Min, Madd, Msub, Itof, Ftoi, Abs, Clip, Opmula, Opmsub, Nop };
+enum class Src { Ft, X, Y, Z, W, I, Q };
+
+struct Decoded { Op op = Op::Nop; Src src = Src::Ft; bool toAcc = false; int shift = 0; };
+
+static constexpr Src kBc[4] = {Src::X, Src::Y, Src::Z, Src::W};
+static constexpr int kFix[4] = {0, 4, 12, 15};
+
+static Decoded decode(uint32_t i) {
+    const uint32_t funct = i & 0x3F;
+    if (funct >= 0x3C) {
+        const uint32_t s = ((i >> 4) & 0x7C) | (i & 3);
+        if (s < 0x10) {
+            static constexpr Op kOps[4] = {Op::Add, Op::Sub, Op::Madd, Op::Msub};
+            return {kOps[s >> 2], kBc[s & 3], true};
+        }
+        if (s < 0x14) return {Op::Itof, Src::Ft, false, kFix[s & 3]};
+        if (s < 0x18) return {Op::Ftoi, Src::Ft, false, kFix[s & 3]};
+        if (s < 0x1C) return {Op::Mul, kBc[s & 3], true};
+        switch (s) {
+            case 0x1C: return {Op::Mul, Src::Q, true};
+            case 0x1D: return {Op::Abs};
+            case 0x1E: return {Op::Mul, Src::I, true};
+            case 0x1F: return {Op::Clip};
+            case 0x20: return {Op::Add, Src::Q, true};
+            case 0x21: return {Op::Madd, Src::Q, true};
+            case 0x22: return {Op::Add, Src::I, true};
+            case 0x23: return {Op::Madd, Src::I, true};
+            case 0x24: return {Op::Sub, Src::Q, true};
+            case 0x25: return {Op::Msub, Src::Q, true};
+            case 0x26: return {Op::Sub, Src::I, true};
+            case 0x27: return {Op::Msub, Src::I, true};
+            case 0x28: return {Op::Add, Src::Ft, true};
+            case 0x29: return {Op::Madd, Src::Ft, true};
+            case 0x2A: return {Op::Mul, Src::Ft, true};
+            case 0x2C: return {Op::Sub, Src::Ft, true};
+            case 0x2D: return {Op::Msub, Src::Ft, true};
+            case 0x2E: return {Op::Opmula};
+            default:   return {};
+        }
+    }
+    if (funct < 0x1C) {
+        static constexpr Op kOps[7] = {Op::Add, Op::Sub, Op::Madd, Op::Msub, Op::Max, Op::Min, Op::Mul};
+        return {kOps[funct >> 2], kBc[funct & 3]};
+    }
+    switch (funct) {
+        case 0x1C: return {Op::Mul, Src::Q};
+        case 0x1D: return {Op::Max, Src::I};
+        case 0x1E: return {Op::Mul, Src::I};
+        case 0x1F: return {Op::Min, Src::I};
+        case 0x20: return {Op::Add, Src::Q};
+        case 0x21: return {Op::Madd, Src::Q};
+        case 0x22: return {Op::Add, Src::I};
+        case 0x23: return {Op::Madd, Src::I};
+        case 0x24: return {Op::Sub, Src::Q};
+        case 0x25: return {Op::Msub, Src::Q};
+        case 0x26: return {Op::Sub, Src::I};
+        case 0x27: return {Op::Msub, Src::I};
+        case 0x28: return {Op::Add, Src::Ft};
+        case 0x29: return {Op::Madd, Src::Ft};
+        case 0x2A: return {Op::Mul, Src::Ft};
+        case 0x2B: return {Op::Max, Src::Ft};
+        case 0x2C: return {Op::Sub, Src::Ft};
+        case 0x2D: return {Op::Msub, Src::Ft};
+        case 0x2E: return {Op::Opmsub};
+        case 0x2F: return {Op::Min, Src::Ft};
+        default:   return {};
+    }
+}
+
+// Exponent 255 saturates to FLT_MAX of the same sign
+static float clamp(float x) { return std::fabs(x) <= FLT_MAX ? x : std::signbit(x) ? -FLT_MAX : FLT_MAX; }
+
+static int32_t ftoi(float s) {
+    if (s >= 2147483648.0f) return 0x7FFFFFFF;
+    if (!(s > -2147483648.0f)) return INT32_MIN;
+    return static_cast<int32_t>(s);
+}
+
+static void model(VU& vu, uint32_t i) {
+    const Decoded d = decode(i);
+    const uint32_t dest = (i >> 21) & 0xF, ft = (i >> 16) & 0x1F, fs = (i >> 11) & 0x1F, fd = (i >> 6) & 0x1F;
+    const VUVec a = vu.VF[fs], b = vu.VF[ft];
+    VUVec raw{}, r{};
+
+    switch (d.op) {
+        case Op::Nop:
+            return;
+        case Op::Itof: case Op::Ftoi: case Op::Abs:
+            for (int l = 0; l < 4; ++l) {
+                if (d.op == Op::Itof) r.F[l] = static_cast<float>(a.SL[l]) / static_cast<float>(1 << d.shift);
+                if (d.op == Op::Ftoi) r.SL[l] = ftoi(a.F[l] * static_cast<float>(1 << d.shift));
+                if (d.op == Op::Abs)  r.UL[l] = a.UL[l] & 0x7FFFFFFFu;
+            }
+            for (int l = 0; l < 4; ++l) if (ft && (dest & (8 >> l))) vu.VF[ft].UL[l] = r.UL[l];
+            return;
+        case Op::Clip: {
+            const float w = std::fabs(b.F[3]);
+            uint32_t j = 0;
+            for (int l = 0; l < 3; ++l) j |= (a.F[l] > w ? 1u : 0u) << (2 * l) | (a.F[l] < 0.0f - w ? 2u : 0u) << (2 * l);
+            vu.clip = ((vu.clip << 6) | j) & 0xFFFFFF;
+            return;
+        }
+        default:
+            break;
+    }
+
+    for (int l = 0; l < 4; ++l) {
+        float y = 0.0f;
+        switch (d.src) {
+            case Src::Ft: y = b.F[l]; break;
+            case Src::X:  y = b.F[0]; break;
+            case Src::Y:  y = b.F[1]; break;
+            case Src::Z:  y = b.F[2]; break;
+            case Src::W:  y = b.F[3]; break;
+            case Src::I:  y = flt(vu.I); break;
+            case Src::Q:  y = flt(vu.Q); break;
+        }
+        const float x = a.F[l];
+        static constexpr int kYzx[4] = {1, 2, 0, 3}, kZxy[4] = {2, 0, 1, 3};
+        switch (d.op) {
+            case Op::Add:    raw.F[l] = x + y; break;
+            case Op::Sub:    raw.F[l] = x - y; break;
+            case Op::Mul:    raw.F[l] = x * y; break;
+            case Op::Max:    raw.F[l] = x > y ? x : y; break;
+            case Op::Min:    raw.F[l] = x < y ? x : y; break;
+            case Op::Madd:   raw.F[l] = vu.ACC.F[l] + clamp(x * y); break;
+            case Op::Msub:   raw.F[l] = vu.ACC.F[l] - clamp(x * y); break;
+            case Op::Opmula: raw.F[l] = clamp(a.F[kYzx[l]] * b.F[kZxy[l]]); break;
+            case Op::Opmsub: raw.F[l] = vu.ACC.F[l] - clamp(a.F[kYzx[l]] * b.F[kZxy[l]]); break;
+            default: break;
+        }
+        r.F[l] = clamp(raw.F[l]);
+    }
+
+    if (d.op != Op::Max && d.op != Op::Min) {
+        uint32_t z = 0, s = 0, o = 0;
+        for (int l = 0; l < 4; ++l) {
+            const uint32_t lane = 8u >> l;
+            if (!(dest & lane)) continue;
+            if (r.F[l] == 0.0f) z |= lane;
+            if (std::signbit(r.F[l])) s |= lane;
+            if (!(std::fabs(raw.F[l]) <= FLT_MAX)) o |= lane;
+        }
+        vu.mac = z | s << 4 | o << 12;
+        const uint32_t st = (z ? VU_STATUS_Z : 0) | (s ? VU_STATUS_S : 0) | (o ? VU_STATUS_O : 0);
+        vu.status = (vu.status & ~0xFu) | st | st << 6;
+    }
+
+    const bool toAcc = d.toAcc || d.op == Op::Opmula;
+    VUVec& out = toAcc ? vu.ACC : vu.VF[fd];
+    if (!toAcc && !fd) return;
+    for (int l = 0; l < 4; ++l) if (dest & (8 >> l)) out.UL[l] = r.UL[l];
+}
+
+// -----------------------------------------------------------------------------
+
+static bool same(const VUVec& a, const VUVec& b) { return std::memcmp(a.UL, b.UL, 16) == 0; }
+
+static bool same(const VU& a, const VU& b) {
+    for (int r = 0; r < 32; ++r) if (!same(a.VF[r], b.VF[r])) return false;
+    return same(a.ACC, b.ACC) && a.mac == b.mac && a.status == b.status && a.clip == b.clip;
+}
+
+int main() {
+    static VU vu, ref;
+    vuInit(vu, 0);
+    vuInit(ref, 0);
+
+    for (uint32_t n = 0; n < 200000; ++n) {
+        for (int r = 1; r < 32; ++r) for (int l = 0; l < 4; ++l) vu.VF[r].UL[l] = rndValue();
+        for (int l = 0; l < 4; ++l) vu.ACC.UL[l] = bits(clamp(flt(rndValue())));
+        vu.I = rndValue();
+        vuWriteReg(vu, VU_REG_Q, rndValue());
+
+        // Special slots half the time so both tables get the same coverage
+        uint32_t insn = rnd() & 0x01FFFFFFu;
+        insn = (rnd() & 1) ? (insn & ~0x3Fu) | (0x3C | (insn & 3)) : (insn & ~0x3Fu) | (rnd() % 0x30);
+
+        // Which NaN of two a host op returns is unspecified, so NaNs only
+        // meet non-NaN operands: fs keeps them, ft (or all but fs.x) and I/Q don't
+        const uint32_t fs = (insn >> 11) & 0x1F, ft = (insn >> 16) & 0x1F;
+        for (int l = fs == ft ? 1 : 0; l < 4; ++l) if (isNan(vu.VF[ft].UL[l])) vu.VF[ft].UL[l] &= 0xFF800000u;
+        if (isNan(vu.I)) vu.I &= 0xFF800000u;
+        if (isNan(vu.Q)) vu.Q &= 0xFF800000u;
+
+        for (int r = 0; r < 32; ++r) ref.VF[r] = vu.VF[r];
+        ref.ACC = vu.ACC;
+        ref.I = vu.I;
+        ref.Q = vu.Q;
+        ref.mac = vu.mac; ref.status = vu.status; ref.clip = vu.clip;
+
+        vuExecUpper(vu, insn);
+        model(ref, insn);
+        if (!same(vu, ref)) std::fprintf(stderr, "upper op %08X\n", insn);
+        CHECK(same(vu, ref));
+    }
+    return 0;
+}
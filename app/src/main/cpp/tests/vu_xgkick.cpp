@@ -0,0 +1,94 @@
+// XGKICK sends VU1's GIF packets down PATH1 to the GIF FIFO, inline and
+// from the MTVU worker, up to the EOP tag and wrapping at the end of data
+// memory
+#include "check.h"
+#include "gif_fifo.h"
+#include "gs_stub.h"
+#include "mtvu.h"
+
+static constexpr uint32_t XGKICK_VI1 = 0x80000EFC;  // XGKICK vi1
+static constexpr uint32_t LOWER_NOP  = 0x8000033C;
+static constexpr uint32_t UPPER_NOP  = 0x000002FF;
+static constexpr uint32_t UPPER_E    = 1u << 30;
+
+// GIFtag quadword: PACKED with nreg registers, or IMAGE (nreg unused)
+static VUVec gifTag(uint32_t nloop, bool eop, bool image, uint32_t nreg) {
+    VUVec t = {};
+    t.UL[0] = nloop | (eop ? 0x8000u : 0u);
+    t.UL[1] = (image ? 2u : 0u) << 26 | (nreg & 15) << 28;
+    return t;
+}
+
+// PACKED tag with two loops of one register, then an IMAGE tag with EOP
+// and three quadwords: 7 quadwords, then a tag that must not be sent
+static void putChain(MTVU& m, uint32_t qaddr) {
+    const VUVec chain[8] = {
+        gifTag(2, false, false, 1), {}, {},
+        gifTag(3, true, true, 0), {}, {}, {},
+        gifTag(100, true, false, 1),
+    };
+    for (uint32_t i = 0; i < 8; ++i) mtvuWriteData(m, (qaddr + i) & 1023, &chain[i], 1);
+}
+
+// Kick `XGKICK vi1` with vi1 at qaddr; returns GIF {transfers, quadwords} it added
+static void kick(MTVU& m, GIFFifo& gif, VU& vu1, uint32_t qaddr, uint64_t& packets, uint64_t& qwords) {
+    const GIFFifoStats before = gifFifoStats(gif);
+    vu1.VI[1] = static_cast<uint16_t>(qaddr);
+    mtvuKick(m, 0);
+    if (m.threaded) mtvuSync(m);
+    else            mtvuRun(m, 16);
+    gifFifoSync(gif);
+    const GIFFifoStats after = gifFifoStats(gif);
+    packets = after.packets - before.packets;
+    qwords = after.qwords - before.qwords;
+}
+
+int main() {
+    static GS gs;
+    static GIFFifo gif;
+    gifFifoInit(gif, gs);
+    static VU vu1;
+    vuInit(vu1, 1);
+    static MTVU m;
+    mtvuInit(m, vu1, &gif);
+    CHECK(vu1.data.size() == 1024);
+
+    const uint32_t prog[4] = {XGKICK_VI1, UPPER_NOP | UPPER_E, LOWER_NOP, UPPER_NOP};
+    mtvuWriteMicro(m, 0, prog, 4);
+
+    for (int mode = 0; mode < 4; ++mode) {
+        const bool mtvu = mode & 1, gsThread = mode & 2;
+        mtvuSetThreaded(m, mtvu);
+        gifFifoSetThreaded(gif, gsThread);
+        uint64_t packets = 0, qwords = 0;
+
+        // In one piece
+        putChain(m, 16);
+        kick(m, gif, vu1, 16, packets, qwords);
+        CHECK(packets == 1 && qwords == 7);
+
+        // Across the end of data memory: two transfers, same quadwords
+        putChain(m, 1020);
+        kick(m, gif, vu1, 1020, packets, qwords);
+        CHECK(packets == 2 && qwords == 7);
+    }
+
+    // More PATH1 output than its ring holds, queued before the EE syncs:
+    // the worker waits for room, which the EE makes while it waits in turn
+    const VUVec big = gifTag(1000, true, true, 0);
+    mtvuWriteData(m, 0, &big, 1);
+    vu1.VI[1] = 0;
+    const GIFFifoStats before = gifFifoStats(gif);
+    for (int i = 0; i < 40; ++i) mtvuKick(m, 0);
+    mtvuSync(m);
+    gifFifoSync(gif);
+    CHECK(gifFifoStats(gif).qwords - before.qwords == 40 * 1001);
+
+    // A chain with no EOP stops after all of data memory
+    const VUVec noEop = gifTag(0, false, false, 1);
+    CHECK(gifPacketChainSize(&noEop.UL[0], 1, 0) == 1);
+
+    mtvuShutdown(m);
+    gifFifoShutdown(gif);
+    return 0;
+}
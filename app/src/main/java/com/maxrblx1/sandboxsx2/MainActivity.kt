@@ -17,7 +17,9 @@ import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.Color
 import androidx.compose.ui.unit.dp
 import com.maxrblx1.sandboxsx2.ui.theme.SandboxSX2Theme
+import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.delay
+import kotlinx.coroutines.withContext
 =======
 import androidx.compose.ui.unit.dp
 import com.maxrblx1.sandboxsx2.ui.theme.SandboxSX2Theme
@@ -76,17 +78,25 @@ fun EmulatorScreen(modifier: Modifier = Modifier, biosDir: File) {
     var debugState by remember { mutableStateOf("") }
     var biosWarning by remember { mutableStateOf("") }
     var biosLoaded by remember { mutableStateOf(false) }
+    var turbo by remember { mutableStateOf(false) }
+    var fps by remember { mutableDoubleStateOf(0.0) }
+    var speed by remember { mutableDoubleStateOf(0.0) }
 
     // BIOS loader
     LaunchedEffect(Unit) {
+        val cacheDir = File(biosDir.parentFile, "tcache")
+        if (!cacheDir.exists()) {
+            cacheDir.mkdirs()
+        }
+        emulator.nativeSetCacheDir(cacheDir.absolutePath)
+
         val biosFiles = biosDir.listFiles()
         if (biosFiles.isNullOrEmpty()) {
             biosWarning = "No BIOS found in /ps2_bios/"
         } else {
             val validFile = biosFiles.firstOrNull { it.isFile && it.name.lowercase().endsWith(".bin") }
             if (validFile != null) {
-                val bytes = validFile.readBytes()
-                val ok = emulator.nativeLoadBiosPart("bin", bytes)
+                val ok = emulator.nativeLoadBiosFile(validFile.absolutePath)
                 biosLoaded = ok
                 biosWarning = if (ok) "" else "Failed to load BIOS: ${validFile.name}"
             } else {
@@ -95,19 +105,31 @@ fun EmulatorScreen(modifier: Modifier = Modifier, biosDir: File) {
         }
     }
 
-    // VM loop
+    // VM loop: the core runs on its own thread; the UI only polls it
     LaunchedEffect(isRunning) {
         if (isRunning && biosLoaded) {
+            emulator.nativeStart()
             while (isRunning) {
-                emulator.nativeTick()
                 tickCount = emulator.nativeGetTickCount()
                 pc = emulator.nativeGetPC()
+                fps = emulator.nativeGetFps()
+                speed = emulator.nativeGetSpeedPercent()
                 debugState = emulator.nativeGetDebugState()
-                delay(16) // ~60 ticks per second
+                // Paused itself on a breakpoint
+                if (!emulator.nativeIsRunning()) isRunning = false
+                delay(250)
             }
+        } else if (biosLoaded) {
+            emulator.nativePause()
+            // Keep decoded BIOS blocks for the next launch
+            withContext(Dispatchers.IO) { emulator.nativeSaveCaches() }
         }
     }
 
+    DisposableEffect(Unit) {
+        onDispose { emulator.nativeStop() }
+    }
+
     val scrollState = rememberScrollState()
 
     Column(
@@ -142,6 +164,15 @@ fun EmulatorScreen(modifier: Modifier = Modifier, biosDir: File) {
                     }
                 )
             }
+            Button(
+                onClick = {
+                    turbo = !turbo
+                    emulator.nativeSetTurbo(turbo)
+                },
+                modifier = Modifier.weight(1f)
+            ) {
+                Text(if (turbo) "Turbo: On" else "Turbo: Off")
+            }
         }
 
         Spacer(Modifier.height(16.dp))
@@ -156,6 +187,7 @@ fun EmulatorScreen(modifier: Modifier = Modifier, biosDir: File) {
                 Spacer(Modifier.height(8.dp))
                 Text("PC: 0x${pc.toUInt().toString(16).uppercase()}", style = MaterialTheme.typography.bodySmall)
                 Text("Ticks: $tickCount", style = MaterialTheme.typography.bodySmall)
+                Text("FPS: ${"%.1f".format(fps)} (${"%.0f".format(speed)}%)", style = MaterialTheme.typography.bodySmall)
                 Text("EE State: $debugState", style = MaterialTheme.typography.bodySmall)
             }
 =======
@@ -3,7 +3,26 @@ package com.maxrblx1.sandboxsx2
 <<<<<<< HEAD
 class NativeEmulator {
 
+    // Emulation thread owned by the core; a breakpoint pauses it. Getters
+    // below can be polled while it runs.
+    external fun nativeStart()
+    external fun nativePause()
+    external fun nativeResume()
+    external fun nativeStop()
+    external fun nativeIsRunning(): Boolean
+
+    // Drive the core from the caller's thread instead (run thread stopped):
+    // one run slice, or one guest frame paced to 59.94/50 Hz
     external fun nativeTick()
+    external fun nativeRunFrame()
+
+    // Turbo skips the frame pacing sleep
+    external fun nativeSetTurbo(enabled: Boolean)
+    // PAL timing instead of NTSC, from the next BIOS load
+    external fun nativeSetVideoMode(pal: Boolean)
+    external fun nativeGetFps(): Double
+    external fun nativeGetSpeedPercent(): Double
+
     external fun nativeGetPC(): Int
     external fun nativeGetTickCount(): Long
     external fun nativeGetDebugState(): String
@@ -11,6 +30,34 @@ class NativeEmulator {
     // BIOS loader — accepts part name and byte array
     external fun nativeLoadBiosPart(part: String, bytes: ByteArray): Boolean
 
+    // BIOS loader — maps the file read-only instead of copying it; the fd
+    // variant (e.g. from a ParcelFileDescriptor) stays owned by the caller
+    external fun nativeLoadBiosFile(path: String): Boolean
+    external fun nativeLoadBiosFd(fd: Int): Boolean
+
+    // Translation cache — set the directory before loading the BIOS,
+    // save when the VM loop stops
+    external fun nativeSetCacheDir(dir: String)
+    external fun nativeSaveCaches(): Boolean
+
+    // Debug run-loop features (all off by default)
+    external fun nativeSetRunPolicy(trace: Boolean, cycleAccurate: Boolean, breakpoints: Boolean)
+    external fun nativeSetBreakpoint(pc: Int, enabled: Boolean)
+
+    // FPU accuracy (fast by default), globally or for the block at pc
+    external fun nativeSetFpuMode(accurate: Boolean)
+    external fun nativeSetBlockFpuMode(pc: Int, accurate: Boolean, pinned: Boolean)
+
+    // Run VU1 on its own thread (off = deterministic lockstep with the EE)
+    external fun nativeSetMtvu(threaded: Boolean)
+
+    // Process GIF packets on a GS thread (on by default); the EE waits only
+    // for a full queue or a GS register read
+    external fun nativeSetGsThread(threaded: Boolean)
+
+    // Fastmem: compiled loads go straight to a reserved host window
+    external fun nativeSetFastmem(enabled: Boolean)
+
     companion object {
         init {
             System.loadLibrary("ps2native") // match your CMake target name